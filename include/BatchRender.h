@@ -0,0 +1,79 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#ifndef FACTURATION_BASE_BATCHRENDER_H
+#define FACTURATION_BASE_BATCHRENDER_H
+
+#include <Config.h>
+
+/** @defgroup BatchRender Rendering of many documents in parallel
+ * @ingroup Format
+ *
+ * A batch renders a list of saved documents with the same print format into text
+ * files, without the GUI. The print format is taken from the PrintFormatCache and its
+ * compiled templates are shared by a pool of worker threads. Each worker takes the
+ * next document of the list, loads it in its own Document and renders it with its own
+ * Dictionary into OUTPUTDIRECTORY/DOCNUMBER.txt.
+ * @{
+ */
+
+/** The file names of the bills, %s standing for the document number */
+#define BATCHRENDER_BILL_FILENAME BASEPATH "/data/bill-%s.dat"
+
+/** The file names of the quotations, %s standing for the document number */
+#define BATCHRENDER_QUOTATION_FILENAME BASEPATH "/data/quotation-%s.dat"
+
+/** The maximal number of worker threads of a batch */
+#define BATCHRENDER_MAX_THREADS 64
+
+/** The result of a batch */
+typedef struct
+{
+  int documentCount; /**< The number of documents of the batch */
+  int renderedCount; /**< The number of documents rendered */
+  int failedCount; /**< The number of documents which could not be read or written */
+  int threadCount; /**< The number of worker threads used */
+  double seconds; /**< The elapsed time of the batch */
+} BatchRenderReport;
+
+/** Render a list of saved documents with a print format into a directory
+ * @param formatFilename the file name of the print format
+ * @param documentFilenamePattern the file names of the documents, %s standing for the document number,
+ * as BATCHRENDER_BILL_FILENAME or BATCHRENDER_QUOTATION_FILENAME
+ * @param docNumbers the numbers of the documents
+ * @param docNumberCount the number of documents
+ * @param outputDirectory the directory receiving the text files, created if needed
+ * @param threadCount the number of worker threads, 0 for one per processor
+ * @param report the structure receiving the result of the batch
+ * @return a non null value if all the documents were rendered
+ */
+int BatchRender_run(const char * formatFilename, const char * documentFilenamePattern, const char * const * docNumbers,
+    int docNumberCount, const char * outputDirectory, int threadCount, BatchRenderReport * report);
+
+/** Get the number of documents rendered per second by a batch
+ * @param report the result of the batch
+ * @return the number of documents per second
+ * @relates BatchRenderReport
+ */
+double BatchRenderReport_getThroughput(const BatchRenderReport * report);
+
+/** @} */
+
+#endif
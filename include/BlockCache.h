@@ -0,0 +1,119 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_BLOCKCACHE_H
+#define FACTURATION_BASE_BLOCKCACHE_H
+
+#include <Config.h>
+
+#include <pthread.h>
+
+/** @defgroup BlockCache Cache of the pages of a database file
+ *
+ * The record databases read their file through a cache of fixed size pages so that
+ * reading the records one by one does not cost one system call per record. The
+ * cache keeps as many pages as its memory budget allows and drops the least
+ * recently used one when it is full.
+ *
+ * When the pages are read in increasing order, the cache detects the sequential
+ * access and reads the next BLOCKCACHE_READAHEAD_PAGES pages with a single call.
+ * The cache can be used by several threads at the same time.
+ * @{
+ */
+
+/** The default size in bytes of a page */
+#define BLOCKCACHE_PAGE_SIZE (64UL * 1024UL)
+
+/** The default memory budget in bytes of the cache of a database */
+#define BLOCKCACHE_DEFAULT_BUDGET (4UL * 1024UL * 1024UL)
+
+/** The number of pages read at once when the access is sequential */
+#define BLOCKCACHE_READAHEAD_PAGES 8
+
+/** A cached page */
+typedef struct
+{
+  long pageNumber; /**< The number of the page in the file, -1 if the entry is unused */
+  size_t length; /**< The number of bytes of the page present in the file */
+  char * data; /**< The bytes of the page */
+  int previous; /**< The previous entry in the order of use, -1 for the most recently used */
+  int next; /**< The next entry in the order of use, -1 for the least recently used */
+  int hashNext; /**< The next entry of the same bucket, -1 for the last one */
+} BlockCachePage;
+
+/** A cache of pages */
+typedef struct
+{
+  BlockCachePage * pages; /**< The entries */
+  int capacity; /**< The number of entries */
+  size_t pageSize; /**< The size in bytes of a page */
+  int * buckets; /**< The first entry of each bucket of the hash table from page numbers to entries */
+  int bucketMask; /**< The number of buckets minus one, the number of buckets being a power of 2 */
+  int first; /**< The most recently used entry */
+  int last; /**< The least recently used entry */
+  long lastPageNumber; /**< The page loaded by the last miss, used to detect the sequential accesses */
+  char * readAheadBuffer; /**< The buffer receiving the pages read at once, NULL until needed */
+  pthread_mutex_t mutex; /**< The lock protecting the cache from concurrent threads */
+  unsigned long hits; /**< The number of pages found in the cache */
+  unsigned long misses; /**< The number of pages not found in the cache */
+  unsigned long readCount; /**< The number of reads done on the file */
+} BlockCache;
+
+/** Initialize an empty cache
+ * @param cache the cache
+ * @param pageSize the size in bytes of a page
+ * @param budget the memory budget in bytes, at least two pages are kept
+ * @relates BlockCache
+ */
+void BlockCache_init(BlockCache * cache, size_t pageSize, size_t budget);
+
+/** Free the memory used by a cache
+ * @param cache the cache
+ * @relates BlockCache
+ */
+void BlockCache_finalize(BlockCache * cache);
+
+/** Read some bytes of a file through a cache
+ * @param cache the cache
+ * @param fd the file descriptor of the file
+ * @param offset the offset of the first byte
+ * @param size the number of bytes
+ * @param buffer the buffer receiving the bytes
+ * @return a non null value on success, 0 if the bytes are not all in the file
+ * @relates BlockCache
+ */
+int BlockCache_read(BlockCache * cache, int fd, long offset, size_t size, char * buffer);
+
+/** Drop the pages containing some bytes of the file, used when the bytes are written
+ * @param cache the cache
+ * @param offset the offset of the first byte
+ * @param size the number of bytes
+ * @relates BlockCache
+ */
+void BlockCache_invalidate(BlockCache * cache, long offset, size_t size);
+
+/** Drop all the pages of a cache
+ * @param cache the cache
+ * @relates BlockCache
+ */
+void BlockCache_clear(BlockCache * cache);
+
+/** @} */
+
+#endif
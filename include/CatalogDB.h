@@ -22,10 +22,20 @@
 
 #include <Config.h>
 #include <CatalogRecord.h>
+#include <SlotTable.h>
+#include <CatalogIndex.h>
+#include <TrigramIndex.h>
+#include <WriteAheadLog.h>
+#include <DatabaseLock.h>
+#include <BlockCache.h>
 
 /**
  * @defgroup CatalogDB Catalog database
  * @ingroup Catalog
+ *
+ * An opened database can be used by several threads at the same time as described
+ * in @ref DatabaseLock, except for the functions working on the memory mapping and
+ * for CatalogDB_close().
  * @{
  */
 
@@ -36,9 +46,52 @@ extern const char * CATALOGDB_FILENAME;
 typedef struct _CatalogDB
 {
   FILE * file; /**< The FILE pointer for the associated file */
+  char * filename; /**< The file name of the database */
   int recordCount; /**< The number of record in the database */
+  SlotTable slots; /**< The slot where each record is stored in the file */
+  WriteAheadLog log; /**< The log of the changes done since the last checkpoint */
+  DatabaseLock lock; /**< The locks protecting the database from the other threads and processes */
+  BlockCache cache; /**< The cache of the pages of the file through which the records are read */
+  CatalogIndex codeIndex; /**< The index of the records by code, built when first needed if it is not valid */
+  TrigramIndex designationIndex; /**< The index of the records by trigrams of their designation, built when first needed if it is not valid */
+  int isModified; /**< True if the database changed since it was opened */
+  const char * mapping; /**< The read-only memory mapping of the file, NULL if the database is not mapped */
+  size_t mappingSize; /**< The size in bytes of the memory mapping */
+  char * batchBuffer; /**< The encoded records of the current batch not yet written, NULL outside a batch */
+  int batchCount; /**< The number of records stored in batchBuffer */
+  int pendingSlots[WRITEAHEADLOG_GROUP_SIZE]; /**< The slots changed by the entries of the log not yet forced to the disk */
+  int pendingRemovals[WRITEAHEADLOG_GROUP_SIZE]; /**< True for the pending slots which receive a tombstone */
+  char pendingRecords[WRITEAHEADLOG_GROUP_SIZE * CATALOGRECORD_SIZE]; /**< The encoded records written in the pending slots */
+  int pendingCount; /**< The number of pending slots, written in place once their log entries are on the disk */
 } CatalogDB;
 
+/** The number of records buffered by a batch before they are written to the file */
+#define CATALOGDB_BATCH_SIZE 2048
+
+/** A function called for each record scanned by CatalogDB_forEach()
+ * @param recordIndex the position of the record
+ * @param record the record, only valid during the call
+ * @param data the data given to CatalogDB_forEach()
+ * @return 0 to continue the scan, a non null value to stop it
+ */
+typedef int (*CatalogDB_Visitor)(int recordIndex, CatalogRecord * record, void * data);
+
+/** A read-only view on a record of a mapped database.
+ *
+ * The string fields point directly into the memory mapping of the database and
+ * remain valid until the database is unmapped, closed or remapped because it grew.
+ * The numeric fields are copied since they are not aligned in the file.
+ */
+typedef struct
+{
+  const char * code; /**< The code of the product */
+  const char * designation; /**< The designation of the product */
+  const char * unity; /**< The unity of the product */
+  double basePrice; /**< The base price of the product */
+  double sellingPrice; /**< The selling price of the product */
+  double rateOfVAT; /**< The rate of the VAT of the product */
+} CatalogRecordView;
+
 /** Create a database of products
  * @param filename the file name of the database
  * @return a pointer on a CatalogDB representing the opened database, NULL otherwise
@@ -52,6 +105,15 @@ OVERRIDABLE_PREFIX CatalogDB * OVERRIDABLE(CatalogDB_create)(const char * filena
  * @relates CatalogDB
  */
 OVERRIDABLE_PREFIX CatalogDB * OVERRIDABLE(CatalogDB_open)(const char * filename);
+
+/** Open an existing database of products and lock its file according to an access mode
+ * @param filename the file name of the database
+ * @param access the access mode
+ * @return a pointer on a CatalogDB representing the opened database, NULL if the file can not be opened or is locked by another process
+ * @relates CatalogDB
+ */
+CatalogDB * CatalogDB_openWithAccess(const char * filename, DatabaseAccess access);
+
 /** Open if exists or create otherwise a database of products
  * @param filename the file name of the database
  * @return a pointer on a CatalogDB representing the opened database, NULL otherwise
@@ -121,6 +183,127 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(CatalogDB_readRecord)(CatalogDB * catalogDB,
  */
 OVERRIDABLE_PREFIX void OVERRIDABLE(CatalogDB_writeRecord)(CatalogDB * catalogDB, int recordIndex, CatalogRecord * record);
 
+/** Map the database file in memory so that records can be browsed without any system call or allocation
+ * @param catalogDB the database
+ * @return a non null value if the database is mapped, 0 otherwise (the database then keeps working through its FILE pointer)
+ * @note The records appended after the mapping are read through the FILE pointer until the database is mapped again
+ * @warning The views on the mapping are invalid once the database is mapped again or unmapped.
+ * @relates CatalogDB
+ */
+int CatalogDB_map(CatalogDB * catalogDB);
+
+/** Release the memory mapping of a database
+ * @param catalogDB the database
+ * @relates CatalogDB
+ */
+void CatalogDB_unmap(CatalogDB * catalogDB);
+
+/** Get a read-only view on a record of a mapped database
+ * @param catalogDB the database which must have been mapped with CatalogDB_map()
+ * @param recordIndex the position of the record
+ * @param view the view to fill
+ * @return a non null value on success, 0 if the database is not mapped or the index is invalid
+ * @relates CatalogDB
+ */
+int CatalogDB_getRecordView(CatalogDB * catalogDB, int recordIndex, CatalogRecordView * view);
+
+/** Get the value of the specified field for the specified record of a database as a string without allocating memory
+ * @param catalogDB the database
+ * @param recordIndex the record index
+ * @param field the field to query
+ * @param buffer a buffer used to store the value when it can not be returned directly from the mapping
+ * @param bufferSize the size of the buffer
+ * @return a pointer on the value, either in the mapping of the database or in buffer
+ * @relates CatalogDB
+ */
+const char * CatalogDB_getFieldValue(CatalogDB * catalogDB, int recordIndex, int field, char * buffer, size_t bufferSize);
+
+/** Start a batch of appends on the database
+ *
+ * Records appended until CatalogDB_commitBatch() are encoded in memory and written
+ * to the file with large sequential writes. They are counted in the number of
+ * records of the database as soon as they are appended. They are not logged: the
+ * commit saves them with a checkpoint and a crash before it loses the whole batch.
+ * @param catalogDB the database
+ * @relates CatalogDB
+ */
+void CatalogDB_beginBatch(CatalogDB * catalogDB);
+
+/** Append several records at the end of the database
+ * @param catalogDB the database
+ * @param records the array of records to append
+ * @param count the number of records in the array
+ * @note Outside a batch, the records are appended as a single batch.
+ * @relates CatalogDB
+ */
+void CatalogDB_appendMany(CatalogDB * catalogDB, CatalogRecord * records, int count);
+
+/** Write the pending records of the current batch and update the header of the database file
+ * @param catalogDB the database
+ * @relates CatalogDB
+ */
+void CatalogDB_commitBatch(CatalogDB * catalogDB);
+
+/** Force the logged changes of the database to the disk so that they survive a crash
+ *
+ * The log is otherwise forced once for each group of WRITEAHEADLOG_GROUP_SIZE changes.
+ * @param catalogDB the database
+ * @relates CatalogDB
+ */
+void CatalogDB_sync(CatalogDB * catalogDB);
+
+/** Replace the cache through which the records of the database are read
+ * @param catalogDB the database
+ * @param pageSize the size in bytes of a page
+ * @param budget the memory budget in bytes of the cache
+ * @relates CatalogDB
+ */
+void CatalogDB_setCache(CatalogDB * catalogDB, size_t pageSize, size_t budget);
+
+/** Call a function for each record of the database in the order they are stored in the file
+ *
+ * The records are not visited in the order of their positions but in the order of
+ * their slots so that the file is read sequentially, page after page. The database
+ * stays locked for reading during the scan: the function must not modify it.
+ * @param catalogDB the database
+ * @param visitor the function called for each record
+ * @param data the data given to the function
+ * @return the number of records visited
+ * @relates CatalogDB
+ */
+int CatalogDB_forEach(CatalogDB * catalogDB, CatalogDB_Visitor visitor, void * data);
+
+/** Find a record by its code using the index of the database
+ * @param catalogDB the database
+ * @param code the code of the product
+ * @param record the record to fill with data if a product has this code, may be NULL
+ * @return the position of a product with this code, -1 if there is no such product
+ * @note The index is rebuilt from the database file if it was missing or out of date.
+ * @relates CatalogDB
+ */
+int CatalogDB_findRecordByCode(CatalogDB * catalogDB, const char * code, CatalogRecord * record);
+
+/** Search the products whose designation best matches a query
+ * @param catalogDB the database
+ * @param query the words to search, the last one may be the beginning of a word
+ * @param limit the maximum number of products to return
+ * @param recordIndexes the array of at least limit elements receiving the positions of the products, best match first
+ * @return the number of products found
+ * @note The case and the punctuation are ignored. The index is rebuilt from the database file if it was missing or out of date.
+ * @relates CatalogDB
+ */
+int CatalogDB_search(CatalogDB * catalogDB, const char * query, int limit, int * recordIndexes);
+
+/** Rewrite a closed database so that its records are stored densely in their logical order
+ *
+ * The removed slots are dropped and the slot table side file is deleted, so the
+ * database file gets back the plain layout of one record per slot.
+ * @param filename the file name of the database
+ * @return a non null value on success or if the database does not exist, 0 if it is locked by another process or can not be rewritten
+ * @relates CatalogDB
+ */
+int CatalogDB_compact(const char * filename);
+
 /** @} */
 
 #include <provided/CatalogDB.h>
@@ -0,0 +1,145 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_CATALOGINDEX_H
+#define FACTURATION_BASE_CATALOGINDEX_H
+
+#include <Config.h>
+#include <CatalogRecord.h>
+
+/** @defgroup CatalogIndex Index of the products by code
+ * @ingroup Catalog
+ *
+ * An open addressing hash table (linear probing) from the code of a product to the
+ * slot of the database file where the product is stored. Slots do not move when
+ * records are inserted or removed, so the index only changes for the modified record.
+ *
+ * The index is saved next to the database (Catalog.db gives Catalog.idx) together
+ * with the size and the modification time of the database file. An index which does
+ * not match the database file is ignored and rebuilt when it is first needed.
+ * @{
+ */
+
+/** The extension of the index file which replaces the extension of the database file */
+#define CATALOGINDEX_EXTENSION ".idx"
+
+/** An entry of the index */
+typedef struct
+{
+  char code[CATALOGRECORD_CODE_SIZE]; /**< The code of the product */
+  int slot; /**< The slot of one of the records with this code, -1 if the entry is empty */
+  int count; /**< The number of records with this code */
+} CatalogIndexEntry;
+
+/** The index of the products by code */
+typedef struct
+{
+  CatalogIndexEntry * entries; /**< The hash table */
+  int capacity; /**< The number of entries of the hash table, always a power of 2 */
+  int size; /**< The number of used entries */
+  int isValid; /**< True if the index describes the whole database */
+  int isModified; /**< True if the index changed since it was loaded */
+} CatalogIndex;
+
+/** Initialize an empty and invalid index
+ * @param catalogIndex the index
+ * @relates CatalogIndex
+ */
+void CatalogIndex_init(CatalogIndex * catalogIndex);
+
+/** Free the memory used by an index and make it invalid
+ * @param catalogIndex the index
+ * @relates CatalogIndex
+ */
+void CatalogIndex_finalize(CatalogIndex * catalogIndex);
+
+/** Remove all the entries of an index and make it valid
+ * @param catalogIndex the index
+ * @relates CatalogIndex
+ */
+void CatalogIndex_clear(CatalogIndex * catalogIndex);
+
+/** Create a new string on the heap containing the file name of the index of a database
+ * @param filename the file name of the database
+ * @return a new string
+ * @note The string is allocated using malloc().
+ * @warning the user is responsible for freeing the memory allocated for the new string
+ */
+char * CatalogIndex_getFilename(const char * filename);
+
+/** Load the index of a database if it matches the database file
+ * @param catalogIndex the index
+ * @param filename the file name of the database
+ * @return a non null value if the index is valid, 0 otherwise
+ * @relates CatalogIndex
+ */
+int CatalogIndex_load(CatalogIndex * catalogIndex, const char * filename);
+
+/** Save the index of a database, stamped with the current state of the database file
+ * @param catalogIndex the index
+ * @param filename the file name of the database which must be up to date on disk
+ * @relates CatalogIndex
+ */
+void CatalogIndex_save(CatalogIndex * catalogIndex, const char * filename);
+
+/** Remove the saved index of a database
+ * @param filename the file name of the database
+ */
+void CatalogIndex_remove(const char * filename);
+
+/** Get the size and the modification time of a database file, used to stamp the files built from it
+ *
+ * The nanoseconds tell apart two changes of the same size within the same second.
+ * @param filename the file name of the database
+ * @param databaseSize the size of the file
+ * @param databaseTime the modification time of the file
+ * @param databaseNanoseconds the nanoseconds of the modification time of the file
+ * @return a non null value on success, 0 otherwise
+ */
+int CatalogIndex_getDatabaseStamp(const char * filename, long * databaseSize, long * databaseTime, long * databaseNanoseconds);
+
+/** Find the entry of a code
+ * @param catalogIndex the index
+ * @param code the code
+ * @return the entry or NULL if no record has this code
+ * @relates CatalogIndex
+ */
+CatalogIndexEntry * CatalogIndex_find(CatalogIndex * catalogIndex, const char * code);
+
+/** Record that a slot holds a product with a given code
+ * @param catalogIndex the index
+ * @param code the code of the product
+ * @param slot the slot of the product
+ * @relates CatalogIndex
+ */
+void CatalogIndex_add(CatalogIndex * catalogIndex, const char * code, int slot);
+
+/** Record that a slot does not hold a product with a given code anymore
+ * @param catalogIndex the index
+ * @param code the code of the product
+ * @param slot the slot of the product
+ * @return a non null value if other records have this code but the entry pointed to the slot:
+ * the caller must find one of these records and update the slot of the entry
+ * @relates CatalogIndex
+ */
+int CatalogIndex_delete(CatalogIndex * catalogIndex, const char * code, int slot);
+
+/** @} */
+
+#endif
@@ -195,6 +195,20 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(CatalogRecord_read)(CatalogRecord * record,
  */
 OVERRIDABLE_PREFIX void OVERRIDABLE(CatalogRecord_write)(CatalogRecord * record, FILE * file);
 
+/** Encode a record in memory using the same packed layout as CatalogRecord_write()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CATALOGRECORD_SIZE bytes receiving the data
+ * @relates CatalogRecord
+ */
+void CatalogRecord_encode(CatalogRecord * record, char * buffer);
+
+/** Decode a record from memory using the same packed layout as CatalogRecord_read()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CATALOGRECORD_SIZE bytes containing the data
+ * @relates CatalogRecord
+ */
+void CatalogRecord_decode(CatalogRecord * record, const char * buffer);
+
 /** @} */
 
 #include <provided/CatalogRecord.h>
@@ -0,0 +1,116 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_CATALOGSNAPSHOT_H
+#define FACTURATION_BASE_CATALOGSNAPSHOT_H
+
+#include <Config.h>
+#include <CatalogDB.h>
+#include <CatalogRecordEditor.h>
+
+/** @defgroup CatalogSnapshot In-memory copy of the catalog organized by column
+ * @ingroup Catalog
+ *
+ * A snapshot reads the whole catalog once and stores each field in its own array:
+ * the strings are packed in a single arena and referenced by their offset, the
+ * numbers are stored in contiguous arrays of doubles. Sorting or filtering the
+ * products then only touches the needed column in memory.
+ *
+ * The order of the products by a field is computed when first asked for and kept
+ * as a permutation of the record positions. A snapshot is not updated when the
+ * database changes: it must be created again.
+ * @{
+ */
+
+/** An in-memory copy of a catalog organized by column */
+typedef struct
+{
+  int recordCount; /**< The number of records */
+  char * arena; /**< The null terminated strings of all the records */
+  size_t arenaSize; /**< The used size of arena */
+  size_t * codes; /**< The offset in arena of the code of each record */
+  size_t * designations; /**< The offset in arena of the designation of each record */
+  size_t * unities; /**< The offset in arena of the unity of each record */
+  double * basePrices; /**< The base price of each record */
+  double * sellingPrices; /**< The selling price of each record */
+  double * ratesOfVAT; /**< The rate of VAT of each record */
+  int * orders[CATALOGRECORD_FIELDCOUNT]; /**< The record positions sorted by each field, NULL until first needed */
+} CatalogSnapshot;
+
+/** Create a snapshot of a catalog by reading all its records
+ * @param catalogDB the database
+ * @return the new snapshot
+ * @relates CatalogSnapshot
+ */
+CatalogSnapshot * CatalogSnapshot_create(CatalogDB * catalogDB);
+
+/** Free the memory used by a snapshot
+ * @param snapshot the snapshot
+ * @relates CatalogSnapshot
+ */
+void CatalogSnapshot_destroy(CatalogSnapshot * snapshot);
+
+/** Get the code of a record of a snapshot
+ * @param snapshot the snapshot
+ * @param recordIndex the position of the record
+ * @return the code, stored in the snapshot
+ * @relates CatalogSnapshot
+ */
+const char * CatalogSnapshot_getCode(CatalogSnapshot * snapshot, int recordIndex);
+
+/** Get the designation of a record of a snapshot
+ * @param snapshot the snapshot
+ * @param recordIndex the position of the record
+ * @return the designation, stored in the snapshot
+ * @relates CatalogSnapshot
+ */
+const char * CatalogSnapshot_getDesignation(CatalogSnapshot * snapshot, int recordIndex);
+
+/** Get the unity of a record of a snapshot
+ * @param snapshot the snapshot
+ * @param recordIndex the position of the record
+ * @return the unity, stored in the snapshot
+ * @relates CatalogSnapshot
+ */
+const char * CatalogSnapshot_getUnity(CatalogSnapshot * snapshot, int recordIndex);
+
+/** Get the positions of the records sorted by increasing value of a field
+ *
+ * The strings are compared without case. Records with the same value keep the
+ * order of their positions.
+ * @param snapshot the snapshot
+ * @param field the field
+ * @return the array of the recordCount positions, owned by the snapshot
+ * @relates CatalogSnapshot
+ */
+const int * CatalogSnapshot_getOrder(CatalogSnapshot * snapshot, int field);
+
+/** Find the records whose code or designation contains a text, without case
+ * @param snapshot the snapshot
+ * @param text the text to find
+ * @param order the order in which the records are returned as given by CatalogSnapshot_getOrder(), NULL for the order of the positions
+ * @param recordIndexes the array of at least recordCount elements receiving the positions of the records found
+ * @return the number of records found
+ * @relates CatalogSnapshot
+ */
+int CatalogSnapshot_filter(CatalogSnapshot * snapshot, const char * text, const int * order, int * recordIndexes);
+
+/** @} */
+
+#endif
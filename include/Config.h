@@ -26,6 +26,8 @@
  */
 
 
+/* Expose the POSIX functions used by the databases (threads, pread()) in spite of the strict C89 mode */
+#define _XOPEN_SOURCE 600
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -90,6 +92,24 @@ extern const char * STUDENT_GROUP;
  */
 #define MAXVALUE(x, y) (((x)>(y))?(x):(y))
 
+/**
+ * Compute the minimal value of the two parameters
+ * @param x the first parameter
+ * @param y the second parameter
+ */
+#define MINVALUE(x, y) (((x)<(y))?(x):(y))
+
+/**
+ * Get the nanoseconds of the modification time of a file, 0 if the C library does not give them
+ * @param status the pointer on the struct stat of the file
+ * @note _XOPEN_SOURCE 600 hides st_mtim, the GNU C library giving the nanoseconds as st_mtimensec
+ */
+#ifdef __GLIBC__
+#define getModificationNanoseconds(status) ((long)(status)->st_mtimensec)
+#else
+#define getModificationNanoseconds(status) 0L
+#endif
+
 #define OVERRIDABLE_PREFIX extern
 #define OVERRIDABLE(functionname) (*functionname)
 #define IMPLEMENT(functionname) user_ ## functionname
@@ -99,11 +119,15 @@ extern const char * STUDENT_GROUP;
  */
 void setupOverridable(void);
 
-/* Include these two prototypes since string.h can not be included without errors. */
+/* Include these prototypes since string.h can not be included without errors. */
+void *memcpy(void *dest, const void *src, size_t n);
 void *memmove(void *dest, const void *src, size_t n);
+int memcmp(const void *s1, const void *s2, size_t n);
 void *memset(void *s, int c, size_t n);
 /* Include a prototype which is not standard in C89 but available on gcc. */
 int snprintf(char *str, size_t size, const char *format, ...);
+/* Include a prototype which is not standard in C89 but available on POSIX systems. */
+int fileno(FILE *stream);
 
 
 /* Replace the standard strcmp() function with our function */
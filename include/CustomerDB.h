@@ -22,9 +22,16 @@
 
 #include <Config.h>
 #include <CustomerRecord.h>
+#include <SlotTable.h>
+#include <WriteAheadLog.h>
+#include <DatabaseLock.h>
+#include <BlockCache.h>
 
 /** @defgroup CustomerDB Customer database
  * @ingroup Customer
+ *
+ * An opened database can be used by several threads at the same time as described
+ * in @ref DatabaseLock, except for CustomerDB_close().
  * @{
  */
 
@@ -35,9 +42,24 @@ extern const char * CUSTOMERDB_FILENAME;
 typedef struct
 {
   FILE * file; /**< The FILE pointer for the associated file */
+  char * filename; /**< The file name of the database */
   int recordCount; /**< The number of record in the database */
+  SlotTable slots; /**< The slot where each record is stored in the file */
+  WriteAheadLog log; /**< The log of the changes done since the last checkpoint */
+  DatabaseLock lock; /**< The locks protecting the database from the other threads and processes */
+  BlockCache cache; /**< The cache of the pages of the file through which the records are read */
+  int isModified; /**< True if the database changed since it was opened */
+  char * batchBuffer; /**< The encoded records of the current batch not yet written, NULL outside a batch */
+  int batchCount; /**< The number of records stored in batchBuffer */
+  int pendingSlots[WRITEAHEADLOG_GROUP_SIZE]; /**< The slots changed by the entries of the log not yet forced to the disk */
+  int pendingRemovals[WRITEAHEADLOG_GROUP_SIZE]; /**< True for the pending slots which receive a tombstone */
+  char pendingRecords[WRITEAHEADLOG_GROUP_SIZE * CUSTOMERRECORD_SIZE]; /**< The encoded records written in the pending slots */
+  int pendingCount; /**< The number of pending slots, written in place once their log entries are on the disk */
 } CustomerDB;
 
+/** The number of records buffered by a batch before they are written to the file */
+#define CUSTOMERDB_BATCH_SIZE 2048
+
 /** Create a database of customers
  * @param filename the file name of the database
  * @return a pointer on a CustomerDB representing the opened database, NULL otherwise
@@ -50,6 +72,13 @@ OVERRIDABLE_PREFIX CustomerDB * OVERRIDABLE(CustomerDB_create)(const char * file
  * @relates CustomerDB
  */
 OVERRIDABLE_PREFIX CustomerDB * OVERRIDABLE(CustomerDB_open)(const char * filename);
+/** Open an existing database of customers and lock its file according to an access mode
+ * @param filename the file name of the database
+ * @param access the access mode
+ * @return a pointer on a CustomerDB representing the opened database, NULL if the file can not be opened or is locked by another process
+ * @relates CustomerDB
+ */
+CustomerDB * CustomerDB_openWithAccess(const char * filename, DatabaseAccess access);
 /** Open if exists or create otherwise a database of customers
  * @param filename the file name of the database
  * @return a pointer on a CustomerDB representing the opened database, NULL otherwise
@@ -119,6 +148,58 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(CustomerDB_readRecord)(CustomerDB * customer
  */
 OVERRIDABLE_PREFIX void OVERRIDABLE(CustomerDB_writeRecord)(CustomerDB * customerDB, int recordIndex, CustomerRecord * record);
 
+/** Start a batch of appends on the database
+ *
+ * Records appended until CustomerDB_commitBatch() are encoded in memory and written
+ * to the file with large sequential writes. They are counted in the number of
+ * records of the database as soon as they are appended. They are not logged: the
+ * commit saves them with a checkpoint and a crash before it loses the whole batch.
+ * @param customerDB the database
+ * @relates CustomerDB
+ */
+void CustomerDB_beginBatch(CustomerDB * customerDB);
+
+/** Append several records at the end of the database
+ * @param customerDB the database
+ * @param records the array of records to append
+ * @param count the number of records in the array
+ * @note Outside a batch, the records are appended as a single batch.
+ * @relates CustomerDB
+ */
+void CustomerDB_appendMany(CustomerDB * customerDB, CustomerRecord * records, int count);
+
+/** Write the pending records of the current batch and update the header of the database file
+ * @param customerDB the database
+ * @relates CustomerDB
+ */
+void CustomerDB_commitBatch(CustomerDB * customerDB);
+
+/** Force the logged changes of the database to the disk so that they survive a crash
+ *
+ * The log is otherwise forced once for each group of WRITEAHEADLOG_GROUP_SIZE changes.
+ * @param customerDB the database
+ * @relates CustomerDB
+ */
+void CustomerDB_sync(CustomerDB * customerDB);
+
+/** Replace the cache through which the records of the database are read
+ * @param customerDB the database
+ * @param pageSize the size in bytes of a page
+ * @param budget the memory budget in bytes of the cache
+ * @relates CustomerDB
+ */
+void CustomerDB_setCache(CustomerDB * customerDB, size_t pageSize, size_t budget);
+
+/** Rewrite a closed database so that its records are stored densely in their logical order
+ *
+ * The removed slots are dropped and the slot table side file is deleted, so the
+ * database file gets back the plain layout of one record per slot.
+ * @param filename the file name of the database
+ * @return a non null value on success or if the database does not exist, 0 if it is locked by another process or can not be rewritten
+ * @relates CustomerDB
+ */
+int CustomerDB_compact(const char * filename);
+
 /** @} */
 
 #include <provided/CustomerDB.h>
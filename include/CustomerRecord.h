@@ -144,6 +144,20 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(CustomerRecord_read)(CustomerRecord * record
  */
 OVERRIDABLE_PREFIX void OVERRIDABLE(CustomerRecord_write)(CustomerRecord * record, FILE * file);
 
+/** Encode a record in memory using the same packed layout as CustomerRecord_write()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CUSTOMERRECORD_SIZE bytes receiving the data
+ * @relates CustomerRecord
+ */
+void CustomerRecord_encode(CustomerRecord * record, char * buffer);
+
+/** Decode a record from memory using the same packed layout as CustomerRecord_read()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CUSTOMERRECORD_SIZE bytes containing the data
+ * @relates CustomerRecord
+ */
+void CustomerRecord_decode(CustomerRecord * record, const char * buffer);
+
 /** @} */
 
 #include <provided/CustomerRecord.h>
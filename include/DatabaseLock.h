@@ -0,0 +1,131 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_DATABASELOCK_H
+#define FACTURATION_BASE_DATABASELOCK_H
+
+#include <Config.h>
+
+#include <pthread.h>
+
+/** @defgroup DatabaseLock Concurrent access to a record database
+ *
+ * An opened database can be shared by several threads: the reading functions take
+ * a reader-writer lock in read mode and read the file with pread() so that they
+ * do not depend on the position of the FILE, the modifying functions take it in
+ * write mode.
+ *
+ * Between processes, a database opened as a reader holds a shared advisory lock
+ * on its file and refuses any change while a database opened as a writer holds an
+ * exclusive one. Several processes can therefore read a database at the same time
+ * but a writer is alone. A database opened without access mode does not lock its file.
+ * @{
+ */
+
+/** The ways a process can access a database file */
+typedef enum
+{
+  DATABASE_PRIVATE = 0, /**< The file is not locked, the caller ensures that no other process uses it */
+  DATABASE_READER = 1, /**< The file is shared with the other readers and can not be changed */
+  DATABASE_WRITER = 2 /**< The file is used by this process only */
+} DatabaseAccess;
+
+/** The locks of an opened database */
+typedef struct
+{
+  pthread_rwlock_t lock; /**< The lock shared by the threads using the database */
+  DatabaseAccess access; /**< The access mode of the database */
+  int fd; /**< The file descriptor of the locked file, -1 if the file is not locked */
+  int isExclusive; /**< True if the file is locked exclusively */
+} DatabaseLock;
+
+/** Initialize the locks of a database
+ * @param lock the locks
+ * @param access the access mode
+ * @relates DatabaseLock
+ */
+void DatabaseLock_init(DatabaseLock * lock, DatabaseAccess access);
+
+/** Release the lock of the file and free the resources used by the locks of a database
+ * @param lock the locks
+ * @relates DatabaseLock
+ */
+void DatabaseLock_finalize(DatabaseLock * lock);
+
+/** Lock a database file according to the access mode without waiting
+ *
+ * A reader first tries to lock the file exclusively so that it can repair the file
+ * left by a crashed writer, it then calls DatabaseLock_shareFile().
+ * @param lock the locks
+ * @param file the database file
+ * @return a non null value on success, 0 if another process holds an incompatible lock
+ * @relates DatabaseLock
+ */
+int DatabaseLock_lockFile(DatabaseLock * lock, FILE * file);
+
+/** Tell if the file can be changed, either by the functions of the database or to repair it
+ * @param lock the locks
+ * @return a non null value if the file can be changed
+ * @relates DatabaseLock
+ */
+int DatabaseLock_canWriteFile(DatabaseLock * lock);
+
+/** Downgrade the exclusive lock taken by a reader to a shared lock
+ * @param lock the locks
+ * @return a non null value on success, 0 if the shared lock could not be taken
+ * @relates DatabaseLock
+ */
+int DatabaseLock_shareFile(DatabaseLock * lock);
+
+/** Wait until no thread modifies the database and prevent any modification
+ * @param lock the locks
+ * @relates DatabaseLock
+ */
+void DatabaseLock_beginRead(DatabaseLock * lock);
+
+/** End a reading started by DatabaseLock_beginRead()
+ * @param lock the locks
+ * @relates DatabaseLock
+ */
+void DatabaseLock_endRead(DatabaseLock * lock);
+
+/** Wait until no other thread uses the database and prevent any other access
+ * @param lock the locks
+ * @note A fatal error is raised if the database is opened as a reader.
+ * @relates DatabaseLock
+ */
+void DatabaseLock_beginWrite(DatabaseLock * lock);
+
+/** Wait until no other thread uses the database and prevent any other access, even for a reader
+ *
+ * It protects the structures kept in memory only, such as the indexes built on the fly.
+ * @param lock the locks
+ * @relates DatabaseLock
+ */
+void DatabaseLock_beginExclusive(DatabaseLock * lock);
+
+/** End a modification started by DatabaseLock_beginWrite() or DatabaseLock_beginExclusive()
+ * @param lock the locks
+ * @relates DatabaseLock
+ */
+void DatabaseLock_endWrite(DatabaseLock * lock);
+
+/** @} */
+
+#endif
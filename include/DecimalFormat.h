@@ -0,0 +1,69 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#ifndef FACTURATION_BASE_DECIMALFORMAT_H
+#define FACTURATION_BASE_DECIMALFORMAT_H
+
+#include <Config.h>
+
+/** @defgroup DecimalFormat Conversion of the numbers into decimal text
+ * @ingroup Format
+ *
+ * The numbers of the documents are written without going through the format
+ * strings of sprintf(). A number with a fixed number of decimals is scaled by a
+ * power of ten and rounded as an integer, which gives the same text as "%.*f" as
+ * long as the scaled value is below 2^52 and is not exactly halfway between two
+ * integers; the other numbers are left to sprintf().
+ *
+ * The shortest form is the decimal number with the fewest decimals which is read
+ * back as the same double. When it needs more than DECIMALFORMAT_FAST_PRECISION
+ * decimals, the first of "%.15g", "%.16g" and "%.17g" which is read back as the same
+ * double is used.
+ * @{
+ */
+
+/** The precision asking for the shortest decimal number which is read back as the same double */
+#define DECIMALFORMAT_SHORTEST (-1)
+
+/** The maximal number of decimals, a larger precision being reduced to it */
+#define DECIMALFORMAT_MAX_PRECISION 30
+
+/** The maximal number of decimals handled without sprintf() */
+#define DECIMALFORMAT_FAST_PRECISION 15
+
+/** The size of a buffer large enough for any number without padding */
+#define DECIMALFORMAT_BUFFER_SIZE 400
+
+/** Write a number in decimal notation
+ *
+ * The output is truncated to the size of the buffer but the returned length is
+ * always the length of the whole output, as snprintf() does.
+ * @param buffer the buffer receiving the null terminated text, may be NULL if bufferSize is 0
+ * @param bufferSize the size of the buffer
+ * @param value the number
+ * @param precision the number of decimals, or DECIMALFORMAT_SHORTEST
+ * @param width the minimal length of the text, padded with spaces on the left
+ * @return the length of the whole text
+ */
+size_t DecimalFormat_write(char * buffer, size_t bufferSize, double value, int precision, int width);
+
+/** @} */
+
+#endif
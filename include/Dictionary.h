@@ -53,13 +53,31 @@ typedef struct
   } value;
 } DictionaryEntry;
 
-/** Structure representing a dictionary */
+/** Structure representing a dictionary
+ *
+ * The entries are stored in the order of their definition. They are found through
+ * an open addressing hash table of their names, hashed without case, whose size
+ * doubles when it is half full. The names of the entries are interned: they are
+ * shared by all the dictionaries of the process and never freed. The strings values
+ * are kept between two changes of an entry so that a dictionary refilled with the
+ * same names does not allocate anymore.
+ */
 typedef struct _Dictionary
 {
   /** The number of entries of the dictionary */
   int count;
   /** The table of entries */
   DictionaryEntry * entries;
+  /** The number of allocated entries */
+  int capacity;
+  /** The hash of the name of each entry */
+  unsigned int * hashes;
+  /** The allocated size of the string value of each entry, 0 if none */
+  size_t * valueSizes;
+  /** The hash table giving for each slot the index of an entry or -1 if the slot is empty */
+  int * slots;
+  /** The number of slots minus one, the number of slots being a power of 2 */
+  int slotMask;
 } Dictionary;
 
 /** Create an empty dictionary on the heap
@@ -101,6 +119,34 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(Dictionary_setNumberEntry)(Dictionary * dict
  */
 OVERRIDABLE_PREFIX char * OVERRIDABLE(Dictionary_format)(Dictionary * dictionary, const char * format);
 
+/** Compute the hash of the name of an entry without case
+ * @param name the name
+ * @return the hash
+ */
+unsigned int Dictionary_hashName(const char * name);
+
+/** Get the interned copy of the name of an entry, adding it to the pool if needed
+ * @param name the name
+ * @return the copy of the name shared by all the dictionaries, never freed
+ */
+const char * Dictionary_internName(const char * name);
+
+/** Get a pointer on the entry associated with the given entry name whose hash is known
+ *
+ * The lookup does not compare the characters of the names when name is interned
+ * and defined with the same case.
+ * @param dictionary the dictionary
+ * @param name the name of the entry, preferably interned
+ * @param hash the hash of the name given by Dictionary_hashName()
+ * @return a pointer on the entry or NULL if the entry was not found
+ */
+DictionaryEntry * Dictionary_getEntryWithHash(Dictionary * dictionary, const char * name, unsigned int hash);
+
+/** Remove all the entries of a dictionary but keep its memory for the next entries
+ * @param dictionary the dictionary
+ */
+void Dictionary_clear(Dictionary * dictionary);
+
 /** @} */
 
 #include <provided/Dictionary.h>
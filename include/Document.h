@@ -31,6 +31,39 @@
  * @{
  */
 
+/** The bytes starting the files of the documents since the version 2 of their format
+ *
+ * The files of the version 1 start directly with the name of the customer which cannot
+ * begin with the DEL character.
+ */
+#define DOCUMENT_MAGIC "\177FACTDOC"
+
+/** The number of bytes of DOCUMENT_MAGIC */
+#define DOCUMENT_MAGIC_SIZE 8
+
+/** The version of the format of the files written by Document_saveToFile()
+ *
+ * A file of the version 3 contains DOCUMENT_MAGIC, the version and the type of the
+ * document on one byte each, then the size in bytes of the rest of the header written by
+ * writeVarint(). The rest of the header is the number of rows written by writeVarint(),
+ * the totals without VAT, of VAT and with VAT written by writeBinaryInteger(), the
+ * customer as written by CustomerRecord_write(), and the edit date, the expiry date, the
+ * document number, the object and the operator written by writeCompactString(). The
+ * rows written by DocumentRow_writeCompactRow() follow the header.
+ *
+ * A file of the version 2 contains the version and the type, the customer, the strings
+ * of the header, the number of rows and the rows, written as in the version 3.
+ *
+ * A file of the version 1 contains the customer, the strings of the header written by
+ * writeString() and the rows written by DocumentRow_writeRow().
+ *
+ * The files of the versions 1 and 2 can still be loaded.
+ */
+#define DOCUMENT_FORMAT_VERSION 3
+
+/** The number of bytes read at first by Document_loadHeaderFromFile(), enough for most headers */
+#define DOCUMENT_HEADER_READ_SIZE 4096
+
 /** Enumeration defining the type of a document */
 typedef enum
 {
@@ -49,6 +82,7 @@ typedef struct
   char * operator /** The last operator */;
   DocumentRow * rows /** The rows */;
   TypeDocument typeDocument /** The type of document */;
+  StringArena * arena /** The arena of the strings of the header and of the loaded rows, NULL if they are allocated with malloc() */;
 } Document;
 
 /** Initialize a document
@@ -71,12 +105,89 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(Document_finalize)(Document * document);
 OVERRIDABLE_PREFIX void OVERRIDABLE(Document_saveToFile)(Document * document, const char * filename);
 
 /** Load the content of a document from a file
+ *
+ * The files of the versions 1 and 2 of the format are recognized.
  * @param document the document to fill
  * @param filename the file name
  * @warning document must have been initialized
  */
 OVERRIDABLE_PREFIX void OVERRIDABLE(Document_loadFromFile)(Document * document, const char * filename);
 
+/** Load the content of a document from a file which may be missing, truncated or corrupted
+ *
+ * Unlike Document_loadFromFile(), an unreadable file is not a fatal error. The document
+ * may then be partially filled and must still be finalized.
+ * @param document the document to fill
+ * @param filename the file name
+ * @return a non null value on success, 0 if the file cannot be read
+ * @warning document must have been initialized
+ */
+int Document_tryLoadFromFile(Document * document, const char * filename);
+
+/** Load the header of a document from a file without its rows
+ *
+ * Only the header is read from the files of the version 3 of the format. The files of
+ * the older versions are read entirely to count the rows and compute the totals.
+ * @param document the document to fill, its list of rows being left empty
+ * @param filename the file name
+ * @param totals the totals of the rows of the document to fill
+ * @return the number of rows of the document
+ * @warning document must have been initialized
+ */
+int Document_loadHeaderFromFile(Document * document, const char * filename, MoneyTotals * totals);
+
+/** Load the header of a document from a file which may be missing, truncated or corrupted
+ *
+ * Unlike Document_loadHeaderFromFile(), an unreadable file is not a fatal error. The
+ * document may then be partially filled and must still be finalized.
+ * @param document the document to fill, its list of rows being left empty
+ * @param filename the file name
+ * @param totals the totals of the rows of the document to fill
+ * @return the number of rows of the document, -1 if the file cannot be read
+ * @warning document must have been initialized
+ */
+int Document_tryLoadHeaderFromFile(Document * document, const char * filename, MoneyTotals * totals);
+
+/** Make the strings of a document allocated from an arena
+ *
+ * The strings of the header and of the rows are moved into the arena. The strings read
+ * by Document_loadFromFile() are then carved from the arena and freed all at once by
+ * Document_finalize(). The strings of a document with an arena must only be changed with
+ * the setters of Document and DocumentRow.
+ * @param document the document
+ */
+void Document_enableArena(Document * document);
+
+/** Set the edit date of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_editDate(Document * document, const char * value);
+
+/** Set the expiry date of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_expiryDate(Document * document, const char * value);
+
+/** Set the number of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_docNumber(Document * document, const char * value);
+
+/** Set the object of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_object(Document * document, const char * value);
+
+/** Set the operator of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_operator(Document * document, const char * value);
+
 /** @} */
 
 #include <provided/Document.h>
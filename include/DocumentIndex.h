@@ -0,0 +1,197 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_DOCUMENTINDEX_H
+#define FACTURATION_BASE_DOCUMENTINDEX_H
+
+#include <Config.h>
+#include <Document.h>
+#include <StringArena.h>
+
+/** @defgroup DocumentIndex Index of the documents of a directory
+ * @ingroup Documents
+ *
+ * The index keeps in the file DOCUMENTINDEX_FILENAME of the directory of the documents
+ * what the selection dialogs show about each bill and quotation, so that they do not
+ * load every document file.
+ *
+ * The type of a document is given by the prefix of its file name. A saved document
+ * appends its entry to the journal DOCUMENTINDEX_JOURNAL_FILENAME with
+ * DocumentIndex_record() so that a save does not rewrite the whole index file. The
+ * journal is applied when an index is opened and folded into the index file when it is
+ * saved. An entry is also updated in memory with DocumentIndex_update(), and
+ * DocumentIndex_refresh() loads again the documents whose modification time, to the
+ * nanosecond, or size changed since they were indexed. An index file of another
+ * version, or a truncated or corrupted one, is rebuilt.
+ *
+ * The headers of the documents to load are read by a pool of worker threads. A
+ * listener given to DocumentIndex_refreshWith() receives the entries by batches of at
+ * most DOCUMENTINDEX_BATCH_SIZE as soon as they are known: first the unchanged ones,
+ * then the loaded ones in the order they complete. The selection dialogs use it to
+ * fill their list while the directory is still being scanned.
+ * @{
+ */
+
+/** The name of the index file in the directory of the documents */
+#define DOCUMENTINDEX_FILENAME "documents.idx"
+
+/** The name of the file of the directory of the documents to which the saved documents append their entry */
+#define DOCUMENTINDEX_JOURNAL_FILENAME "documents.idx.journal"
+
+/** The bytes starting an index file */
+#define DOCUMENTINDEX_MAGIC "\177FACTIDX"
+
+/** The number of bytes of DOCUMENTINDEX_MAGIC */
+#define DOCUMENTINDEX_MAGIC_SIZE 8
+
+/** The version of the format of the index files */
+#define DOCUMENTINDEX_FORMAT_VERSION 2
+
+/** The prefix of the file names of the bills */
+#define DOCUMENTINDEX_BILL_PREFIX "bill-"
+
+/** The prefix of the file names of the quotations */
+#define DOCUMENTINDEX_QUOTATION_PREFIX "quotation-"
+
+/** The suffix of the file names of the documents */
+#define DOCUMENTINDEX_SUFFIX ".dat"
+
+/** The maximal number of worker threads loading the documents of a refresh */
+#define DOCUMENTINDEX_MAX_THREADS 64
+
+/** The maximal number of entries given at once to the listener of a refresh */
+#define DOCUMENTINDEX_BATCH_SIZE 64
+
+/** What the index keeps about a document */
+typedef struct
+{
+  char * filename; /**< The name of the document file in the directory */
+  TypeDocument typeDocument; /**< The type of the document */
+  char * docNumber; /**< The document number */
+  char * customerName; /**< The name of the customer */
+  char * editDate; /**< The last edit date */
+  char * expiryDate; /**< The expiry date */
+  char * object; /**< The object of the document */
+  MoneyTotals totals; /**< The totals of the rows */
+  long modificationTime; /**< The modification time of the file when it was indexed */
+  long modificationNanoseconds; /**< The nanoseconds of the modification time of the file when it was indexed */
+  long fileSize; /**< The size of the file when it was indexed */
+} DocumentIndexEntry;
+
+/** The index of the documents of a directory */
+typedef struct
+{
+  char * directory; /**< The directory of the documents */
+  StringArena * arena; /**< The strings of the entries */
+  DocumentIndexEntry * entries; /**< The entries sorted by file name */
+  int count; /**< The number of entries */
+  int capacity; /**< The allocated number of entries */
+  int isModified; /**< A non null value if the entries differ from the index file */
+} DocumentIndex;
+
+/** The function receiving the entries of an index during a refresh
+ *
+ * It is called from the calling thread of the refresh or from one of its workers,
+ * never by two threads at once.
+ * @param entries the copies of the entries, valid until the function returns
+ * @param count the number of entries
+ * @param data the data given to DocumentIndex_refreshWith()
+ */
+typedef void (*DocumentIndexListener)(const DocumentIndexEntry * entries, int count, void * data);
+
+/** Open the index of a directory, reading its index file if there is a valid one
+ * @param directory the directory of the documents
+ * @return the new index
+ * @relates DocumentIndex
+ */
+DocumentIndex * DocumentIndex_open(const char * directory);
+
+/** Save the index file if the index changed and free the memory used by an index
+ * @param documentIndex the index
+ * @relates DocumentIndex
+ */
+void DocumentIndex_close(DocumentIndex * documentIndex);
+
+/** Write the index file of an index
+ *
+ * The entries written in the index file by another index since this one was opened
+ * are merged first, the entry of the most recently modified document being kept, so
+ * that an index opened for a long refresh does not undo the update of a document saved
+ * meanwhile. The threads and the processes writing the index file are serialized.
+ * @param documentIndex the index
+ * @return a non null value on success, 0 if the file cannot be written
+ * @warning the entries of the index are moved
+ * @relates DocumentIndex
+ */
+int DocumentIndex_save(DocumentIndex * documentIndex);
+
+/** Update the entry of a document which was just saved
+ * @param documentIndex the index
+ * @param filename the name of the document file in the directory
+ * @param document the document
+ * @relates DocumentIndex
+ */
+void DocumentIndex_update(DocumentIndex * documentIndex, const char * filename, Document * document);
+
+/** Append the entry of a document which was just saved to the journal of the index of its directory
+ *
+ * Only the entry is written, the index file being updated when an index of the directory
+ * is next saved.
+ * @param directory the directory of the documents
+ * @param filename the name of the document file in the directory
+ * @param document the document
+ * @return a non null value on success, 0 if the journal cannot be written
+ */
+int DocumentIndex_record(const char * directory, const char * filename, Document * document);
+
+/** Check the index against the document files of its directory
+ *
+ * The documents which are new or whose file changed are loaded and the entries of the
+ * removed files are dropped.
+ * @param documentIndex the index
+ * @return the number of loaded documents, -1 if the directory cannot be listed
+ * @relates DocumentIndex
+ */
+int DocumentIndex_refresh(DocumentIndex * documentIndex);
+
+/** Check the index against the document files of its directory, loading the changed documents in parallel
+ *
+ * The documents which are new or whose file changed are loaded by a pool of worker
+ * threads and the entries of the removed files are dropped. Every entry of the
+ * refreshed index is given once to the listener.
+ * @param documentIndex the index
+ * @param threadCount the number of worker threads, 0 for one per processor
+ * @param listener the function receiving the entries, NULL if none
+ * @param data the data given to the listener
+ * @return the number of loaded documents, -1 if the directory cannot be listed
+ * @relates DocumentIndex
+ */
+int DocumentIndex_refreshWith(DocumentIndex * documentIndex, int threadCount, DocumentIndexListener listener, void * data);
+
+/** Find the entry of a document file
+ * @param documentIndex the index
+ * @param filename the name of the document file in the directory
+ * @return the entry, NULL if the file is not indexed
+ * @relates DocumentIndex
+ */
+DocumentIndexEntry * DocumentIndex_find(DocumentIndex * documentIndex, const char * filename);
+
+/** @} */
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_DOCUMENTREADER_H
+#define FACTURATION_BASE_DOCUMENTREADER_H
+
+#include <Config.h>
+#include <StringArena.h>
+
+/** @defgroup DocumentReader Parsing of a document file held in memory
+ * @ingroup Documents
+ *
+ * The whole file is mapped in memory, or read with a single system call when it cannot
+ * be mapped, and its fields are parsed from the memory. A field which goes past the end
+ * of the file, or which is malformed, marks the reader as corrupted: the fields read
+ * after it are empty so that the parsing ends normally and the caller then checks
+ * isCorrupted.
+ * @{
+ */
+
+/** The maximal number of bytes read at once by DocumentReader_readBytes() */
+#define DOCUMENTREADER_MAX_FIXED_SIZE 512
+
+/** A document file held in memory */
+typedef struct
+{
+  const char * data; /**< The content of the file */
+  size_t size; /**< The size of the file */
+  size_t position; /**< The position of the next field to read */
+  int isMapped; /**< A non null value if data is a mapping of the file, 0 if it is allocated with malloc() */
+  int isCorrupted; /**< A non null value once a field could not be read */
+} DocumentReader;
+
+/** Load a file in memory
+ * @param reader the reader to initialize
+ * @param filename the file name
+ * @return a non null value on success, 0 if the file cannot be read
+ * @relates DocumentReader
+ */
+int DocumentReader_open(DocumentReader * reader, const char * filename);
+
+/** Load the beginning of a file in memory
+ * @param reader the reader to initialize
+ * @param filename the file name
+ * @param size the maximum number of bytes to read
+ * @return a non null value on success, 0 if the file cannot be read
+ * @relates DocumentReader
+ */
+int DocumentReader_openPrefix(DocumentReader * reader, const char * filename, size_t size);
+
+/** Release the memory holding the file
+ * @param reader the reader
+ * @relates DocumentReader
+ */
+void DocumentReader_close(DocumentReader * reader);
+
+/** Tell if all the fields of the file have been read
+ * @param reader the reader
+ * @return a non null value at the end of the file
+ * @relates DocumentReader
+ */
+int DocumentReader_isAtEnd(DocumentReader * reader);
+
+/** Mark the file as corrupted, the fields read afterwards being empty
+ * @param reader the reader
+ * @relates DocumentReader
+ */
+void DocumentReader_setCorrupted(DocumentReader * reader);
+
+/** Read some bytes
+ * @param reader the reader
+ * @param size the number of bytes, at most DOCUMENTREADER_MAX_FIXED_SIZE
+ * @return the bytes, valid until the reader is closed, zeros if the file is corrupted
+ * @relates DocumentReader
+ */
+const char * DocumentReader_readBytes(DocumentReader * reader, size_t size);
+
+/** Read a string written by writeString()
+ * @param reader the reader
+ * @param arena the arena receiving the string, NULL to create the string on the heap
+ * @return the string
+ * @relates DocumentReader
+ */
+char * DocumentReader_readString(DocumentReader * reader, StringArena * arena);
+
+/** Read a number written as a string by writeString()
+ * @param reader the reader
+ * @return the number
+ * @relates DocumentReader
+ */
+double DocumentReader_readNumber(DocumentReader * reader);
+
+/** Read an unsigned integer written by writeVarint()
+ * @param reader the reader
+ * @return the integer
+ * @relates DocumentReader
+ */
+size_t DocumentReader_readVarint(DocumentReader * reader);
+
+/** Read a string written by writeCompactString()
+ * @param reader the reader
+ * @param arena the arena receiving the string, NULL to create the string on the heap
+ * @return the string
+ * @relates DocumentReader
+ */
+char * DocumentReader_readCompactString(DocumentReader * reader, StringArena * arena);
+
+/** Read an integer written by writeBinaryInteger()
+ * @param reader the reader
+ * @return the integer
+ * @relates DocumentReader
+ */
+long long DocumentReader_readBinaryInteger(DocumentReader * reader);
+
+/** Read a number written by writeBinaryNumber()
+ * @param reader the reader
+ * @return the number
+ * @relates DocumentReader
+ */
+double DocumentReader_readBinaryNumber(DocumentReader * reader);
+
+/** @} */
+
+#endif
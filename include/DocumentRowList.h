@@ -21,6 +21,9 @@
 #define FACTURATION_BASE_DOCUMENTROWLIST_H
 
 #include <Config.h>
+#include <Money.h>
+#include <StringArena.h>
+#include <DocumentReader.h>
 
 /** @defgroup DocumentRowList List of rows of a document
  * @see Document
@@ -28,6 +31,22 @@
  * @{
  */
 
+struct _DocumentRow;
+
+/** The array of the rows of a list giving their position in constant time
+ *
+ * It is owned by the first row of the list and moved to the new first row when the
+ * first row changes. The rows stay linked by their next field so that a list can
+ * still be traversed from its first row. A list must only be changed through the
+ * DocumentRowList functions.
+ */
+typedef struct
+{
+  struct _DocumentRow ** rows /** The rows in the order of the list */;
+  int count /** The number of rows */;
+  int capacity /** The allocated number of rows */;
+} DocumentRowVector;
+
 /** Structure representing a row in a document (as a cell in a simple linked list */
 typedef struct _DocumentRow
 {
@@ -40,6 +59,8 @@ typedef struct _DocumentRow
   double discount /** The discount */;
   double rateOfVAT /** The rate of VAT */;
   struct _DocumentRow * next /** The pointer to the next row */;
+  DocumentRowVector * vector /** The array of the rows of the list if the row is the first one of a list, NULL otherwise */;
+  StringArena * arena /** The arena of the code, the designation and the unity, NULL if they are allocated with malloc() */;
 } DocumentRow;
 
 /** Initialize a row
@@ -126,6 +147,61 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(DocumentRow_writeRow)(DocumentRow * row, FIL
  */
 OVERRIDABLE_PREFIX DocumentRow * OVERRIDABLE(DocumentRow_readRow)(FILE * file);
 
+/** Read a row from a file held in memory
+ * @param reader the reader of the file
+ * @param arena the arena receiving the strings of the row, NULL to allocate them with malloc()
+ * @return a new row created on the heap filled with the data
+ * @see DocumentRow_readRow()
+ */
+DocumentRow * DocumentRow_parseRow(DocumentReader * reader, StringArena * arena);
+
+/** Write a row in a file in the compact format of the version 2 of the document files
+ *
+ * The strings are written by writeCompactString() and the numbers by writeBinaryNumber().
+ * @param row the row
+ * @param file the opened file
+ */
+void DocumentRow_writeCompactRow(DocumentRow * row, FILE * file);
+
+/** Read a row written by DocumentRow_writeCompactRow() from a file held in memory
+ * @param reader the reader of the file
+ * @param arena the arena receiving the strings of the row, NULL to allocate them with malloc()
+ * @return a new row created on the heap filled with the data
+ */
+DocumentRow * DocumentRow_parseCompactRow(DocumentReader * reader, StringArena * arena);
+
+/** Set the code of a row, the copy being made in the arena of the row if it has one
+ * @param row the row
+ * @param value the value
+ */
+void DocumentRow_setValue_code(DocumentRow * row, const char * value);
+
+/** Set the designation of a row, the copy being made in the arena of the row if it has one
+ * @param row the row
+ * @param value the value
+ */
+void DocumentRow_setValue_designation(DocumentRow * row, const char * value);
+
+/** Set the unity of a row, the copy being made in the arena of the row if it has one
+ * @param row the row
+ * @param value the value
+ */
+void DocumentRow_setValue_unity(DocumentRow * row, const char * value);
+
+/** The number of rows converted at once by DocumentRowList_computeTotals() */
+#define DOCUMENTROWLIST_TOTALS_BLOCK 256
+
+/** Compute the exact totals of a list of rows
+ *
+ * The values of the rows are converted to Money by blocks of DOCUMENTROWLIST_TOTALS_BLOCK
+ * rows which are added with MoneyTotals_addRows().
+ * A row with a value out of the range of Money_tryFromDouble() is left out of the totals.
+ * @param list the pointer on the first cell of the list
+ * @param totals the totals to compute
+ * @return a non null value if all the rows are in the totals, 0 if a row was left out
+ */
+int DocumentRowList_computeTotals(DocumentRow * list, MoneyTotals * totals);
+
 /** @} */
 
 #include <provided/DocumentRowList.h>
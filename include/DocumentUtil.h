@@ -58,6 +58,42 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(writeString)(const char * str, FILE * file);
  */
 OVERRIDABLE_PREFIX char * OVERRIDABLE(readString)(FILE * file);
 
+/** Write an unsigned integer in a binary file using 7 bits per byte, the lowest bits first
+ * @param value the integer
+ * @param file the file
+ */
+void writeVarint(size_t value, FILE * file);
+
+/** Get the number of bytes written by writeVarint() for an integer
+ * @param value the integer
+ * @return the number of bytes
+ */
+size_t getVarintSize(size_t value);
+
+/** Get the number of bytes written by writeCompactString() for a string
+ * @param str the string
+ * @return the number of bytes
+ */
+size_t getCompactStringSize(const char * str);
+
+/** Write a string in a binary file with its length written by writeVarint()
+ * @param str the string
+ * @param file the file
+ */
+void writeCompactString(const char * str, FILE * file);
+
+/** Write an integer in a binary file on 8 bytes, the lowest byte first
+ * @param value the integer
+ * @param file the file
+ */
+void writeBinaryInteger(long long value, FILE * file);
+
+/** Write a number in a binary file as its 8 bytes IEEE 754 representation, the lowest byte first
+ * @param value the number
+ * @param file the file
+ */
+void writeBinaryNumber(double value, FILE * file);
+
 /** @} */
 
 #include <provided/DocumentUtil.h>
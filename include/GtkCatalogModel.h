@@ -22,6 +22,8 @@
 
 #include <Config.h>
 #include <CatalogDB.h>
+#include <RowCache.h>
+#include <CatalogSnapshot.h>
 
 /** @defgroup GtkCatalogModel A specialized treeview model backed by our data structure instead of GTK+ ones
  * GTK+ related stuff. It has no interest for the teaching.
@@ -54,6 +56,11 @@ struct _GtkCatalogModel {
   CatalogDB * catalogDB;
   int shouldCloseDB;
   gint stamp; /* Random integer to check whether an iter belongs to our model */
+  RowCache rowCache; /* The strings of the recently displayed rows */
+  CatalogSnapshot * snapshot; /* The columns of the catalog used to sort the rows, NULL until a sort is asked */
+  int * rows; /* The record displayed by each row, NULL while the rows follow the order of the records */
+  gint sortColumn; /* The sort column, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID if the rows are not sorted */
+  GtkSortType sortOrder; /* The sort order */
 };
 
 /* GtkCatalogModelClass: more boilerplate GObject stuff */
@@ -65,6 +72,8 @@ GType GtkCatalogModel_get_type(void);
 
 GtkCatalogModel *GtkCatalogModel_new(CatalogDB * catalogDB, int shouldCloseDB);
 
+gint GtkCatalogModel_get_record_index(GtkCatalogModel * custom_list, gint row);
+
 void GtkCatalogModel_remove_record(GtkCatalogModel * custom_list, gint recordIndex);
 void GtkCatalogModel_change_record(GtkCatalogModel * custom_list, gint recordIndex);
 void GtkCatalogModel_insert_record(GtkCatalogModel * custom_list, gint recordIndex);
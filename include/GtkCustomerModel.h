@@ -22,6 +22,7 @@
 
 #include <Config.h>
 #include <CustomerDB.h>
+#include <RowCache.h>
 
 /** @defgroup GtkCustomerModel A specialized treeview model backed by our data structure instead of GTK+ ones
  * GTK+ related stuff. It has no interest for the teaching.
@@ -54,6 +55,7 @@ struct _GtkCustomerModel {
         CustomerDB * clientDB;
         int shouldCloseDB;
         gint stamp; /* Random integer to check whether an iter belongs to our model */
+        RowCache rowCache; /* The strings of the recently displayed rows */
 };
 
 /* GtkCustomerModelClass: more boilerplate GObject stuff */
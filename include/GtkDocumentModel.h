@@ -0,0 +1,49 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id: GtkCustomerModel.h 247 2010-09-10 10:23:07Z sebtic $
+ */
+
+#ifndef FACTURATION_GTKDOCUMENTMODEL_H
+#define FACTURATION_GTKDOCUMENTMODEL_H
+
+#include <Config.h>
+#include <Document.h>
+
+/** @defgroup GtkDocumentModel The list of the documents shown by the selection dialogs
+ * GTK+ related stuff. It has no interest for the teaching.
+ * @ingroup Documents
+ *
+ * The list is returned empty so that the dialog opens at once. A background thread
+ * refreshes the DocumentIndex of the directory of the documents and the entries it
+ * receives are appended to the list by batches from idle callbacks of the GTK+ main
+ * loop, which is the only thread touching the widgets.
+ * @{
+ */
+
+/** The number of columns of the list: the number, the customer name, the edit date and the object */
+#define GTKDOCUMENTMODEL_COLUMNCOUNT 4
+
+/** Create the list of the documents of a type, filled in the background
+ * @param typeDocument the type of the listed documents
+ * @param errorMessage the message shown if the directory of the documents cannot be listed
+ * @return the new list with GTKDOCUMENTMODEL_COLUMNCOUNT string columns
+ */
+GtkTreeModel * GtkDocumentModel_new(TypeDocument typeDocument, const char * errorMessage);
+
+/** @} */
+
+#endif
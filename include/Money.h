@@ -0,0 +1,135 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#ifndef FACTURATION_BASE_MONEY_H
+#define FACTURATION_BASE_MONEY_H
+
+#include <Config.h>
+
+/** @defgroup Money Exact decimal amounts
+ * @ingroup Documents
+ *
+ * The amounts, the quantities and the rates of the documents are computed as 64-bit
+ * integers counting ten thousandths, so that adding the rows of a document gives the
+ * same total whatever their number and their order. Each product is rounded to the
+ * nearest ten thousandth, halves away from zero.
+ *
+ * The products are computed on 128 bits so that they never overflow before being
+ * rounded. A product whose result is beyond MONEY_MAX is saturated to MONEY_MAX or
+ * -MONEY_MAX.
+ * @{
+ */
+
+/** The number of units of a Money in one */
+#define MONEY_SCALE 10000
+
+/** The number of decimals of a Money */
+#define MONEY_DECIMALS 4
+
+/** The largest Money */
+#define MONEY_MAX 0x7FFFFFFFFFFFFFFFLL
+
+/** A decimal number counted in ten thousandths */
+typedef long long Money;
+
+/** The totals of a list of rows */
+typedef struct
+{
+  Money withoutVAT; /**< The sum of the amounts without VAT */
+  Money ofVAT; /**< The sum of the VAT */
+  Money withVAT; /**< The sum of the amounts with VAT */
+} MoneyTotals;
+
+/** Convert a double to the nearest Money
+ *
+ * A value which is not a number or whose absolute value is 4.5e14 or more, so that
+ * the difference of two Money could not be represented, gives 0. Such a value is told
+ * apart by Money_tryFromDouble().
+ * @param value the number
+ * @return the Money
+ */
+Money Money_fromDouble(double value);
+
+/** Convert a double to the nearest Money, rejecting the values out of the range of Money_fromDouble()
+ * @param value the number
+ * @param money the Money to fill, set to 0 if the value is rejected
+ * @return a non null value on success, 0 if the value can not be represented
+ */
+int Money_tryFromDouble(double value, Money * money);
+
+/** Convert a Money to the nearest double
+ * @param value the Money
+ * @return the number
+ */
+double Money_toDouble(Money value);
+
+/** Multiply two Money, rounding the result and saturating it to MONEY_MAX
+ * @param value1 the first factor
+ * @param value2 the second factor
+ * @return the product
+ */
+Money Money_multiply(Money value1, Money value2);
+
+/** Compute a percentage of a Money, rounding the result and saturating it to MONEY_MAX
+ * @param value the Money
+ * @param rate the rate in percent
+ * @return the percentage of the Money
+ */
+Money Money_percent(Money value, Money rate);
+
+/** Write a Money in decimal notation, rounded to a number of decimals
+ *
+ * The output is truncated to the size of the buffer but the returned length is
+ * always the length of the whole output, as snprintf() does.
+ * @param buffer the buffer receiving the null terminated text, may be NULL if bufferSize is 0
+ * @param bufferSize the size of the buffer
+ * @param value the Money
+ * @param precision the number of decimals, at most MONEY_DECIMALS
+ * @param width the minimal length of the text, padded with spaces on the left
+ * @return the length of the whole text
+ */
+size_t Money_write(char * buffer, size_t bufferSize, Money value, int precision, int width);
+
+/** Empty the totals of a list of rows
+ * @param totals the totals
+ * @relates MoneyTotals
+ */
+void MoneyTotals_init(MoneyTotals * totals);
+
+/** Add rows to totals
+ *
+ * The rows are given as one array per field so that the loop only reads contiguous
+ * integers. The amount without VAT of a row is (sellingPrice - discount) * quantity and
+ * its VAT is the rateOfVAT percentage of this amount, both rounded to the nearest ten
+ * thousandth before being added.
+ * @param totals the totals receiving the rows
+ * @param sellingPrices the selling price of each row
+ * @param discounts the discount of each row
+ * @param quantities the quantity of each row
+ * @param ratesOfVAT the rate of VAT of each row
+ * @param count the number of rows
+ * @relates MoneyTotals
+ */
+void MoneyTotals_addRows(MoneyTotals * totals, const Money * sellingPrices, const Money * discounts,
+    const Money * quantities, const Money * ratesOfVAT, int count);
+
+/** @} */
+
+#endif
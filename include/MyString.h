@@ -174,6 +174,81 @@ OVERRIDABLE_PREFIX char * OVERRIDABLE(insertString)(const char * src, int insert
 
 /** @} */
 
+/** @defgroup StringBuilder Growable strings
+ * @ingroup Strings
+ *
+ * A string builder accumulates text in a buffer whose capacity doubles when it is
+ * full, so that appending n characters costs O(n) whatever the number of appends.
+ * The text is always null terminated.
+ * @{
+ */
+
+/** A growable string */
+typedef struct
+{
+  char * data; /**< The null terminated text */
+  size_t length; /**< The length of the text */
+  size_t capacity; /**< The allocated size of data */
+} StringBuilder;
+
+/** Initialize an empty string builder
+ * @param builder the string builder
+ * @relates StringBuilder
+ */
+void StringBuilder_init(StringBuilder * builder);
+
+/** Free the memory used by a string builder
+ * @param builder the string builder
+ * @relates StringBuilder
+ */
+void StringBuilder_finalize(StringBuilder * builder);
+
+/** Empty a string builder without freeing its buffer
+ * @param builder the string builder
+ * @relates StringBuilder
+ */
+void StringBuilder_clear(StringBuilder * builder);
+
+/** Make sure that a string builder can hold a text of a given length without growing
+ * @param builder the string builder
+ * @param length the length of the text
+ * @relates StringBuilder
+ */
+void StringBuilder_reserve(StringBuilder * builder, size_t length);
+
+/** Append a string to a string builder
+ * @param builder the string builder
+ * @param str the string
+ * @relates StringBuilder
+ */
+void StringBuilder_append(StringBuilder * builder, const char * str);
+
+/** Append the first characters of a string to a string builder
+ * @param builder the string builder
+ * @param str the characters, which may not be null terminated
+ * @param length the number of characters to append
+ * @relates StringBuilder
+ */
+void StringBuilder_appendN(StringBuilder * builder, const char * str, size_t length);
+
+/** Append a text formatted like with printf() to a string builder
+ * @param builder the string builder
+ * @param format the format
+ * @relates StringBuilder
+ */
+void StringBuilder_appendFormatted(StringBuilder * builder, const char * format, ...);
+
+/** Give the text of a string builder to the caller and empty the string builder
+ * @param builder the string builder
+ * @return the text
+ * @note The string is allocated using malloc().
+ * @warning the user is responsible for freeing the memory allocated for the string
+ * @relates StringBuilder
+ */
+char * StringBuilder_detach(StringBuilder * builder);
+
+/** @} */
+
 #include <provided/MyString.h>
 #include <user/MyString.h>
 
@@ -35,14 +35,6 @@
  */
 void Print_preview(Document * document);
 
-/** Format a document according to a print format
- * @param printFormat the print format
- * @param document the document
- * @return a new string created on the heap containing the formatted document
- * @warning The user is responsible for freeing the memory
- */
-char * PrintFormat_format(PrintFormat * printFormat, Document * document);
-
 /** @} */
 
 #endif
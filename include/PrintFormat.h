@@ -22,6 +22,7 @@
 
 #include <Config.h>
 #include <Document.h>
+#include <Template.h>
 
 /** @defgroup PrintFormat Print format model management
  * @ingroup Format
@@ -58,6 +59,67 @@ OVERRIDABLE_PREFIX void OVERRIDABLE(PrintFormat_finalize)(PrintFormat * format);
  */
 OVERRIDABLE_PREFIX void OVERRIDABLE(PrintFormat_loadFromFile)(PrintFormat * format, const char * filename);
 
+/** The number of characters accumulated by PrintFormat_renderTo() before they are given to the sink */
+#define PRINTFORMAT_CHUNK_SIZE (16 * 1024)
+
+/** A function receiving the successive parts of a rendered document
+ * @param text the characters of the part, not null terminated
+ * @param length the number of characters
+ * @param data the data given to PrintFormat_renderTo()
+ */
+typedef void (*PrintFormat_Sink)(const char * text, size_t length, void * data);
+
+/** Format a document according to a print format and give the result part by part to a sink
+ *
+ * The header, the rows and the footer are rendered one after the other in a buffer
+ * which is given to the sink each time it holds about PRINTFORMAT_CHUNK_SIZE
+ * characters, so that the memory used does not depend on the number of rows.
+ * @param printFormat the print format
+ * @param document the document
+ * @param sink the function receiving the parts of the result
+ * @param data the data given to the sink
+ */
+void PrintFormat_renderTo(PrintFormat * printFormat, Document * document, PrintFormat_Sink sink, void * data);
+
+/** Format a document according to the compiled parts of a print format and give the result part by part to a sink
+ *
+ * The templates are only read, so the same compiled print format can render several
+ * documents at the same time from different threads, each one with its own dictionary.
+ * A dictionary can be reused from one document to the next.
+ * @param header the compiled header format
+ * @param rowTemplate the compiled row format
+ * @param footer the compiled footer format
+ * @param document the document
+ * @param dictionary the dictionary receiving the values of each part, emptied before each part
+ * @param sink the function receiving the parts of the result
+ * @param data the data given to the sink
+ */
+void PrintFormat_renderTemplatesTo(const Template * header, const Template * rowTemplate, const Template * footer,
+    Document * document, Dictionary * dictionary, PrintFormat_Sink sink, void * data);
+
+/** A sink writing the parts of a rendered document to a file
+ * @param text the characters of the part
+ * @param length the number of characters
+ * @param file the FILE pointer of the file opened for writing
+ */
+void PrintFormat_writeToFile(const char * text, size_t length, void * file);
+
+/** Format a document according to a print format
+ * @param printFormat the print format
+ * @param document the document
+ * @return a new string created on the heap containing the formatted document
+ * @warning The user is responsible for freeing the memory
+ */
+char * PrintFormat_format(PrintFormat * printFormat, Document * document);
+
+/** Format a document saved in a file according to a print format file and write the result in a text file
+ * @param formatFilename the file name of the print format
+ * @param documentFilename the file name of the document
+ * @param outputFilename the file name of the text file to create
+ * @return a non null value on success, 0 if a file can not be opened or written
+ */
+int PrintFormat_renderFile(const char * formatFilename, const char * documentFilename, const char * outputFilename);
+
 /** @} */
 
 #include <provided/PrintFormat.h>
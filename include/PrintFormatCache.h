@@ -0,0 +1,92 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#ifndef FACTURATION_BASE_PRINTFORMATCACHE_H
+#define FACTURATION_BASE_PRINTFORMATCACHE_H
+
+#include <Config.h>
+#include <PrintFormat.h>
+#include <Template.h>
+
+#include <time.h>
+
+/** @defgroup PrintFormatCache Cache of the parsed print formats
+ * @ingroup Format
+ *
+ * The print formats are read from their file and compiled once for the whole
+ * process. An entry is found by the file name of the format and is used again as
+ * long as the modification time, to the nanosecond, and the size of the file did not change; otherwise
+ * the file is parsed again.
+ *
+ * An entry is shared: it is acquired before being used and released afterwards. An
+ * entry replaced by a newer version of its file or dropped by PrintFormatCache_clear()
+ * stays valid until its last user releases it. The cache can be used by several
+ * threads at the same time.
+ * @{
+ */
+
+/** A print format of the cache with its compiled parts */
+typedef struct _PrintFormatCacheEntry
+{
+  char * filename; /**< The file name of the print format */
+  time_t modificationTime; /**< The modification time of the file when it was parsed */
+  long modificationNanoseconds; /**< The nanoseconds of the modification time of the file when it was parsed */
+  long fileSize; /**< The size of the file when it was parsed */
+  PrintFormat format; /**< The parsed print format */
+  Template * header; /**< The compiled header format */
+  Template * row; /**< The compiled row format */
+  Template * footer; /**< The compiled footer format */
+  int useCount; /**< The number of users, plus one while the entry is in the cache */
+  struct _PrintFormatCacheEntry * next; /**< The next entry of the cache */
+} PrintFormatCacheEntry;
+
+/** Get the print format of a file, parsing the file only if it changed since it was cached
+ * @param filename the file name of the print format
+ * @return the entry, or NULL if the file can not be read
+ * @warning the entry must be released using PrintFormatCache_release()
+ */
+PrintFormatCacheEntry * PrintFormatCache_acquire(const char * filename);
+
+/** Release an entry given by PrintFormatCache_acquire()
+ * @param entry the entry
+ * @relates PrintFormatCacheEntry
+ */
+void PrintFormatCache_release(PrintFormatCacheEntry * entry);
+
+/** Format a document according to a cached print format and give the result part by part to a sink
+ * @param entry the acquired entry
+ * @param document the document
+ * @param sink the function receiving the parts of the result
+ * @param data the data given to the sink
+ * @relates PrintFormatCacheEntry
+ */
+void PrintFormatCache_renderTo(PrintFormatCacheEntry * entry, Document * document, PrintFormat_Sink sink, void * data);
+
+/** Drop all the entries of the cache */
+void PrintFormatCache_clear(void);
+
+/** Get the number of files parsed by the cache since the start of the process
+ * @return the number of files parsed
+ */
+int PrintFormatCache_getLoadCount(void);
+
+/** @} */
+
+#endif
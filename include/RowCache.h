@@ -0,0 +1,114 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_ROWCACHE_H
+#define FACTURATION_BASE_ROWCACHE_H
+
+#include <Config.h>
+
+/** @defgroup RowCache Cache of the formatted rows of a record list
+ *
+ * The tree models display a record as one string per field. A row cache keeps the
+ * strings of the most recently displayed records so that a record is read and
+ * formatted once for all its columns. When the cache is full, the least recently
+ * used row is dropped.
+ * @{
+ */
+
+/** The default number of rows kept by the caches of the tree models */
+#define ROWCACHE_DEFAULT_CAPACITY 256
+
+/** A cached row */
+typedef struct
+{
+  int recordIndex; /**< The position of the record, -1 if the entry is unused */
+  char ** values; /**< The string of each field */
+  int previous; /**< The previous entry in the order of use, -1 for the most recently used */
+  int next; /**< The next entry in the order of use, -1 for the least recently used */
+  int hashNext; /**< The next entry of the same bucket, -1 for the last one */
+} RowCacheEntry;
+
+/** A cache of rows */
+typedef struct
+{
+  RowCacheEntry * entries; /**< The entries */
+  int capacity; /**< The number of entries */
+  int fieldCount; /**< The number of strings of a row */
+  int * buckets; /**< The first entry of each bucket of the hash table from positions to entries */
+  int bucketMask; /**< The number of buckets minus one, the number of buckets being a power of 2 */
+  int first; /**< The most recently used entry */
+  int last; /**< The least recently used entry */
+  unsigned long hits; /**< The number of lookups which found their row */
+  unsigned long misses; /**< The number of lookups which did not find their row */
+} RowCache;
+
+/** Initialize an empty cache
+ * @param cache the cache
+ * @param capacity the number of rows kept by the cache
+ * @param fieldCount the number of strings of a row
+ * @relates RowCache
+ */
+void RowCache_init(RowCache * cache, int capacity, int fieldCount);
+
+/** Free the memory used by a cache
+ * @param cache the cache
+ * @relates RowCache
+ */
+void RowCache_finalize(RowCache * cache);
+
+/** Drop all the rows of a cache, used when records are inserted or removed since the positions change
+ * @param cache the cache
+ * @relates RowCache
+ */
+void RowCache_clear(RowCache * cache);
+
+/** Drop the row of a record, used when the record is modified
+ * @param cache the cache
+ * @param recordIndex the position of the record
+ * @relates RowCache
+ */
+void RowCache_invalidate(RowCache * cache, int recordIndex);
+
+/** Get the strings of a cached row and mark it as the most recently used
+ * @param cache the cache
+ * @param recordIndex the position of the record
+ * @return the array of the strings of the row or NULL if the row is not cached
+ * @relates RowCache
+ */
+char ** RowCache_find(RowCache * cache, int recordIndex);
+
+/** Add the row of a record to a cache, dropping the least recently used row if needed
+ * @param cache the cache
+ * @param recordIndex the position of the record which must not be cached
+ * @return the array of fieldCount NULL pointers which must receive the strings of the row
+ * @note The strings are allocated by the caller using malloc() and freed by the cache.
+ * @relates RowCache
+ */
+char ** RowCache_add(RowCache * cache, int recordIndex);
+
+/** Get the ratio of the lookups which found their row
+ * @param cache the cache
+ * @return the ratio between 0 and 1, 0 if there was no lookup
+ * @relates RowCache
+ */
+double RowCache_getHitRatio(RowCache * cache);
+
+/** @} */
+
+#endif
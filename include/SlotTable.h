@@ -0,0 +1,151 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_SLOTTABLE_H
+#define FACTURATION_BASE_SLOTTABLE_H
+
+#include <Config.h>
+
+/** @defgroup SlotTable Indirection between record positions and slots of a database file
+ *
+ * The record databases store fixed size records in slots. The slot table maps the
+ * position of a record as seen by the application (its logical index) to the slot
+ * where it is stored so that inserting or removing a record does not move the
+ * following ones. Removed slots are marked with a tombstone and reused by the next
+ * insertions.
+ *
+ * While the records are stored in slot order without any hole, the table is the
+ * identity and nothing is stored beside the database. Otherwise the table is saved
+ * in a side file named after the database with the SLOTTABLE_EXTENSION suffix.
+ * @{
+ */
+
+/** The suffix appended to the database file name to get the file name of its slot table */
+#define SLOTTABLE_EXTENSION ".slots"
+
+/** The byte written at the beginning of a removed slot */
+#define SLOTTABLE_TOMBSTONE '\x7f'
+
+/** The slot table of a database */
+typedef struct
+{
+  int * slots; /**< The slot of each record, indexed by the position of the record */
+  int count; /**< The number of records */
+  int capacity; /**< The allocated size of slots */
+  int * freeSlots; /**< The stack of the removed slots which can be reused */
+  int freeCount; /**< The number of removed slots */
+  int freeCapacity; /**< The allocated size of freeSlots */
+  int * indexes; /**< The position of the record stored in each slot, -1 for the removed slots */
+  int indexCapacity; /**< The allocated size of indexes */
+  int slotCount; /**< The number of slots used in the database file, including the removed ones */
+  int isIdentity; /**< True if each record is stored in the slot of the same number */
+} SlotTable;
+
+/** Initialize a slot table for a database of densely stored records
+ * @param table the table
+ * @param slotCount the number of records of the database
+ * @relates SlotTable
+ */
+void SlotTable_init(SlotTable * table, int slotCount);
+
+/** Free the memory used by a slot table
+ * @param table the table
+ * @relates SlotTable
+ */
+void SlotTable_finalize(SlotTable * table);
+
+/** Create a new string on the heap containing the file name of the slot table of a database
+ * @param filename the file name of the database
+ * @return a new string
+ * @note The string is allocated using malloc().
+ * @warning the user is responsible for freeing the memory allocated for the new string
+ */
+char * SlotTable_getFilename(const char * filename);
+
+/** Initialize a slot table from the side file of a database
+ * @param table the table
+ * @param database the database file
+ * @param filename the file name of the database
+ * @param slotCount the number of slots stored in the header of the database
+ * @param recordSize the size of a slot in the database file
+ * @return a non null value if the side file is valid or missing, 0 if the table was rebuilt from the database file
+ * @note Without side file, the table is initialized as the identity on slotCount records.
+ * Otherwise the number of slots of the side file is used since it is saved first.
+ * @note A side file whose slots are out of the database file or used twice is ignored: the
+ * table is rebuilt from the tombstones of the database and the records keep their slot order.
+ * @relates SlotTable
+ */
+int SlotTable_load(SlotTable * table, FILE * database, const char * filename, int slotCount, size_t recordSize);
+
+/** Save a slot table in the side file of a database or remove the side file if the table is the identity
+ * @param table the table
+ * @param filename the file name of the database
+ * @note The side file is replaced atomically once its content is on the disk.
+ * @relates SlotTable
+ */
+void SlotTable_save(SlotTable * table, const char * filename);
+
+/** Get the slot of a record
+ * @param table the table
+ * @param recordIndex the position of the record
+ * @return the slot
+ * @relates SlotTable
+ */
+int SlotTable_getSlot(SlotTable * table, int recordIndex);
+
+/** Get the position of the record stored in a slot
+ * @param table the table
+ * @param slot the slot
+ * @return the position of the record or -1 if the slot does not hold a record
+ * @relates SlotTable
+ */
+int SlotTable_getIndex(SlotTable * table, int slot);
+
+/** Insert a record at a given position and choose its slot, reusing a removed slot if any
+ * @param table the table
+ * @param recordIndex the insertion position
+ * @return the slot where the record must be written
+ * @relates SlotTable
+ */
+int SlotTable_insert(SlotTable * table, int recordIndex);
+
+/** Add a record at the end using a new slot at the end of the file
+ * @param table the table
+ * @return the slot where the record must be written
+ * @relates SlotTable
+ */
+int SlotTable_append(SlotTable * table);
+
+/** Remove the record at a given position
+ * @param table the table
+ * @param recordIndex the removal position
+ * @return the slot of the removed record which must be marked with a tombstone
+ * @relates SlotTable
+ */
+int SlotTable_remove(SlotTable * table, int recordIndex);
+
+/** Write a tombstone in a slot of a database file
+ * @param file the database file
+ * @param offset the offset of the slot in the file
+ */
+void SlotTable_writeTombstone(FILE * file, long offset);
+
+/** @} */
+
+#endif
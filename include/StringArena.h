@@ -0,0 +1,91 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_STRINGARENA_H
+#define FACTURATION_BASE_STRINGARENA_H
+
+#include <Config.h>
+
+/** @defgroup StringArena Arena of strings freed all at once
+ *
+ * An arena carves the strings out of large blocks instead of allocating them one by
+ * one. A string of an arena is never freed on its own: all the strings are released
+ * with the arena. Replacing a string of an arena therefore keeps the old one until the
+ * arena is destroyed.
+ *
+ * An arena is not thread safe.
+ * @{
+ */
+
+/** The size of the blocks of an arena */
+#define STRINGARENA_BLOCK_SIZE 16384
+
+/** A block of an arena */
+typedef struct _StringArenaBlock
+{
+  struct _StringArenaBlock * next; /**< The previously allocated block */
+  size_t size; /**< The size of the data of the block */
+  size_t used; /**< The used size of the data of the block */
+} StringArenaBlock;
+
+/** An arena of strings */
+typedef struct
+{
+  StringArenaBlock * blocks; /**< The blocks, the one in which the strings are carved first */
+  size_t allocatedSize; /**< The total size of the strings carved from the arena */
+} StringArena;
+
+/** Create a new empty arena on the heap
+ * @return the new arena
+ * @relates StringArena
+ */
+StringArena * StringArena_create(void);
+
+/** Free all the strings of an arena and the arena itself
+ * @param arena the arena
+ * @relates StringArena
+ */
+void StringArena_destroy(StringArena * arena);
+
+/** Allocate some bytes from an arena
+ * @param arena the arena
+ * @param size the number of bytes
+ * @return the bytes, valid until the arena is destroyed
+ * @relates StringArena
+ */
+char * StringArena_allocate(StringArena * arena, size_t size);
+
+/** Copy a string into an arena
+ * @param arena the arena
+ * @param str the string
+ * @return the copy, valid until the arena is destroyed
+ * @relates StringArena
+ */
+char * StringArena_duplicate(StringArena * arena, const char * str);
+
+/** Get the total size of the strings carved from an arena
+ * @param arena the arena
+ * @return the size in bytes
+ * @relates StringArena
+ */
+size_t StringArena_getAllocatedSize(StringArena * arena);
+
+/** @} */
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#ifndef FACTURATION_BASE_TEMPLATE_H
+#define FACTURATION_BASE_TEMPLATE_H
+
+#include <Config.h>
+#include <Dictionary.h>
+
+/** @defgroup Template Compiled templates
+ * @ingroup Format
+ *
+ * A template is the text given to Dictionary_format() parsed once into a list of
+ * operations: copying a span of literal text or writing the value of a dictionary
+ * entry with its modifiers. A placeholder is written %NAME% or %NAME{modifiers}%
+ * where the modifiers are separated by commas:
+ * - case=U or case=l writes a string in upper or lower case,
+ * - max=n truncates a string to n characters,
+ * - min=n pads a string with spaces on the right or a number on the left up to n characters,
+ * - precision=n writes a number with n decimals, 6 by default.
+ *
+ * The sequence %% writes a single %. A placeholder whose entry is not defined
+ * writes nothing. A template can be rendered any number of times, by several
+ * threads at the same time, without being parsed again.
+ * @{
+ */
+
+/** The default number of decimals of the numbers */
+#define TEMPLATE_DEFAULT_PRECISION 6
+
+/** The maximal number of decimals of the numbers */
+#define TEMPLATE_MAX_PRECISION 30
+
+/** The kinds of operation of a template */
+typedef enum
+{
+  TEMPLATE_LITERAL, /**< Copy a span of the text of the template */
+  TEMPLATE_FIELD /**< Write the value of a dictionary entry */
+} TemplateOperationType;
+
+/** An operation of a template */
+typedef struct
+{
+  TemplateOperationType type; /**< The kind of operation */
+  size_t start; /**< The offset in the text of the template of the literal span */
+  size_t length; /**< The length of the literal span */
+  const char * name; /**< The interned name of the entry of a field */
+  unsigned int hash; /**< The hash of the name of the entry given by Dictionary_hashName() */
+  char letterCase; /**< 'U' for upper case, 'l' for lower case, 0 to keep the case */
+  int minimum; /**< The minimal width of the value, -1 if none */
+  int maximum; /**< The maximal length of a string value, -1 if none */
+  int precision; /**< The number of decimals of a number value */
+} TemplateOperation;
+
+/** A compiled template */
+typedef struct
+{
+  char * text; /**< A copy of the text of the template */
+  TemplateOperation * operations; /**< The operations */
+  int count; /**< The number of operations */
+} Template;
+
+/** Parse a template into a list of operations
+ * @param format the text of the template
+ * @return the new template
+ * @warning the template should be destroyed using Template_destroy()
+ * @relates Template
+ */
+Template * Template_compile(const char * format);
+
+/** Destroy a template
+ * @param template the template
+ * @relates Template
+ */
+void Template_destroy(Template * template);
+
+/** Render a template with the values of a dictionary
+ *
+ * The output is written in a single pass without any allocation. It is truncated to
+ * the size of the buffer but the returned length is always the length of the whole
+ * output, so that a buffer of the returned length plus one can be used again.
+ * @param template the template
+ * @param dictionary the dictionary
+ * @param buffer the buffer receiving the null terminated output, may be NULL if bufferSize is 0
+ * @param bufferSize the size of the buffer
+ * @return the length of the whole output
+ * @relates Template
+ */
+size_t Template_render(const Template * template, Dictionary * dictionary, char * buffer, size_t bufferSize);
+
+/** Render a template with the values of a dictionary at the end of a string builder
+ * @param template the template
+ * @param dictionary the dictionary
+ * @param builder the string builder receiving the output
+ * @relates Template
+ */
+void Template_renderTo(const Template * template, Dictionary * dictionary, StringBuilder * builder);
+
+/** @} */
+
+#endif
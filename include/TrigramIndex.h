@@ -0,0 +1,145 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_TRIGRAMINDEX_H
+#define FACTURATION_BASE_TRIGRAMINDEX_H
+
+#include <Config.h>
+
+/** @defgroup TrigramIndex Index of the products by trigrams of their designation
+ * @ingroup Catalog
+ *
+ * The designation is reduced to an alphabet of TRIGRAMINDEX_SYMBOL_COUNT symbols: the
+ * letters without case, the digits, one symbol for all the non ASCII characters and
+ * the space which replaces any sequence of other characters. Each word is surrounded
+ * by spaces and every sequence of three symbols (a trigram) gives the list of the
+ * slots whose designation contains it.
+ *
+ * A query is reduced the same way except that its last word is not closed, so that a
+ * query matches the designations containing its words or starting words with its
+ * last word. The records are ranked by the number of trigrams of the query they hold.
+ *
+ * The index is saved next to the database (Catalog.db gives Catalog.tri) with the same
+ * stamp as the index by code and is rebuilt when it does not match the database file.
+ * @{
+ */
+
+/** The extension of the index file which replaces the extension of the database file */
+#define TRIGRAMINDEX_EXTENSION ".tri"
+
+/** The number of symbols of the alphabet of the trigrams */
+#define TRIGRAMINDEX_SYMBOL_COUNT 38
+
+/** The number of different trigrams */
+#define TRIGRAMINDEX_TRIGRAM_COUNT (TRIGRAMINDEX_SYMBOL_COUNT * TRIGRAMINDEX_SYMBOL_COUNT * TRIGRAMINDEX_SYMBOL_COUNT)
+
+/** The slots holding a trigram */
+typedef struct
+{
+  int * slots; /**< The slots, in increasing order so that they are found by a binary search */
+  int count; /**< The number of slots */
+  int capacity; /**< The allocated size of slots */
+} TrigramPostingList;
+
+/** The index of the products by trigrams */
+typedef struct
+{
+  TrigramPostingList * lists; /**< The posting list of each trigram, NULL while the index is not valid */
+  int isValid; /**< True if the index describes the whole database */
+  int isModified; /**< True if the index changed since it was loaded */
+} TrigramIndex;
+
+/** Initialize an empty and invalid index
+ * @param trigramIndex the index
+ * @relates TrigramIndex
+ */
+void TrigramIndex_init(TrigramIndex * trigramIndex);
+
+/** Free the memory used by an index and make it invalid
+ * @param trigramIndex the index
+ * @relates TrigramIndex
+ */
+void TrigramIndex_finalize(TrigramIndex * trigramIndex);
+
+/** Remove all the entries of an index and make it valid
+ * @param trigramIndex the index
+ * @relates TrigramIndex
+ */
+void TrigramIndex_clear(TrigramIndex * trigramIndex);
+
+/** Create a new string on the heap containing the file name of the trigram index of a database
+ * @param filename the file name of the database
+ * @return a new string
+ * @note The string is allocated using malloc().
+ * @warning the user is responsible for freeing the memory allocated for the new string
+ */
+char * TrigramIndex_getFilename(const char * filename);
+
+/** Load the trigram index of a database if it matches the database file
+ * @param trigramIndex the index
+ * @param filename the file name of the database
+ * @return a non null value if the index is valid, 0 otherwise
+ * @relates TrigramIndex
+ */
+int TrigramIndex_load(TrigramIndex * trigramIndex, const char * filename);
+
+/** Save the trigram index of a database, stamped with the current state of the database file
+ * @param trigramIndex the index
+ * @param filename the file name of the database which must be up to date on disk
+ * @relates TrigramIndex
+ */
+void TrigramIndex_save(TrigramIndex * trigramIndex, const char * filename);
+
+/** Remove the saved trigram index of a database
+ * @param filename the file name of the database
+ */
+void TrigramIndex_remove(const char * filename);
+
+/** Record that a slot holds a product with a given designation
+ * @param trigramIndex the index
+ * @param text the designation of the product
+ * @param slot the slot of the product
+ * @relates TrigramIndex
+ */
+void TrigramIndex_add(TrigramIndex * trigramIndex, const char * text, int slot);
+
+/** Record that a slot does not hold a product with a given designation anymore
+ * @param trigramIndex the index
+ * @param text the designation of the product
+ * @param slot the slot of the product
+ * @relates TrigramIndex
+ */
+void TrigramIndex_delete(TrigramIndex * trigramIndex, const char * text, int slot);
+
+/** Find the slots whose designation best matches a query
+ * @param trigramIndex the index
+ * @param query the query
+ * @param slotCount the number of slots of the database
+ * @param limit the maximum number of slots to return
+ * @param slots the array of at least limit elements receiving the slots, best match first
+ * @return the number of slots found
+ * @note A slot must hold at least half the trigrams of the query to be found. Slots
+ * with the same score are sorted by increasing slot.
+ * @relates TrigramIndex
+ */
+int TrigramIndex_search(TrigramIndex * trigramIndex, const char * query, int slotCount, int limit, int * slots);
+
+/** @} */
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef FACTURATION_BASE_WRITEAHEADLOG_H
+#define FACTURATION_BASE_WRITEAHEADLOG_H
+
+#include <Config.h>
+#include <SlotTable.h>
+
+/** @defgroup WriteAheadLog Journal of the changes of a record database
+ *
+ * The record databases write their records in place and only save their header and
+ * their slot table at a checkpoint (closing, committing a batch). Every insertion,
+ * removal or modification done in between is first appended to a log file named
+ * after the database with the WRITEAHEADLOG_EXTENSION suffix.
+ *
+ * An entry reaches the system before the database file is touched so that a crashed
+ * process loses nothing. The log is forced to the disk once for a group of
+ * WRITEAHEADLOG_GROUP_SIZE entries (group commit) or when asked to, and the database
+ * keeps the changes of a group in memory until then so that no record reaches the
+ * disk before its entry.
+ *
+ * The log starts with a stamp of the slot table it applies to. When a database is
+ * opened, the entries of a log whose stamp matches the saved slot table are replayed
+ * up to the first incomplete or corrupted one. A log left by a checkpoint which
+ * completed does not match anymore and is ignored. The log is removed at each
+ * checkpoint.
+ * @{
+ */
+
+/** The suffix appended to the database file name to get the file name of its log */
+#define WRITEAHEADLOG_EXTENSION ".wal"
+
+/** The number of entries written before the log is forced to the disk */
+#define WRITEAHEADLOG_GROUP_SIZE 32
+
+/** The size in bytes of the log above which the database should do a checkpoint */
+#define WRITEAHEADLOG_CHECKPOINT_SIZE (1024L * 1024L)
+
+/** The kinds of change recorded by a log */
+typedef enum
+{
+  WRITEAHEADLOG_INSERT = 1, /**< A record inserted at a position */
+  WRITEAHEADLOG_REMOVE = 2, /**< The record at a position removed */
+  WRITEAHEADLOG_WRITE = 3 /**< The record at a position replaced */
+} WriteAheadLogOperation;
+
+/** The log of a database */
+typedef struct
+{
+  FILE * file; /**< The log file, NULL until the first entry after a checkpoint */
+  char * filename; /**< The file name of the log */
+  size_t recordSize; /**< The size of an encoded record */
+  SlotTable * table; /**< The slot table of the database */
+  long size; /**< The size in bytes of the log file */
+  int pendingCount; /**< The number of entries not yet forced to the disk */
+} WriteAheadLog;
+
+/** Initialize the log of a database without touching the log file
+ * @param log the log
+ * @param filename the file name of the database
+ * @param recordSize the size of an encoded record
+ * @param table the slot table of the database
+ * @relates WriteAheadLog
+ */
+void WriteAheadLog_init(WriteAheadLog * log, const char * filename, size_t recordSize, SlotTable * table);
+
+/** Close the log file and free the memory used by a log
+ * @param log the log
+ * @relates WriteAheadLog
+ */
+void WriteAheadLog_finalize(WriteAheadLog * log);
+
+/** Create a new string on the heap containing the file name of the log of a database
+ * @param filename the file name of the database
+ * @return a new string
+ * @note The string is allocated using malloc().
+ * @warning the user is responsible for freeing the memory allocated for the new string
+ */
+char * WriteAheadLog_getFilename(const char * filename);
+
+/** Apply to a database the entries of the log left by a previous session
+ * @param log the log
+ * @param database the database file whose slot table was just loaded
+ * @return the number of entries replayed
+ * @note When entries are replayed, the database must do a checkpoint.
+ * @relates WriteAheadLog
+ */
+int WriteAheadLog_replay(WriteAheadLog * log, FILE * database);
+
+/** Append an entry to the log before the change is applied to the database
+ * @param log the log
+ * @param operation the kind of change
+ * @param recordIndex the position of the record
+ * @param record the encoded record for the insertions and the modifications, NULL otherwise
+ * @relates WriteAheadLog
+ */
+void WriteAheadLog_append(WriteAheadLog * log, WriteAheadLogOperation operation, int recordIndex, const char * record);
+
+/** Force the pending entries to the disk
+ * @param log the log
+ * @relates WriteAheadLog
+ */
+void WriteAheadLog_sync(WriteAheadLog * log);
+
+/** Tell if the log is large enough for the database to do a checkpoint
+ * @param log the log
+ * @return a non null value if a checkpoint should be done
+ * @relates WriteAheadLog
+ */
+int WriteAheadLog_needsCheckpoint(WriteAheadLog * log);
+
+/** Empty the log once the database saved its slot table and its header
+ * @param log the log
+ * @relates WriteAheadLog
+ */
+void WriteAheadLog_reset(WriteAheadLog * log);
+
+/** @} */
+
+#endif
@@ -23,6 +23,14 @@ debug/App.c.o: src/App.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/App.c.o src/App.c
 
+release/BatchRender.c.o: src/BatchRender.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/BatchRender.c.o src/BatchRender.c
+
+debug/BatchRender.c.o: src/BatchRender.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/BatchRender.c.o src/BatchRender.c
+
 release/Bill.c.o: src/Bill.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/Bill.c.o src/Bill.c
@@ -31,6 +39,14 @@ debug/Bill.c.o: src/Bill.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/Bill.c.o src/Bill.c
 
+release/BlockCache.c.o: src/BlockCache.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/BlockCache.c.o src/BlockCache.c
+
+debug/BlockCache.c.o: src/BlockCache.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/BlockCache.c.o src/BlockCache.c
+
 release/BridgeUtil.c.o: src/BridgeUtil.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/BridgeUtil.c.o src/BridgeUtil.c
@@ -63,6 +79,14 @@ debug/CatalogDBUnit.c.o: src/CatalogDBUnit.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/CatalogDBUnit.c.o src/CatalogDBUnit.c
 
+release/CatalogIndex.c.o: src/CatalogIndex.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/CatalogIndex.c.o src/CatalogIndex.c
+
+debug/CatalogIndex.c.o: src/CatalogIndex.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/CatalogIndex.c.o src/CatalogIndex.c
+
 release/CatalogRecord.c.o: src/CatalogRecord.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/CatalogRecord.c.o src/CatalogRecord.c
@@ -79,6 +103,14 @@ debug/CatalogRecordUnit.c.o: src/CatalogRecordUnit.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/CatalogRecordUnit.c.o src/CatalogRecordUnit.c
 
+release/CatalogSnapshot.c.o: src/CatalogSnapshot.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/CatalogSnapshot.c.o src/CatalogSnapshot.c
+
+debug/CatalogSnapshot.c.o: src/CatalogSnapshot.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/CatalogSnapshot.c.o src/CatalogSnapshot.c
+
 release/Customer.c.o: src/Customer.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/Customer.c.o src/Customer.c
@@ -119,6 +151,22 @@ debug/CustomerRecordUnit.c.o: src/CustomerRecordUnit.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/CustomerRecordUnit.c.o src/CustomerRecordUnit.c
 
+release/DatabaseLock.c.o: src/DatabaseLock.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/DatabaseLock.c.o src/DatabaseLock.c
+
+debug/DatabaseLock.c.o: src/DatabaseLock.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/DatabaseLock.c.o src/DatabaseLock.c
+
+release/DecimalFormat.c.o: src/DecimalFormat.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/DecimalFormat.c.o src/DecimalFormat.c
+
+debug/DecimalFormat.c.o: src/DecimalFormat.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/DecimalFormat.c.o src/DecimalFormat.c
+
 release/Dictionary.c.o: src/Dictionary.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/Dictionary.c.o src/Dictionary.c
@@ -151,6 +199,22 @@ debug/DocumentEditor.c.o: src/DocumentEditor.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/DocumentEditor.c.o src/DocumentEditor.c
 
+release/DocumentIndex.c.o: src/DocumentIndex.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/DocumentIndex.c.o src/DocumentIndex.c
+
+debug/DocumentIndex.c.o: src/DocumentIndex.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/DocumentIndex.c.o src/DocumentIndex.c
+
+release/DocumentReader.c.o: src/DocumentReader.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/DocumentReader.c.o src/DocumentReader.c
+
+debug/DocumentReader.c.o: src/DocumentReader.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/DocumentReader.c.o src/DocumentReader.c
+
 release/DocumentRowList.c.o: src/DocumentRowList.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/DocumentRowList.c.o src/DocumentRowList.c
@@ -223,6 +287,14 @@ debug/GtkCustomerModel.c.o: src/GtkCustomerModel.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/GtkCustomerModel.c.o src/GtkCustomerModel.c
 
+release/GtkDocumentModel.c.o: src/GtkDocumentModel.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/GtkDocumentModel.c.o src/GtkDocumentModel.c
+
+debug/GtkDocumentModel.c.o: src/GtkDocumentModel.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/GtkDocumentModel.c.o src/GtkDocumentModel.c
+
 release/main.c.o: src/main.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/main.c.o src/main.c
@@ -239,6 +311,14 @@ debug/MainWindow.c.o: src/MainWindow.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/MainWindow.c.o src/MainWindow.c
 
+release/Money.c.o: src/Money.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/Money.c.o src/Money.c
+
+debug/Money.c.o: src/Money.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/Money.c.o src/Money.c
+
 release/MyString.c.o: src/MyString.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/MyString.c.o src/MyString.c
@@ -295,6 +375,14 @@ debug/PrintFormat.c.o: src/PrintFormat.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/PrintFormat.c.o src/PrintFormat.c
 
+release/PrintFormatCache.c.o: src/PrintFormatCache.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/PrintFormatCache.c.o src/PrintFormatCache.c
+
+debug/PrintFormatCache.c.o: src/PrintFormatCache.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/PrintFormatCache.c.o src/PrintFormatCache.c
+
 release/PrintFormatUnit.c.o: src/PrintFormatUnit.c
 	@mkdir -p release
 		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/PrintFormatUnit.c.o src/PrintFormatUnit.c
@@ -311,3 +399,51 @@ debug/Quotation.c.o: src/Quotation.c
 	@mkdir -p debug
 	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/Quotation.c.o src/Quotation.c
 
+release/RowCache.c.o: src/RowCache.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/RowCache.c.o src/RowCache.c
+
+debug/RowCache.c.o: src/RowCache.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/RowCache.c.o src/RowCache.c
+
+release/SlotTable.c.o: src/SlotTable.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/SlotTable.c.o src/SlotTable.c
+
+debug/SlotTable.c.o: src/SlotTable.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/SlotTable.c.o src/SlotTable.c
+
+release/StringArena.c.o: src/StringArena.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/StringArena.c.o src/StringArena.c
+
+debug/StringArena.c.o: src/StringArena.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/StringArena.c.o src/StringArena.c
+
+release/Template.c.o: src/Template.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/Template.c.o src/Template.c
+
+debug/Template.c.o: src/Template.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/Template.c.o src/Template.c
+
+release/TrigramIndex.c.o: src/TrigramIndex.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/TrigramIndex.c.o src/TrigramIndex.c
+
+debug/TrigramIndex.c.o: src/TrigramIndex.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/TrigramIndex.c.o src/TrigramIndex.c
+
+release/WriteAheadLog.c.o: src/WriteAheadLog.c
+	@mkdir -p release
+		LANG=C gcc -c ${CFLAGS} ${RELEASE_CFLAGS} ${GTK_CFLAGS} -o release/WriteAheadLog.c.o src/WriteAheadLog.c
+
+debug/WriteAheadLog.c.o: src/WriteAheadLog.c
+	@mkdir -p debug
+	LANG=C gcc -c ${CFLAGS} ${DEBUG_CFLAGS} ${GTK_CFLAGS} -o debug/WriteAheadLog.c.o src/WriteAheadLog.c
+
@@ -19,6 +19,10 @@
 
 #include <App.h>
 #include <MainWindow.h>
+#include <CatalogDB.h>
+#include <CustomerDB.h>
+#include <PrintFormat.h>
+#include <BatchRender.h>
 
 #include <MyStringUnit.h>
 #include <OperatorTableUnit.h>
@@ -74,6 +78,68 @@ void App_run(int * argc, char * *argv[])
 
   setupOverridable();
 
+  /* Offline maintenance: store the records of the databases densely again */
+  if (isSpecified("compact-databases"))
+  {
+    int status = 0;
+
+    if (!CatalogDB_compact(CATALOGDB_FILENAME))
+    {
+      fprintf(stderr, "Unable to compact the catalog database \"%s\"\n", CATALOGDB_FILENAME);
+      status = 1;
+    }
+    if (!CustomerDB_compact(CUSTOMERDB_FILENAME))
+    {
+      fprintf(stderr, "Unable to compact the customer database \"%s\"\n", CUSTOMERDB_FILENAME);
+      status = 1;
+    }
+    exit(status);
+  }
+
+  /* Offline printing: render-document <print format> <document> <output text file> */
+  if (isSpecified("render-document"))
+  {
+    int i;
+
+    for (i = 1; i < *argc; ++i)
+      if (compareString((*argv)[i], "render-document") == 0)
+        break;
+    if (i + 3 >= *argc)
+    {
+      fprintf(stderr, "Usage: render-document <print format file> <document file> <output file>\n");
+      exit(1);
+    }
+    if (!PrintFormat_renderFile((*argv)[i + 1], (*argv)[i + 2], (*argv)[i + 3]))
+    {
+      fprintf(stderr, "Unable to render the document \"%s\" to \"%s\"\n", (*argv)[i + 2], (*argv)[i + 3]);
+      exit(1);
+    }
+    exit(0);
+  }
+
+  /* Offline printing: render-batch <print format> <bill|quotation> <output directory> <document number>... */
+  if (isSpecified("render-batch"))
+  {
+    BatchRenderReport report;
+    int isRendered;
+    int i;
+
+    for (i = 1; i < *argc; ++i)
+      if (compareString((*argv)[i], "render-batch") == 0)
+        break;
+    if (i + 4 >= *argc || (compareString((*argv)[i + 2], "bill") != 0 && compareString((*argv)[i + 2], "quotation") != 0))
+    {
+      fprintf(stderr, "Usage: render-batch <print format file> <bill|quotation> <output directory> <document number>...\n");
+      exit(1);
+    }
+    isRendered = BatchRender_run((*argv)[i + 1],
+        (compareString((*argv)[i + 2], "bill") == 0) ? BATCHRENDER_BILL_FILENAME : BATCHRENDER_QUOTATION_FILENAME,
+        (const char * const *)(*argv) + i + 4, *argc - i - 4, (*argv)[i + 3], 0, &report);
+    printf("%d of %d documents rendered in %.2f s by %d threads (%.1f documents/s)\n", report.renderedCount,
+        report.documentCount, report.seconds, report.threadCount, BatchRenderReport_getThroughput(&report));
+    exit(isRendered ? 0 : 1);
+  }
+
   if (!isSpecified("silent-tests"))
   {
     printf("Running preliminary unit test... (specify verbose-unittests for details)\n");
@@ -99,6 +165,12 @@ void App_run(int * argc, char * *argv[])
   {
     GtkWidget * window;
 
+#if !GLIB_CHECK_VERSION(2, 32, 0)
+    /* the lists of documents are filled through idle callbacks added by other threads */
+    if (!g_thread_supported())
+      g_thread_init(NULL);
+#endif
+
     /* Initialise GTK+ passing to it all command line arguments  */
     gtk_init(argc, argv);
 
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#include <BatchRender.h>
+#include <PrintFormatCache.h>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+/** The state shared by the workers of a batch */
+typedef struct
+{
+  PrintFormatCacheEntry * printFormat; /**< The print format, shared read-only */
+  const char * documentFilenamePattern; /**< The file names of the documents */
+  const char * const * docNumbers; /**< The numbers of the documents */
+  int docNumberCount; /**< The number of documents */
+  const char * outputDirectory; /**< The directory receiving the text files */
+  int nextDocument; /**< The position of the next document to render */
+  int renderedCount; /**< The number of documents rendered */
+  int failedCount; /**< The number of documents which failed */
+  pthread_mutex_t mutex; /**< The lock protecting the counters */
+} BatchRenderJob;
+
+static void * BatchRender_work(void * data);
+static int BatchRender_renderDocument(BatchRenderJob * job, const char * docNumber, Document * document, Dictionary * dictionary);
+static int BatchRender_isValidDocNumber(const char * docNumber);
+static double BatchRender_getTime(void);
+
+/** Render a list of saved documents with a print format into a directory
+ * @param formatFilename the file name of the print format
+ * @param documentFilenamePattern the file names of the documents, %s standing for the document number
+ * @param docNumbers the numbers of the documents
+ * @param docNumberCount the number of documents
+ * @param outputDirectory the directory receiving the text files, created if needed
+ * @param threadCount the number of worker threads, 0 for one per processor
+ * @param report the structure receiving the result of the batch
+ * @return a non null value if all the documents were rendered
+ */
+int BatchRender_run(const char * formatFilename, const char * documentFilenamePattern, const char * const * docNumbers,
+        int docNumberCount, const char * outputDirectory, int threadCount, BatchRenderReport * report)
+{
+    pthread_t threads[BATCHRENDER_MAX_THREADS];
+    BatchRenderJob job;
+    double start = BatchRender_getTime();
+    int i;
+
+    report->documentCount = docNumberCount;
+    report->renderedCount = 0;
+    report->failedCount = docNumberCount;
+    report->threadCount = 0;
+    report->seconds = 0;
+
+    job.printFormat = PrintFormatCache_acquire(formatFilename);
+    if (job.printFormat == NULL)
+        return 0;
+    mkdir(outputDirectory, 0755);
+
+    if (threadCount <= 0)
+        threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = MINVALUE(MAXVALUE(threadCount, 1), BATCHRENDER_MAX_THREADS);
+    /* a worker without document to render would only cost its creation */
+    threadCount = MAXVALUE(MINVALUE(threadCount, docNumberCount), 1);
+
+    job.documentFilenamePattern = documentFilenamePattern;
+    job.docNumbers = docNumbers;
+    job.docNumberCount = docNumberCount;
+    job.outputDirectory = outputDirectory;
+    job.nextDocument = 0;
+    job.renderedCount = 0;
+    job.failedCount = 0;
+    pthread_mutex_init(&job.mutex, NULL);
+
+    for (i = 0; i < threadCount; ++i)
+        if (pthread_create(&threads[i], NULL, BatchRender_work, &job) != 0)
+            fatalError("pthread_create error : unable to start a worker of the batch");
+    for (i = 0; i < threadCount; ++i)
+        pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&job.mutex);
+    PrintFormatCache_release(job.printFormat);
+
+    report->renderedCount = job.renderedCount;
+    report->failedCount = job.failedCount;
+    report->threadCount = threadCount;
+    report->seconds = BatchRender_getTime() - start;
+    return job.failedCount == 0;
+}
+
+/** Get the number of documents rendered per second by a batch
+ * @param report the result of the batch
+ * @return the number of documents per second
+ */
+double BatchRenderReport_getThroughput(const BatchRenderReport * report)
+{
+    if (report->seconds <= 0)
+        return 0.0;
+    return (double)report->renderedCount / report->seconds;
+}
+
+/** Render the documents of a batch until none is left
+ * @param data the job of the batch
+ * @return NULL
+ */
+static void * BatchRender_work(void * data)
+{
+    BatchRenderJob * job = data;
+    Dictionary * dictionary = Dictionary_create();
+    Document document;
+    int documentIndex;
+    int isRendered;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&job->mutex);
+        documentIndex = job->nextDocument;
+        if (documentIndex < job->docNumberCount)
+            job->nextDocument += 1;
+        pthread_mutex_unlock(&job->mutex);
+        if (documentIndex >= job->docNumberCount)
+            break;
+
+        isRendered = BatchRender_renderDocument(job, job->docNumbers[documentIndex], &document, dictionary);
+
+        pthread_mutex_lock(&job->mutex);
+        if (isRendered)
+            job->renderedCount += 1;
+        else
+            job->failedCount += 1;
+        pthread_mutex_unlock(&job->mutex);
+    }
+
+    Dictionary_destroy(dictionary);
+    return NULL;
+}
+
+/** Load a document of a batch and render it into its text file
+ * @param job the job of the batch
+ * @param docNumber the number of the document
+ * @param document the document of the worker, not initialized
+ * @param dictionary the dictionary of the worker
+ * @return a non null value if the document was rendered
+ */
+static int BatchRender_renderDocument(BatchRenderJob * job, const char * docNumber, Document * document, Dictionary * dictionary)
+{
+    char documentFilename[1024];
+    char outputFilename[1024];
+    FILE * file;
+    int isWritten;
+
+    /* the number names the files: a path separator would read or write outside of their directories */
+    if (!BatchRender_isValidDocNumber(docNumber))
+        return 0;
+    snprintf(documentFilename, 1024, job->documentFilenamePattern, docNumber);
+    snprintf(outputFilename, 1024, "%s/%s.txt", job->outputDirectory, docNumber);
+
+    Document_init(document);
+    /* the document is only read: its strings are freed all at once */
+    Document_enableArena(document);
+    /* a missing or corrupted file only fails its document, not the whole batch */
+    if (!Document_tryLoadFromFile(document, documentFilename))
+    {
+        Document_finalize(document);
+        return 0;
+    }
+    file = fopen(outputFilename, "w");
+    if (file == NULL)
+    {
+        Document_finalize(document);
+        return 0;
+    }
+
+    PrintFormat_renderTemplatesTo(job->printFormat->header, job->printFormat->row, job->printFormat->footer,
+            document, dictionary, PrintFormat_writeToFile, file);
+    isWritten = !ferror(file);
+    if (fclose(file) != 0)
+        isWritten = 0;
+    Document_finalize(document);
+    return isWritten;
+}
+
+/** Tell if a document number can be used in the names of the files of a batch
+ * @param docNumber the number of the document
+ * @return a non null value if the number is not empty and has no path separator
+ */
+static int BatchRender_isValidDocNumber(const char * docNumber)
+{
+    return docNumber[0] != '\0' && indexOfChar(docNumber, '/') == NULL && indexOfChar(docNumber, '\\') == NULL;
+}
+
+/** Get the current time
+ * @return the number of seconds since the epoch
+ */
+static double BatchRender_getTime(void)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (double)now.tv_sec + (double)now.tv_usec / 1e6;
+}
@@ -25,6 +25,8 @@
 #include <DocumentUtil.h>
 #include <Document.h>
 #include <DocumentRowList.h>
+#include <DocumentIndex.h>
+#include <GtkDocumentModel.h>
 
 /** Save a document as a bill
  * @param document the document
@@ -32,8 +34,11 @@
 void Bill_save(Document * document)
 {
   char buf[1024];
+
   snprintf(buf, 1024, BASEPATH "/data/bill-%s.dat", document->docNumber);
   Document_saveToFile(document, buf);
+
+  DocumentIndex_record(BASEPATH "/data", buf + sizeof(BASEPATH "/data/") - 1, document);
 }
 
 /** Load a document as a bill
@@ -49,43 +54,8 @@ void Bill_load(const char * docNumber, Document * document)
 
 static GtkTreeModel * Bill_loadModel(void)
 {
-  GtkListStore * store;
-  GtkTreeIter iter;
-  GDir * directory;
-  Document document;
-
-  Document_init(&document);
-
-  store = gtk_list_store_new(4, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
-
-  directory = g_dir_open(BASEPATH "/data", 0, NULL);
-  if (directory == NULL)
-  {
-    GtkWidget *errordialog;
-    errordialog = gtk_message_dialog_new(NULL, GTK_DIALOG_DESTROY_WITH_PARENT, GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
-        "Impossible de lister les factures");
-    g_signal_connect(errordialog, "response", G_CALLBACK (gtk_widget_destroy), NULL);
-    gtk_widget_show(errordialog);
-  }
-  else
-  {
-    const gchar * entry;
-    while ((entry = g_dir_read_name(directory)) != NULL)
-    {
-      if (icaseStartWith("bill-", entry) && icaseEndWith(".dat", entry))
-      {
-        char * filename = concatenateString(BASEPATH "/data/", entry);
-        Document_loadFromFile(&document, filename);
-        gtk_list_store_append(store, &iter);
-        gtk_list_store_set(store, &iter, 0, document.docNumber, 1, document.customer.name, 2, document.editDate, 3, document.object, -1);
-        free(filename);
-      }
-    }
-    g_dir_close(directory);
-  }
-
-  Document_finalize(&document);
-  return GTK_TREE_MODEL(store);
+  /* the bills are appended while the index loads the ones which changed since the last time */
+  return GtkDocumentModel_new(BILL, "Impossible de lister les factures");
 }
 
 static int Bill_select(Document * document)
@@ -0,0 +1,361 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <BlockCache.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+static int BlockCache_lookup(BlockCache * cache, long pageNumber);
+static int BlockCache_load(BlockCache * cache, int fd, long pageNumber);
+static int BlockCache_add(BlockCache * cache, long pageNumber, const char * data, size_t length);
+static void BlockCache_drop(BlockCache * cache, int entry);
+static void BlockCache_unlink(BlockCache * cache, int entry);
+static void BlockCache_pushFront(BlockCache * cache, int entry);
+static size_t BlockCache_readFile(int fd, long offset, size_t size, char * buffer);
+
+/** Initialize an empty cache
+ * @param cache the cache
+ * @param pageSize the size in bytes of a page
+ * @param budget the memory budget in bytes, at least two pages are kept
+ */
+void BlockCache_init(BlockCache * cache, size_t pageSize, size_t budget)
+{
+    int capacity = (int)MAXVALUE(budget / pageSize, 2UL);
+    int bucketCount = 1;
+    char * data;
+    int i;
+
+    if (pageSize == 0)
+        fatalError("BlockCache_init: invalid page size");
+    while (bucketCount < capacity * 2)
+        bucketCount *= 2;
+
+    cache->pages = malloc(sizeof(BlockCachePage) * (size_t)capacity);
+    cache->buckets = malloc(sizeof(int) * (size_t)bucketCount);
+    data = malloc(pageSize * (size_t)capacity);
+    if (cache->pages == NULL || cache->buckets == NULL || data == NULL)
+        fatalError("malloc error : Allocation of the block cache failed");
+    for (i = 0; i < capacity; ++i)
+        cache->pages[i].data = data + pageSize * (size_t)i;
+    if (pthread_mutex_init(&cache->mutex, NULL) != 0)
+        fatalError("pthread_mutex_init error : unable to create the lock of the block cache");
+
+    cache->capacity = capacity;
+    cache->pageSize = pageSize;
+    cache->bucketMask = bucketCount - 1;
+    cache->readAheadBuffer = NULL;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->readCount = 0;
+    BlockCache_clear(cache);
+}
+
+/** Free the memory used by a cache
+ * @param cache the cache
+ */
+void BlockCache_finalize(BlockCache * cache)
+{
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache->pages[0].data);
+    free(cache->pages);
+    free(cache->buckets);
+    free(cache->readAheadBuffer);
+    cache->pages = NULL;
+    cache->buckets = NULL;
+    cache->readAheadBuffer = NULL;
+    cache->capacity = 0;
+}
+
+/** Read some bytes of a file through a cache
+ * @param cache the cache
+ * @param fd the file descriptor of the file
+ * @param offset the offset of the first byte
+ * @param size the number of bytes
+ * @param buffer the buffer receiving the bytes
+ * @return a non null value on success, 0 if the bytes are not all in the file
+ */
+int BlockCache_read(BlockCache * cache, int fd, long offset, size_t size, char * buffer)
+{
+    int isRead = 1;
+
+    pthread_mutex_lock(&cache->mutex);
+    while (size > 0)
+    {
+        long pageNumber = offset / (long)cache->pageSize;
+        size_t pageOffset = (size_t)(offset % (long)cache->pageSize);
+        size_t length = MINVALUE(size, cache->pageSize - pageOffset);
+        int entry = BlockCache_lookup(cache, pageNumber);
+
+        if (entry != -1)
+        {
+            cache->hits += 1;
+            if (entry != cache->first)
+            {
+                BlockCache_unlink(cache, entry);
+                BlockCache_pushFront(cache, entry);
+            }
+        }
+        else
+        {
+            cache->misses += 1;
+            entry = BlockCache_load(cache, fd, pageNumber);
+        }
+
+        if (entry == -1 || pageOffset + length > cache->pages[entry].length)
+        {
+            isRead = 0;
+            break;
+        }
+        memcpy(buffer, cache->pages[entry].data + pageOffset, length);
+        buffer += length;
+        offset += (long)length;
+        size -= length;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    return isRead;
+}
+
+/** Drop the pages containing some bytes of the file, used when the bytes are written
+ * @param cache the cache
+ * @param offset the offset of the first byte
+ * @param size the number of bytes
+ */
+void BlockCache_invalidate(BlockCache * cache, long offset, size_t size)
+{
+    long pageNumber;
+    long lastPageNumber;
+
+    if (size == 0)
+        return;
+    lastPageNumber = (offset + (long)size - 1) / (long)cache->pageSize;
+    pthread_mutex_lock(&cache->mutex);
+    for (pageNumber = offset / (long)cache->pageSize; pageNumber <= lastPageNumber; ++pageNumber)
+    {
+        int entry = BlockCache_lookup(cache, pageNumber);
+        if (entry != -1)
+            BlockCache_drop(cache, entry);
+    }
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+/** Drop all the pages of a cache
+ * @param cache the cache
+ */
+void BlockCache_clear(BlockCache * cache)
+{
+    int i;
+
+    pthread_mutex_lock(&cache->mutex);
+    for (i = 0; i <= cache->bucketMask; ++i)
+        cache->buckets[i] = -1;
+    for (i = 0; i < cache->capacity; ++i)
+    {
+        cache->pages[i].pageNumber = -1;
+        cache->pages[i].length = 0;
+        cache->pages[i].hashNext = -1;
+        cache->pages[i].previous = i - 1;
+        cache->pages[i].next = (i + 1 < cache->capacity) ? i + 1 : -1;
+    }
+    cache->first = 0;
+    cache->last = cache->capacity - 1;
+    cache->lastPageNumber = -2;
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+/** Find the entry of a page
+ * @param cache the cache
+ * @param pageNumber the number of the page
+ * @return the entry or -1 if the page is not cached
+ */
+static int BlockCache_lookup(BlockCache * cache, long pageNumber)
+{
+    int entry = cache->buckets[pageNumber & cache->bucketMask];
+
+    while (entry != -1 && cache->pages[entry].pageNumber != pageNumber)
+        entry = cache->pages[entry].hashNext;
+    return entry;
+}
+
+/** Read a missing page from the file, with the following ones if the access is sequential
+ * @param cache the cache
+ * @param fd the file descriptor of the file
+ * @param pageNumber the number of the page
+ * @return the entry of the page or -1 if the page is beyond the end of the file
+ */
+static int BlockCache_load(BlockCache * cache, int fd, long pageNumber)
+{
+    int pageCount = 1;
+    int entry = -1;
+    size_t length;
+    int i;
+
+    if (pageNumber == cache->lastPageNumber + 1)
+        pageCount = MINVALUE(BLOCKCACHE_READAHEAD_PAGES, cache->capacity / 2);
+    cache->lastPageNumber = pageNumber + pageCount - 1;
+
+    if (pageCount == 1)
+    {
+        /* the page is read directly in the least recently used entry */
+        entry = cache->last;
+        if (cache->pages[entry].pageNumber != -1)
+            BlockCache_drop(cache, entry);
+        length = BlockCache_readFile(fd, pageNumber * (long)cache->pageSize, cache->pageSize, cache->pages[entry].data);
+        cache->readCount += 1;
+        if (length == 0)
+            return -1;
+        return BlockCache_add(cache, pageNumber, NULL, length);
+    }
+
+    if (cache->readAheadBuffer == NULL)
+    {
+        cache->readAheadBuffer = malloc(cache->pageSize * BLOCKCACHE_READAHEAD_PAGES);
+        if (cache->readAheadBuffer == NULL)
+            fatalError("malloc error : Allocation of the read-ahead buffer failed");
+    }
+    length = BlockCache_readFile(fd, pageNumber * (long)cache->pageSize, cache->pageSize * (size_t)pageCount, cache->readAheadBuffer);
+    cache->readCount += 1;
+    if (length == 0)
+        return -1;
+
+    /* the first page is added last so that it is the most recently used one */
+    for (i = pageCount - 1; i >= 0; --i)
+    {
+        size_t pageOffset = cache->pageSize * (size_t)i;
+
+        if (pageOffset >= length)
+            continue;
+        entry = BlockCache_lookup(cache, pageNumber + i);
+        if (entry != -1)
+            BlockCache_drop(cache, entry);
+        entry = BlockCache_add(cache, pageNumber + i, cache->readAheadBuffer + pageOffset, MINVALUE(cache->pageSize, length - pageOffset));
+    }
+    return entry;
+}
+
+/** Store a page in the least recently used entry and make it the most recently used one
+ * @param cache the cache
+ * @param pageNumber the number of the page
+ * @param data the bytes of the page, NULL if they are already in the entry
+ * @param length the number of bytes of the page
+ * @return the entry
+ */
+static int BlockCache_add(BlockCache * cache, long pageNumber, const char * data, size_t length)
+{
+    int entry = cache->last;
+    int bucket = (int)(pageNumber & cache->bucketMask);
+
+    if (cache->pages[entry].pageNumber != -1)
+        BlockCache_drop(cache, entry);
+    entry = cache->last;
+    if (data != NULL)
+        memcpy(cache->pages[entry].data, data, length);
+
+    BlockCache_unlink(cache, entry);
+    BlockCache_pushFront(cache, entry);
+    cache->pages[entry].pageNumber = pageNumber;
+    cache->pages[entry].length = length;
+    cache->pages[entry].hashNext = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    return entry;
+}
+
+/** Remove a page from the cache, its entry becoming the first one to be reused
+ * @param cache the cache
+ * @param entry the entry of the page
+ */
+static void BlockCache_drop(BlockCache * cache, int entry)
+{
+    int * link = &cache->buckets[cache->pages[entry].pageNumber & cache->bucketMask];
+
+    while (*link != entry)
+        link = &cache->pages[*link].hashNext;
+    *link = cache->pages[entry].hashNext;
+    cache->pages[entry].pageNumber = -1;
+    cache->pages[entry].length = 0;
+    cache->pages[entry].hashNext = -1;
+
+    BlockCache_unlink(cache, entry);
+    cache->pages[entry].previous = cache->last;
+    cache->pages[entry].next = -1;
+    if (cache->last != -1)
+        cache->pages[cache->last].next = entry;
+    else
+        cache->first = entry;
+    cache->last = entry;
+}
+
+/** Remove an entry from the list in the order of use
+ * @param cache the cache
+ * @param entry the entry
+ */
+static void BlockCache_unlink(BlockCache * cache, int entry)
+{
+    BlockCachePage * current = &cache->pages[entry];
+
+    if (current->previous != -1)
+        cache->pages[current->previous].next = current->next;
+    else
+        cache->first = current->next;
+    if (current->next != -1)
+        cache->pages[current->next].previous = current->previous;
+    else
+        cache->last = current->previous;
+}
+
+/** Insert an entry at the beginning of the list in the order of use
+ * @param cache the cache
+ * @param entry the entry
+ */
+static void BlockCache_pushFront(BlockCache * cache, int entry)
+{
+    cache->pages[entry].previous = -1;
+    cache->pages[entry].next = cache->first;
+    if (cache->first != -1)
+        cache->pages[cache->first].previous = entry;
+    else
+        cache->last = entry;
+    cache->first = entry;
+}
+
+/** Read bytes of a file at a given offset until the size or the end of the file is reached
+ * @param fd the file descriptor
+ * @param offset the offset of the first byte
+ * @param size the maximal number of bytes
+ * @param buffer the buffer receiving the bytes
+ * @return the number of bytes read
+ */
+static size_t BlockCache_readFile(int fd, long offset, size_t size, char * buffer)
+{
+    size_t length = 0;
+
+    while (length < size)
+    {
+        ssize_t count = pread(fd, buffer + length, size - length, (off_t)offset + (off_t)length);
+
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+            fatalError("pread error : unable to read the database");
+        if (count == 0)
+            break;
+        length += (size_t)count;
+    }
+    return length;
+}
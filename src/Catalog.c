@@ -44,11 +44,46 @@ static void Catalog_delete(GtkWidget * button, GtkTreeView * treeview);
  */
 static void Catalog_modify(GtkWidget * button, GtkTreeView * treeview);
 
+/** The maximum number of products matching a search typed in a list of products */
+#define CATALOG_SEARCH_LIMIT 50
+
+/** The state of the search typed in a list of products */
+typedef struct {
+    CatalogDB * catalogDB; /**< The database displayed by the list */
+    gchar * key; /**< The last searched text, NULL before the first search */
+    int results[CATALOG_SEARCH_LIMIT]; /**< The positions of the products matching key, best match first */
+    int count; /**< The number of products matching key */
+} CatalogSearch;
+
+/**
+ * Enable the search of the products by designation when the user types in a list of products
+ * @param treeview the GtkTreeView pointer displaying a GtkCatalogModel
+ * @param catalogDB the database displayed by the list
+ */
+static void Catalog_setupSearch(GtkTreeView * treeview, CatalogDB * catalogDB);
+
+/**
+ * Search function of the list of products: a row matches if its product is among the best matches of the key
+ * @param model the model of the list
+ * @param column the search column
+ * @param key the text typed by the user
+ * @param iter the row to test
+ * @param data the CatalogSearch pointer
+ * @return FALSE if the row matches, TRUE otherwise
+ */
+static gboolean Catalog_searchEqual(GtkTreeModel * model, gint column, const gchar * key, GtkTreeIter * iter,
+        gpointer data);
+
+/**
+ * Free the state of the search of a list of products
+ * @param data the CatalogSearch pointer
+ */
+static void Catalog_freeSearch(gpointer data);
+
 
 void Catalog_add(GtkWidget * UNUSED(button), GtkTreeView * treeview) {
     GtkTreeModel * model = gtk_tree_view_get_model(treeview);
-    GtkCatalogModel_append_record(
-            GTKCATALOGMODEL(gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (model))));
+    GtkCatalogModel_append_record(GTKCATALOGMODEL(model));
 }
 
 void Catalog_delete(GtkWidget * UNUSED(button), GtkTreeView * treeview) {
@@ -62,8 +97,8 @@ void Catalog_delete(GtkWidget * UNUSED(button), GtkTreeView * treeview) {
 
         path = gtk_tree_model_get_path(model, &iter);
         i = gtk_tree_path_get_indices(path)[0];
-        GtkCatalogModel_remove_record(
-                GTKCATALOGMODEL(gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (model))), i);
+        GtkCatalogModel_remove_record(GTKCATALOGMODEL(model),
+                GtkCatalogModel_get_record_index(GTKCATALOGMODEL(model), i));
         gtk_tree_path_free(path);
     }
 }
@@ -79,12 +114,51 @@ void Catalog_modify(GtkWidget * UNUSED(button), GtkTreeView * treeview) {
 
         path = gtk_tree_model_get_path(model, &iter);
         i = gtk_tree_path_get_indices(path)[0];
-        GtkCatalogModel_change_record(
-                GTKCATALOGMODEL(gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (model))), i);
+        GtkCatalogModel_change_record(GTKCATALOGMODEL(model),
+                GtkCatalogModel_get_record_index(GTKCATALOGMODEL(model), i));
         gtk_tree_path_free(path);
     }
 }
 
+void Catalog_setupSearch(GtkTreeView * treeview, CatalogDB * catalogDB) {
+    CatalogSearch * search = g_new(CatalogSearch, 1);
+
+    search->catalogDB = catalogDB;
+    search->key = NULL;
+    search->count = 0;
+    gtk_tree_view_set_search_equal_func(treeview, Catalog_searchEqual, search, Catalog_freeSearch);
+}
+
+gboolean Catalog_searchEqual(GtkTreeModel * model, gint UNUSED(column), const gchar * key, GtkTreeIter * iter,
+        gpointer data) {
+    CatalogSearch * search = (CatalogSearch *) data;
+    GtkTreePath * path;
+    int recordIndex;
+    int i;
+
+    /* GTK tests every row with the same key: the index is queried once per key */
+    if (search->key == NULL || g_strcmp0(search->key, key) != 0) {
+        g_free(search->key);
+        search->key = g_strdup(key);
+        search->count = CatalogDB_search(search->catalogDB, key, CATALOG_SEARCH_LIMIT, search->results);
+    }
+
+    path = gtk_tree_model_get_path(model, iter);
+    recordIndex = GtkCatalogModel_get_record_index(GTKCATALOGMODEL(model), gtk_tree_path_get_indices(path)[0]);
+    gtk_tree_path_free(path);
+    for (i = 0; i < search->count; ++i)
+        if (search->results[i] == recordIndex)
+            return FALSE;
+    return TRUE;
+}
+
+void Catalog_freeSearch(gpointer data) {
+    CatalogSearch * search = (CatalogSearch *) data;
+
+    g_free(search->key);
+    g_free(search);
+}
+
 void Catalog_manage(GtkWidget * UNUSED(widget), GtkWindow * parent) {
     CatalogDB * catalogDB = CatalogDB_openOrCreate(CATALOGDB_FILENAME);
     if (catalogDB == NULL) {
@@ -106,7 +180,7 @@ void Catalog_manage(GtkWidget * UNUSED(widget), GtkWindow * parent) {
         GtkWidget *hbox;
         GtkWidget * bbox;
         GtkWidget * sw;
-        GtkTreeModel * model, *unsortedmodel;
+        GtkTreeModel * model;
         GtkWidget *treeview;
         GtkWidget * button;
         GtkCellRenderer * renderer;
@@ -130,13 +204,16 @@ void Catalog_manage(GtkWidget * UNUSED(widget), GtkWindow * parent) {
                 GTK_POLICY_AUTOMATIC);
         gtk_box_pack_start(GTK_BOX (hbox), sw, TRUE, TRUE, 0);
 
-        unsortedmodel = GTK_TREE_MODEL(GtkCatalogModel_new(catalogDB, TRUE));
-        model = gtk_tree_model_sort_new_with_model(unsortedmodel);
+        /* browse the records directly from memory, the database still works if it can not be mapped */
+        CatalogDB_map(catalogDB);
+        /* the model sorts its rows itself, from an in-memory snapshot of the catalog */
+        model = GTK_TREE_MODEL(GtkCatalogModel_new(catalogDB, TRUE));
 
         /* create tree view */
         treeview = gtk_tree_view_new_with_model(model);
         gtk_tree_view_set_rules_hint(GTK_TREE_VIEW (treeview), TRUE);
-        gtk_tree_view_set_search_column(GTK_TREE_VIEW (treeview), 0);
+        gtk_tree_view_set_search_column(GTK_TREE_VIEW (treeview), CATALOGRECORD_DESIGNATION_FIELD);
+        Catalog_setupSearch(GTK_TREE_VIEW (treeview), catalogDB);
 
         for (columnNum = 0; columnNum < CATALOGRECORD_FIELDCOUNT; ++columnNum) {
             CatalogRecord_FieldProperties properties;
@@ -159,7 +236,6 @@ void Catalog_manage(GtkWidget * UNUSED(widget), GtkWindow * parent) {
         gtk_widget_show(treeview);
 
         g_object_unref(model);
-        g_object_unref(unsortedmodel);
 
         gtk_container_add(GTK_CONTAINER (sw), treeview);
 
@@ -204,7 +280,7 @@ int Catalog_select(GtkWindow * parent) {
         GtkWidget *hbox;
         GtkWidget * bbox;
         GtkWidget * sw;
-        GtkTreeModel * model, *unsortedmodel;
+        GtkTreeModel * model;
         GtkWidget *treeview;
         GtkWidget * button;
         GtkCellRenderer * renderer;
@@ -230,13 +306,16 @@ int Catalog_select(GtkWindow * parent) {
                 GTK_POLICY_AUTOMATIC);
         gtk_box_pack_start(GTK_BOX (hbox), sw, TRUE, TRUE, 0);
 
-        unsortedmodel = GTK_TREE_MODEL(GtkCatalogModel_new(catalogDB, TRUE));
-        model = gtk_tree_model_sort_new_with_model(unsortedmodel);
+        /* browse the records directly from memory, the database still works if it can not be mapped */
+        CatalogDB_map(catalogDB);
+        /* the model sorts its rows itself, from an in-memory snapshot of the catalog */
+        model = GTK_TREE_MODEL(GtkCatalogModel_new(catalogDB, TRUE));
 
         /* create tree view */
         treeview = gtk_tree_view_new_with_model(model);
         gtk_tree_view_set_rules_hint(GTK_TREE_VIEW (treeview), TRUE);
-        gtk_tree_view_set_search_column(GTK_TREE_VIEW (treeview), 0);
+        gtk_tree_view_set_search_column(GTK_TREE_VIEW (treeview), CATALOGRECORD_DESIGNATION_FIELD);
+        Catalog_setupSearch(GTK_TREE_VIEW (treeview), catalogDB);
 
         for (columnNum = 0; columnNum < CATALOGRECORD_FIELDCOUNT; ++columnNum) {
             CatalogRecord_FieldProperties properties;
@@ -259,7 +338,6 @@ int Catalog_select(GtkWindow * parent) {
         gtk_widget_show(treeview);
 
         g_object_unref(model);
-        g_object_unref(unsortedmodel);
 
         gtk_container_add(GTK_CONTAINER (sw), treeview);
 
@@ -295,7 +373,8 @@ int Catalog_select(GtkWindow * parent) {
                 GtkTreePath *path;
 
                 path = gtk_tree_model_get_path(model, &iter);
-                recordNum = gtk_tree_path_get_indices(path)[0];
+                recordNum = GtkCatalogModel_get_record_index(GTKCATALOGMODEL(model),
+                        gtk_tree_path_get_indices(path)[0]);
                 gtk_tree_path_free(path);
             } else
                 recordNum = -1;
@@ -21,6 +21,34 @@
 #include <CatalogRecord.h>
 #include <CatalogRecordEditor.h>
 
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void CatalogDB_flushBatch(CatalogDB * catalogDB);
+static void CatalogDB_endWrite(CatalogDB * catalogDB);
+static void CatalogDB_doInsert(CatalogDB * catalogDB, int recordIndex, CatalogRecord * record);
+static void CatalogDB_doAppend(CatalogDB * catalogDB, CatalogRecord * record);
+static void CatalogDB_doAppendMany(CatalogDB * catalogDB, CatalogRecord * records, int count);
+static void CatalogDB_doCommitBatch(CatalogDB * catalogDB);
+static void CatalogDB_allocateBatch(CatalogDB * catalogDB);
+static void CatalogDB_readBytes(CatalogDB * catalogDB, int slot, long fieldOffset, size_t size, char * buffer);
+static void CatalogDB_readSlot(CatalogDB * catalogDB, int slot, CatalogRecord * record);
+static void CatalogDB_readField(CatalogDB * catalogDB, int slot, long fieldOffset, size_t fieldSize, char * buffer);
+static void CatalogDB_buildIndexes(CatalogDB * catalogDB);
+static void CatalogDB_unindex(CatalogDB * catalogDB, const char * code, int slot);
+static void CatalogDB_renameFile(char * oldFilename, char * newFilename);
+static void CatalogDB_log(CatalogDB * catalogDB, WriteAheadLogOperation operation, int recordIndex, CatalogRecord * record);
+static void CatalogDB_checkpoint(CatalogDB * catalogDB);
+static int CatalogDB_doMap(CatalogDB * catalogDB);
+static void CatalogDB_doUnmap(CatalogDB * catalogDB);
+static int CatalogDB_doGetRecordView(CatalogDB * catalogDB, int recordIndex, CatalogRecordView * view);
+static void CatalogDB_writeSlot(CatalogDB * catalogDB, int slot, CatalogRecord * record);
+static int CatalogDB_findPending(CatalogDB * catalogDB, int slot);
+static void CatalogDB_commitGroup(CatalogDB * catalogDB);
+static void CatalogDB_applyPending(CatalogDB * catalogDB);
+
 /** The catalog file name */
 const char * CATALOGDB_FILENAME = BASEPATH "/data/Catalog.db";
 
@@ -52,6 +80,26 @@ CatalogDB * IMPLEMENT(CatalogDB_create)(const char * filename)
         fatalError("fwrite error : return value is < 1.");
     }
     catalogDB->file = file;
+    catalogDB->filename = duplicateString(filename);
+    SlotTable_init(&catalogDB->slots, 0);
+    WriteAheadLog_init(&catalogDB->log, filename, CATALOGRECORD_SIZE, &catalogDB->slots);
+    /* drop the slot table, the log and the index of a previous database with the same name */
+    SlotTable_save(&catalogDB->slots, filename);
+    WriteAheadLog_reset(&catalogDB->log);
+    CatalogIndex_remove(filename);
+    TrigramIndex_remove(filename);
+    CatalogIndex_init(&catalogDB->codeIndex);
+    CatalogIndex_clear(&catalogDB->codeIndex);
+    TrigramIndex_init(&catalogDB->designationIndex);
+    TrigramIndex_clear(&catalogDB->designationIndex);
+    catalogDB->isModified = 1;
+    catalogDB->batchBuffer = NULL;
+    catalogDB->batchCount = 0;
+    catalogDB->pendingCount = 0;
+    catalogDB->mapping = NULL;
+    catalogDB->mappingSize = 0;
+    DatabaseLock_init(&catalogDB->lock, DATABASE_PRIVATE);
+    BlockCache_init(&catalogDB->cache, BLOCKCACHE_PAGE_SIZE, BLOCKCACHE_DEFAULT_BUDGET);
 
     return catalogDB;
 }
@@ -61,8 +109,20 @@ CatalogDB * IMPLEMENT(CatalogDB_create)(const char * filename)
  * @return a pointer on a CatalogDB representing the opened database, NULL otherwise
  */
 CatalogDB * IMPLEMENT(CatalogDB_open)(const char * filename)
+{
+    return CatalogDB_openWithAccess(filename, DATABASE_PRIVATE);
+}
+
+/** Open an existing database of products and lock its file according to an access mode
+ * @param filename the file name of the database
+ * @param access the access mode
+ * @return a pointer on a CatalogDB representing the opened database, NULL if the file can not be opened or is locked by another process
+ */
+CatalogDB * CatalogDB_openWithAccess(const char * filename, DatabaseAccess access)
 {
     CatalogDB * catalogDB = malloc(sizeof(CatalogDB));
+    int replayedCount = 0;
+    int isRebuilt;
 
     if (catalogDB == NULL)
         fatalError("malloc error : Allocation of CatalogDB * catalogDB failed");
@@ -75,6 +135,15 @@ CatalogDB * IMPLEMENT(CatalogDB_open)(const char * filename)
         return NULL;
     }
 
+    DatabaseLock_init(&catalogDB->lock, access);
+    if (!DatabaseLock_lockFile(&catalogDB->lock, file))
+    {
+        DatabaseLock_finalize(&catalogDB->lock);
+        fclose(file);
+        free(catalogDB);
+        return NULL;
+    }
+
     if (fread(&catalogDB->recordCount, sizeof(int), 1, file) < 1)
     {
         fclose(file);
@@ -82,7 +151,45 @@ CatalogDB * IMPLEMENT(CatalogDB_open)(const char * filename)
         fatalError("fread error : return value is < 1");
     }
 
+    /* the header stores the number of slots, the slot table tells which ones hold a record */
+    isRebuilt = !SlotTable_load(&catalogDB->slots, file, filename, catalogDB->recordCount, CATALOGRECORD_SIZE);
+
+    /* the changes logged after the last checkpoint of a crashed session are applied again */
+    WriteAheadLog_init(&catalogDB->log, filename, CATALOGRECORD_SIZE, &catalogDB->slots);
+    if (DatabaseLock_canWriteFile(&catalogDB->lock))
+        replayedCount = WriteAheadLog_replay(&catalogDB->log, file);
+    if (replayedCount > 0 || isRebuilt)
+    {
+        CatalogIndex_remove(filename);
+        TrigramIndex_remove(filename);
+    }
+
     catalogDB->file = file;
+    catalogDB->filename = duplicateString(filename);
+    catalogDB->recordCount = catalogDB->slots.count;
+    CatalogIndex_init(&catalogDB->codeIndex);
+    CatalogIndex_load(&catalogDB->codeIndex, filename);
+    TrigramIndex_init(&catalogDB->designationIndex);
+    TrigramIndex_load(&catalogDB->designationIndex, filename);
+    catalogDB->isModified = 0;
+    catalogDB->batchBuffer = NULL;
+    catalogDB->batchCount = 0;
+    catalogDB->pendingCount = 0;
+    catalogDB->mapping = NULL;
+    catalogDB->mappingSize = 0;
+    BlockCache_init(&catalogDB->cache, BLOCKCACHE_PAGE_SIZE, BLOCKCACHE_DEFAULT_BUDGET);
+    /* a rebuilt slot table is saved at once so that the side file is repaired, nothing is left to save at close */
+    if (replayedCount > 0 || (isRebuilt && DatabaseLock_canWriteFile(&catalogDB->lock)))
+        CatalogDB_checkpoint(catalogDB);
+    else if (DatabaseLock_canWriteFile(&catalogDB->lock))
+        WriteAheadLog_reset(&catalogDB->log);
+
+    /* a reader let the other readers in once the file is repaired */
+    if (!DatabaseLock_shareFile(&catalogDB->lock))
+    {
+        CatalogDB_close(catalogDB);
+        return NULL;
+    }
 
     return catalogDB;
 }
@@ -105,14 +212,30 @@ CatalogDB * IMPLEMENT(CatalogDB_openOrCreate)(const char * filename)
  */
 void IMPLEMENT(CatalogDB_close)(CatalogDB * catalogDB)
 {
-    rewind(catalogDB->file);
-    if (fwrite(&catalogDB->recordCount, sizeof(int), 1, catalogDB->file) < 1)
+    if (catalogDB->batchBuffer != NULL)
+        CatalogDB_commitBatch(catalogDB);
+    CatalogDB_unmap(catalogDB);
+    if (catalogDB->isModified && DatabaseLock_canWriteFile(&catalogDB->lock))
+        CatalogDB_checkpoint(catalogDB);
+
+    /* the indexes are stamped with the database file as it is now on disk, the readers leave them to the writers */
+    if (DatabaseLock_canWriteFile(&catalogDB->lock))
     {
-        fclose(catalogDB->file);
-        free(catalogDB);
-        fatalError("fwrite error : return value is < 1");
+        if (catalogDB->isModified || catalogDB->codeIndex.isModified)
+            CatalogIndex_save(&catalogDB->codeIndex, catalogDB->filename);
+        if (catalogDB->isModified || catalogDB->designationIndex.isModified)
+            TrigramIndex_save(&catalogDB->designationIndex, catalogDB->filename);
     }
+
+    DatabaseLock_finalize(&catalogDB->lock);
     fclose(catalogDB->file);
+
+    CatalogIndex_finalize(&catalogDB->codeIndex);
+    TrigramIndex_finalize(&catalogDB->designationIndex);
+    WriteAheadLog_finalize(&catalogDB->log);
+    SlotTable_finalize(&catalogDB->slots);
+    BlockCache_finalize(&catalogDB->cache);
+    free(catalogDB->filename);
     free(catalogDB);
 }
 
@@ -121,7 +244,12 @@ void IMPLEMENT(CatalogDB_close)(CatalogDB * catalogDB)
  * @return the number of records
  */
 int IMPLEMENT(CatalogDB_getRecordCount)(CatalogDB * catalogDB) {
-    return catalogDB->recordCount;
+    int recordCount;
+
+    DatabaseLock_beginRead(&catalogDB->lock);
+    recordCount = catalogDB->recordCount;
+    DatabaseLock_endRead(&catalogDB->lock);
+    return recordCount;
 }
 
 /** Create a new string on the heap containing the value of the specified field for the specified record of a database
@@ -134,7 +262,10 @@ int IMPLEMENT(CatalogDB_getRecordCount)(CatalogDB * catalogDB) {
  */
 char * CatalogDB_getFieldValueAsString(CatalogDB * catalogDB, int recordIndex, int field) {
     char * content = NULL;
-    if (catalogDB != NULL) {
+    if (catalogDB != NULL && catalogDB->mapping != NULL) {
+        char buffer[CATALOGRECORD_MAXSTRING_SIZE];
+        content = duplicateString(CatalogDB_getFieldValue(catalogDB, recordIndex, field, buffer, sizeof(buffer)));
+    } else if (catalogDB != NULL) {
         CatalogRecord_FieldProperties properties = CatalogRecord_getFieldProperties(field);
         CatalogRecord record;
         CatalogRecord_init(&record);
@@ -151,11 +282,9 @@ char * CatalogDB_getFieldValueAsString(CatalogDB * catalogDB, int recordIndex, i
  */
 void IMPLEMENT(CatalogDB_appendRecord)(CatalogDB * catalogDB, CatalogRecord *record)
 {
-    rewind(catalogDB->file);
-    fseek(catalogDB->file, (int)sizeof(int) + (int)CATALOGRECORD_SIZE * catalogDB->recordCount, SEEK_CUR);
-    catalogDB->recordCount += 1;
-    CatalogRecord_write(record, catalogDB->file);
-    rewind(catalogDB->file);
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_doAppend(catalogDB, record);
+    CatalogDB_endWrite(catalogDB);
 }
 
 /** Insert the specified record at the given position in the database
@@ -165,24 +294,45 @@ void IMPLEMENT(CatalogDB_appendRecord)(CatalogDB * catalogDB, CatalogRecord *rec
  */
 void IMPLEMENT(CatalogDB_insertRecord)(CatalogDB * catalogDB, int recordIndex, CatalogRecord * record)
 {
-    int recordCount = CatalogDB_getRecordCount(catalogDB);
-    CatalogRecord * recordCopie = malloc(sizeof(CatalogRecord));
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_doInsert(catalogDB, recordIndex, record);
+    CatalogDB_endWrite(catalogDB);
+}
 
-    if (recordCopie == NULL)
-        fatalError("malloc error : Allocation of CatalogRecord * recordCopie failed");
+/** Insert a record at the given position in the database while the database is locked
+ * @param catalogDB the database
+ * @param recordIndex the insertion position
+ * @param record the record
+ */
+static void CatalogDB_doInsert(CatalogDB * catalogDB, int recordIndex, CatalogRecord * record)
+{
+    int slot;
 
-    CatalogRecord_init(recordCopie);
+    CatalogDB_flushBatch(catalogDB);
+    if (recordIndex > catalogDB->recordCount || recordIndex < 0)
+        fatalError("Error : recordIndex is too higher or too smaller than recordCount");
+    CatalogDB_log(catalogDB, WRITEAHEADLOG_INSERT, recordIndex, record);
+    slot = SlotTable_insert(&catalogDB->slots, recordIndex);
+    catalogDB->recordCount = catalogDB->slots.count;
+    catalogDB->isModified = 1;
 
-    while (recordCount != recordIndex)
-    {
-        CatalogDB_readRecord(catalogDB, recordCount-1, recordCopie);
-        CatalogDB_writeRecord(catalogDB, recordCount, recordCopie);
-        recordCount--;
-    }
+    CatalogDB_writeSlot(catalogDB, slot, record);
+    if (catalogDB->codeIndex.isValid)
+        CatalogIndex_add(&catalogDB->codeIndex, record->code, slot);
+    if (catalogDB->designationIndex.isValid)
+        TrigramIndex_add(&catalogDB->designationIndex, record->designation, slot);
+}
 
-    CatalogRecord_finalize(recordCopie);
-    free(recordCopie);
-    CatalogDB_writeRecord(catalogDB, recordIndex, record);
+/** Append a record at the end of the database while the database is locked
+ * @param catalogDB the database
+ * @param record the record
+ */
+static void CatalogDB_doAppend(CatalogDB * catalogDB, CatalogRecord * record)
+{
+    if (catalogDB->batchBuffer != NULL)
+        CatalogDB_doAppendMany(catalogDB, record, 1);
+    else
+        CatalogDB_doInsert(catalogDB, catalogDB->recordCount, record);
 }
 
 /** Remove a record at a given position from the database
@@ -191,28 +341,32 @@ void IMPLEMENT(CatalogDB_insertRecord)(CatalogDB * catalogDB, int recordIndex, C
  */
 void IMPLEMENT(CatalogDB_removeRecord)(CatalogDB * catalogDB, int recordIndex)
 {
-    int recordCount = CatalogDB_getRecordCount(catalogDB);
-    CatalogRecord * recordCopie = malloc(sizeof(CatalogRecord));
-
-    if (recordCopie == NULL)
-        fatalError("malloc error : Allocation of CatalogRecord * recordCopie failed");
-
-    CatalogRecord_init(recordCopie);
+    char code[CATALOGRECORD_CODE_SIZE];
+    char designation[CATALOGRECORD_DESIGNATION_SIZE];
+    int slot;
 
-    if (recordIndex >= recordCount || recordIndex < 0 )
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_flushBatch(catalogDB);
+    if (recordIndex >= catalogDB->recordCount || recordIndex < 0 )
         fatalError("Error : recordIndex is too higher or too smaller than recordCount");
 
-    rewind(catalogDB->file);
+    slot = SlotTable_getSlot(&catalogDB->slots, recordIndex);
+    if (catalogDB->codeIndex.isValid)
+        CatalogDB_readField(catalogDB, slot, 0, CATALOGRECORD_CODE_SIZE, code);
+    if (catalogDB->designationIndex.isValid)
+        CatalogDB_readField(catalogDB, slot, CATALOGRECORD_CODE_SIZE, CATALOGRECORD_DESIGNATION_SIZE, designation);
 
-    while (recordIndex != recordCount - 1)
-    {
-        CatalogDB_readRecord(catalogDB, recordIndex+1, recordCopie);
-        CatalogDB_writeRecord(catalogDB, recordIndex, recordCopie);
-        recordIndex++;
-    }
-    catalogDB->recordCount -= 1;
-    CatalogRecord_finalize(recordCopie);
-    free(recordCopie);
+    CatalogDB_log(catalogDB, WRITEAHEADLOG_REMOVE, recordIndex, NULL);
+    SlotTable_remove(&catalogDB->slots, recordIndex);
+    catalogDB->recordCount = catalogDB->slots.count;
+    catalogDB->isModified = 1;
+
+    CatalogDB_writeSlot(catalogDB, slot, NULL);
+    if (catalogDB->codeIndex.isValid)
+        CatalogDB_unindex(catalogDB, code, slot);
+    if (catalogDB->designationIndex.isValid)
+        TrigramIndex_delete(&catalogDB->designationIndex, designation, slot);
+    CatalogDB_endWrite(catalogDB);
 }
 
 /** Read a record from the database
@@ -222,8 +376,11 @@ void IMPLEMENT(CatalogDB_removeRecord)(CatalogDB * catalogDB, int recordIndex)
  */
 void IMPLEMENT(CatalogDB_readRecord)(CatalogDB * catalogDB, int recordIndex, CatalogRecord * record)
 {
-    fseek(catalogDB->file, (int)sizeof(int) + (int)CATALOGRECORD_SIZE * recordIndex, SEEK_SET);
-    CatalogRecord_read(record, catalogDB->file);
+    DatabaseLock_beginRead(&catalogDB->lock);
+    if (recordIndex >= catalogDB->recordCount || recordIndex < 0)
+        fatalError("Error : recordIndex is too higher or too smaller than recordCount");
+    CatalogDB_readSlot(catalogDB, SlotTable_getSlot(&catalogDB->slots, recordIndex), record);
+    DatabaseLock_endRead(&catalogDB->lock);
 }
 
 /** Write a record from the database
@@ -233,13 +390,753 @@ void IMPLEMENT(CatalogDB_readRecord)(CatalogDB * catalogDB, int recordIndex, Cat
  */
 void IMPLEMENT(CatalogDB_writeRecord)(CatalogDB * catalogDB, int recordIndex, CatalogRecord * record)
 {
-    if (recordIndex < CatalogDB_getRecordCount(catalogDB))
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_flushBatch(catalogDB);
+    if (recordIndex < catalogDB->recordCount)
     {
-        rewind(catalogDB->file);
-        fseek(catalogDB->file, (int)sizeof(int) + (int)CATALOGRECORD_SIZE * recordIndex, SEEK_CUR);
-        CatalogRecord_write(record, catalogDB->file);
+        int slot = SlotTable_getSlot(&catalogDB->slots, recordIndex);
+        char code[CATALOGRECORD_CODE_SIZE];
+        char newCode[CATALOGRECORD_CODE_SIZE];
+        char designation[CATALOGRECORD_DESIGNATION_SIZE];
+        char newDesignation[CATALOGRECORD_DESIGNATION_SIZE];
+
+        if (catalogDB->codeIndex.isValid)
+        {
+            CatalogDB_readField(catalogDB, slot, 0, CATALOGRECORD_CODE_SIZE, code);
+            copyStringWithLength(newCode, record->code, CATALOGRECORD_CODE_SIZE);
+            if (compareString(code, newCode) != 0)
+            {
+                CatalogDB_unindex(catalogDB, code, slot);
+                CatalogIndex_add(&catalogDB->codeIndex, newCode, slot);
+            }
+        }
+        if (catalogDB->designationIndex.isValid)
+        {
+            CatalogDB_readField(catalogDB, slot, CATALOGRECORD_CODE_SIZE, CATALOGRECORD_DESIGNATION_SIZE, designation);
+            copyStringWithLength(newDesignation, record->designation, CATALOGRECORD_DESIGNATION_SIZE);
+            if (compareString(designation, newDesignation) != 0)
+            {
+                TrigramIndex_delete(&catalogDB->designationIndex, designation, slot);
+                TrigramIndex_add(&catalogDB->designationIndex, newDesignation, slot);
+            }
+        }
+        CatalogDB_log(catalogDB, WRITEAHEADLOG_WRITE, recordIndex, record);
+        catalogDB->isModified = 1;
+        CatalogDB_writeSlot(catalogDB, slot, record);
     }
     else
-        CatalogDB_appendRecord(catalogDB, record);
+        CatalogDB_doAppend(catalogDB, record);
+    CatalogDB_endWrite(catalogDB);
+}
+
+/** Map the database file in memory so that records can be browsed without any system call or allocation
+ * @param catalogDB the database
+ * @return a non null value if the database is mapped, 0 otherwise
+ */
+int CatalogDB_map(CatalogDB * catalogDB)
+{
+    int isMapped;
+
+    /* no reader may hold a view into the mapping while it is replaced */
+    DatabaseLock_beginExclusive(&catalogDB->lock);
+    CatalogDB_flushBatch(catalogDB);
+    CatalogDB_commitGroup(catalogDB);
+    isMapped = CatalogDB_doMap(catalogDB);
+    DatabaseLock_endWrite(&catalogDB->lock);
+    return isMapped;
+}
+
+/** Release the memory mapping of a database
+ * @param catalogDB the database
+ */
+void CatalogDB_unmap(CatalogDB * catalogDB)
+{
+    DatabaseLock_beginExclusive(&catalogDB->lock);
+    CatalogDB_doUnmap(catalogDB);
+    DatabaseLock_endWrite(&catalogDB->lock);
+}
+
+/** Get a read-only view on a record of a mapped database
+ * @param catalogDB the database
+ * @param recordIndex the position of the record
+ * @param view the view to fill
+ * @return a non null value on success, 0 otherwise
+ */
+int CatalogDB_getRecordView(CatalogDB * catalogDB, int recordIndex, CatalogRecordView * view)
+{
+    int isViewed;
+
+    DatabaseLock_beginRead(&catalogDB->lock);
+    isViewed = CatalogDB_doGetRecordView(catalogDB, recordIndex, view);
+    DatabaseLock_endRead(&catalogDB->lock);
+    return isViewed;
+}
+
+/** Get the value of the specified field for the specified record of a database as a string without allocating memory
+ * @param catalogDB the database
+ * @param recordIndex the record index
+ * @param field the field to query
+ * @param buffer a buffer used to store the value when it can not be returned directly from the mapping
+ * @param bufferSize the size of the buffer
+ * @return a pointer on the value, either in the mapping of the database or in buffer
+ */
+const char * CatalogDB_getFieldValue(CatalogDB * catalogDB, int recordIndex, int field, char * buffer, size_t bufferSize)
+{
+    CatalogRecordView view;
+    const char * value = buffer;
+    int isViewed;
+
+    DatabaseLock_beginRead(&catalogDB->lock);
+    isViewed = CatalogDB_doGetRecordView(catalogDB, recordIndex, &view);
+    if (isViewed)
+    {
+        switch (field)
+        {
+            case CATALOGRECORD_CODE_FIELD:
+                value = view.code;
+                break;
+            case CATALOGRECORD_DESIGNATION_FIELD:
+                value = view.designation;
+                break;
+            case CATALOGRECORD_UNITY_FIELD:
+                value = view.unity;
+                break;
+            case CATALOGRECORD_BASEPRICE_FIELD:
+                snprintf(buffer, bufferSize, "%.2f", view.basePrice);
+                break;
+            case CATALOGRECORD_SELLINGPRICE_FIELD:
+                snprintf(buffer, bufferSize, "%.2f", view.sellingPrice);
+                break;
+            case CATALOGRECORD_RATEOFVAT_FIELD:
+                snprintf(buffer, bufferSize, "%.2f", view.rateOfVAT);
+                break;
+            default:
+                fatalError("CatalogDB_getFieldValue: invalid field");
+        }
+    }
+    DatabaseLock_endRead(&catalogDB->lock);
+
+    /* CatalogDB_getFieldValueAsString() would come back here for a mapped database */
+    if (!isViewed)
+    {
+        CatalogRecord_FieldProperties properties = CatalogRecord_getFieldProperties(field);
+        CatalogRecord record;
+        char * content;
+
+        CatalogRecord_init(&record);
+        CatalogDB_readRecord(catalogDB, recordIndex, &record);
+        content = (*properties.getValue)(&record);
+        copyStringWithLength(buffer, content, bufferSize);
+        free(content);
+        CatalogRecord_finalize(&record);
+    }
+    return value;
+}
+
+/** Map the database file in memory while the database is locked exclusively
+ * @param catalogDB the database
+ * @return a non null value if the database is mapped, 0 otherwise
+ */
+static int CatalogDB_doMap(CatalogDB * catalogDB)
+{
+    struct stat status;
+    void * mapping;
+
+    CatalogDB_doUnmap(catalogDB);
+    if (fflush(catalogDB->file) != 0 || fstat(fileno(catalogDB->file), &status) != 0)
+        return 0;
+    /* an empty database has nothing to map but must still be considered as mapped */
+    if (status.st_size < (off_t)sizeof(int))
+        status.st_size = (off_t)sizeof(int);
+
+    mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fileno(catalogDB->file), 0);
+    if (mapping == MAP_FAILED)
+        return 0;
+
+    catalogDB->mapping = (const char *)mapping;
+    catalogDB->mappingSize = (size_t)status.st_size;
+    return 1;
+}
+
+/** Release the memory mapping of a database while the database is locked exclusively
+ * @param catalogDB the database
+ */
+static void CatalogDB_doUnmap(CatalogDB * catalogDB)
+{
+    if (catalogDB->mapping != NULL)
+        munmap((void *)catalogDB->mapping, catalogDB->mappingSize);
+    catalogDB->mapping = NULL;
+    catalogDB->mappingSize = 0;
+}
+
+/** Get a read-only view on a record of a mapped database while the database is locked
+ * @param catalogDB the database
+ * @param recordIndex the position of the record
+ * @param view the view to fill
+ * @return a non null value on success, 0 if the record is not in the mapping
+ */
+static int CatalogDB_doGetRecordView(CatalogDB * catalogDB, int recordIndex, CatalogRecordView * view)
+{
+    const char * base;
+    size_t offset;
+    int slot;
+
+    if (catalogDB->mapping == NULL || recordIndex < 0 || recordIndex >= catalogDB->recordCount)
+        return 0;
+    /* the records of the current batch, the pending ones and the ones appended since the mapping are read from the file */
+    slot = SlotTable_getSlot(&catalogDB->slots, recordIndex);
+    if (slot >= catalogDB->slots.slotCount - catalogDB->batchCount || CatalogDB_findPending(catalogDB, slot) != -1)
+        return 0;
+    offset = (size_t)sizeof(int) + (size_t)CATALOGRECORD_SIZE * (size_t)slot;
+    if (offset + CATALOGRECORD_SIZE > catalogDB->mappingSize)
+        return 0;
+
+    base = catalogDB->mapping + offset;
+    view->code = base;
+    base += CATALOGRECORD_CODE_SIZE;
+    view->designation = base;
+    base += CATALOGRECORD_DESIGNATION_SIZE;
+    view->unity = base;
+    base += CATALOGRECORD_UNITY_SIZE;
+    memcpy(&view->basePrice, base, CATALOGRECORD_BASEPRICE_SIZE);
+    base += CATALOGRECORD_BASEPRICE_SIZE;
+    memcpy(&view->sellingPrice, base, CATALOGRECORD_SELLINGPRICE_SIZE);
+    base += CATALOGRECORD_SELLINGPRICE_SIZE;
+    memcpy(&view->rateOfVAT, base, CATALOGRECORD_RATEOFVAT_SIZE);
+    return 1;
+}
+
+/** Write the records buffered by the current batch at the end of the database file
+ * @param catalogDB the database
+ */
+static void CatalogDB_flushBatch(CatalogDB * catalogDB)
+{
+    long offset;
+
+    if (catalogDB->batchCount == 0)
+        return;
+
+    offset = (long)sizeof(int) + (long)CATALOGRECORD_SIZE * (long)(catalogDB->slots.slotCount - catalogDB->batchCount);
+    if (fseek(catalogDB->file, offset, SEEK_SET) != 0)
+        fatalError("fseek error : unable to reach the end of the database");
+    if (fwrite(catalogDB->batchBuffer, CATALOGRECORD_SIZE, (size_t)catalogDB->batchCount, catalogDB->file) < (size_t)catalogDB->batchCount)
+        fatalError("fwrite error : return value is not valid.");
+    BlockCache_invalidate(&catalogDB->cache, offset, CATALOGRECORD_SIZE * (size_t)catalogDB->batchCount);
+    catalogDB->batchCount = 0;
+    /* the records are read with pread() which does not see the buffer of the FILE */
+    if (fflush(catalogDB->file) != 0)
+        fatalError("fflush error : unable to write the database");
 }
 
+/** Start a batch of appends on the database
+ * @param catalogDB the database
+ */
+void CatalogDB_beginBatch(CatalogDB * catalogDB)
+{
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_allocateBatch(catalogDB);
+    DatabaseLock_endWrite(&catalogDB->lock);
+}
+
+/** Allocate the buffer of a batch if no batch is started
+ * @param catalogDB the database
+ */
+static void CatalogDB_allocateBatch(CatalogDB * catalogDB)
+{
+    if (catalogDB->batchBuffer != NULL)
+        return;
+
+    catalogDB->batchBuffer = malloc(CATALOGRECORD_SIZE * CATALOGDB_BATCH_SIZE);
+    if (catalogDB->batchBuffer == NULL)
+        fatalError("malloc error : Allocation of the batch buffer failed");
+    catalogDB->batchCount = 0;
+}
+
+/** Append several records at the end of the database
+ * @param catalogDB the database
+ * @param records the array of records to append
+ * @param count the number of records in the array
+ */
+void CatalogDB_appendMany(CatalogDB * catalogDB, CatalogRecord * records, int count)
+{
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_doAppendMany(catalogDB, records, count);
+    CatalogDB_endWrite(catalogDB);
+}
+
+/** Append several records at the end of the database while the database is locked
+ * @param catalogDB the database
+ * @param records the array of records to append
+ * @param count the number of records in the array
+ */
+static void CatalogDB_doAppendMany(CatalogDB * catalogDB, CatalogRecord * records, int count)
+{
+    int i;
+    int slot;
+    int isImplicitBatch = (catalogDB->batchBuffer == NULL);
+
+    catalogDB->isModified = 1;
+
+    if (isImplicitBatch)
+        CatalogDB_allocateBatch(catalogDB);
+
+    for (i = 0; i < count; ++i)
+    {
+        if (catalogDB->batchCount == CATALOGDB_BATCH_SIZE)
+            CatalogDB_flushBatch(catalogDB);
+        CatalogRecord_encode(&records[i], catalogDB->batchBuffer + CATALOGRECORD_SIZE * (size_t)catalogDB->batchCount);
+        catalogDB->batchCount += 1;
+        slot = SlotTable_append(&catalogDB->slots);
+        catalogDB->recordCount = catalogDB->slots.count;
+        if (catalogDB->codeIndex.isValid)
+            CatalogIndex_add(&catalogDB->codeIndex, records[i].code, slot);
+        if (catalogDB->designationIndex.isValid)
+            TrigramIndex_add(&catalogDB->designationIndex, records[i].designation, slot);
+    }
+
+    if (isImplicitBatch)
+        CatalogDB_doCommitBatch(catalogDB);
+}
+
+/** Write the pending records of the current batch and update the header of the database file
+ * @param catalogDB the database
+ */
+void CatalogDB_commitBatch(CatalogDB * catalogDB)
+{
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_doCommitBatch(catalogDB);
+    CatalogDB_endWrite(catalogDB);
+}
+
+/** Write the pending records of the current batch while the database is locked
+ * @param catalogDB the database
+ */
+static void CatalogDB_doCommitBatch(CatalogDB * catalogDB)
+{
+    if (catalogDB->batchBuffer == NULL)
+        return;
+
+    CatalogDB_flushBatch(catalogDB);
+    free(catalogDB->batchBuffer);
+    catalogDB->batchBuffer = NULL;
+
+    /* the appends of a batch are not logged, they are saved by a checkpoint */
+    CatalogDB_checkpoint(catalogDB);
+}
+
+/** Force the logged changes of the database to the disk so that they survive a crash
+ * @param catalogDB the database
+ */
+void CatalogDB_sync(CatalogDB * catalogDB)
+{
+    DatabaseLock_beginWrite(&catalogDB->lock);
+    CatalogDB_commitGroup(catalogDB);
+    CatalogDB_endWrite(catalogDB);
+}
+
+/** Replace the cache through which the records of the database are read
+ * @param catalogDB the database
+ * @param pageSize the size in bytes of a page
+ * @param budget the memory budget in bytes of the cache
+ */
+void CatalogDB_setCache(CatalogDB * catalogDB, size_t pageSize, size_t budget)
+{
+    DatabaseLock_beginExclusive(&catalogDB->lock);
+    BlockCache_finalize(&catalogDB->cache);
+    BlockCache_init(&catalogDB->cache, pageSize, budget);
+    DatabaseLock_endWrite(&catalogDB->lock);
+}
+
+/** Call a function for each record of the database in the order they are stored in the file
+ * @param catalogDB the database
+ * @param visitor the function called for each record
+ * @param data the data given to the function
+ * @return the number of records visited
+ */
+int CatalogDB_forEach(CatalogDB * catalogDB, CatalogDB_Visitor visitor, void * data)
+{
+    CatalogRecord record;
+    int visitedCount = 0;
+    int slot;
+
+    CatalogRecord_init(&record);
+    DatabaseLock_beginRead(&catalogDB->lock);
+    for (slot = 0; slot < catalogDB->slots.slotCount; ++slot)
+    {
+        int recordIndex = SlotTable_getIndex(&catalogDB->slots, slot);
+
+        if (recordIndex == -1)
+            continue;
+        CatalogDB_readSlot(catalogDB, slot, &record);
+        visitedCount += 1;
+        if ((*visitor)(recordIndex, &record, data))
+            break;
+    }
+    DatabaseLock_endRead(&catalogDB->lock);
+    CatalogRecord_finalize(&record);
+    return visitedCount;
+}
+
+/** Find a record by its code using the index of the database
+ * @param catalogDB the database
+ * @param code the code of the product
+ * @param record the record to fill with data if a product has this code, may be NULL
+ * @return the position of a product with this code, -1 if there is no such product
+ */
+int CatalogDB_findRecordByCode(CatalogDB * catalogDB, const char * code, CatalogRecord * record)
+{
+    CatalogIndexEntry * entry;
+    int recordIndex = -1;
+
+    /* the index may be built on the fly so the lookup is exclusive */
+    DatabaseLock_beginExclusive(&catalogDB->lock);
+    CatalogDB_flushBatch(catalogDB);
+    if (!catalogDB->codeIndex.isValid)
+        CatalogDB_buildIndexes(catalogDB);
+
+    entry = CatalogIndex_find(&catalogDB->codeIndex, code);
+    if (entry != NULL)
+        recordIndex = SlotTable_getIndex(&catalogDB->slots, entry->slot);
+    if (recordIndex != -1 && record != NULL)
+        CatalogDB_readSlot(catalogDB, entry->slot, record);
+    DatabaseLock_endWrite(&catalogDB->lock);
+    return recordIndex;
+}
+
+/** Search the products whose designation best matches a query
+ * @param catalogDB the database
+ * @param query the words to search, the last one may be the beginning of a word
+ * @param limit the maximum number of products to return
+ * @param recordIndexes the array of at least limit elements receiving the positions of the products, best match first
+ * @return the number of products found
+ */
+int CatalogDB_search(CatalogDB * catalogDB, const char * query, int limit, int * recordIndexes)
+{
+    int count;
+    int i;
+
+    DatabaseLock_beginExclusive(&catalogDB->lock);
+    CatalogDB_flushBatch(catalogDB);
+    if (!catalogDB->designationIndex.isValid)
+        CatalogDB_buildIndexes(catalogDB);
+
+    /* the index works on slots which are translated into positions in place */
+    count = TrigramIndex_search(&catalogDB->designationIndex, query, catalogDB->slots.slotCount, limit, recordIndexes);
+    for (i = 0; i < count; ++i)
+        recordIndexes[i] = SlotTable_getIndex(&catalogDB->slots, recordIndexes[i]);
+    DatabaseLock_endWrite(&catalogDB->lock);
+    return count;
+}
+
+/** Rewrite a closed database so that its records are stored densely in their logical order
+ * @param filename the file name of the database
+ * @return a non null value on success, 0 otherwise
+ */
+int CatalogDB_compact(const char * filename)
+{
+    CatalogDB * source;
+    CatalogDB * target;
+    CatalogRecord record;
+    char * compactFilename;
+    struct stat status;
+    int i;
+
+    /* nothing is compacted before the database is created */
+    if (stat(filename, &status) != 0 && errno == ENOENT)
+        return 1;
+    /* the lock of the file keeps a process using the database away while it is rewritten */
+    source = CatalogDB_openWithAccess(filename, DATABASE_WRITER);
+    if (source == NULL)
+        return 0;
+    if (source->slots.isIdentity)
+    {
+        CatalogDB_close(source);
+        return 1;
+    }
+
+    compactFilename = concatenateString(filename, ".compact");
+    target = CatalogDB_create(compactFilename);
+    if (target == NULL)
+    {
+        CatalogDB_close(source);
+        free(compactFilename);
+        return 0;
+    }
+
+    CatalogRecord_init(&record);
+    CatalogDB_beginBatch(target);
+    for (i = 0; i < source->recordCount; ++i)
+    {
+        CatalogDB_readRecord(source, i, &record);
+        CatalogDB_appendRecord(target, &record);
+    }
+    CatalogRecord_finalize(&record);
+    CatalogDB_close(target);
+    CatalogDB_close(source);
+
+    if (rename(compactFilename, filename) != 0)
+    {
+        remove(compactFilename);
+        free(compactFilename);
+        return 0;
+    }
+    /* renaming keeps the size and the modification time so the indexes of the new file stay valid */
+    CatalogDB_renameFile(CatalogIndex_getFilename(compactFilename), CatalogIndex_getFilename(filename));
+    CatalogDB_renameFile(TrigramIndex_getFilename(compactFilename), TrigramIndex_getFilename(filename));
+    free(compactFilename);
+
+    /* the records are now stored in their logical order */
+    compactFilename = SlotTable_getFilename(filename);
+    remove(compactFilename);
+    free(compactFilename);
+    return 1;
+}
+
+/** Read a field stored in a slot of the database file
+ * @param catalogDB the database
+ * @param slot the slot
+ * @param fieldOffset the offset of the field in the record
+ * @param fieldSize the size of the field
+ * @param buffer the buffer of fieldSize characters receiving the field
+ */
+static void CatalogDB_readField(CatalogDB * catalogDB, int slot, long fieldOffset, size_t fieldSize, char * buffer)
+{
+    CatalogDB_readBytes(catalogDB, slot, fieldOffset, fieldSize, buffer);
+    buffer[fieldSize - 1] = '\0';
+}
+
+/** Read some bytes of a slot without using the position of the database file
+ *
+ * The pending slots and the slots of the current batch are read from memory, the
+ * other ones from the mapping of the file if it covers them or through the page cache.
+ * @param catalogDB the database
+ * @param slot the slot
+ * @param fieldOffset the offset of the first byte in the record
+ * @param size the number of bytes
+ * @param buffer the buffer of size characters receiving the bytes
+ */
+static void CatalogDB_readBytes(CatalogDB * catalogDB, int slot, long fieldOffset, size_t size, char * buffer)
+{
+    int firstBatchSlot = catalogDB->slots.slotCount - catalogDB->batchCount;
+    long offset = (long)sizeof(int) + (long)CATALOGRECORD_SIZE * (long)slot + fieldOffset;
+    int pending = CatalogDB_findPending(catalogDB, slot);
+
+    if (pending != -1)
+        memcpy(buffer, catalogDB->pendingRecords + CATALOGRECORD_SIZE * (size_t)pending + (size_t)fieldOffset, size);
+    else if (slot >= firstBatchSlot)
+        memcpy(buffer, catalogDB->batchBuffer + CATALOGRECORD_SIZE * (size_t)(slot - firstBatchSlot) + (size_t)fieldOffset, size);
+    else if (catalogDB->mapping != NULL && (size_t)offset + size <= catalogDB->mappingSize)
+        memcpy(buffer, catalogDB->mapping + offset, size);
+    else if (!BlockCache_read(&catalogDB->cache, fileno(catalogDB->file), offset, size, buffer))
+        fatalError("pread error : unable to read a record");
+}
+
+/** Read the record stored in a slot without using the position of the database file
+ * @param catalogDB the database
+ * @param slot the slot
+ * @param record the record to fill with data
+ */
+static void CatalogDB_readSlot(CatalogDB * catalogDB, int slot, CatalogRecord * record)
+{
+    char buffer[CATALOGRECORD_SIZE];
+
+    CatalogDB_readBytes(catalogDB, slot, 0, CATALOGRECORD_SIZE, buffer);
+    CatalogRecord_decode(record, buffer);
+}
+
+/** End a modification of the database so that the other threads see the written records
+ * @param catalogDB the database
+ */
+static void CatalogDB_endWrite(CatalogDB * catalogDB)
+{
+    if (fflush(catalogDB->file) != 0)
+        fatalError("fflush error : unable to write the database");
+    DatabaseLock_endWrite(&catalogDB->lock);
+}
+
+/** Build the invalid indexes of a database by reading all its slots sequentially
+ * @param catalogDB the database
+ */
+static void CatalogDB_buildIndexes(CatalogDB * catalogDB)
+{
+    char buffer[CATALOGRECORD_SIZE];
+    int isCodeIndexBuilt = !catalogDB->codeIndex.isValid;
+    int isDesignationIndexBuilt = !catalogDB->designationIndex.isValid;
+    int slot;
+
+    if (isCodeIndexBuilt)
+        CatalogIndex_clear(&catalogDB->codeIndex);
+    if (isDesignationIndexBuilt)
+        TrigramIndex_clear(&catalogDB->designationIndex);
+    /* the file is read sequentially so the pending slots must be written first */
+    CatalogDB_commitGroup(catalogDB);
+    if (fseek(catalogDB->file, (long)sizeof(int), SEEK_SET) != 0)
+        fatalError("fseek error : unable to read the database");
+    for (slot = 0; slot < catalogDB->slots.slotCount; ++slot)
+    {
+        if (fread(buffer, CATALOGRECORD_SIZE, 1, catalogDB->file) < 1)
+            fatalError("fread error : unable to read the database");
+        if (SlotTable_getIndex(&catalogDB->slots, slot) == -1)
+            continue;
+        buffer[CATALOGRECORD_CODE_SIZE - 1] = '\0';
+        buffer[CATALOGRECORD_CODE_SIZE + CATALOGRECORD_DESIGNATION_SIZE - 1] = '\0';
+        if (isCodeIndexBuilt)
+            CatalogIndex_add(&catalogDB->codeIndex, buffer, slot);
+        if (isDesignationIndexBuilt)
+            TrigramIndex_add(&catalogDB->designationIndex, buffer + CATALOGRECORD_CODE_SIZE, slot);
+    }
+}
+
+/** Remove a slot from the index and point the entry of its code to another record with the same code if needed
+ * @param catalogDB the database
+ * @param code the code of the record stored in the slot
+ * @param slot the slot
+ */
+static void CatalogDB_unindex(CatalogDB * catalogDB, const char * code, int slot)
+{
+    char otherCode[CATALOGRECORD_CODE_SIZE];
+    int i;
+
+    if (!CatalogIndex_delete(&catalogDB->codeIndex, code, slot))
+        return;
+
+    /* duplicated codes are rare: a scan is enough to find another record */
+    for (i = 0; i < catalogDB->recordCount; ++i)
+    {
+        int otherSlot = SlotTable_getSlot(&catalogDB->slots, i);
+        if (otherSlot == slot)
+            continue;
+        CatalogDB_readField(catalogDB, otherSlot, 0, CATALOGRECORD_CODE_SIZE, otherCode);
+        if (compareString(otherCode, code) == 0)
+        {
+            CatalogIndex_find(&catalogDB->codeIndex, code)->slot = otherSlot;
+            return;
+        }
+    }
+}
+
+/** Rename a file, replacing any file with the new name, and free both names
+ * @param oldFilename the current name of the file
+ * @param newFilename the new name of the file
+ */
+static void CatalogDB_renameFile(char * oldFilename, char * newFilename)
+{
+    if (rename(oldFilename, newFilename) != 0)
+    {
+        remove(oldFilename);
+        remove(newFilename);
+    }
+    free(oldFilename);
+    free(newFilename);
+}
+
+/** Append a change to the log of the database before it is applied
+ * @param catalogDB the database
+ * @param operation the kind of change
+ * @param recordIndex the position of the record
+ * @param record the record inserted or written, NULL for a removal
+ */
+static void CatalogDB_log(CatalogDB * catalogDB, WriteAheadLogOperation operation, int recordIndex, CatalogRecord * record)
+{
+    char buffer[CATALOGRECORD_SIZE];
+
+    /* the log must start from a saved slot table which includes the appends of the current batch */
+    if (catalogDB->batchBuffer != NULL || WriteAheadLog_needsCheckpoint(&catalogDB->log))
+        CatalogDB_checkpoint(catalogDB);
+
+    if (record != NULL)
+        CatalogRecord_encode(record, buffer);
+    WriteAheadLog_append(&catalogDB->log, operation, recordIndex, (record != NULL) ? buffer : NULL);
+}
+
+/** Save the slot table and the header of the database so that its log can be emptied
+ * @param catalogDB the database
+ */
+static void CatalogDB_checkpoint(CatalogDB * catalogDB)
+{
+    CatalogDB_commitGroup(catalogDB);
+    CatalogDB_flushBatch(catalogDB);
+
+    /* the records must be on the disk before the slot table and the header refer to them */
+    if (fflush(catalogDB->file) != 0 || fsync(fileno(catalogDB->file)) != 0)
+        fatalError("fsync error : unable to force the database to the disk");
+    SlotTable_save(&catalogDB->slots, catalogDB->filename);
+    rewind(catalogDB->file);
+    if (fwrite(&catalogDB->slots.slotCount, sizeof(int), 1, catalogDB->file) < 1)
+        fatalError("fwrite error : return value is < 1");
+    BlockCache_invalidate(&catalogDB->cache, 0, sizeof(int));
+    if (fflush(catalogDB->file) != 0 || fsync(fileno(catalogDB->file)) != 0)
+        fatalError("fsync error : unable to force the database to the disk");
+    WriteAheadLog_reset(&catalogDB->log);
+}
+
+/** Write a record or a tombstone in a slot once the log entry of the change is on the disk
+ *
+ * The slot is pending until the group of log entries is forced to the disk, it is
+ * then written in place. It is written at once if the entry just completed a group.
+ * @param catalogDB the database
+ * @param slot the slot
+ * @param record the record to write, NULL for a tombstone
+ */
+static void CatalogDB_writeSlot(CatalogDB * catalogDB, int slot, CatalogRecord * record)
+{
+    if (catalogDB->pendingCount == WRITEAHEADLOG_GROUP_SIZE)
+        CatalogDB_commitGroup(catalogDB);
+
+    catalogDB->pendingSlots[catalogDB->pendingCount] = slot;
+    catalogDB->pendingRemovals[catalogDB->pendingCount] = (record == NULL);
+    if (record != NULL)
+        CatalogRecord_encode(record, catalogDB->pendingRecords + CATALOGRECORD_SIZE * (size_t)catalogDB->pendingCount);
+    catalogDB->pendingCount += 1;
+
+    if (catalogDB->log.pendingCount == 0)
+        CatalogDB_applyPending(catalogDB);
+}
+
+/** Find the last pending record written in a slot
+ * @param catalogDB the database
+ * @param slot the slot
+ * @return the position of the pending record, -1 if the slot is not pending or receives a tombstone
+ */
+static int CatalogDB_findPending(CatalogDB * catalogDB, int slot)
+{
+    int i;
+
+    for (i = catalogDB->pendingCount - 1; i >= 0; --i)
+        if (catalogDB->pendingSlots[i] == slot)
+            return catalogDB->pendingRemovals[i] ? -1 : i;
+    return -1;
+}
+
+/** Force the log to the disk and write the pending slots in place
+ * @param catalogDB the database
+ */
+static void CatalogDB_commitGroup(CatalogDB * catalogDB)
+{
+    WriteAheadLog_sync(&catalogDB->log);
+    CatalogDB_applyPending(catalogDB);
+}
+
+/** Write the pending slots in place, their log entries being on the disk
+ * @param catalogDB the database
+ */
+static void CatalogDB_applyPending(CatalogDB * catalogDB)
+{
+    long offset;
+    int i;
+
+    for (i = 0; i < catalogDB->pendingCount; ++i)
+    {
+        offset = (long)sizeof(int) + (long)CATALOGRECORD_SIZE * (long)catalogDB->pendingSlots[i];
+        if (catalogDB->pendingRemovals[i])
+            SlotTable_writeTombstone(catalogDB->file, offset);
+        else if (fseek(catalogDB->file, offset, SEEK_SET) != 0
+                || fwrite(catalogDB->pendingRecords + CATALOGRECORD_SIZE * (size_t)i, CATALOGRECORD_SIZE, 1, catalogDB->file) < 1)
+            fatalError("fwrite error : unable to write a record");
+        BlockCache_invalidate(&catalogDB->cache, offset, CATALOGRECORD_SIZE);
+    }
+    catalogDB->pendingCount = 0;
+    /* the records are read with pread() which does not see the buffer of the FILE */
+    if (fflush(catalogDB->file) != 0)
+        fatalError("fflush error : unable to write the database");
+}
@@ -20,8 +20,13 @@
 #include <CatalogDB.h>
 #include <UnitTest.h>
 #include <CatalogRecord.h>
+#include <CatalogRecordEditor.h>
+#include <CatalogSnapshot.h>
+#include <MyString.h>
 
+#include <pthread.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
 
 static void test_CatalogDB_openAndCreate(void)
@@ -167,6 +172,823 @@ static void test_CatalogDB_insertAndRemove(void)
   CatalogRecord_finalize(&record);
 }
 
+static void test_CatalogDB_mapped(void)
+{
+  CatalogDB * catalogDB;
+  CatalogRecord record;
+  CatalogRecordView view;
+  char buffer[CATALOGRECORD_MAXSTRING_SIZE];
+  int i;
+
+  CatalogRecord_init(&record);
+  CatalogRecord_setValue_code(&record, "CODE");
+  CatalogRecord_setValue_designation(&record, "Designation");
+  CatalogRecord_setValue_unity(&record, "kg");
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  for(i = 0; i < 50; ++i)
+  {
+    record.sellingPrice = i;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+
+  ASSERT(CatalogDB_map(catalogDB));
+  ASSERT_NOT_EQUAL(catalogDB->mapping, NULL);
+  ASSERT_EQUAL(CatalogDB_getRecordView(catalogDB, 50, &view), 0);
+
+  for(i = 0; i < 50; ++i)
+  {
+    ASSERT(CatalogDB_getRecordView(catalogDB, i, &view));
+    ASSERT_EQUAL_STRING(view.code, "CODE");
+    ASSERT_EQUAL_STRING(view.designation, "Designation");
+    ASSERT_EQUAL_STRING(view.unity, "kg");
+    ASSERT_EQUAL_DOUBLE(view.sellingPrice, i);
+  }
+
+  /* records written after the mapping must be visible */
+  for(i = 50; i < 100; ++i)
+  {
+    record.sellingPrice = i;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+  record.sellingPrice = 1000;
+  CatalogDB_writeRecord(catalogDB, 10, &record);
+
+  for(i = 0; i < 100; ++i)
+  {
+    CatalogDB_readRecord(catalogDB, i, &record);
+    ASSERT_EQUAL_STRING(record.code, "CODE");
+    if (i == 10)
+      ASSERT_EQUAL_DOUBLE(record.sellingPrice, 1000);
+    else
+      ASSERT_EQUAL_DOUBLE(record.sellingPrice, i);
+  }
+  ASSERT_EQUAL_STRING(CatalogDB_getFieldValue(catalogDB, 99, CATALOGRECORD_SELLINGPRICE_FIELD, buffer, sizeof(buffer)), "99.00");
+  ASSERT_EQUAL_STRING(CatalogDB_getFieldValue(catalogDB, 99, CATALOGRECORD_UNITY_FIELD, buffer, sizeof(buffer)), "kg");
+
+  /* a reader never remaps the database, the appended records are in the mapping once it is mapped again */
+  ASSERT_EQUAL(CatalogDB_getRecordView(catalogDB, 99, &view), 0);
+  ASSERT(CatalogDB_map(catalogDB));
+  ASSERT(CatalogDB_getRecordView(catalogDB, 99, &view));
+  ASSERT_EQUAL_DOUBLE(view.sellingPrice, 99);
+
+  CatalogDB_unmap(catalogDB);
+  ASSERT_EQUAL(catalogDB->mapping, NULL);
+  ASSERT_EQUAL_STRING(CatalogDB_getFieldValue(catalogDB, 99, CATALOGRECORD_SELLINGPRICE_FIELD, buffer, sizeof(buffer)), "99.00");
+
+  CatalogDB_close(catalogDB);
+
+  CatalogRecord_finalize(&record);
+}
+
+static void test_CatalogDB_batch(void)
+{
+  CatalogDB * catalogDB;
+  CatalogRecord records[100];
+  CatalogRecord record;
+  struct timeval start;
+  struct timeval end;
+  double seconds;
+  int i;
+
+  for(i = 0; i < 100; ++i)
+  {
+    CatalogRecord_init(&records[i]);
+    CatalogRecord_setValue_code(&records[i], "CODE");
+    CatalogRecord_setValue_designation(&records[i], "Designation");
+  }
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+
+  /* a bulk import flushes the batch several times, its throughput is only reported since it depends on the machine */
+  gettimeofday(&start, NULL);
+  CatalogDB_beginBatch(catalogDB);
+  for(i = 0; i < 5000; ++i)
+  {
+    records[i % 100].sellingPrice = i;
+    if (i % 100 == 99)
+      CatalogDB_appendMany(catalogDB, records, 100);
+  }
+  CatalogDB_commitBatch(catalogDB);
+  gettimeofday(&end, NULL);
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 5000);
+  seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_usec - start.tv_usec) / 1e6;
+  if (isSpecified("verbose-unittests"))
+    printf("Batched appends: 5000 records in %.3f s (%.0f records/s)\n", seconds, 5000 / MAXVALUE(seconds, 1e-6));
+
+  /* the header is up to date as soon as the batch is committed */
+  CatalogDB_close(catalogDB);
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 5000);
+  CatalogDB_readRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL_STRING(record.code, "CODE");
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 0);
+  CatalogDB_readRecord(catalogDB, 4999, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 4999);
+
+  /* appends of a batch keep their order with other appends and are readable before the commit */
+  CatalogDB_beginBatch(catalogDB);
+  CatalogDB_appendMany(catalogDB, records, 1);
+  record.sellingPrice = -1;
+  CatalogDB_appendRecord(catalogDB, &record);
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 5002);
+  CatalogDB_readRecord(catalogDB, 5001, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, -1);
+  CatalogDB_readRecord(catalogDB, 5000, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 4900);
+  CatalogDB_commitBatch(catalogDB);
+
+  /* outside a batch, appendMany is a single batch */
+  CatalogDB_appendMany(catalogDB, records, 100);
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 5102);
+  CatalogDB_readRecord(catalogDB, 5101, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 4999);
+  CatalogDB_close(catalogDB);
+
+  for(i = 0; i < 100; ++i)
+    CatalogRecord_finalize(&records[i]);
+  CatalogRecord_finalize(&record);
+}
+
+static void test_CatalogDB_slots(void)
+{
+  CatalogDB * catalogDB;
+  CatalogRecord record;
+  FILE * file;
+  int i;
+  int j;
+
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  for(i = 0; i < 100; ++i)
+  {
+    record.sellingPrice = i;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+
+  /* removing a record leaves its slot free and does not move the following ones */
+  for(i = 0; i < 10; ++i)
+    CatalogDB_removeRecord(catalogDB, 0);
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 90);
+  ASSERT_EQUAL(catalogDB->slots.slotCount, 100);
+  ASSERT_EQUAL(catalogDB->slots.freeCount, 10);
+  CatalogDB_readRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 10);
+
+  /* the free slots are reused by the insertions */
+  record.sellingPrice = -1;
+  CatalogDB_insertRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL(catalogDB->slots.slotCount, 100);
+  ASSERT_EQUAL(catalogDB->slots.freeCount, 9);
+  CatalogDB_close(catalogDB);
+
+  file = fopen(BASEPATH "/unittest/catalogdb-unittest.db" SLOTTABLE_EXTENSION, "rb");
+  ASSERT_NOT_EQUAL(file, NULL);
+  fclose(file);
+
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 91);
+  CatalogDB_readRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, -1);
+  for(i = 1; i < 91; ++i)
+  {
+    CatalogDB_readRecord(catalogDB, i, &record);
+    ASSERT_EQUAL_DOUBLE(record.sellingPrice, (i + 9));
+  }
+  CatalogDB_close(catalogDB);
+
+  /* a side file whose slots are used twice or are out of the database is rebuilt from the tombstones */
+  for(j = 0; j < 2; ++j)
+  {
+    int slot = (j == 0) ? 10 : 1000;
+
+    file = fopen(BASEPATH "/unittest/catalogdb-unittest.db" SLOTTABLE_EXTENSION, "rb+");
+    ASSERT_NOT_EQUAL(file, NULL);
+    ASSERT_EQUAL(fseek(file, (long)(3 * sizeof(int)), SEEK_SET), 0);
+    ASSERT_EQUAL(fwrite(&slot, sizeof(int), 1, file), 1);
+    fclose(file);
+
+    /* a reader repairs the side file while it holds the file alone and has nothing left to save at close */
+    catalogDB = CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_READER);
+    ASSERT_NOT_EQUAL(catalogDB, NULL);
+    ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 91);
+    ASSERT(!catalogDB->isModified);
+    CatalogDB_close(catalogDB);
+    file = fopen(BASEPATH "/unittest/catalogdb-unittest.db" SLOTTABLE_EXTENSION, "rb");
+    ASSERT_NOT_EQUAL(file, NULL);
+    ASSERT_EQUAL(fseek(file, (long)(3 * sizeof(int)), SEEK_SET), 0);
+    ASSERT_EQUAL(fread(&slot, sizeof(int), 1, file), 1);
+    ASSERT_EQUAL(slot, 9);
+    fclose(file);
+
+    catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+    ASSERT(!catalogDB->isModified);
+    ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 91);
+    ASSERT_EQUAL(catalogDB->slots.slotCount, 100);
+    ASSERT_EQUAL(catalogDB->slots.freeCount, 9);
+    CatalogDB_readRecord(catalogDB, 0, &record);
+    ASSERT_EQUAL_DOUBLE(record.sellingPrice, -1);
+    for(i = 1; i < 91; ++i)
+    {
+      CatalogDB_readRecord(catalogDB, i, &record);
+      ASSERT_EQUAL_DOUBLE(record.sellingPrice, (i + 9));
+    }
+    CatalogDB_close(catalogDB);
+  }
+
+  /* a database used by another process is not rewritten, a missing one has nothing to compact */
+  catalogDB = CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_WRITER);
+  ASSERT_NOT_EQUAL(catalogDB, NULL);
+  ASSERT(!CatalogDB_compact(BASEPATH "/unittest/catalogdb-unittest.db"));
+  CatalogDB_close(catalogDB);
+  remove(BASEPATH "/unittest/catalogdb-unittest-doesnotexist.db");
+  ASSERT(CatalogDB_compact(BASEPATH "/unittest/catalogdb-unittest-doesnotexist.db"));
+
+  /* the compaction gets rid of the free slots and of the slot table */
+  ASSERT(CatalogDB_compact(BASEPATH "/unittest/catalogdb-unittest.db"));
+  file = fopen(BASEPATH "/unittest/catalogdb-unittest.db" SLOTTABLE_EXTENSION, "rb");
+  ASSERT_EQUAL(file, NULL);
+
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 91);
+  ASSERT_EQUAL(catalogDB->slots.slotCount, 91);
+  ASSERT(catalogDB->slots.isIdentity);
+  CatalogDB_readRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, -1);
+  CatalogDB_readRecord(catalogDB, 90, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 99);
+  CatalogDB_close(catalogDB);
+
+  CatalogRecord_finalize(&record);
+}
+
+static void test_CatalogDB_findRecordByCode(void)
+{
+  CatalogDB * catalogDB;
+  CatalogRecord record;
+  FILE * file;
+  struct stat status;
+  struct timeval times[2];
+  char code[CATALOGRECORD_CODE_SIZE];
+  int i;
+
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  CatalogDB_beginBatch(catalogDB);
+  for(i = 0; i < 1000; ++i)
+  {
+    snprintf(code, sizeof(code), "P%d", i);
+    CatalogRecord_setValue_code(&record, code);
+    record.sellingPrice = i;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+  CatalogDB_commitBatch(catalogDB);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P500", &record), 500);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 500);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P1000", NULL), -1);
+  CatalogDB_close(catalogDB);
+
+  /* the index is saved with the database and kept up to date */
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT(catalogDB->codeIndex.isValid);
+  CatalogDB_removeRecord(catalogDB, 0);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P0", NULL), -1);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P500", NULL), 499);
+  CatalogRecord_setValue_code(&record, "NEW");
+  CatalogDB_insertRecord(catalogDB, 10, &record);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "NEW", NULL), 10);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P500", NULL), 500);
+  CatalogRecord_setValue_code(&record, "RENAMED");
+  CatalogDB_writeRecord(catalogDB, 10, &record);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "NEW", NULL), -1);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "RENAMED", NULL), 10);
+
+  /* duplicated codes */
+  CatalogRecord_setValue_code(&record, "P42");
+  CatalogDB_appendRecord(catalogDB, &record);
+  CatalogDB_removeRecord(catalogDB, CatalogDB_findRecordByCode(catalogDB, "P42", NULL));
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P42", NULL), CatalogDB_getRecordCount(catalogDB) - 1);
+  CatalogDB_close(catalogDB);
+
+  /* an index which does not match the database is rebuilt */
+  file = fopen(BASEPATH "/unittest/catalogdb-unittest.db", "ab");
+  ASSERT_NOT_EQUAL(file, NULL);
+  fputc(0, file);
+  fclose(file);
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT_EQUAL(catalogDB->codeIndex.isValid, 0);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "RENAMED", NULL), 10);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P999", &record), CatalogDB_getRecordCount(catalogDB) - 2);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 999);
+  CatalogDB_close(catalogDB);
+
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT(catalogDB->codeIndex.isValid);
+  CatalogDB_close(catalogDB);
+
+  /* a change of the same size within the same second is told apart by the nanoseconds */
+  ASSERT(stat(BASEPATH "/unittest/catalogdb-unittest.db", &status) == 0);
+  file = fopen(BASEPATH "/unittest/catalogdb-unittest.db", "r+b");
+  ASSERT_NOT_EQUAL(file, NULL);
+  fseek(file, -1, SEEK_END);
+  fputc(1, file);
+  fclose(file);
+  times[0].tv_sec = status.st_mtime;
+  times[0].tv_usec = (getModificationNanoseconds(&status) / 1000 == 500000) ? 250000 : 500000;
+  times[1] = times[0];
+  ASSERT(utimes(BASEPATH "/unittest/catalogdb-unittest.db", times) == 0);
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT_EQUAL(catalogDB->codeIndex.isValid, 0);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "RENAMED", NULL), 10);
+  CatalogDB_close(catalogDB);
+
+  CatalogRecord_finalize(&record);
+}
+
+static void test_CatalogDB_search(void)
+{
+  CatalogDB * catalogDB;
+  CatalogRecord record;
+  int results[10];
+  int i;
+  int j;
+  const char * designations[] = { "Pomme de terre", "Vis a bois 4x40", "Pommeau de douche", "Vis a metaux 4x40",
+      "Tournevis cruciforme", "Pommes golden" };
+
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  for(i = 0; i < 6; ++i)
+  {
+    CatalogRecord_setValue_designation(&record, designations[i]);
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+
+  /* the last word of the query is a prefix, the case and the punctuation are ignored */
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "POMM", 10, results), 3);
+  ASSERT_EQUAL(results[0], 0);
+  ASSERT_EQUAL(results[1], 2);
+  ASSERT_EQUAL(results[2], 5);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "pomme", 1, results), 1);
+  ASSERT_EQUAL(results[0], 0);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "vis, a m", 10, results), 2);
+  ASSERT_EQUAL(results[0], 3);
+  ASSERT_EQUAL(results[1], 1);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "x", 10, results), 0);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "salade", 10, results), 0);
+  CatalogDB_close(catalogDB);
+
+  /* the index is saved with the database and kept up to date */
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT(catalogDB->designationIndex.isValid);
+  CatalogDB_removeRecord(catalogDB, 0);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "pomme de", 10, results), 2);
+  ASSERT_EQUAL(results[0], 1);
+  CatalogRecord_setValue_designation(&record, "Salade verte");
+  CatalogDB_insertRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "salade", 10, results), 1);
+  ASSERT_EQUAL(results[0], 0);
+  CatalogRecord_setValue_designation(&record, "Salade frisee");
+  CatalogDB_writeRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "verte", 10, results), 0);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "frisee", 10, results), 1);
+  /* the posting lists stay sorted through the insertions, the removals and the rewrites */
+  for(i = 0; i < TRIGRAMINDEX_TRIGRAM_COUNT; ++i)
+    for(j = 1; j < catalogDB->designationIndex.lists[i].count; ++j)
+      ASSERT(catalogDB->designationIndex.lists[i].slots[j - 1] < catalogDB->designationIndex.lists[i].slots[j]);
+  CatalogDB_close(catalogDB);
+
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  ASSERT(catalogDB->designationIndex.isValid);
+  ASSERT_EQUAL(CatalogDB_search(catalogDB, "tournevis", 10, results), 1);
+  ASSERT_EQUAL(results[0], 4);
+  CatalogDB_close(catalogDB);
+
+  CatalogRecord_finalize(&record);
+}
+
+static void test_CatalogDB_snapshot(void)
+{
+  CatalogDB * catalogDB;
+  CatalogSnapshot * snapshot;
+  CatalogRecord record;
+  const int * order;
+  int * results;
+  char text[CATALOGRECORD_DESIGNATION_SIZE];
+  int i;
+
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  CatalogDB_beginBatch(catalogDB);
+  for(i = 0; i < 5000; ++i)
+  {
+    snprintf(text, sizeof(text), "P%d", i);
+    CatalogRecord_setValue_code(&record, text);
+    snprintf(text, sizeof(text), "%s produit %d", (i % 2 == 0) ? "Grand" : "petit", (i * 7919) % 5000);
+    CatalogRecord_setValue_designation(&record, text);
+    record.sellingPrice = (i * 31) % 1000;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+  CatalogDB_commitBatch(catalogDB);
+
+  snapshot = CatalogSnapshot_create(catalogDB);
+  ASSERT_EQUAL(snapshot->recordCount, 5000);
+  ASSERT_EQUAL_STRING(CatalogSnapshot_getCode(snapshot, 1234), "P1234");
+
+  /* the designations are sorted without case, equal values keep the order of the records */
+  order = CatalogSnapshot_getOrder(snapshot, CATALOGRECORD_DESIGNATION_FIELD);
+  for(i = 1; i < 5000; ++i)
+    ASSERT(icaseCompareString(CatalogSnapshot_getDesignation(snapshot, order[i - 1]),
+        CatalogSnapshot_getDesignation(snapshot, order[i])) <= 0);
+  order = CatalogSnapshot_getOrder(snapshot, CATALOGRECORD_SELLINGPRICE_FIELD);
+  for(i = 1; i < 5000; ++i)
+  {
+    ASSERT(snapshot->sellingPrices[order[i - 1]] <= snapshot->sellingPrices[order[i]]);
+    if (!(snapshot->sellingPrices[order[i - 1]] < snapshot->sellingPrices[order[i]]))
+      ASSERT(order[i - 1] < order[i]);
+  }
+
+  results = malloc(sizeof(int) * 5000);
+  ASSERT_NOT_EQUAL(results, NULL);
+  ASSERT_EQUAL(CatalogSnapshot_filter(snapshot, "GRAND", NULL, results), 2500);
+  ASSERT_EQUAL(results[1], 2);
+  ASSERT_EQUAL(CatalogSnapshot_filter(snapshot, "p4999", NULL, results), 1);
+  ASSERT_EQUAL(results[0], 4999);
+  ASSERT_EQUAL(CatalogSnapshot_filter(snapshot, "petit", order, results), 2500);
+  for(i = 1; i < 2500; ++i)
+    ASSERT(snapshot->sellingPrices[results[i - 1]] <= snapshot->sellingPrices[results[i]]);
+  free(results);
+
+  CatalogSnapshot_destroy(snapshot);
+  CatalogDB_close(catalogDB);
+  CatalogRecord_finalize(&record);
+}
+
+/** Copy a file as it is on the disk, removing the destination if the source does not exist */
+static void copyFile(const char * source, const char * destination)
+{
+  char buffer[4096];
+  FILE * input = fopen(source, "rb");
+  FILE * output;
+  size_t size;
+
+  remove(destination);
+  if (input == NULL)
+    return;
+  output = fopen(destination, "wb");
+  ASSERT_NOT_EQUAL(output, NULL);
+  while ((size = fread(buffer, 1, sizeof(buffer), input)) > 0)
+    ASSERT_EQUAL(fwrite(buffer, 1, size, output), size);
+  fclose(output);
+  fclose(input);
+}
+
+/** Tell if a file contains a text */
+static int fileContains(const char * filename, const char * text)
+{
+  char buffer[4096];
+  FILE * file = fopen(filename, "rb");
+  size_t length = stringLength(text);
+  size_t size;
+  size_t matched = 0;
+  size_t i;
+
+  ASSERT_NOT_EQUAL(file, NULL);
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    for (i = 0; i < size && matched < length; ++i)
+    {
+      if (buffer[i] == text[matched])
+        matched += 1;
+      else
+        matched = (buffer[i] == text[0]) ? 1 : 0;
+    }
+  fclose(file);
+  return matched == length;
+}
+
+/** Check the content of the database built by test_CatalogDB_log() */
+static void checkLoggedChanges(CatalogDB * catalogDB)
+{
+  CatalogRecord record;
+  int i;
+
+  CatalogRecord_init(&record);
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 21);
+  CatalogDB_readRecord(catalogDB, 0, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, -1);
+  CatalogDB_readRecord(catalogDB, 1, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 0);
+  CatalogDB_readRecord(catalogDB, 2, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 1);
+  CatalogDB_readRecord(catalogDB, 3, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 3);
+  CatalogDB_readRecord(catalogDB, 4, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 100);
+  for(i = 5; i < 20; ++i)
+  {
+    CatalogDB_readRecord(catalogDB, i, &record);
+    ASSERT_EQUAL_DOUBLE(record.sellingPrice, i);
+  }
+  CatalogDB_readRecord(catalogDB, 20, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 200);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "P200", NULL), 20);
+  CatalogRecord_finalize(&record);
+}
+
+static void test_CatalogDB_log(void)
+{
+  CatalogDB * catalogDB;
+  CatalogDB * recoveredDB;
+  CatalogRecord record;
+  FILE * file;
+  int i;
+
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  for(i = 0; i < 20; ++i)
+  {
+    record.sellingPrice = i;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+  CatalogDB_close(catalogDB);
+
+  /* the changes are logged until the next checkpoint */
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  CatalogDB_removeRecord(catalogDB, 2);
+  record.sellingPrice = -1;
+  CatalogDB_insertRecord(catalogDB, 0, &record);
+  record.sellingPrice = 100;
+  CatalogDB_writeRecord(catalogDB, 4, &record);
+  record.sellingPrice = 200;
+  CatalogRecord_setValue_code(&record, "P200");
+  CatalogDB_appendRecord(catalogDB, &record);
+
+  /* the records are written in place only once their log entries are on the disk */
+  ASSERT(!fileContains(BASEPATH "/unittest/catalogdb-unittest.db", "P200"));
+  CatalogDB_readRecord(catalogDB, 20, &record);
+  ASSERT_EQUAL_STRING(record.code, "P200");
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db", BASEPATH "/unittest/catalogdb-unittest-crash.db");
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db" SLOTTABLE_EXTENSION, BASEPATH "/unittest/catalogdb-unittest-crash.db" SLOTTABLE_EXTENSION);
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db" WRITEAHEADLOG_EXTENSION, BASEPATH "/unittest/catalogdb-unittest-crash.db" WRITEAHEADLOG_EXTENSION);
+  recoveredDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest-crash.db");
+  checkLoggedChanges(recoveredDB);
+  CatalogDB_close(recoveredDB);
+
+  CatalogDB_sync(catalogDB);
+  ASSERT(fileContains(BASEPATH "/unittest/catalogdb-unittest.db", "P200"));
+
+  file = fopen(BASEPATH "/unittest/catalogdb-unittest.db" WRITEAHEADLOG_EXTENSION, "rb");
+  ASSERT_NOT_EQUAL(file, NULL);
+  fclose(file);
+
+  /* a crash leaves the files as they are now on the disk: the log is replayed when opening them */
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db", BASEPATH "/unittest/catalogdb-unittest-crash.db");
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db" SLOTTABLE_EXTENSION, BASEPATH "/unittest/catalogdb-unittest-crash.db" SLOTTABLE_EXTENSION);
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db" WRITEAHEADLOG_EXTENSION, BASEPATH "/unittest/catalogdb-unittest-crash.db" WRITEAHEADLOG_EXTENSION);
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.db" WRITEAHEADLOG_EXTENSION, BASEPATH "/unittest/catalogdb-unittest.wal.old");
+
+  recoveredDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest-crash.db");
+  ASSERT_NOT_EQUAL(recoveredDB, NULL);
+  checkLoggedChanges(recoveredDB);
+  CatalogDB_close(recoveredDB);
+  file = fopen(BASEPATH "/unittest/catalogdb-unittest-crash.db" WRITEAHEADLOG_EXTENSION, "rb");
+  ASSERT_EQUAL(file, NULL);
+
+  recoveredDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest-crash.db");
+  checkLoggedChanges(recoveredDB);
+  CatalogDB_close(recoveredDB);
+
+  /* the log of a completed checkpoint is not applied twice */
+  CatalogDB_close(catalogDB);
+  copyFile(BASEPATH "/unittest/catalogdb-unittest.wal.old", BASEPATH "/unittest/catalogdb-unittest.db" WRITEAHEADLOG_EXTENSION);
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  checkLoggedChanges(catalogDB);
+  CatalogDB_close(catalogDB);
+
+  remove(BASEPATH "/unittest/catalogdb-unittest.wal.old");
+  CatalogRecord_finalize(&record);
+}
+
+/** The number of threads reading the database in test_CatalogDB_concurrency() */
+#define CONCURRENCY_READER_COUNT 4
+
+/** A thread of test_CatalogDB_concurrency() */
+typedef struct
+{
+  CatalogDB * catalogDB; /**< The shared database */
+  unsigned int seed; /**< The seed of the positions read */
+  int readCount; /**< The number of records read */
+  int errorCount; /**< The number of records read with an unexpected value */
+} ConcurrencyThread;
+
+/** Read random records of the shared database, the selling price of a record being its position */
+static void * readConcurrently(void * data)
+{
+  ConcurrencyThread * thread = (ConcurrencyThread *)data;
+  CatalogRecord record;
+  int i;
+
+  CatalogRecord_init(&record);
+  for(i = 0; i < 20000; ++i)
+  {
+    int recordIndex;
+
+    thread->seed = thread->seed * 1103515245U + 12345U;
+    recordIndex = (int)((thread->seed >> 8) % (unsigned int)CatalogDB_getRecordCount(thread->catalogDB));
+    CatalogDB_readRecord(thread->catalogDB, recordIndex, &record);
+    if (record.sellingPrice < recordIndex - 0.5 || record.sellingPrice > recordIndex + 0.5)
+      thread->errorCount += 1;
+    thread->readCount += 1;
+  }
+  CatalogRecord_finalize(&record);
+  return NULL;
+}
+
+/** Append records to the shared database, the selling price of a record being its position */
+static void * appendConcurrently(void * data)
+{
+  ConcurrencyThread * thread = (ConcurrencyThread *)data;
+  CatalogRecord record;
+  int i;
+
+  CatalogRecord_init(&record);
+  for(i = 0; i < 2000; ++i)
+  {
+    record.sellingPrice = CatalogDB_getRecordCount(thread->catalogDB);
+    CatalogDB_appendRecord(thread->catalogDB, &record);
+  }
+  CatalogRecord_finalize(&record);
+  return NULL;
+}
+
+static void test_CatalogDB_concurrency(void)
+{
+  CatalogDB * catalogDB;
+  CatalogDB * otherDB;
+  CatalogRecord record;
+  ConcurrencyThread threads[CONCURRENCY_READER_COUNT + 1];
+  pthread_t identifiers[CONCURRENCY_READER_COUNT + 1];
+  int i;
+
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  for(i = 0; i < 100; ++i)
+  {
+    record.sellingPrice = i;
+    CatalogDB_appendRecord(catalogDB, &record);
+  }
+  CatalogDB_close(catalogDB);
+
+  /* one writer and several readers share the same database */
+  catalogDB = CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_WRITER);
+  ASSERT_NOT_EQUAL(catalogDB, NULL);
+  for(i = 0; i <= CONCURRENCY_READER_COUNT; ++i)
+  {
+    threads[i].catalogDB = catalogDB;
+    threads[i].seed = (unsigned int)i + 1U;
+    threads[i].readCount = 0;
+    threads[i].errorCount = 0;
+    ASSERT_EQUAL(pthread_create(&identifiers[i], NULL, (i == 0) ? appendConcurrently : readConcurrently, &threads[i]), 0);
+  }
+  for(i = 0; i <= CONCURRENCY_READER_COUNT; ++i)
+    ASSERT_EQUAL(pthread_join(identifiers[i], NULL), 0);
+  for(i = 1; i <= CONCURRENCY_READER_COUNT; ++i)
+  {
+    ASSERT_EQUAL(threads[i].readCount, 20000);
+    ASSERT_EQUAL(threads[i].errorCount, 0);
+  }
+  ASSERT_EQUAL(CatalogDB_getRecordCount(catalogDB), 2100);
+
+  /* a writer is alone on the file */
+  ASSERT_EQUAL(CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_WRITER), NULL);
+  ASSERT_EQUAL(CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_READER), NULL);
+  CatalogDB_close(catalogDB);
+
+  /* the readers share the file */
+  catalogDB = CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_READER);
+  ASSERT_NOT_EQUAL(catalogDB, NULL);
+  otherDB = CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_READER);
+  ASSERT_NOT_EQUAL(otherDB, NULL);
+  ASSERT_EQUAL(CatalogDB_openWithAccess(BASEPATH "/unittest/catalogdb-unittest.db", DATABASE_WRITER), NULL);
+  CatalogDB_readRecord(otherDB, 2099, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 2099);
+  ASSERT_EQUAL(CatalogDB_findRecordByCode(catalogDB, "", NULL), 0);
+  CatalogDB_close(otherDB);
+  CatalogDB_close(catalogDB);
+
+  CatalogRecord_finalize(&record);
+}
+
+/** The state of a scan of test_CatalogDB_forEach() */
+typedef struct
+{
+  int count; /**< The number of records visited */
+  double sum; /**< The sum of the selling prices */
+  int isOrdered; /**< True while the selling price of each record is its original position */
+  int stopAt; /**< The number of records after which the scan stops, -1 for none */
+} ScanState;
+
+static int sumRecords(int recordIndex, CatalogRecord * record, void * data)
+{
+  ScanState * state = data;
+  int position = (int)record->sellingPrice;
+
+  /* every third record of the first 3000 ones was removed */
+  if (position < 3000)
+    position -= position / 3 + 1;
+  else
+    position -= 1000;
+  if (position != recordIndex)
+    state->isOrdered = 0;
+  state->count += 1;
+  state->sum += record->sellingPrice;
+  return state->count == state->stopAt;
+}
+
+static void test_CatalogDB_forEach(void)
+{
+  CatalogDB * catalogDB;
+  CatalogRecord records[100];
+  CatalogRecord record;
+  ScanState state;
+  unsigned long pageCount;
+  double sum = 0;
+  int i;
+
+  for(i = 0; i < 100; ++i)
+  {
+    CatalogRecord_init(&records[i]);
+    CatalogRecord_setValue_code(&records[i], "CODE");
+    CatalogRecord_setValue_designation(&records[i], "Designation");
+  }
+  CatalogRecord_init(&record);
+
+  catalogDB = CatalogDB_create(BASEPATH "/unittest/catalogdb-unittest.db");
+  CatalogDB_beginBatch(catalogDB);
+  for(i = 0; i < 100000; ++i)
+  {
+    records[i % 100].sellingPrice = i;
+    if (i % 100 == 99)
+      CatalogDB_appendMany(catalogDB, records, 100);
+  }
+  CatalogDB_commitBatch(catalogDB);
+  for(i = 0; i < 1000; ++i)
+    CatalogDB_removeRecord(catalogDB, 2 * i);
+  for(i = 0; i < 100000; ++i)
+    if (i >= 3000 || i % 3 != 0)
+      sum += i;
+  CatalogDB_close(catalogDB);
+
+  /* a full scan reads the file sequentially, several pages at once */
+  catalogDB = CatalogDB_open(BASEPATH "/unittest/catalogdb-unittest.db");
+  state.count = 0;
+  state.sum = 0;
+  state.isOrdered = 1;
+  state.stopAt = -1;
+  ASSERT_EQUAL(CatalogDB_forEach(catalogDB, sumRecords, &state), 99000);
+  ASSERT_EQUAL(state.count, 99000);
+  ASSERT_EQUAL_DOUBLE(state.sum, sum);
+  ASSERT(state.isOrdered);
+  pageCount = ((unsigned long)CATALOGRECORD_SIZE * 100000UL) / BLOCKCACHE_PAGE_SIZE + 1;
+  ASSERT(catalogDB->cache.readCount <= pageCount / BLOCKCACHE_READAHEAD_PAGES + 2);
+
+  /* the visitor can stop the scan */
+  state.count = 0;
+  state.stopAt = 10;
+  ASSERT_EQUAL(CatalogDB_forEach(catalogDB, sumRecords, &state), 10);
+
+  /* the written records are not read from stale pages */
+  CatalogDB_readRecord(catalogDB, 5000, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, 6000);
+  record.sellingPrice = -1;
+  CatalogDB_writeRecord(catalogDB, 5000, &record);
+  CatalogDB_readRecord(catalogDB, 5000, &record);
+  ASSERT_EQUAL_DOUBLE(record.sellingPrice, -1);
+
+  /* a cache smaller than the file keeps working, the random reads miss one page at a time */
+  CatalogDB_setCache(catalogDB, 4096, 4 * 4096);
+  for(i = 0; i < 1000; ++i)
+  {
+    int recordIndex = (i * 7919) % 99000;
+    CatalogDB_readRecord(catalogDB, recordIndex, &record);
+    if (recordIndex != 5000)
+      ASSERT_EQUAL_DOUBLE(record.sellingPrice, (double)((recordIndex < 2000) ? recordIndex + recordIndex / 2 + 1 : recordIndex + 1000));
+  }
+  state.count = 0;
+  ASSERT_EQUAL(CatalogDB_forEach(catalogDB, sumRecords, &state), 10);
+  CatalogDB_close(catalogDB);
+
+  for(i = 0; i < 100; ++i)
+    CatalogRecord_finalize(&records[i]);
+  CatalogRecord_finalize(&record);
+}
+
 void test_CatalogDB(void)
 {
   BEGIN_TESTS(CatalogDB)
@@ -175,6 +997,15 @@ void test_CatalogDB(void)
     RUN_TEST(test_CatalogDB_readAndWrite);
     RUN_TEST(test_CatalogDB_append);
     RUN_TEST(test_CatalogDB_insertAndRemove);
+    RUN_TEST(test_CatalogDB_mapped);
+    RUN_TEST(test_CatalogDB_batch);
+    RUN_TEST(test_CatalogDB_slots);
+    RUN_TEST(test_CatalogDB_findRecordByCode);
+    RUN_TEST(test_CatalogDB_search);
+    RUN_TEST(test_CatalogDB_snapshot);
+    RUN_TEST(test_CatalogDB_log);
+    RUN_TEST(test_CatalogDB_concurrency);
+    RUN_TEST(test_CatalogDB_forEach);
   }
   END_TESTS
 }
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <CatalogIndex.h>
+#include <MyString.h>
+
+#include <sys/stat.h>
+
+/** The initial number of entries of an index */
+#define CATALOGINDEX_INITIAL_CAPACITY 1024
+
+/** The header of an index file */
+typedef struct
+{
+  long databaseSize; /**< The size of the database file when the index was saved */
+  long databaseTime; /**< The modification time of the database file when the index was saved */
+  long databaseNanoseconds; /**< The nanoseconds of the modification time of the database file */
+  int capacity; /**< The number of entries */
+  int size; /**< The number of used entries */
+} CatalogIndexHeader;
+
+static unsigned long CatalogIndex_hash(const char * code);
+static int CatalogIndex_lookup(CatalogIndex * catalogIndex, const char * code);
+static void CatalogIndex_resize(CatalogIndex * catalogIndex, int capacity);
+
+/** Initialize an empty and invalid index
+ * @param catalogIndex the index
+ */
+void CatalogIndex_init(CatalogIndex * catalogIndex)
+{
+    catalogIndex->entries = NULL;
+    catalogIndex->capacity = 0;
+    catalogIndex->size = 0;
+    catalogIndex->isValid = 0;
+    catalogIndex->isModified = 0;
+}
+
+/** Free the memory used by an index and make it invalid
+ * @param catalogIndex the index
+ */
+void CatalogIndex_finalize(CatalogIndex * catalogIndex)
+{
+    free(catalogIndex->entries);
+    CatalogIndex_init(catalogIndex);
+}
+
+/** Remove all the entries of an index and make it valid
+ * @param catalogIndex the index
+ */
+void CatalogIndex_clear(CatalogIndex * catalogIndex)
+{
+    CatalogIndex_finalize(catalogIndex);
+    CatalogIndex_resize(catalogIndex, CATALOGINDEX_INITIAL_CAPACITY);
+    catalogIndex->isValid = 1;
+    catalogIndex->isModified = 1;
+}
+
+/** Create a new string on the heap containing the file name of the index of a database
+ * @param filename the file name of the database
+ * @return a new string
+ */
+char * CatalogIndex_getFilename(const char * filename)
+{
+    size_t length = stringLength(filename);
+    char * base;
+    char * indexFilename;
+
+    if (length < 3 || compareString(filename + length - 3, ".db") != 0)
+        return concatenateString(filename, CATALOGINDEX_EXTENSION);
+
+    base = subString(filename, filename + length - 3);
+    indexFilename = concatenateString(base, CATALOGINDEX_EXTENSION);
+    free(base);
+    return indexFilename;
+}
+
+/** Load the index of a database if it matches the database file
+ * @param catalogIndex the index
+ * @param filename the file name of the database
+ * @return a non null value if the index is valid, 0 otherwise
+ */
+int CatalogIndex_load(CatalogIndex * catalogIndex, const char * filename)
+{
+    char * indexFilename = CatalogIndex_getFilename(filename);
+    FILE * file = fopen(indexFilename, "rb");
+    CatalogIndexHeader header;
+    CatalogIndexHeader stamp;
+
+    free(indexFilename);
+    CatalogIndex_finalize(catalogIndex);
+    if (file == NULL)
+        return 0;
+
+    if (fread(&header, sizeof(header), 1, file) < 1
+            || !CatalogIndex_getDatabaseStamp(filename, &stamp.databaseSize, &stamp.databaseTime, &stamp.databaseNanoseconds)
+            || header.databaseSize != stamp.databaseSize || header.databaseTime != stamp.databaseTime
+            || header.databaseNanoseconds != stamp.databaseNanoseconds
+            || header.capacity < CATALOGINDEX_INITIAL_CAPACITY || (header.capacity & (header.capacity - 1)) != 0
+            || header.size < 0 || header.size >= header.capacity)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    catalogIndex->entries = malloc(sizeof(CatalogIndexEntry) * (size_t)header.capacity);
+    if (catalogIndex->entries == NULL)
+        fatalError("malloc error : Allocation of the catalog index failed");
+    if (fread(catalogIndex->entries, sizeof(CatalogIndexEntry), (size_t)header.capacity, file) < (size_t)header.capacity)
+    {
+        fclose(file);
+        CatalogIndex_finalize(catalogIndex);
+        return 0;
+    }
+    fclose(file);
+
+    catalogIndex->capacity = header.capacity;
+    catalogIndex->size = header.size;
+    catalogIndex->isValid = 1;
+    return 1;
+}
+
+/** Save the index of a database, stamped with the current state of the database file
+ * @param catalogIndex the index
+ * @param filename the file name of the database which must be up to date on disk
+ */
+void CatalogIndex_save(CatalogIndex * catalogIndex, const char * filename)
+{
+    char * indexFilename;
+    FILE * file;
+    CatalogIndexHeader header;
+
+    memset(&header, 0, sizeof(header));
+    if (!catalogIndex->isValid || !CatalogIndex_getDatabaseStamp(filename, &header.databaseSize, &header.databaseTime,
+            &header.databaseNanoseconds))
+    {
+        CatalogIndex_remove(filename);
+        return;
+    }
+
+    indexFilename = CatalogIndex_getFilename(filename);
+    file = fopen(indexFilename, "wb");
+    free(indexFilename);
+    if (file == NULL)
+        return;
+
+    header.capacity = catalogIndex->capacity;
+    header.size = catalogIndex->size;
+    if (fwrite(&header, sizeof(header), 1, file) < 1
+            || fwrite(catalogIndex->entries, sizeof(CatalogIndexEntry), (size_t)catalogIndex->capacity, file) < (size_t)catalogIndex->capacity)
+    {
+        fclose(file);
+        CatalogIndex_remove(filename);
+        return;
+    }
+    fclose(file);
+    catalogIndex->isModified = 0;
+}
+
+/** Remove the saved index of a database
+ * @param filename the file name of the database
+ */
+void CatalogIndex_remove(const char * filename)
+{
+    char * indexFilename = CatalogIndex_getFilename(filename);
+    remove(indexFilename);
+    free(indexFilename);
+}
+
+/** Get the size and the modification time of a database file
+ * @param filename the file name of the database
+ * @param databaseSize the size of the file
+ * @param databaseTime the modification time of the file
+ * @param databaseNanoseconds the nanoseconds of the modification time of the file
+ * @return a non null value on success, 0 otherwise
+ */
+int CatalogIndex_getDatabaseStamp(const char * filename, long * databaseSize, long * databaseTime, long * databaseNanoseconds)
+{
+    struct stat status;
+
+    if (stat(filename, &status) != 0)
+        return 0;
+    *databaseSize = (long)status.st_size;
+    *databaseTime = (long)status.st_mtime;
+    *databaseNanoseconds = getModificationNanoseconds(&status);
+    return 1;
+}
+
+/** Find the entry of a code
+ * @param catalogIndex the index
+ * @param code the code
+ * @return the entry or NULL if no record has this code
+ */
+CatalogIndexEntry * CatalogIndex_find(CatalogIndex * catalogIndex, const char * code)
+{
+    int position;
+
+    if (catalogIndex->capacity == 0)
+        return NULL;
+    position = CatalogIndex_lookup(catalogIndex, code);
+    if (catalogIndex->entries[position].slot == -1)
+        return NULL;
+    return &catalogIndex->entries[position];
+}
+
+/** Record that a slot holds a product with a given code
+ * @param catalogIndex the index
+ * @param code the code of the product
+ * @param slot the slot of the product
+ */
+void CatalogIndex_add(CatalogIndex * catalogIndex, const char * code, int slot)
+{
+    CatalogIndexEntry * entry;
+
+    /* keep the load factor under 3/4 */
+    if ((catalogIndex->size + 1) * 4 > catalogIndex->capacity * 3)
+        CatalogIndex_resize(catalogIndex, MAXVALUE(catalogIndex->capacity * 2, CATALOGINDEX_INITIAL_CAPACITY));
+
+    entry = &catalogIndex->entries[CatalogIndex_lookup(catalogIndex, code)];
+    if (entry->slot == -1)
+    {
+        copyStringWithLength(entry->code, code, CATALOGRECORD_CODE_SIZE);
+        entry->slot = slot;
+        entry->count = 1;
+        catalogIndex->size += 1;
+    }
+    else
+    {
+        entry->count += 1;
+        if (slot < entry->slot)
+            entry->slot = slot;
+    }
+    catalogIndex->isModified = 1;
+}
+
+/** Record that a slot does not hold a product with a given code anymore
+ * @param catalogIndex the index
+ * @param code the code of the product
+ * @param slot the slot of the product
+ * @return a non null value if the caller must update the slot of the entry
+ */
+int CatalogIndex_delete(CatalogIndex * catalogIndex, const char * code, int slot)
+{
+    unsigned long mask = (unsigned long)catalogIndex->capacity - 1;
+    unsigned long hole;
+    unsigned long next;
+    int position = CatalogIndex_lookup(catalogIndex, code);
+    CatalogIndexEntry * entry = &catalogIndex->entries[position];
+
+    if (entry->slot == -1)
+        return 0;
+    catalogIndex->isModified = 1;
+    if (entry->count > 1)
+    {
+        entry->count -= 1;
+        return entry->slot == slot;
+    }
+
+    /* backward shift deletion: move back the following entries which can not be reached anymore */
+    hole = (unsigned long)position;
+    next = (hole + 1) & mask;
+    while (catalogIndex->entries[next].slot != -1)
+    {
+        unsigned long home = CatalogIndex_hash(catalogIndex->entries[next].code) & mask;
+        if ((next > hole && (home <= hole || home > next)) || (next < hole && home <= hole && home > next))
+        {
+            catalogIndex->entries[hole] = catalogIndex->entries[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    catalogIndex->entries[hole].slot = -1;
+    catalogIndex->size -= 1;
+    return 0;
+}
+
+/** Compute the hash value of a code (FNV-1a)
+ * @param code the code
+ * @return the hash value
+ */
+static unsigned long CatalogIndex_hash(const char * code)
+{
+    unsigned long hash = 2166136261UL;
+    size_t i;
+
+    for (i = 0; i + 1 < CATALOGRECORD_CODE_SIZE && code[i] != '\0'; ++i)
+    {
+        hash ^= (unsigned char)code[i];
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+/** Find the position of the entry of a code or of the empty entry where it must be stored
+ * @param catalogIndex the index
+ * @param code the code
+ * @return the position
+ */
+static int CatalogIndex_lookup(CatalogIndex * catalogIndex, const char * code)
+{
+    char key[CATALOGRECORD_CODE_SIZE];
+    unsigned long mask = (unsigned long)catalogIndex->capacity - 1;
+    unsigned long position;
+
+    /* codes longer than the field are stored truncated */
+    copyStringWithLength(key, code, CATALOGRECORD_CODE_SIZE);
+    position = CatalogIndex_hash(key) & mask;
+    while (catalogIndex->entries[position].slot != -1 && compareString(catalogIndex->entries[position].code, key) != 0)
+        position = (position + 1) & mask;
+    return (int)position;
+}
+
+/** Change the number of entries of an index and rehash its content
+ * @param catalogIndex the index
+ * @param capacity the new number of entries, a power of 2
+ */
+static void CatalogIndex_resize(CatalogIndex * catalogIndex, int capacity)
+{
+    CatalogIndexEntry * oldEntries = catalogIndex->entries;
+    int oldCapacity = catalogIndex->capacity;
+    int i;
+
+    catalogIndex->entries = calloc((size_t)capacity, sizeof(CatalogIndexEntry));
+    if (catalogIndex->entries == NULL)
+        fatalError("calloc error : Allocation of the catalog index failed");
+    for (i = 0; i < capacity; ++i)
+        catalogIndex->entries[i].slot = -1;
+    catalogIndex->capacity = capacity;
+
+    for (i = 0; i < oldCapacity; ++i)
+        if (oldEntries[i].slot != -1)
+            catalogIndex->entries[CatalogIndex_lookup(catalogIndex, oldEntries[i].code)] = oldEntries[i];
+    free(oldEntries);
+}
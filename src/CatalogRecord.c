@@ -282,33 +282,63 @@ void IMPLEMENT(CatalogRecord_write)(CatalogRecord * record, FILE * file)
 {
     char buffer[CATALOGRECORD_SIZE];
 
-    memset(buffer, '\0', sizeof(char) * CATALOGRECORD_CODE_SIZE);
-    copyStringWithLength(buffer, record->code, CATALOGRECORD_CODE_SIZE);
+    CatalogRecord_encode(record, buffer);
 
-    if(fwrite(buffer, sizeof(char) * CATALOGRECORD_CODE_SIZE, 1, file) < 1)
+    if(fwrite(buffer, CATALOGRECORD_SIZE, 1, file) < 1)
         fatalError("fwrite error : return value is not valid.");
+}
 
+/** Encode a record in memory using the same packed layout as CatalogRecord_write()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CATALOGRECORD_SIZE bytes receiving the data
+ */
+void CatalogRecord_encode(CatalogRecord * record, char * buffer)
+{
+    memset(buffer, '\0', sizeof(char) * CATALOGRECORD_CODE_SIZE);
+    copyStringWithLength(buffer, record->code, CATALOGRECORD_CODE_SIZE);
+    buffer += CATALOGRECORD_CODE_SIZE;
 
     memset(buffer, '\0', sizeof(char) * CATALOGRECORD_DESIGNATION_SIZE);
     copyStringWithLength(buffer, record->designation, CATALOGRECORD_DESIGNATION_SIZE);
-
-    if(fwrite(buffer, sizeof(char) * CATALOGRECORD_DESIGNATION_SIZE, 1, file) < 1)
-        fatalError("fwrite error : return value is not valid.");
-
+    buffer += CATALOGRECORD_DESIGNATION_SIZE;
 
     memset(buffer, '\0', sizeof(char) * CATALOGRECORD_UNITY_SIZE);
     copyStringWithLength(buffer, record->unity, CATALOGRECORD_UNITY_SIZE);
+    buffer += CATALOGRECORD_UNITY_SIZE;
 
-    if(fwrite(buffer, sizeof(char) * CATALOGRECORD_UNITY_SIZE, 1, file) < 1)
-        fatalError("fwrite error : return value is not valid.");
-
-
-    if(fwrite(&record->basePrice, CATALOGRECORD_BASEPRICE_SIZE, 1, file) < 1)
-        fatalError("fwrite error : return value is not valid.");
-
-    if(fwrite(&record->sellingPrice, CATALOGRECORD_SELLINGPRICE_SIZE, 1, file) < 1)
-        fatalError("fwrite error : return value is not valid.");
+    memcpy(buffer, &record->basePrice, CATALOGRECORD_BASEPRICE_SIZE);
+    buffer += CATALOGRECORD_BASEPRICE_SIZE;
+    memcpy(buffer, &record->sellingPrice, CATALOGRECORD_SELLINGPRICE_SIZE);
+    buffer += CATALOGRECORD_SELLINGPRICE_SIZE;
+    memcpy(buffer, &record->rateOfVAT, CATALOGRECORD_RATEOFVAT_SIZE);
+}
 
-    if(fwrite(&record->rateOfVAT, CATALOGRECORD_RATEOFVAT_SIZE, 1, file) < 1)
-        fatalError("fwrite error : return value is not valid.");
+/** Decode a record from memory using the same packed layout as CatalogRecord_read()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CATALOGRECORD_SIZE bytes containing the data
+ */
+void CatalogRecord_decode(CatalogRecord * record, const char * buffer)
+{
+    char field[CATALOGRECORD_MAXSTRING_SIZE + 1];
+
+    memcpy(field, buffer, CATALOGRECORD_CODE_SIZE);
+    field[CATALOGRECORD_CODE_SIZE] = '\0';
+    CatalogRecord_setValue_code(record, field);
+    buffer += CATALOGRECORD_CODE_SIZE;
+
+    memcpy(field, buffer, CATALOGRECORD_DESIGNATION_SIZE);
+    field[CATALOGRECORD_DESIGNATION_SIZE] = '\0';
+    CatalogRecord_setValue_designation(record, field);
+    buffer += CATALOGRECORD_DESIGNATION_SIZE;
+
+    memcpy(field, buffer, CATALOGRECORD_UNITY_SIZE);
+    field[CATALOGRECORD_UNITY_SIZE] = '\0';
+    CatalogRecord_setValue_unity(record, field);
+    buffer += CATALOGRECORD_UNITY_SIZE;
+
+    memcpy(&record->basePrice, buffer, CATALOGRECORD_BASEPRICE_SIZE);
+    buffer += CATALOGRECORD_BASEPRICE_SIZE;
+    memcpy(&record->sellingPrice, buffer, CATALOGRECORD_SELLINGPRICE_SIZE);
+    buffer += CATALOGRECORD_SELLINGPRICE_SIZE;
+    memcpy(&record->rateOfVAT, buffer, CATALOGRECORD_RATEOFVAT_SIZE);
 }
@@ -0,0 +1,409 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <CatalogSnapshot.h>
+#include <MyString.h>
+
+/** What is compared to sort the records by a field */
+typedef struct
+{
+  const char * arena; /**< The strings of the snapshot */
+  const size_t * strings; /**< The offsets of the strings of the field, NULL for a numeric field */
+  const unsigned long * keys; /**< The first characters of the strings of the field packed in an integer */
+  const double * numbers; /**< The values of the numeric field, NULL for a string field */
+} CatalogSnapshotSortContext;
+
+static void * CatalogSnapshot_allocate(size_t size);
+static size_t CatalogSnapshot_store(CatalogSnapshot * snapshot, size_t * arenaCapacity, const char * string);
+static unsigned long CatalogSnapshot_getKey(const char * string);
+static int CatalogSnapshot_compareStrings(const char * string1, const char * string2);
+static int CatalogSnapshot_compare(const CatalogSnapshotSortContext * context, int recordIndex1, int recordIndex2);
+static void CatalogSnapshot_sort(const CatalogSnapshotSortContext * context, int * order, int * buffer, int count);
+static int CatalogSnapshot_contains(const char * string, const char * text);
+
+/** Create a snapshot of a catalog by reading all its records
+ * @param catalogDB the database
+ * @return the new snapshot
+ */
+CatalogSnapshot * CatalogSnapshot_create(CatalogDB * catalogDB)
+{
+    CatalogSnapshot * snapshot = CatalogSnapshot_allocate(sizeof(CatalogSnapshot));
+    size_t count = (size_t)CatalogDB_getRecordCount(catalogDB);
+    size_t arenaCapacity = 4096;
+    int wasMapped = (catalogDB->mapping != NULL);
+    CatalogRecordView view;
+    CatalogRecord record;
+    int i;
+
+    snapshot->recordCount = (int)count;
+    snapshot->arena = CatalogSnapshot_allocate(arenaCapacity);
+    snapshot->arenaSize = 0;
+    snapshot->codes = CatalogSnapshot_allocate(sizeof(size_t) * (count + 1));
+    snapshot->designations = CatalogSnapshot_allocate(sizeof(size_t) * (count + 1));
+    snapshot->unities = CatalogSnapshot_allocate(sizeof(size_t) * (count + 1));
+    snapshot->basePrices = CatalogSnapshot_allocate(sizeof(double) * (count + 1));
+    snapshot->sellingPrices = CatalogSnapshot_allocate(sizeof(double) * (count + 1));
+    snapshot->ratesOfVAT = CatalogSnapshot_allocate(sizeof(double) * (count + 1));
+    for (i = 0; i < CATALOGRECORD_FIELDCOUNT; ++i)
+        snapshot->orders[i] = NULL;
+
+    /* the records are read from the memory mapping when possible */
+    if (!wasMapped)
+        CatalogDB_map(catalogDB);
+    CatalogRecord_init(&record);
+    for (i = 0; i < snapshot->recordCount; ++i)
+    {
+        if (!CatalogDB_getRecordView(catalogDB, i, &view))
+        {
+            CatalogDB_readRecord(catalogDB, i, &record);
+            view.code = record.code;
+            view.designation = record.designation;
+            view.unity = record.unity;
+            view.basePrice = record.basePrice;
+            view.sellingPrice = record.sellingPrice;
+            view.rateOfVAT = record.rateOfVAT;
+        }
+        snapshot->codes[i] = CatalogSnapshot_store(snapshot, &arenaCapacity, view.code);
+        snapshot->designations[i] = CatalogSnapshot_store(snapshot, &arenaCapacity, view.designation);
+        snapshot->unities[i] = CatalogSnapshot_store(snapshot, &arenaCapacity, view.unity);
+        snapshot->basePrices[i] = view.basePrice;
+        snapshot->sellingPrices[i] = view.sellingPrice;
+        snapshot->ratesOfVAT[i] = view.rateOfVAT;
+    }
+    CatalogRecord_finalize(&record);
+    if (!wasMapped)
+        CatalogDB_unmap(catalogDB);
+
+    return snapshot;
+}
+
+/** Free the memory used by a snapshot
+ * @param snapshot the snapshot
+ */
+void CatalogSnapshot_destroy(CatalogSnapshot * snapshot)
+{
+    int i;
+
+    for (i = 0; i < CATALOGRECORD_FIELDCOUNT; ++i)
+        free(snapshot->orders[i]);
+    free(snapshot->arena);
+    free(snapshot->codes);
+    free(snapshot->designations);
+    free(snapshot->unities);
+    free(snapshot->basePrices);
+    free(snapshot->sellingPrices);
+    free(snapshot->ratesOfVAT);
+    free(snapshot);
+}
+
+/** Get the code of a record of a snapshot
+ * @param snapshot the snapshot
+ * @param recordIndex the position of the record
+ * @return the code, stored in the snapshot
+ */
+const char * CatalogSnapshot_getCode(CatalogSnapshot * snapshot, int recordIndex)
+{
+    return snapshot->arena + snapshot->codes[recordIndex];
+}
+
+/** Get the designation of a record of a snapshot
+ * @param snapshot the snapshot
+ * @param recordIndex the position of the record
+ * @return the designation, stored in the snapshot
+ */
+const char * CatalogSnapshot_getDesignation(CatalogSnapshot * snapshot, int recordIndex)
+{
+    return snapshot->arena + snapshot->designations[recordIndex];
+}
+
+/** Get the unity of a record of a snapshot
+ * @param snapshot the snapshot
+ * @param recordIndex the position of the record
+ * @return the unity, stored in the snapshot
+ */
+const char * CatalogSnapshot_getUnity(CatalogSnapshot * snapshot, int recordIndex)
+{
+    return snapshot->arena + snapshot->unities[recordIndex];
+}
+
+/** Get the positions of the records sorted by increasing value of a field
+ * @param snapshot the snapshot
+ * @param field the field
+ * @return the array of the recordCount positions, owned by the snapshot
+ */
+const int * CatalogSnapshot_getOrder(CatalogSnapshot * snapshot, int field)
+{
+    CatalogSnapshotSortContext context;
+    unsigned long * keys = NULL;
+    int * order;
+    int * buffer;
+    int i;
+
+    if (field < 0 || field >= CATALOGRECORD_FIELDCOUNT)
+        fatalError("CatalogSnapshot_getOrder: invalid field");
+    if (snapshot->orders[field] != NULL)
+        return snapshot->orders[field];
+
+    context.arena = snapshot->arena;
+    context.strings = NULL;
+    context.keys = NULL;
+    context.numbers = NULL;
+    switch (field)
+    {
+        case CATALOGRECORD_CODE_FIELD:
+            context.strings = snapshot->codes;
+            break;
+        case CATALOGRECORD_DESIGNATION_FIELD:
+            context.strings = snapshot->designations;
+            break;
+        case CATALOGRECORD_UNITY_FIELD:
+            context.strings = snapshot->unities;
+            break;
+        case CATALOGRECORD_BASEPRICE_FIELD:
+            context.numbers = snapshot->basePrices;
+            break;
+        case CATALOGRECORD_SELLINGPRICE_FIELD:
+            context.numbers = snapshot->sellingPrices;
+            break;
+        default:
+            context.numbers = snapshot->ratesOfVAT;
+            break;
+    }
+
+    /* most string comparisons are decided by the first characters compared as a single integer */
+    if (context.strings != NULL)
+    {
+        keys = CatalogSnapshot_allocate(sizeof(unsigned long) * (size_t)(snapshot->recordCount + 1));
+        for (i = 0; i < snapshot->recordCount; ++i)
+            keys[i] = CatalogSnapshot_getKey(snapshot->arena + context.strings[i]);
+        context.keys = keys;
+    }
+
+    order = CatalogSnapshot_allocate(sizeof(int) * (size_t)(snapshot->recordCount + 1));
+    buffer = CatalogSnapshot_allocate(sizeof(int) * (size_t)(snapshot->recordCount + 1));
+    for (i = 0; i < snapshot->recordCount; ++i)
+        order[i] = i;
+    CatalogSnapshot_sort(&context, order, buffer, snapshot->recordCount);
+    free(buffer);
+    free(keys);
+
+    snapshot->orders[field] = order;
+    return order;
+}
+
+/** Find the records whose code or designation contains a text, without case
+ * @param snapshot the snapshot
+ * @param text the text to find
+ * @param order the order in which the records are returned, NULL for the order of the positions
+ * @param recordIndexes the array of at least recordCount elements receiving the positions of the records found
+ * @return the number of records found
+ */
+int CatalogSnapshot_filter(CatalogSnapshot * snapshot, const char * text, const int * order, int * recordIndexes)
+{
+    int found = 0;
+    int i;
+
+    for (i = 0; i < snapshot->recordCount; ++i)
+    {
+        int recordIndex = (order != NULL) ? order[i] : i;
+
+        if (CatalogSnapshot_contains(snapshot->arena + snapshot->codes[recordIndex], text)
+                || CatalogSnapshot_contains(snapshot->arena + snapshot->designations[recordIndex], text))
+        {
+            recordIndexes[found] = recordIndex;
+            found += 1;
+        }
+    }
+    return found;
+}
+
+/** Allocate memory or stop the application
+ * @param size the number of bytes
+ * @return the allocated memory
+ */
+static void * CatalogSnapshot_allocate(size_t size)
+{
+    void * memory = malloc(size);
+
+    if (memory == NULL)
+        fatalError("malloc error : Allocation of the catalog snapshot failed");
+    return memory;
+}
+
+/** Copy a string at the end of the arena of a snapshot
+ * @param snapshot the snapshot
+ * @param arenaCapacity the allocated size of the arena, updated if the arena grows
+ * @param string the string
+ * @return the offset of the copy in the arena
+ */
+static size_t CatalogSnapshot_store(CatalogSnapshot * snapshot, size_t * arenaCapacity, const char * string)
+{
+    size_t offset = snapshot->arenaSize;
+    size_t size = stringLength(string) + 1;
+
+    if (offset + size > *arenaCapacity)
+    {
+        char * arena;
+
+        while (offset + size > *arenaCapacity)
+            *arenaCapacity *= 2;
+        arena = realloc(snapshot->arena, *arenaCapacity);
+        if (arena == NULL)
+            fatalError("realloc error : Reallocation of the catalog snapshot failed");
+        snapshot->arena = arena;
+    }
+    memcpy(snapshot->arena + offset, string, size);
+    snapshot->arenaSize += size;
+    return offset;
+}
+
+/** Pack the first characters of a string, without case, in an integer which sorts like the string
+ * @param string the string
+ * @return the key
+ */
+static unsigned long CatalogSnapshot_getKey(const char * string)
+{
+    unsigned long key = 0;
+    size_t i;
+    int isEnded = 0;
+
+    for (i = 0; i < sizeof(unsigned long); ++i)
+    {
+        unsigned char c = 0;
+
+        if (!isEnded && string[i] == '\0')
+            isEnded = 1;
+        if (!isEnded)
+            c = (unsigned char)toLowerChar(string[i]);
+        key = (key << 8) | c;
+    }
+    return key;
+}
+
+/** Compare two strings without case, the characters being compared as unsigned values
+ * @param string1 the first string
+ * @param string2 the second string
+ * @return a negative, null or positive value as string1 is lower, equal or greater than string2
+ */
+static int CatalogSnapshot_compareStrings(const char * string1, const char * string2)
+{
+    unsigned char c1;
+    unsigned char c2;
+
+    do
+    {
+        c1 = (unsigned char)toLowerChar(*string1++);
+        c2 = (unsigned char)toLowerChar(*string2++);
+    } while (c1 == c2 && c1 != '\0');
+    return (int)c1 - (int)c2;
+}
+
+/** Compare two records by the field of a sort context
+ * @param context the sort context
+ * @param recordIndex1 the position of the first record
+ * @param recordIndex2 the position of the second record
+ * @return a negative, null or positive value as the first record is lower, equal or greater than the second one
+ */
+static int CatalogSnapshot_compare(const CatalogSnapshotSortContext * context, int recordIndex1, int recordIndex2)
+{
+    if (context->numbers != NULL)
+    {
+        if (context->numbers[recordIndex1] < context->numbers[recordIndex2])
+            return -1;
+        if (context->numbers[recordIndex1] > context->numbers[recordIndex2])
+            return 1;
+        return 0;
+    }
+    if (context->keys[recordIndex1] != context->keys[recordIndex2])
+        return (context->keys[recordIndex1] < context->keys[recordIndex2]) ? -1 : 1;
+    return CatalogSnapshot_compareStrings(context->arena + context->strings[recordIndex1],
+            context->arena + context->strings[recordIndex2]);
+}
+
+/** Sort record positions with a stable bottom-up merge sort
+ * @param context the sort context
+ * @param order the positions to sort
+ * @param buffer a buffer of count elements
+ * @param count the number of positions
+ */
+static void CatalogSnapshot_sort(const CatalogSnapshotSortContext * context, int * order, int * buffer, int count)
+{
+    int * source = order;
+    int * target = buffer;
+    int width;
+    int i;
+
+    /* merge the runs of width positions of source into target, then swap their roles */
+    for (width = 1; width < count; width *= 2)
+    {
+        int * swap;
+
+        for (i = 0; i < count; i += 2 * width)
+        {
+            int left = i;
+            int leftEnd = MINVALUE(i + width, count);
+            int right = leftEnd;
+            int rightEnd = MINVALUE(i + 2 * width, count);
+            int k = i;
+
+            while (left < leftEnd && right < rightEnd)
+            {
+                if (CatalogSnapshot_compare(context, source[right], source[left]) < 0)
+                    target[k++] = source[right++];
+                else
+                    target[k++] = source[left++];
+            }
+            while (left < leftEnd)
+                target[k++] = source[left++];
+            while (right < rightEnd)
+                target[k++] = source[right++];
+        }
+        swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != order)
+        memcpy(order, source, sizeof(int) * (size_t)count);
+}
+
+/** Tell if a string contains a text, without case
+ * @param string the string
+ * @param text the text
+ * @return a non null value if the text is found
+ */
+static int CatalogSnapshot_contains(const char * string, const char * text)
+{
+    if (*text == '\0')
+        return 1;
+    for (; *string != '\0'; ++string)
+    {
+        const char * s = string;
+        const char * t = text;
+
+        while (*s != '\0' && *t != '\0' && toLowerChar(*s) == toLowerChar(*t))
+        {
+            ++s;
+            ++t;
+        }
+        if (*t == '\0')
+            return 1;
+    }
+    return 0;
+}
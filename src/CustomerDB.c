@@ -21,6 +21,25 @@
 #include <CustomerRecord.h>
 #include <CustomerRecordEditor.h>
 
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static void CustomerDB_flushBatch(CustomerDB * customerDB);
+static long CustomerDB_getOffset(CustomerDB * customerDB, int recordIndex);
+static void CustomerDB_endWrite(CustomerDB * customerDB);
+static void CustomerDB_doInsert(CustomerDB * customerDB, int recordIndex, CustomerRecord * record);
+static void CustomerDB_doAppend(CustomerDB * customerDB, CustomerRecord * record);
+static void CustomerDB_doAppendMany(CustomerDB * customerDB, CustomerRecord * records, int count);
+static void CustomerDB_doCommitBatch(CustomerDB * customerDB);
+static void CustomerDB_allocateBatch(CustomerDB * customerDB);
+static void CustomerDB_log(CustomerDB * customerDB, WriteAheadLogOperation operation, int recordIndex, CustomerRecord * record);
+static void CustomerDB_checkpoint(CustomerDB * customerDB);
+static void CustomerDB_writeSlot(CustomerDB * customerDB, int slot, CustomerRecord * record);
+static int CustomerDB_findPending(CustomerDB * customerDB, int slot);
+static void CustomerDB_commitGroup(CustomerDB * customerDB);
+static void CustomerDB_applyPending(CustomerDB * customerDB);
+
 const char * CUSTOMERDB_FILENAME = BASEPATH "/data/Customer.db";
 
 /** Function to create a new CustomerDb on the heap
@@ -51,6 +70,18 @@ CustomerDB * IMPLEMENT(CustomerDB_create)(const char * filename)
         fatalError("fwrite error : return value is < 1.");
     }
     customerDB->file = file;
+    customerDB->filename = duplicateString(filename);
+    SlotTable_init(&customerDB->slots, 0);
+    WriteAheadLog_init(&customerDB->log, filename, CUSTOMERRECORD_SIZE, &customerDB->slots);
+    /* drop the slot table and the log of a previous database with the same name */
+    SlotTable_save(&customerDB->slots, filename);
+    WriteAheadLog_reset(&customerDB->log);
+    customerDB->batchBuffer = NULL;
+    customerDB->batchCount = 0;
+    customerDB->pendingCount = 0;
+    customerDB->isModified = 1;
+    DatabaseLock_init(&customerDB->lock, DATABASE_PRIVATE);
+    BlockCache_init(&customerDB->cache, BLOCKCACHE_PAGE_SIZE, BLOCKCACHE_DEFAULT_BUDGET);
 
     return customerDB;
 }
@@ -60,8 +91,20 @@ CustomerDB * IMPLEMENT(CustomerDB_create)(const char * filename)
  * @return the new CustomerDB
  */
 CustomerDB * IMPLEMENT(CustomerDB_open)(const char * filename)
+{
+    return CustomerDB_openWithAccess(filename, DATABASE_PRIVATE);
+}
+
+/** Open an existing database of customers and lock its file according to an access mode
+ * @param filename the file name of the database
+ * @param access the access mode
+ * @return the new CustomerDB, NULL if the file can not be opened or is locked by another process
+ */
+CustomerDB * CustomerDB_openWithAccess(const char * filename, DatabaseAccess access)
 {
     CustomerDB * customerDB = malloc(sizeof(CustomerDB));
+    int replayedCount = 0;
+    int isRebuilt;
 
     if (customerDB == NULL)
         fatalError("malloc error : Allocation of CustomerDB * customerDB failed");
@@ -74,6 +117,15 @@ CustomerDB * IMPLEMENT(CustomerDB_open)(const char * filename)
         return NULL;
     }
 
+    DatabaseLock_init(&customerDB->lock, access);
+    if (!DatabaseLock_lockFile(&customerDB->lock, file))
+    {
+        DatabaseLock_finalize(&customerDB->lock);
+        fclose(file);
+        free(customerDB);
+        return NULL;
+    }
+
     if (fread(&customerDB->recordCount, sizeof(int), 1, file) < 1)
     {
         fclose(file);
@@ -81,7 +133,34 @@ CustomerDB * IMPLEMENT(CustomerDB_open)(const char * filename)
         fatalError("fread error : return value is < 1");
     }
 
+    /* the header stores the number of slots, the slot table tells which ones hold a record */
+    isRebuilt = !SlotTable_load(&customerDB->slots, file, filename, customerDB->recordCount, CUSTOMERRECORD_SIZE);
+
+    /* the changes logged after the last checkpoint of a crashed session are applied again */
+    WriteAheadLog_init(&customerDB->log, filename, CUSTOMERRECORD_SIZE, &customerDB->slots);
+    if (DatabaseLock_canWriteFile(&customerDB->lock))
+        replayedCount = WriteAheadLog_replay(&customerDB->log, file);
+
     customerDB->file = file;
+    customerDB->filename = duplicateString(filename);
+    customerDB->recordCount = customerDB->slots.count;
+    customerDB->batchBuffer = NULL;
+    customerDB->batchCount = 0;
+    customerDB->pendingCount = 0;
+    customerDB->isModified = 0;
+    BlockCache_init(&customerDB->cache, BLOCKCACHE_PAGE_SIZE, BLOCKCACHE_DEFAULT_BUDGET);
+    /* a rebuilt slot table is saved at once so that the side file is repaired, nothing is left to save at close */
+    if (replayedCount > 0 || (isRebuilt && DatabaseLock_canWriteFile(&customerDB->lock)))
+        CustomerDB_checkpoint(customerDB);
+    else if (DatabaseLock_canWriteFile(&customerDB->lock))
+        WriteAheadLog_reset(&customerDB->log);
+
+    /* a reader let the other readers in once the file is repaired */
+    if (!DatabaseLock_shareFile(&customerDB->lock))
+    {
+        CustomerDB_close(customerDB);
+        return NULL;
+    }
 
     return customerDB;
 }
@@ -105,14 +184,16 @@ CustomerDB * IMPLEMENT(CustomerDB_openOrCreate)(const char * filename)
  */
 void IMPLEMENT(CustomerDB_close)(CustomerDB * customerDB)
 {
-    rewind(customerDB->file);
-    if (fwrite(&customerDB->recordCount, sizeof(int), 1, customerDB->file) < 1)
-    {
-        fclose(customerDB->file);
-        free(customerDB);
-        fatalError("fwrite error : return value is < 1");
-    }
+    if (customerDB->batchBuffer != NULL)
+        CustomerDB_commitBatch(customerDB);
+    if (customerDB->isModified && DatabaseLock_canWriteFile(&customerDB->lock))
+        CustomerDB_checkpoint(customerDB);
+    DatabaseLock_finalize(&customerDB->lock);
     fclose(customerDB->file);
+    WriteAheadLog_finalize(&customerDB->log);
+    SlotTable_finalize(&customerDB->slots);
+    BlockCache_finalize(&customerDB->cache);
+    free(customerDB->filename);
     free(customerDB);
 }
 
@@ -122,7 +203,12 @@ void IMPLEMENT(CustomerDB_close)(CustomerDB * customerDB)
  */
 int IMPLEMENT(CustomerDB_getRecordCount)(CustomerDB * customerDB)
 {
-    return customerDB->recordCount;
+    int recordCount;
+
+    DatabaseLock_beginRead(&customerDB->lock);
+    recordCount = customerDB->recordCount;
+    DatabaseLock_endRead(&customerDB->lock);
+    return recordCount;
 }
 
 
@@ -145,11 +231,9 @@ char * CustomerDB_getFieldValueAsString(CustomerDB * customerDB, int recordIndex
  */
 void IMPLEMENT(CustomerDB_appendRecord)(CustomerDB * customerDB, CustomerRecord *record)
 {
-    rewind(customerDB->file);
-    fseek(customerDB->file, (int)sizeof(int) + (int)CUSTOMERRECORD_SIZE * customerDB->recordCount, SEEK_CUR);
-    customerDB->recordCount += 1;
-    CustomerRecord_write(record, customerDB->file);
-    rewind(customerDB->file);
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_doAppend(customerDB, record);
+    CustomerDB_endWrite(customerDB);
 }
 
 /** Function to insert a new record located by record index position
@@ -159,23 +243,41 @@ void IMPLEMENT(CustomerDB_appendRecord)(CustomerDB * customerDB, CustomerRecord
  */
 void IMPLEMENT(CustomerDB_insertRecord)(CustomerDB * customerDB, int recordIndex, CustomerRecord * record)
 {
-    int recordCount = CustomerDB_getRecordCount(customerDB);
-    CustomerRecord * recordCopie = malloc(sizeof(CustomerRecord));
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_doInsert(customerDB, recordIndex, record);
+    CustomerDB_endWrite(customerDB);
+}
 
-    if (recordCopie == NULL)
-        fatalError("malloc error : Allocation of CustomerRecord * recordCopie failed");
+/** Insert a record at a given position while the database is locked
+ * @param customerDB the database
+ * @param recordIndex the insertion position
+ * @param record the record
+ */
+static void CustomerDB_doInsert(CustomerDB * customerDB, int recordIndex, CustomerRecord * record)
+{
+    int slot;
 
-    CustomerRecord_init(recordCopie);
+    CustomerDB_flushBatch(customerDB);
+    if (recordIndex > customerDB->recordCount || recordIndex < 0)
+        fatalError("Error : recordIndex is too higher or too smaller than recordCount");
+    CustomerDB_log(customerDB, WRITEAHEADLOG_INSERT, recordIndex, record);
+    slot = SlotTable_insert(&customerDB->slots, recordIndex);
+    customerDB->recordCount = customerDB->slots.count;
+    customerDB->isModified = 1;
 
-    while (recordCount != recordIndex)
-    {
-        CustomerDB_readRecord(customerDB, recordCount-1, recordCopie);
-        CustomerDB_writeRecord(customerDB, recordCount, recordCopie);
-        recordCount--;
-    }
+    CustomerDB_writeSlot(customerDB, slot, record);
+}
 
-    free(recordCopie);
-    CustomerDB_writeRecord(customerDB, recordIndex, record);
+/** Append a record at the end of the database while the database is locked
+ * @param customerDB the database
+ * @param record the record
+ */
+static void CustomerDB_doAppend(CustomerDB * customerDB, CustomerRecord * record)
+{
+    if (customerDB->batchBuffer != NULL)
+        CustomerDB_doAppendMany(customerDB, record, 1);
+    else
+        CustomerDB_doInsert(customerDB, customerDB->recordCount, record);
 }
 
 /** Function to remove a record located by record index position
@@ -184,27 +286,20 @@ void IMPLEMENT(CustomerDB_insertRecord)(CustomerDB * customerDB, int recordIndex
  */
 void IMPLEMENT(CustomerDB_removeRecord)(CustomerDB * customerDB, int recordIndex)
 {
-    int recordCount = CustomerDB_getRecordCount(customerDB);
-    CustomerRecord * recordCopie = malloc(sizeof(CustomerRecord));
-
-    if (recordCopie == NULL)
-        fatalError("malloc error : Allocation of CustomerRecord * recordCopie failed");
+    int slot;
 
-    CustomerRecord_init(recordCopie);
-
-    if (recordIndex >= recordCount || recordIndex < 0 )
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_flushBatch(customerDB);
+    if (recordIndex >= customerDB->recordCount || recordIndex < 0 )
         fatalError("Error : recordIndex is too higher or too smaller than recordCount");
 
-    rewind(customerDB->file);
+    CustomerDB_log(customerDB, WRITEAHEADLOG_REMOVE, recordIndex, NULL);
+    slot = SlotTable_remove(&customerDB->slots, recordIndex);
+    customerDB->recordCount = customerDB->slots.count;
+    customerDB->isModified = 1;
 
-    while (recordIndex != recordCount - 1)
-    {
-        CustomerDB_readRecord(customerDB, recordIndex+1, recordCopie);
-        CustomerDB_writeRecord(customerDB, recordIndex, recordCopie);
-        recordIndex++;
-    }
-    customerDB->recordCount -= 1;
-    free(recordCopie);
+    CustomerDB_writeSlot(customerDB, slot, NULL);
+    CustomerDB_endWrite(customerDB);
 }
 
 /** Function to read a record located in a file
@@ -214,10 +309,28 @@ void IMPLEMENT(CustomerDB_removeRecord)(CustomerDB * customerDB, int recordIndex
  */
 void IMPLEMENT(CustomerDB_readRecord)(CustomerDB * customerDB, int recordIndex, CustomerRecord * record)
 {
-    rewind(customerDB->file);
-    fseek(customerDB->file, (int)sizeof(int) + (int)CUSTOMERRECORD_SIZE * recordIndex, SEEK_CUR);
+    char buffer[CUSTOMERRECORD_SIZE];
+    int firstBatchSlot;
+    int slot;
+    int pending;
+
+    DatabaseLock_beginRead(&customerDB->lock);
+    if (recordIndex >= customerDB->recordCount || recordIndex < 0)
+        fatalError("Error : recordIndex is too higher or too smaller than recordCount");
 
-    CustomerRecord_read(record, customerDB->file);
+    /* the pending records and the ones of the current batch are still in memory, the other ones are read through the page cache */
+    firstBatchSlot = customerDB->slots.slotCount - customerDB->batchCount;
+    slot = SlotTable_getSlot(&customerDB->slots, recordIndex);
+    pending = CustomerDB_findPending(customerDB, slot);
+    if (pending != -1)
+        memcpy(buffer, customerDB->pendingRecords + CUSTOMERRECORD_SIZE * (size_t)pending, CUSTOMERRECORD_SIZE);
+    else if (slot >= firstBatchSlot)
+        memcpy(buffer, customerDB->batchBuffer + CUSTOMERRECORD_SIZE * (size_t)(slot - firstBatchSlot), CUSTOMERRECORD_SIZE);
+    else if (!BlockCache_read(&customerDB->cache, fileno(customerDB->file), CustomerDB_getOffset(customerDB, recordIndex), CUSTOMERRECORD_SIZE, buffer))
+        fatalError("pread error : unable to read a record");
+    DatabaseLock_endRead(&customerDB->lock);
+
+    CustomerRecord_decode(record, buffer);
 }
 
 /** Function to write a record located in a file
@@ -227,13 +340,343 @@ void IMPLEMENT(CustomerDB_readRecord)(CustomerDB * customerDB, int recordIndex,
  */
 void IMPLEMENT(CustomerDB_writeRecord)(CustomerDB * customerDB, int recordIndex, CustomerRecord * record)
 {
-    if (recordIndex < CustomerDB_getRecordCount(customerDB))
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_flushBatch(customerDB);
+    if (recordIndex < customerDB->recordCount)
     {
-        rewind(customerDB->file);
-        fseek(customerDB->file, (int)sizeof(int) + (int)CUSTOMERRECORD_SIZE * recordIndex, SEEK_CUR);
-
-        CustomerRecord_write(record, customerDB->file);
+        CustomerDB_log(customerDB, WRITEAHEADLOG_WRITE, recordIndex, record);
+        customerDB->isModified = 1;
+        CustomerDB_writeSlot(customerDB, SlotTable_getSlot(&customerDB->slots, recordIndex), record);
     }
     else
-        CustomerDB_appendRecord(customerDB, record);
+        CustomerDB_doAppend(customerDB, record);
+    CustomerDB_endWrite(customerDB);
+}
+
+/** Write the records buffered by the current batch at the end of the database file
+ * @param customerDB the database
+ */
+static void CustomerDB_flushBatch(CustomerDB * customerDB)
+{
+    long offset;
+
+    if (customerDB->batchCount == 0)
+        return;
+
+    offset = (long)sizeof(int) + (long)CUSTOMERRECORD_SIZE * (long)(customerDB->slots.slotCount - customerDB->batchCount);
+    if (fseek(customerDB->file, offset, SEEK_SET) != 0)
+        fatalError("fseek error : unable to reach the end of the database");
+    if (fwrite(customerDB->batchBuffer, CUSTOMERRECORD_SIZE, (size_t)customerDB->batchCount, customerDB->file) < (size_t)customerDB->batchCount)
+        fatalError("fwrite error : return value is not valid.");
+    BlockCache_invalidate(&customerDB->cache, offset, CUSTOMERRECORD_SIZE * (size_t)customerDB->batchCount);
+    customerDB->batchCount = 0;
+    /* the records are read with pread() which does not see the buffer of the FILE */
+    if (fflush(customerDB->file) != 0)
+        fatalError("fflush error : unable to write the database");
+}
+
+/** Start a batch of appends on the database
+ * @param customerDB the database
+ */
+void CustomerDB_beginBatch(CustomerDB * customerDB)
+{
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_allocateBatch(customerDB);
+    DatabaseLock_endWrite(&customerDB->lock);
+}
+
+/** Allocate the buffer of a batch if no batch is started
+ * @param customerDB the database
+ */
+static void CustomerDB_allocateBatch(CustomerDB * customerDB)
+{
+    if (customerDB->batchBuffer != NULL)
+        return;
+
+    customerDB->batchBuffer = malloc(CUSTOMERRECORD_SIZE * CUSTOMERDB_BATCH_SIZE);
+    if (customerDB->batchBuffer == NULL)
+        fatalError("malloc error : Allocation of the batch buffer failed");
+    customerDB->batchCount = 0;
+}
+
+/** Append several records at the end of the database
+ * @param customerDB the database
+ * @param records the array of records to append
+ * @param count the number of records in the array
+ */
+void CustomerDB_appendMany(CustomerDB * customerDB, CustomerRecord * records, int count)
+{
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_doAppendMany(customerDB, records, count);
+    CustomerDB_endWrite(customerDB);
+}
+
+/** Append several records at the end of the database while the database is locked
+ * @param customerDB the database
+ * @param records the array of records to append
+ * @param count the number of records in the array
+ */
+static void CustomerDB_doAppendMany(CustomerDB * customerDB, CustomerRecord * records, int count)
+{
+    int i;
+    int isImplicitBatch = (customerDB->batchBuffer == NULL);
+
+    customerDB->isModified = 1;
+
+    if (isImplicitBatch)
+        CustomerDB_allocateBatch(customerDB);
+
+    for (i = 0; i < count; ++i)
+    {
+        if (customerDB->batchCount == CUSTOMERDB_BATCH_SIZE)
+            CustomerDB_flushBatch(customerDB);
+        CustomerRecord_encode(&records[i], customerDB->batchBuffer + CUSTOMERRECORD_SIZE * (size_t)customerDB->batchCount);
+        customerDB->batchCount += 1;
+        SlotTable_append(&customerDB->slots);
+        customerDB->recordCount = customerDB->slots.count;
+    }
+
+    if (isImplicitBatch)
+        CustomerDB_doCommitBatch(customerDB);
+}
+
+/** Write the pending records of the current batch and update the header of the database file
+ * @param customerDB the database
+ */
+void CustomerDB_commitBatch(CustomerDB * customerDB)
+{
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_doCommitBatch(customerDB);
+    CustomerDB_endWrite(customerDB);
+}
+
+/** Write the pending records of the current batch while the database is locked
+ * @param customerDB the database
+ */
+static void CustomerDB_doCommitBatch(CustomerDB * customerDB)
+{
+    if (customerDB->batchBuffer == NULL)
+        return;
+
+    CustomerDB_flushBatch(customerDB);
+    free(customerDB->batchBuffer);
+    customerDB->batchBuffer = NULL;
+
+    /* the appends of a batch are not logged, they are saved by a checkpoint */
+    CustomerDB_checkpoint(customerDB);
+}
+
+/** Force the logged changes of the database to the disk so that they survive a crash
+ * @param customerDB the database
+ */
+void CustomerDB_sync(CustomerDB * customerDB)
+{
+    DatabaseLock_beginWrite(&customerDB->lock);
+    CustomerDB_commitGroup(customerDB);
+    CustomerDB_endWrite(customerDB);
+}
+
+/** Replace the cache through which the records of the database are read
+ * @param customerDB the database
+ * @param pageSize the size in bytes of a page
+ * @param budget the memory budget in bytes of the cache
+ */
+void CustomerDB_setCache(CustomerDB * customerDB, size_t pageSize, size_t budget)
+{
+    DatabaseLock_beginExclusive(&customerDB->lock);
+    BlockCache_finalize(&customerDB->cache);
+    BlockCache_init(&customerDB->cache, pageSize, budget);
+    DatabaseLock_endWrite(&customerDB->lock);
+}
+
+/** Rewrite a closed database so that its records are stored densely in their logical order
+ * @param filename the file name of the database
+ * @return a non null value on success, 0 otherwise
+ */
+int CustomerDB_compact(const char * filename)
+{
+    CustomerDB * source;
+    CustomerDB * target;
+    CustomerRecord record;
+    char * compactFilename;
+    struct stat status;
+    int i;
+
+    /* nothing is compacted before the database is created */
+    if (stat(filename, &status) != 0 && errno == ENOENT)
+        return 1;
+    /* the lock of the file keeps a process using the database away while it is rewritten */
+    source = CustomerDB_openWithAccess(filename, DATABASE_WRITER);
+    if (source == NULL)
+        return 0;
+    if (source->slots.isIdentity)
+    {
+        CustomerDB_close(source);
+        return 1;
+    }
+
+    compactFilename = concatenateString(filename, ".compact");
+    target = CustomerDB_create(compactFilename);
+    if (target == NULL)
+    {
+        CustomerDB_close(source);
+        free(compactFilename);
+        return 0;
+    }
+
+    CustomerRecord_init(&record);
+    CustomerDB_beginBatch(target);
+    for (i = 0; i < source->recordCount; ++i)
+    {
+        CustomerDB_readRecord(source, i, &record);
+        CustomerDB_appendRecord(target, &record);
+    }
+    CustomerRecord_finalize(&record);
+    CustomerDB_close(target);
+    CustomerDB_close(source);
+
+    if (rename(compactFilename, filename) != 0)
+    {
+        remove(compactFilename);
+        free(compactFilename);
+        return 0;
+    }
+    free(compactFilename);
+
+    /* the records are now stored in their logical order */
+    compactFilename = SlotTable_getFilename(filename);
+    remove(compactFilename);
+    free(compactFilename);
+    return 1;
+}
+
+/** Get the offset in the database file of the slot of a record
+ * @param customerDB the database
+ * @param recordIndex the position of the record
+ * @return the offset
+ */
+static long CustomerDB_getOffset(CustomerDB * customerDB, int recordIndex)
+{
+    return (long)sizeof(int) + (long)CUSTOMERRECORD_SIZE * (long)SlotTable_getSlot(&customerDB->slots, recordIndex);
+}
+
+/** End a modification of the database so that the other threads see the written records
+ * @param customerDB the database
+ */
+static void CustomerDB_endWrite(CustomerDB * customerDB)
+{
+    if (fflush(customerDB->file) != 0)
+        fatalError("fflush error : unable to write the database");
+    DatabaseLock_endWrite(&customerDB->lock);
+}
+
+/** Append a change to the log of the database before it is applied
+ * @param customerDB the database
+ * @param operation the kind of change
+ * @param recordIndex the position of the record
+ * @param record the record inserted or written, NULL for a removal
+ */
+static void CustomerDB_log(CustomerDB * customerDB, WriteAheadLogOperation operation, int recordIndex, CustomerRecord * record)
+{
+    char buffer[CUSTOMERRECORD_SIZE];
+
+    /* the log must start from a saved slot table which includes the appends of the current batch */
+    if (customerDB->batchBuffer != NULL || WriteAheadLog_needsCheckpoint(&customerDB->log))
+        CustomerDB_checkpoint(customerDB);
+
+    if (record != NULL)
+        CustomerRecord_encode(record, buffer);
+    WriteAheadLog_append(&customerDB->log, operation, recordIndex, (record != NULL) ? buffer : NULL);
+}
+
+/** Save the slot table and the header of the database so that its log can be emptied
+ * @param customerDB the database
+ */
+static void CustomerDB_checkpoint(CustomerDB * customerDB)
+{
+    CustomerDB_commitGroup(customerDB);
+    CustomerDB_flushBatch(customerDB);
+
+    /* the records must be on the disk before the slot table and the header refer to them */
+    if (fflush(customerDB->file) != 0 || fsync(fileno(customerDB->file)) != 0)
+        fatalError("fsync error : unable to force the database to the disk");
+    SlotTable_save(&customerDB->slots, customerDB->filename);
+    rewind(customerDB->file);
+    if (fwrite(&customerDB->slots.slotCount, sizeof(int), 1, customerDB->file) < 1)
+        fatalError("fwrite error : return value is < 1");
+    BlockCache_invalidate(&customerDB->cache, 0, sizeof(int));
+    if (fflush(customerDB->file) != 0 || fsync(fileno(customerDB->file)) != 0)
+        fatalError("fsync error : unable to force the database to the disk");
+    WriteAheadLog_reset(&customerDB->log);
+}
+
+/** Write a record or a tombstone in a slot once the log entry of the change is on the disk
+ *
+ * The slot is pending until the group of log entries is forced to the disk, it is
+ * then written in place. It is written at once if the entry just completed a group.
+ * @param customerDB the database
+ * @param slot the slot
+ * @param record the record to write, NULL for a tombstone
+ */
+static void CustomerDB_writeSlot(CustomerDB * customerDB, int slot, CustomerRecord * record)
+{
+    if (customerDB->pendingCount == WRITEAHEADLOG_GROUP_SIZE)
+        CustomerDB_commitGroup(customerDB);
+
+    customerDB->pendingSlots[customerDB->pendingCount] = slot;
+    customerDB->pendingRemovals[customerDB->pendingCount] = (record == NULL);
+    if (record != NULL)
+        CustomerRecord_encode(record, customerDB->pendingRecords + CUSTOMERRECORD_SIZE * (size_t)customerDB->pendingCount);
+    customerDB->pendingCount += 1;
+
+    if (customerDB->log.pendingCount == 0)
+        CustomerDB_applyPending(customerDB);
+}
+
+/** Find the last pending record written in a slot
+ * @param customerDB the database
+ * @param slot the slot
+ * @return the position of the pending record, -1 if the slot is not pending or receives a tombstone
+ */
+static int CustomerDB_findPending(CustomerDB * customerDB, int slot)
+{
+    int i;
+
+    for (i = customerDB->pendingCount - 1; i >= 0; --i)
+        if (customerDB->pendingSlots[i] == slot)
+            return customerDB->pendingRemovals[i] ? -1 : i;
+    return -1;
+}
+
+/** Force the log to the disk and write the pending slots in place
+ * @param customerDB the database
+ */
+static void CustomerDB_commitGroup(CustomerDB * customerDB)
+{
+    WriteAheadLog_sync(&customerDB->log);
+    CustomerDB_applyPending(customerDB);
+}
+
+/** Write the pending slots in place, their log entries being on the disk
+ * @param customerDB the database
+ */
+static void CustomerDB_applyPending(CustomerDB * customerDB)
+{
+    long offset;
+    int i;
+
+    for (i = 0; i < customerDB->pendingCount; ++i)
+    {
+        offset = (long)sizeof(int) + (long)CUSTOMERRECORD_SIZE * (long)customerDB->pendingSlots[i];
+        if (customerDB->pendingRemovals[i])
+            SlotTable_writeTombstone(customerDB->file, offset);
+        else if (fseek(customerDB->file, offset, SEEK_SET) != 0
+                || fwrite(customerDB->pendingRecords + CUSTOMERRECORD_SIZE * (size_t)i, CUSTOMERRECORD_SIZE, 1, customerDB->file) < 1)
+            fatalError("fwrite error : unable to write a record");
+        BlockCache_invalidate(&customerDB->cache, offset, CUSTOMERRECORD_SIZE);
+    }
+    customerDB->pendingCount = 0;
+    /* the records are read with pread() which does not see the buffer of the FILE */
+    if (fflush(customerDB->file) != 0)
+        fatalError("fflush error : unable to write the database");
 }
@@ -22,6 +22,8 @@
 #include <CustomerRecord.h>
 #include <CustomerRecordEditor.h>
 
+#include <sys/stat.h>
+
 static void test_CustomerDB_openAndCreate(void)
 {
   CustomerDB * customerDB;
@@ -186,6 +188,216 @@ static void test_CustomerDB_insertAndRemove(void)
   CustomerRecord_finalize(&record);
 }
 
+static void test_CustomerDB_compact(void)
+{
+  CustomerDB * customerDB;
+  CustomerRecord record;
+  struct stat status;
+  struct stat otherStatus;
+  int i;
+  CustomerRecord_FieldProperties properties;
+
+  properties = CustomerRecord_getFieldProperties(CUSTOMERRECORD_NAME_FIELD);
+
+  CustomerRecord_init(&record);
+
+  customerDB = CustomerDB_create(BASEPATH "/unittest/customerdb-unittest.db");
+  for(i = 0; i < 100; ++i)
+  {
+    char buf[1024];
+    snprintf(buf, 1024, "%d", i);
+    (*properties.setValue)(&record, buf);
+    CustomerDB_appendRecord(customerDB, &record);
+  }
+  for(i = 0; i < 50; ++i)
+    CustomerDB_removeRecord(customerDB, i);
+  ASSERT_EQUAL(customerDB->slots.slotCount, 100);
+  CustomerDB_close(customerDB);
+
+  /* a database used by another process is not rewritten, a missing one has nothing to compact */
+  customerDB = CustomerDB_openWithAccess(BASEPATH "/unittest/customerdb-unittest.db", DATABASE_WRITER);
+  ASSERT_NOT_EQUAL(customerDB, NULL);
+  ASSERT(!CustomerDB_compact(BASEPATH "/unittest/customerdb-unittest.db"));
+  CustomerDB_close(customerDB);
+  remove(BASEPATH "/unittest/customerdb-unittest-doesnotexist.db");
+  ASSERT(CustomerDB_compact(BASEPATH "/unittest/customerdb-unittest-doesnotexist.db"));
+
+  ASSERT(CustomerDB_compact(BASEPATH "/unittest/customerdb-unittest.db"));
+
+  customerDB = CustomerDB_open(BASEPATH "/unittest/customerdb-unittest.db");
+  ASSERT_EQUAL(CustomerDB_getRecordCount(customerDB), 50);
+  ASSERT_EQUAL(customerDB->slots.slotCount, 50);
+  for(i = 0; i < 50; ++i)
+  {
+    char buf[1024];
+    snprintf(buf, 1024, "%d", 2 * i + 1);
+    CustomerDB_readRecord(customerDB, i, &record);
+    ASSERT_EQUAL_STRING(record.name, buf);
+  }
+  ASSERT(!customerDB->isModified);
+  ASSERT_EQUAL(stat(BASEPATH "/unittest/customerdb-unittest.db", &status), 0);
+  CustomerDB_close(customerDB);
+
+  /* closing a database which did not change does not write it */
+  ASSERT_EQUAL(stat(BASEPATH "/unittest/customerdb-unittest.db", &otherStatus), 0);
+  ASSERT_EQUAL(otherStatus.st_mtime, status.st_mtime);
+  ASSERT_EQUAL(getModificationNanoseconds(&otherStatus), getModificationNanoseconds(&status));
+
+  CustomerRecord_finalize(&record);
+}
+
+/** Copy the beginning of a file as it is on the disk
+ * @param source the file to copy
+ * @param destination the copy
+ * @param size the number of bytes to copy
+ */
+static void copyFile(const char * source, const char * destination, long size)
+{
+  FILE * input = fopen(source, "rb");
+  FILE * output = fopen(destination, "wb");
+  int c;
+
+  ASSERT_NOT_EQUAL(input, NULL);
+  ASSERT_NOT_EQUAL(output, NULL);
+  while (size > 0 && (c = fgetc(input)) != EOF)
+  {
+    fputc(c, output);
+    --size;
+  }
+  fclose(output);
+  fclose(input);
+}
+
+static void test_CustomerDB_log(void)
+{
+  CustomerDB * customerDB;
+  CustomerDB * recoveredDB;
+  CustomerRecord record;
+  FILE * file;
+  long logSize;
+  int i;
+  CustomerRecord_FieldProperties properties;
+
+  properties = CustomerRecord_getFieldProperties(CUSTOMERRECORD_NAME_FIELD);
+
+  CustomerRecord_init(&record);
+
+  customerDB = CustomerDB_create(BASEPATH "/unittest/customerdb-unittest.db");
+  for(i = 0; i < 10; ++i)
+  {
+    char buf[1024];
+    snprintf(buf, 1024, "%d", i);
+    (*properties.setValue)(&record, buf);
+    CustomerDB_appendRecord(customerDB, &record);
+  }
+  CustomerDB_sync(customerDB);
+
+  /* the last entry of the log was not completely written when the process crashed */
+  file = fopen(BASEPATH "/unittest/customerdb-unittest.db" WRITEAHEADLOG_EXTENSION, "rb");
+  ASSERT_NOT_EQUAL(file, NULL);
+  fseek(file, 0, SEEK_END);
+  logSize = ftell(file);
+  fclose(file);
+  copyFile(BASEPATH "/unittest/customerdb-unittest.db", BASEPATH "/unittest/customerdb-unittest-crash.db", sizeof(int));
+  copyFile(BASEPATH "/unittest/customerdb-unittest.db" WRITEAHEADLOG_EXTENSION, BASEPATH "/unittest/customerdb-unittest-crash.db" WRITEAHEADLOG_EXTENSION, logSize - 10);
+  CustomerDB_close(customerDB);
+
+  recoveredDB = CustomerDB_open(BASEPATH "/unittest/customerdb-unittest-crash.db");
+  ASSERT_NOT_EQUAL(recoveredDB, NULL);
+  ASSERT_EQUAL(CustomerDB_getRecordCount(recoveredDB), 9);
+  for(i = 0; i < 9; ++i)
+  {
+    char buf[1024];
+    snprintf(buf, 1024, "%d", i);
+    CustomerDB_readRecord(recoveredDB, i, &record);
+    ASSERT_EQUAL_STRING(record.name, buf);
+  }
+  CustomerDB_close(recoveredDB);
+
+  CustomerRecord_finalize(&record);
+}
+
+/** Tell if a file contains a text */
+static int fileContains(const char * filename, const char * text)
+{
+  char buffer[4096];
+  FILE * file = fopen(filename, "rb");
+  size_t length = stringLength(text);
+  size_t size;
+  size_t matched = 0;
+  size_t i;
+
+  ASSERT_NOT_EQUAL(file, NULL);
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    for (i = 0; i < size && matched < length; ++i)
+    {
+      if (buffer[i] == text[matched])
+        matched += 1;
+      else
+        matched = (buffer[i] == text[0]) ? 1 : 0;
+    }
+  fclose(file);
+  return matched == length;
+}
+
+static void test_CustomerDB_pending(void)
+{
+  CustomerDB * customerDB;
+  CustomerDB * recoveredDB;
+  CustomerRecord record;
+  int i;
+  CustomerRecord_FieldProperties properties;
+
+  properties = CustomerRecord_getFieldProperties(CUSTOMERRECORD_NAME_FIELD);
+
+  CustomerRecord_init(&record);
+
+  customerDB = CustomerDB_create(BASEPATH "/unittest/customerdb-unittest.db");
+  for(i = 0; i < 10; ++i)
+  {
+    char buf[1024];
+    snprintf(buf, 1024, "%d", i);
+    (*properties.setValue)(&record, buf);
+    CustomerDB_appendRecord(customerDB, &record);
+  }
+  CustomerDB_close(customerDB);
+
+  customerDB = CustomerDB_open(BASEPATH "/unittest/customerdb-unittest.db");
+  (*properties.setValue)(&record, "Changed");
+  CustomerDB_writeRecord(customerDB, 3, &record);
+  CustomerDB_removeRecord(customerDB, 5);
+  (*properties.setValue)(&record, "Appended");
+  CustomerDB_appendRecord(customerDB, &record);
+
+  /* the records are written in place only once their log entries are on the disk */
+  ASSERT(!fileContains(BASEPATH "/unittest/customerdb-unittest.db", "Changed"));
+  ASSERT(!fileContains(BASEPATH "/unittest/customerdb-unittest.db", "Appended"));
+  CustomerDB_readRecord(customerDB, 3, &record);
+  ASSERT_EQUAL_STRING(record.name, "Changed");
+
+  /* a crash at this point is recovered by replaying the log */
+  remove(BASEPATH "/unittest/customerdb-unittest-crash.db" SLOTTABLE_EXTENSION);
+  copyFile(BASEPATH "/unittest/customerdb-unittest.db", BASEPATH "/unittest/customerdb-unittest-crash.db", 1L << 30);
+  copyFile(BASEPATH "/unittest/customerdb-unittest.db" WRITEAHEADLOG_EXTENSION, BASEPATH "/unittest/customerdb-unittest-crash.db" WRITEAHEADLOG_EXTENSION, 1L << 30);
+  recoveredDB = CustomerDB_open(BASEPATH "/unittest/customerdb-unittest-crash.db");
+  ASSERT_NOT_EQUAL(recoveredDB, NULL);
+  ASSERT_EQUAL(CustomerDB_getRecordCount(recoveredDB), 10);
+  CustomerDB_readRecord(recoveredDB, 3, &record);
+  ASSERT_EQUAL_STRING(record.name, "Changed");
+  CustomerDB_readRecord(recoveredDB, 5, &record);
+  ASSERT_EQUAL_STRING(record.name, "6");
+  CustomerDB_readRecord(recoveredDB, 9, &record);
+  ASSERT_EQUAL_STRING(record.name, "Appended");
+  CustomerDB_close(recoveredDB);
+
+  CustomerDB_sync(customerDB);
+  ASSERT(fileContains(BASEPATH "/unittest/customerdb-unittest.db", "Changed"));
+  ASSERT(fileContains(BASEPATH "/unittest/customerdb-unittest.db", "Appended"));
+  CustomerDB_close(customerDB);
+
+  CustomerRecord_finalize(&record);
+}
+
 void test_CustomerDB(void)
 {
   BEGIN_TESTS(CustomerDB)
@@ -194,6 +406,9 @@ void test_CustomerDB(void)
     RUN_TEST(test_CustomerDB_readAndWrite);
     RUN_TEST(test_CustomerDB_append);
     RUN_TEST(test_CustomerDB_insertAndRemove);
+    RUN_TEST(test_CustomerDB_compact);
+    RUN_TEST(test_CustomerDB_log);
+    RUN_TEST(test_CustomerDB_pending);
   }
   END_TESTS
 }
@@ -135,6 +135,36 @@ void IMPLEMENT(CustomerRecord_write)(CustomerRecord * record, FILE * file)
     testError(fwrite(record->town, CUSTOMERRECORD_TOWN_SIZE, 1, file), record->town, record, file);
 }
 
+/** Encode a record in memory using the same packed layout as CustomerRecord_write()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CUSTOMERRECORD_SIZE bytes receiving the data
+ */
+void CustomerRecord_encode(CustomerRecord * record, char * buffer)
+{
+    memcpy(buffer, record->name, CUSTOMERRECORD_NAME_SIZE);
+    buffer += CUSTOMERRECORD_NAME_SIZE;
+    memcpy(buffer, record->address, CUSTOMERRECORD_ADDRESS_SIZE);
+    buffer += CUSTOMERRECORD_ADDRESS_SIZE;
+    memcpy(buffer, record->postalCode, CUSTOMERRECORD_POSTALCODE_SIZE);
+    buffer += CUSTOMERRECORD_POSTALCODE_SIZE;
+    memcpy(buffer, record->town, CUSTOMERRECORD_TOWN_SIZE);
+}
+
+/** Decode a record from memory using the same packed layout as CustomerRecord_read()
+ * @param record a pointer to a record
+ * @param buffer the buffer of at least CUSTOMERRECORD_SIZE bytes containing the data
+ */
+void CustomerRecord_decode(CustomerRecord * record, const char * buffer)
+{
+    memcpy(record->name, buffer, CUSTOMERRECORD_NAME_SIZE);
+    buffer += CUSTOMERRECORD_NAME_SIZE;
+    memcpy(record->address, buffer, CUSTOMERRECORD_ADDRESS_SIZE);
+    buffer += CUSTOMERRECORD_ADDRESS_SIZE;
+    memcpy(record->postalCode, buffer, CUSTOMERRECORD_POSTALCODE_SIZE);
+    buffer += CUSTOMERRECORD_POSTALCODE_SIZE;
+    memcpy(record->town, buffer, CUSTOMERRECORD_TOWN_SIZE);
+}
+
 /** Static function to test if fwrite and fread works correctly
  * @param nbrOpSuccess the return value of function
  * @param pointRecord a pointer to the record filed
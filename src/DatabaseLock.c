@@ -0,0 +1,132 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <DatabaseLock.h>
+
+#include <sys/file.h>
+
+/** Initialize the locks of a database
+ * @param lock the locks
+ * @param access the access mode
+ */
+void DatabaseLock_init(DatabaseLock * lock, DatabaseAccess access)
+{
+    if (pthread_rwlock_init(&lock->lock, NULL) != 0)
+        fatalError("pthread_rwlock_init error : unable to create the lock of the database");
+    lock->access = access;
+    lock->fd = -1;
+    lock->isExclusive = 0;
+}
+
+/** Release the lock of the file and free the resources used by the locks of a database
+ * @param lock the locks
+ */
+void DatabaseLock_finalize(DatabaseLock * lock)
+{
+    if (lock->fd != -1)
+        flock(lock->fd, LOCK_UN);
+    lock->fd = -1;
+    lock->isExclusive = 0;
+    pthread_rwlock_destroy(&lock->lock);
+}
+
+/** Lock a database file according to the access mode without waiting
+ * @param lock the locks
+ * @param file the database file
+ * @return a non null value on success, 0 if another process holds an incompatible lock
+ */
+int DatabaseLock_lockFile(DatabaseLock * lock, FILE * file)
+{
+    int fd = fileno(file);
+
+    if (lock->access == DATABASE_PRIVATE)
+        return 1;
+
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0)
+        lock->isExclusive = 1;
+    else if (lock->access == DATABASE_WRITER || flock(fd, LOCK_SH | LOCK_NB) != 0)
+        return 0;
+    lock->fd = fd;
+    return 1;
+}
+
+/** Tell if the file can be changed, either by the functions of the database or to repair it
+ * @param lock the locks
+ * @return a non null value if the file can be changed
+ */
+int DatabaseLock_canWriteFile(DatabaseLock * lock)
+{
+    return lock->access != DATABASE_READER || lock->isExclusive;
+}
+
+/** Downgrade the exclusive lock taken by a reader to a shared lock
+ * @param lock the locks
+ * @return a non null value on success, 0 if the shared lock could not be taken
+ */
+int DatabaseLock_shareFile(DatabaseLock * lock)
+{
+    if (lock->access != DATABASE_READER || !lock->isExclusive)
+        return 1;
+    lock->isExclusive = 0;
+    return flock(lock->fd, LOCK_SH | LOCK_NB) == 0;
+}
+
+/** Wait until no thread modifies the database and prevent any modification
+ * @param lock the locks
+ */
+void DatabaseLock_beginRead(DatabaseLock * lock)
+{
+    if (pthread_rwlock_rdlock(&lock->lock) != 0)
+        fatalError("pthread_rwlock_rdlock error : unable to lock the database");
+}
+
+/** End a reading started by DatabaseLock_beginRead()
+ * @param lock the locks
+ */
+void DatabaseLock_endRead(DatabaseLock * lock)
+{
+    pthread_rwlock_unlock(&lock->lock);
+}
+
+/** Wait until no other thread uses the database and prevent any other access
+ * @param lock the locks
+ */
+void DatabaseLock_beginWrite(DatabaseLock * lock)
+{
+    if (lock->access == DATABASE_READER)
+        fatalError("Error : the database is opened as a reader and can not be changed");
+    DatabaseLock_beginExclusive(lock);
+}
+
+/** Wait until no other thread uses the database and prevent any other access, even for a reader
+ * @param lock the locks
+ */
+void DatabaseLock_beginExclusive(DatabaseLock * lock)
+{
+    if (pthread_rwlock_wrlock(&lock->lock) != 0)
+        fatalError("pthread_rwlock_wrlock error : unable to lock the database");
+}
+
+/** End a modification started by DatabaseLock_beginWrite() or DatabaseLock_beginExclusive()
+ * @param lock the locks
+ */
+void DatabaseLock_endWrite(DatabaseLock * lock)
+{
+    pthread_rwlock_unlock(&lock->lock);
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#include <DecimalFormat.h>
+
+/** The limit below which a positive integer is exactly represented as a double, 2^52 */
+#define DECIMALFORMAT_EXACT_LIMIT 4503599627370496.0
+
+/** The powers of ten exactly represented as a double */
+static const double powersOfTen[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16
+};
+
+static size_t DecimalFormat_writeFixed(char * digits, double value, int precision);
+static size_t DecimalFormat_writeShortest(char * digits, double value);
+static size_t DecimalFormat_writeInteger(char * digits, double integer, int precision, int isNegative);
+static int DecimalFormat_isSame(double value1, double value2);
+
+/** Write a number in decimal notation
+ * @param buffer the buffer receiving the null terminated text, may be NULL if bufferSize is 0
+ * @param bufferSize the size of the buffer
+ * @param value the number
+ * @param precision the number of decimals, or DECIMALFORMAT_SHORTEST
+ * @param width the minimal length of the text, padded with spaces on the left
+ * @return the length of the whole text
+ */
+size_t DecimalFormat_write(char * buffer, size_t bufferSize, double value, int precision, int width)
+{
+    char digits[DECIMALFORMAT_BUFFER_SIZE];
+    size_t size;
+    size_t padding = 0;
+    size_t i;
+
+    if (precision < 0)
+        size = DecimalFormat_writeShortest(digits, value);
+    else
+        size = DecimalFormat_writeFixed(digits, value, MINVALUE(precision, DECIMALFORMAT_MAX_PRECISION));
+    if (width > 0 && (size_t)width > size)
+        padding = (size_t)width - size;
+
+    if (bufferSize == 0)
+        return padding + size;
+    for (i = 0; i < padding && i + 1 < bufferSize; ++i)
+        buffer[i] = ' ';
+    if (padding + 1 < bufferSize)
+        memcpy(buffer + padding, digits, MINVALUE(size, bufferSize - 1 - padding));
+    buffer[MINVALUE(padding + size, bufferSize - 1)] = '\0';
+    return padding + size;
+}
+
+/** Write a number with a fixed number of decimals
+ * @param digits the buffer of DECIMALFORMAT_BUFFER_SIZE characters receiving the null terminated text
+ * @param value the number
+ * @param precision the number of decimals, at most DECIMALFORMAT_MAX_PRECISION
+ * @return the length of the text
+ */
+static size_t DecimalFormat_writeFixed(char * digits, double value, int precision)
+{
+    /* NaN fails every comparison and is left to sprintf() */
+    if (precision <= DECIMALFORMAT_FAST_PRECISION && value > -DECIMALFORMAT_EXACT_LIMIT && value < DECIMALFORMAT_EXACT_LIMIT)
+    {
+        double scaled = fabs(value) * powersOfTen[precision];
+
+        if (scaled < DECIMALFORMAT_EXACT_LIMIT)
+        {
+            double integer = floor(scaled);
+            double fraction = scaled - integer;
+
+            /* the product is rounded, so a fraction of exactly one half may come from a value
+             * slightly above or below it: only sprintf() knows how to round it */
+            if (fraction > 0.5)
+                return DecimalFormat_writeInteger(digits, integer + 1, precision, value < 0);
+            if (fraction < 0.5)
+                return DecimalFormat_writeInteger(digits, integer, precision, value < 0);
+        }
+    }
+    return (size_t)sprintf(digits, "%.*f", precision, value);
+}
+
+/** Write the shortest decimal number which is read back as the same double
+ * @param digits the buffer of DECIMALFORMAT_BUFFER_SIZE characters receiving the null terminated text
+ * @param value the number
+ * @return the length of the text
+ */
+static size_t DecimalFormat_writeShortest(char * digits, double value)
+{
+    double magnitude = fabs(value);
+    int precision;
+
+    for (precision = 0; precision <= DECIMALFORMAT_FAST_PRECISION; ++precision)
+    {
+        double scaled = magnitude * powersOfTen[precision];
+        double integer;
+
+        if (!(scaled < DECIMALFORMAT_EXACT_LIMIT))
+            break;
+        /* an integer and a power of ten exactly represented give a correctly rounded quotient,
+         * which is the double read from their decimal text */
+        integer = floor(scaled + 0.5);
+        if (DecimalFormat_isSame(integer / powersOfTen[precision], magnitude))
+            return DecimalFormat_writeInteger(digits, integer, precision, value < 0);
+    }
+    /* 17 significant digits always read back as the same double but fewer often do */
+    for (precision = 15; precision < 17; ++precision)
+    {
+        size_t length = (size_t)sprintf(digits, "%.*g", precision, value);
+
+        if (DecimalFormat_isSame(strtod(digits, NULL), value))
+            return length;
+    }
+    return (size_t)sprintf(digits, "%.17g", value);
+}
+
+/** Write an integer exactly represented as a double with a decimal point before its last digits
+ * @param digits the buffer receiving the null terminated text
+ * @param integer the positive integer, below DECIMALFORMAT_EXACT_LIMIT
+ * @param precision the number of digits after the decimal point
+ * @param isNegative a non null value to write a minus sign
+ * @return the length of the text
+ */
+static size_t DecimalFormat_writeInteger(char * digits, double integer, int precision, int isNegative)
+{
+    char reversed[32];
+    size_t count = 0;
+    size_t length = 0;
+
+    /* the digits are produced from the last one, with at least one digit before the point */
+    do
+    {
+        double quotient = floor(integer / 10);
+        reversed[count++] = (char)('0' + (int)(integer - quotient * 10));
+        integer = quotient;
+    }
+    while (integer >= 1 || count <= (size_t)precision);
+
+    if (isNegative)
+        digits[length++] = '-';
+    while (count > 0)
+    {
+        if (count == (size_t)precision)
+            digits[length++] = '.';
+        digits[length++] = reversed[--count];
+    }
+    digits[length] = '\0';
+    return length;
+}
+
+/** Tell if two doubles are equal without triggering the warning about the comparison of floating point numbers
+ * @param value1 the first number
+ * @param value2 the second number
+ * @return a non null value if the numbers are equal
+ */
+static int DecimalFormat_isSame(double value1, double value2)
+{
+    return !(value1 < value2) && !(value1 > value2);
+}
@@ -18,17 +18,29 @@
  */
 
 #include <Dictionary.h>
+#include <Template.h>
 
-static char * findCharInString(char * str, char c);
-static char * formatString(char * copyValueStringEntry, char * buffer, char * charaEqual);
-static char * formatNumber(char * copyValueEntryNumber, char * buffer, char * charaEqual);
-static char * valueAfterEqual(char * buffer, char * charaEqual);
-static char * parameterNotFound(Dictionary * dictionary, char * copyFormat);
-static char * ifModeleIsComplete(Dictionary * dictionary, char * copyFormat, char * stringFormated, char * stringFormatedFinal, char * charaAccolade);
-static char * formatSecondParameterNumber(char * charaEqual, char * copyFormat, char * buffer, char * stringFormated, char * stringFormatedFinal);
-static char * formatSecondParameterString(char * charaEqual, char * copyFormat, char * buffer, char * stringFormated, char * stringFormatedFinal);
-static void setCursorEndOfModele(char * copyFormat);
+#include <pthread.h>
 
+static int Dictionary_findEntry(Dictionary * dictionary, const char * name, unsigned int hash);
+static int Dictionary_defineEntry(Dictionary * dictionary, const char * name);
+static void Dictionary_grow(Dictionary * dictionary);
+
+
+/** The number of entries allocated by an empty dictionary at its first definition */
+#define DICTIONARY_INITIAL_CAPACITY 16
+
+/** The pool of the interned names of entries */
+typedef struct
+{
+  const char ** names; /**< The hash table of the names, NULL for an empty slot */
+  int slotMask; /**< The number of slots minus one, the number of slots being a power of 2 */
+  int count; /**< The number of names */
+  pthread_mutex_t mutex; /**< The lock protecting the pool from concurrent threads */
+} DictionaryNamePool;
+
+/** The names of all the entries of the process */
+static DictionaryNamePool namePool = { NULL, -1, 0, PTHREAD_MUTEX_INITIALIZER };
 
 /** Create an empty dictionary on the heap
  * @return a new dictionary
@@ -43,6 +55,11 @@ Dictionary * IMPLEMENT(Dictionary_create)(void)
 
     dictionary->count = 0;
     dictionary->entries = NULL;
+    dictionary->capacity = 0;
+    dictionary->hashes = NULL;
+    dictionary->valueSizes = NULL;
+    dictionary->slots = NULL;
+    dictionary->slotMask = -1;
 
     return dictionary;
 }
@@ -54,15 +71,17 @@ void IMPLEMENT(Dictionary_destroy)(Dictionary * dictionary)
 {
     int i = 0;
 
+    /* the names are interned and shared with the other dictionaries */
     while (dictionary->count > i)
     {
         if (dictionary->entries[i].type == STRING_ENTRY)
             free(dictionary->entries[i].value.stringValue);
-
-        free(dictionary->entries[i].name);
         i++;
     }
     free(dictionary->entries);
+    free(dictionary->hashes);
+    free(dictionary->valueSizes);
+    free(dictionary->slots);
     free(dictionary);
 }
 
@@ -73,18 +92,11 @@ void IMPLEMENT(Dictionary_destroy)(Dictionary * dictionary)
  */
 DictionaryEntry * IMPLEMENT(Dictionary_getEntry)(Dictionary * dictionary, const char * name)
 {
-    int i = 0;
+    int entryIndex = Dictionary_findEntry(dictionary, name, Dictionary_hashName(name));
 
-    if (dictionary->entries == NULL)
+    if (entryIndex == -1)
         return NULL;
-
-    while (dictionary->count > i)
-    {
-        if (icaseCompareString(dictionary->entries[i].name, name) == 0)
-            return &(dictionary->entries[i]);
-        i++;
-    }
-    return NULL;
+    return &(dictionary->entries[entryIndex]);
 }
 
 /** Define or change a dictionary entry as a string
@@ -94,40 +106,22 @@ DictionaryEntry * IMPLEMENT(Dictionary_getEntry)(Dictionary * dictionary, const
  */
 void IMPLEMENT(Dictionary_setStringEntry)(Dictionary * dictionary, const char * name, const char * value)
 {
-    DictionaryEntry * entryTemp = Dictionary_getEntry(dictionary, name);
+    int entryIndex = Dictionary_defineEntry(dictionary, name);
+    DictionaryEntry * entryTemp = dictionary->entries + entryIndex;
+    size_t size = stringLength(value) + 1;
 
-    if (entryTemp == NULL)
-    {
-        dictionary->count += 1;
-
-        if (dictionary->entries == NULL)
-        {
-            dictionary->entries = (DictionaryEntry*) malloc(sizeof(DictionaryEntry));
-
-            if (dictionary->entries == NULL)
-                fatalError("error malloc : Attribution of dictionary->entries on the heap failed");
-        }
-        else
-        {
-            dictionary->entries = realloc(dictionary->entries, sizeof(DictionaryEntry) * (size_t)dictionary->count);
-
-            if (dictionary->entries == NULL)
-                fatalError("error realloc : Attribution of dictionary->entries on the heap failed");
-        }
-
-        entryTemp = dictionary->entries + (dictionary->count - 1);
-        entryTemp->name = duplicateString(name);
-        entryTemp->value.stringValue = duplicateString(value);
-        entryTemp->type = STRING_ENTRY;
-    }
-    else
+    /* the previous string is reused when it is large enough */
+    if (entryTemp->type != STRING_ENTRY || dictionary->valueSizes[entryIndex] < size)
     {
         if (entryTemp->type == STRING_ENTRY)
             free(entryTemp->value.stringValue);
-
-        entryTemp->value.stringValue = duplicateString(value);
-        entryTemp->type = STRING_ENTRY;
+        entryTemp->value.stringValue = (char*) malloc(size);
+        if (entryTemp->value.stringValue == NULL)
+            fatalError("error malloc : Attribution of the value of the entry on the heap failed");
+        dictionary->valueSizes[entryIndex] = size;
     }
+    memcpy(entryTemp->value.stringValue, value, size);
+    entryTemp->type = STRING_ENTRY;
 }
 
 /** Define or change a dictionary entry as a number
@@ -137,397 +131,211 @@ void IMPLEMENT(Dictionary_setStringEntry)(Dictionary * dictionary, const char *
  */
 void IMPLEMENT(Dictionary_setNumberEntry)(Dictionary * dictionary, const char * name, double value)
 {
-    DictionaryEntry * entryTemp = Dictionary_getEntry(dictionary, name);
-
-    if (entryTemp == NULL)
-    {
-        dictionary->count += 1;
-
-        if (dictionary->entries == NULL)
-        {
-            dictionary->entries = (DictionaryEntry*) malloc(sizeof(DictionaryEntry));
-
-            if (dictionary->entries == NULL)
-                fatalError("error malloc : Attribution of dictionary->entries on the heap failed");
-        }
-        else
-        {
-            dictionary->entries = realloc(dictionary->entries, sizeof(DictionaryEntry) * (size_t)dictionary->count);
-
-            if (dictionary->entries == NULL)
-                fatalError("error realloc : Attribution of dictionary->entries on the heap failed");
-        }
-
-        entryTemp = dictionary->entries + (dictionary->count - 1);
-        entryTemp->name = duplicateString(name);
-        entryTemp->value.numberValue = value;
-        entryTemp->type = NUMBER_ENTRY;
-    }
-    else
-    {
-        if (entryTemp->type == STRING_ENTRY)
-            free(entryTemp->value.stringValue);
-
-        entryTemp->value.numberValue = value;
-        entryTemp->type = NUMBER_ENTRY;
-    }
+    int entryIndex = Dictionary_defineEntry(dictionary, name);
+    DictionaryEntry * entryTemp = dictionary->entries + entryIndex;
+
+    if (entryTemp->type == STRING_ENTRY)
+        free(entryTemp->value.stringValue);
+    dictionary->valueSizes[entryIndex] = 0;
+    entryTemp->value.numberValue = value;
+    entryTemp->type = NUMBER_ENTRY;
 }
 
-/** Create a new string on the heap which is the result of the formatting of format according to the dictionary content
+/** Get a pointer on the entry associated with the given entry name whose hash is known
  * @param dictionary the dictionary
- * @param format the string to format
- * @return a new string created on the heap
- * @warning the user is responsible for freeing the returned string
+ * @param name the name of the entry, preferably interned
+ * @param hash the hash of the name given by Dictionary_hashName()
+ * @return a pointer on the entry or NULL if the entry was not found
  */
-char * IMPLEMENT(Dictionary_format)(Dictionary * dictionary, const char * format)
+DictionaryEntry * Dictionary_getEntryWithHash(Dictionary * dictionary, const char * name, unsigned int hash)
 {
-    char * copyFormatSmall = NULL, * charaAccolade = NULL, * stringFormatedFinal = duplicateString(""), * copyOfParameterNotFound = NULL;
-    char stringFormated[2048] = "";
-    size_t movePourcentage = 0, beforePourcentage = 0;
-
-    memset(stringFormated, '\0', sizeof(char) * 2048);
+    int entryIndex = Dictionary_findEntry(dictionary, name, hash);
 
-    while (movePourcentage <= stringLength(format))
-    {
-        while (format[movePourcentage] != '%' && stringLength(format) != movePourcentage)
-            movePourcentage++;
-
-        copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-        free(stringFormatedFinal);
-
-        if (stringLength(stringFormated) != 0)
-            stringFormatedFinal = insertString(stringFormated, (int)(movePourcentage - beforePourcentage), format + beforePourcentage, 1);
-
-        beforePourcentage = movePourcentage;
-
-        while (format[movePourcentage+1] != '%')
-            movePourcentage++;
-
-        copyFormatSmall = insertString("", 0 , format + beforePourcentage + 1, (int)(movePourcentage - beforePourcentage));
-
-        charaAccolade = findCharInString(copyFormatSmall, '{');
-
-        if (charaAccolade == NULL)
-        {
-            copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-            free(stringFormatedFinal);
-            copyOfParameterNotFound = parameterNotFound(dictionary, copyFormatSmall);
-            stringFormatedFinal = concatenateString(stringFormated, copyOfParameterNotFound);
-            setCursorEndOfModele(copyFormatSmall);
-        }
-        else if(copyFormatSmall[0] == '%')
-        {
-            copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-            free(stringFormatedFinal);
-            stringFormatedFinal = concatenateString(stringFormated, "%");
-            setCursorEndOfModele(copyFormatSmall);
-        }
-        else
-        {
-            stringFormatedFinal = ifModeleIsComplete(dictionary, copyFormatSmall, stringFormated, stringFormatedFinal, charaAccolade);
-        }
-
-        if (copyFormatSmall == NULL)
-            printf("\n\n -- TRADUCTION OF MODEl FAILED -- \n\n");
-
-        if (copyFormatSmall[1] != '\0')
-        {
-            copyStringWithLength(copyFormatSmall, copyFormatSmall + 3, stringLength(copyFormatSmall) -2);
-            copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-            free(stringFormatedFinal);
-            stringFormatedFinal = insertString(stringFormated, (int)stringLength(stringFormated), " ", 1);
-        }
-    }
-    free(copyFormatSmall);
-    free(copyOfParameterNotFound);
-    return stringFormatedFinal;
-    }
+    if (entryIndex == -1)
+        return NULL;
+    return &(dictionary->entries[entryIndex]);
+}
 
-/**Function is called when model is complete to format a string or number
+/** Remove all the entries of a dictionary but keep its memory for the next entries
  * @param dictionary the dictionary
- * @param copyFormat a copy of format
- * @param stringFormated a temporary string
- * @param stringFormatedFinal the future string returned
- * @param charaAccolade a string contain accolade charactere
- * @return a pointer to the string formated
-*/
-
-char * ifModeleIsComplete(Dictionary * dictionary, char * copyFormat, char * stringFormated, char * stringFormatedFinal, char * charaAccolade)
+ */
+void Dictionary_clear(Dictionary * dictionary)
 {
-    DictionaryEntry * entry;
-    char buffer[1024] = "", bufferForNumberEntry[1024] = "";
-    char * charaEqual = NULL;
-    char * copyOfFormat = NULL;
-
-    memset(buffer, '\0', sizeof(char) * 1024);
-    memset(bufferForNumberEntry, '\0', sizeof(char) * 1024);
-    copyStringWithLength(buffer, copyFormat, stringLength(copyFormat) - stringLength(charaAccolade) + 1);
-    entry = Dictionary_getEntry(dictionary, buffer);
-
-    FILE * test = fopen("/tmp/facturation/data/null", "a");
-    int i = 0;
-    while (i != dictionary->count)
-    {
-        fputs(dictionary->entries[i].name, test);
-        fputs("\n", test);
-        i++;
-    }
+    int i;
 
-    fputs(buffer, test);
-    fclose(test);
-
-    if (entry == NULL)
-    {
-        fatalError("Entry not found !");
-    }
-
-    charaEqual = findCharInString(copyFormat, '=');
-    copyStringWithLength(buffer, charaAccolade+1, stringLength(charaAccolade) - stringLength(charaEqual));
-
-    if (entry->type == STRING_ENTRY)
-    {
-        copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-        free(stringFormatedFinal);
-        copyOfFormat = formatString(duplicateString(entry->value.stringValue), buffer, charaEqual);
-        stringFormatedFinal = concatenateString(stringFormated, copyOfFormat);
-        setCursorEndOfModele(copyFormat);
-
-        if (copyFormat[0] == ',')
-            stringFormatedFinal = formatSecondParameterString(charaEqual, copyFormat, buffer, stringFormated, stringFormatedFinal);
-    }
-    else if (entry->type == NUMBER_ENTRY)
-    {
-        sprintf (bufferForNumberEntry, "%f", entry->value.numberValue);
-        copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-        free(stringFormatedFinal);
-        copyOfFormat = formatNumber(duplicateString(bufferForNumberEntry), buffer, charaEqual);
-        stringFormatedFinal = concatenateString(stringFormated, copyOfFormat);
-        setCursorEndOfModele(copyFormat);
-
-        if (copyFormat[0] == ',')
-            stringFormatedFinal = formatSecondParameterNumber(charaEqual, copyFormat, buffer, stringFormated, stringFormatedFinal);
-    }
-    else
-        return NULL;
-
-    free(copyOfFormat);
-    return stringFormatedFinal;
+    for (i = 0; i < dictionary->count; ++i)
+        if (dictionary->entries[i].type == STRING_ENTRY)
+            free(dictionary->entries[i].value.stringValue);
+    for (i = 0; i <= dictionary->slotMask; ++i)
+        dictionary->slots[i] = -1;
+    dictionary->count = 0;
 }
 
-/**Function format the string
- * @param copyValueStringEntry a copy of string value entry
- * @param buffer a buffer
- * @param charaEqual a string contain equal charactere
- * @return a pointer to the string formated
-*/
-
-char * formatString(char * copyValueStringEntry, char * buffer, char * charaEqual)
+/** Compute the hash of the name of an entry without case
+ * @param name the name
+ * @return the hash
+ */
+unsigned int Dictionary_hashName(const char * name)
 {
-    char * charTemp = (char*)malloc(sizeof(char) * stringLength(copyValueStringEntry) + 1);
-
-    if (charTemp == NULL)
-                fatalError("error malloc : Attribution of charTemp on the heap failed");
-
-    copyStringWithLength(charTemp, copyValueStringEntry, stringLength(copyValueStringEntry) + 1);
+    unsigned int hash = 2166136261U;
 
-    if (icaseCompareString(buffer, "case") == 0)
-    {
-        if (charaEqual[1] >= 'A' && charaEqual[1] <= 'Z')
-            makeUpperCaseString(copyValueStringEntry);
-        else if (charaEqual[1] >= 'a' && charaEqual[1] <= 'z')
-            makeLowerCaseString(copyValueStringEntry);
-    }
-    else if (icaseCompareString(buffer, "min") == 0)
-    {
-        while (atoi(valueAfterEqual(buffer, charaEqual)) > (int)stringLength(copyValueStringEntry))
-        {
-            free(copyValueStringEntry);
-            copyValueStringEntry = insertString(charTemp, (int)stringLength(charTemp), " ", 1);
-            charTemp = realloc(charTemp, stringLength(copyValueStringEntry) + 2);
-            copyStringWithLength(charTemp, copyValueStringEntry, stringLength(copyValueStringEntry) +1);
-        }
-    }
-    else if (icaseCompareString(buffer, "max") == 0)
+    while (*name != '\0')
     {
-        copyStringWithLength(copyValueStringEntry, copyValueStringEntry, (size_t)atoi(valueAfterEqual(buffer, charaEqual))+1);
+        char c = *name;
+        if (c >= 'A' && c <= 'Z')
+            c = (char)(c - 'A' + 'a');
+        hash ^= (unsigned int)(unsigned char)c;
+        hash *= 16777619U;
+        ++name;
     }
-
-    free(charTemp);
-    return copyValueStringEntry;
+    return hash;
 }
 
-/**Function format the number
- * @param result a copy of number value entry
- * @param buffer a buffer
- * @param charaEqual a string contain equal charactere
- * @return a pointer to the string formated
-*/
-
-char * formatNumber(char * result, char * buffer, char * charaEqual)
+/** Find the index of an entry
+ * @param dictionary the dictionary
+ * @param name the name of the entry
+ * @param hash the hash of the name given by Dictionary_hashName()
+ * @return the index of the entry or -1 if the entry was not found
+ */
+static int Dictionary_findEntry(Dictionary * dictionary, const char * name, unsigned int hash)
 {
-    double doubleOfCopy = 0.0;
-    int valueAfterEqualInt = 0;
-    char copyOfResult[1024] = "";
-    char * parameterOfSprintf = NULL;
+    int slot;
 
-    memset(copyOfResult, '\0', sizeof(char) * 1024);
+    if (dictionary->slots == NULL)
+        return -1;
 
-    if (icaseCompareString(buffer, "precision") == 0)
-    {
-        doubleOfCopy = atof(result);
-        buffer = valueAfterEqual(buffer, charaEqual);
-        parameterOfSprintf = insertString("%.f", 2, buffer, (int)stringLength(buffer));
-        sprintf (result, parameterOfSprintf, doubleOfCopy);
-    }
-    else if (icaseCompareString(buffer, "min") == 0)
+    /* linear probing: the table is never more than half full so an empty slot ends the search */
+    for (slot = (int)(hash & (unsigned int)dictionary->slotMask); dictionary->slots[slot] != -1; slot = (slot + 1) & dictionary->slotMask)
     {
-        valueAfterEqualInt = atoi(valueAfterEqual(buffer, charaEqual));
-
-        while (valueAfterEqualInt > (int)stringLength(result))
-        {
-            copyStringWithLength(copyOfResult, result, stringLength(result) + 1);
-            free(result);
-            result = insertString(copyOfResult, 0, " ", 1);
-        }
+        int entryIndex = dictionary->slots[slot];
+        /* an interned name is recognized without comparing the characters */
+        if (dictionary->entries[entryIndex].name == name)
+            return entryIndex;
+        if (dictionary->hashes[entryIndex] == hash && icaseCompareString(dictionary->entries[entryIndex].name, name) == 0)
+            return entryIndex;
     }
-    free(parameterOfSprintf);
-    return result;
+    return -1;
 }
 
-
-/**Function search and return the value after equal charactere
- * @param buffer a buffer
- * @param charaEqual a string contain equal charactere
- * @return the string contain the number after equal charactere
-*/
-
-char * valueAfterEqual(char * buffer, char * charaEqual)
+/** Get the index of an entry, adding an undefined entry if the entry was not found
+ * @param dictionary the dictionary
+ * @param name the name of the entry
+ * @return the index of the entry
+ */
+static int Dictionary_defineEntry(Dictionary * dictionary, const char * name)
 {
-    int i = 1;
-    memset(buffer, '\0', sizeof(char) * 1024);
-
-    while (charaEqual[i] >= '0' && charaEqual[i] <= '9')
-    {
-        buffer[i-1] = charaEqual[i];
-        i++;
-    }
-    return buffer;
+    unsigned int hash = Dictionary_hashName(name);
+    int entryIndex = Dictionary_findEntry(dictionary, name, hash);
+    int slot;
+
+    if (entryIndex != -1)
+        return entryIndex;
+
+    if (dictionary->count == dictionary->capacity)
+        Dictionary_grow(dictionary);
+
+    entryIndex = dictionary->count;
+    dictionary->count += 1;
+    dictionary->entries[entryIndex].name = (char *)Dictionary_internName(name);
+    dictionary->entries[entryIndex].type = UNDEFINED_ENTRY;
+    dictionary->hashes[entryIndex] = hash;
+    dictionary->valueSizes[entryIndex] = 0;
+
+    slot = (int)(hash & (unsigned int)dictionary->slotMask);
+    while (dictionary->slots[slot] != -1)
+        slot = (slot + 1) & dictionary->slotMask;
+    dictionary->slots[slot] = entryIndex;
+    return entryIndex;
 }
 
-
-/** Function search a charactere in a string.
- * @param str a string
- * @param c charactere to find
- * @return a pointer to the charactere found
-*/
-
-char * findCharInString(char * str, char c)
+/** Double the number of entries of a dictionary and rebuild its hash table
+ * @param dictionary the dictionary
+ */
+static void Dictionary_grow(Dictionary * dictionary)
 {
-    int i = 0;
-    char * resultat = NULL;
-
-    while (str[i] != '\0' && resultat == NULL)
+    int capacity = (dictionary->capacity == 0) ? DICTIONARY_INITIAL_CAPACITY : dictionary->capacity * 2;
+    int slotCount = capacity * 2;
+    int i;
+
+    dictionary->entries = realloc(dictionary->entries, sizeof(DictionaryEntry) * (size_t)capacity);
+    dictionary->hashes = realloc(dictionary->hashes, sizeof(unsigned int) * (size_t)capacity);
+    dictionary->valueSizes = realloc(dictionary->valueSizes, sizeof(size_t) * (size_t)capacity);
+    free(dictionary->slots);
+    dictionary->slots = malloc(sizeof(int) * (size_t)slotCount);
+    if (dictionary->entries == NULL || dictionary->hashes == NULL || dictionary->valueSizes == NULL || dictionary->slots == NULL)
+        fatalError("error realloc : Attribution of dictionary->entries on the heap failed");
+    dictionary->capacity = capacity;
+    dictionary->slotMask = slotCount - 1;
+
+    for (i = 0; i < slotCount; ++i)
+        dictionary->slots[i] = -1;
+    for (i = 0; i < dictionary->count; ++i)
     {
-        if (str[i] == c)
-        {
-            resultat = &str[i];
-        }
-        i++;
+        int slot = (int)(dictionary->hashes[i] & (unsigned int)dictionary->slotMask);
+        while (dictionary->slots[slot] != -1)
+            slot = (slot + 1) & dictionary->slotMask;
+        dictionary->slots[slot] = i;
     }
-    return resultat;
-}
-
-/**Function format the string a second time
- * @param charaEqual a string contain a equal charactere
- * @param copyFormat a string contain a copy of format
- * @param buffer a buffer
- * @param stringFormated a temporary string
- * @param stringFormatedFinal the future returned value
- * @return a pointer to the new string formated
-*/
-
-char * formatSecondParameterString(char * charaEqual, char * copyFormat, char * buffer, char * stringFormated, char * stringFormatedFinal)
-{
-    charaEqual = findCharInString(copyFormat, '=');
-    memset(buffer, '\0', sizeof(char) * 1024);
-    copyStringWithLength(buffer, copyFormat+1, stringLength(copyFormat+1) - stringLength(charaEqual) + 1);
-    copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-    free(stringFormatedFinal);
-    stringFormatedFinal = formatString(duplicateString(stringFormated), buffer, charaEqual);
-    setCursorEndOfModele(copyFormat);
-    return stringFormatedFinal;
 }
 
-/**Function format the string a second time
- * @param charaEqual a string contain a equal charactere
- * @param copyFormat a string contain a copy of format
- * @param buffer a buffer
- * @param stringFormated a temporary string
- * @param stringFormatedFinal the future returned value
- * @return a pointer to the new string formated
-*/
-
-char * formatSecondParameterNumber(char * charaEqual, char * copyFormat, char * buffer, char * stringFormated, char * stringFormatedFinal)
-{
-    charaEqual = findCharInString(copyFormat, '=');
-    memset(buffer, '\0', sizeof(char) * 1024);
-    copyStringWithLength(buffer, copyFormat+1, stringLength(copyFormat+1) - stringLength(charaEqual) + 1);
-    copyStringWithLength(stringFormated, stringFormatedFinal, stringLength(stringFormatedFinal) + 1);
-    free(stringFormatedFinal);
-    stringFormatedFinal = formatNumber(duplicateString(stringFormated), buffer, charaEqual);
-    setCursorEndOfModele(copyFormat);
-    return stringFormatedFinal;
-}
-
-
-/** Function is called when model haven't parameter
- * @param dictionary a dictionary
- * @param copyFormat a string contain a copy of format
- * @param buffer a buffer
- * @return a pointer to the new string formated
-*/
-
-char * parameterNotFound(Dictionary * dictionary, char * copyFormat)
+/** Get the interned copy of the name of an entry, adding it to the pool if needed
+ * @param name the name
+ * @return the copy of the name shared by all the dictionaries, never freed
+ */
+const char * Dictionary_internName(const char * name)
 {
-    DictionaryEntry * entry;
-    char * result = NULL;
-    char buffer[1024] = "";
+    unsigned int hash = Dictionary_hashName(name);
+    const char * internedName;
+    int slot;
 
-    memset(buffer, '\0', sizeof(char) * 1024);
-    copyStringWithLength(buffer, copyFormat, stringLength(copyFormat) - stringLength(findCharInString(copyFormat, '%')) + 1);
-    entry = Dictionary_getEntry(dictionary, buffer);
+    pthread_mutex_lock(&namePool.mutex);
+    if ((namePool.count + 1) * 2 > namePool.slotMask + 1)
+    {
+        int slotCount = (namePool.slotMask == -1) ? 64 : (namePool.slotMask + 1) * 2;
+        const char ** names = calloc((size_t)slotCount, sizeof(const char *));
+        int i;
+
+        if (names == NULL)
+            fatalError("calloc error : Allocation of the names of the dictionaries failed");
+        for (i = 0; i <= namePool.slotMask; ++i)
+            if (namePool.names[i] != NULL)
+            {
+                slot = (int)(Dictionary_hashName(namePool.names[i]) & (unsigned int)(slotCount - 1));
+                while (names[slot] != NULL)
+                    slot = (slot + 1) & (slotCount - 1);
+                names[slot] = namePool.names[i];
+            }
+        free(namePool.names);
+        namePool.names = names;
+        namePool.slotMask = slotCount - 1;
+    }
 
-    if (entry != NULL)
+    slot = (int)(hash & (unsigned int)namePool.slotMask);
+    while (namePool.names[slot] != NULL && compareString(namePool.names[slot], name) != 0)
+        slot = (slot + 1) & namePool.slotMask;
+    if (namePool.names[slot] == NULL)
     {
-        if (entry->type == STRING_ENTRY)
-            result = duplicateString(entry->value.stringValue);
-        else if (entry->type == NUMBER_ENTRY)
-        {
-            memset(buffer, '\0', sizeof(char) * 1024);
-            sprintf (buffer, "%.6f", entry->value.numberValue);
-            result = duplicateString(buffer);
-        }
-        else
-            result = duplicateString("");
+        namePool.names[slot] = duplicateString(name);
+        namePool.count += 1;
     }
-    else
-        result = duplicateString("");
-    return result;
+    internedName = namePool.names[slot];
+    pthread_mutex_unlock(&namePool.mutex);
+    return internedName;
 }
 
-/**Function cut a part of string formated (model one)
- * @param copyFormat a string contain a copy of format
- * @return a pointer to the new string copyFormat
-*/
-
-void setCursorEndOfModele(char * copyFormat)
+/** Create a new string on the heap which is the result of the formatting of format according to the dictionary content
+ * @param dictionary the dictionary
+ * @param format the string to format
+ * @return a new string created on the heap
+ * @warning the user is responsible for freeing the returned string
+ */
+char * IMPLEMENT(Dictionary_format)(Dictionary * dictionary, const char * format)
 {
-    size_t i = 1;
+    Template * template = Template_compile(format);
+    StringBuilder builder;
 
-    while (copyFormat[i] != ',' && copyFormat[i] != '%')
-        i++;
-
-    copyStringWithLength(copyFormat, copyFormat+i, stringLength(copyFormat) - i + 1);
+    StringBuilder_init(&builder);
+    Template_renderTo(template, dictionary, &builder);
+    Template_destroy(template);
+    return StringBuilder_detach(&builder);
 }
-
-
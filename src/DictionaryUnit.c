@@ -18,6 +18,8 @@
  */
 
 #include <Dictionary.h>
+#include <Template.h>
+#include <DecimalFormat.h>
 #include <UnitTest.h>
 
 static void test_Dictionary_generic(void)
@@ -119,12 +121,176 @@ static void test_Dictionary_format(void)
   Dictionary_destroy(dic);
 }
 
+static void test_Dictionary_hash(void)
+{
+  Dictionary * dic = Dictionary_create();
+  Dictionary * other = Dictionary_create();
+  DictionaryEntry * entry;
+  char * value;
+  char name[32];
+  int i;
+
+  /* the table grows while the entries keep the order of their definition */
+  for (i = 0; i < 1000; ++i)
+  {
+    sprintf(name, "var%d", i);
+    Dictionary_setNumberEntry(dic, name, i);
+  }
+  ASSERT_EQUAL(dic->count, 1000);
+  for (i = 0; i < 1000; ++i)
+  {
+    sprintf(name, "VAR%d", i);
+    entry = Dictionary_getEntry(dic, name);
+    ASSERT_NOT_EQUAL(entry, NULL);
+    ASSERT_EQUAL(entry, &dic->entries[i]);
+    ASSERT_EQUAL_DOUBLE(entry->value.numberValue, i);
+  }
+  ASSERT_EQUAL(Dictionary_getEntry(dic, "var1000"), NULL);
+  ASSERT_EQUAL(Dictionary_getEntry(dic, ""), NULL);
+
+  /* the names are shared between the dictionaries */
+  Dictionary_setStringEntry(other, "var10", "abc");
+  ASSERT_EQUAL(Dictionary_getEntry(other, "Var10")->name, Dictionary_getEntry(dic, "var10")->name);
+
+  /* a string value is overwritten in place when it is large enough */
+  Dictionary_setStringEntry(other, "var10", "abcdef");
+  value = Dictionary_getEntry(other, "var10")->value.stringValue;
+  Dictionary_setStringEntry(other, "var10", "xyz");
+  entry = Dictionary_getEntry(other, "var10");
+  ASSERT_EQUAL(entry->value.stringValue, value);
+  ASSERT_EQUAL_STRING(entry->value.stringValue, "xyz");
+  Dictionary_setNumberEntry(other, "var10", 2);
+  Dictionary_setStringEntry(other, "var10", "a longer value than before");
+  ASSERT_EQUAL_STRING(Dictionary_getEntry(other, "VAR10")->value.stringValue, "a longer value than before");
+  ASSERT_EQUAL(other->count, 1);
+
+  /* a cleared dictionary keeps its table for the next entries */
+  Dictionary_clear(dic);
+  ASSERT_EQUAL(dic->count, 0);
+  ASSERT_EQUAL(Dictionary_getEntry(dic, "var10"), NULL);
+  Dictionary_setStringEntry(dic, "var20", "again");
+  ASSERT_EQUAL(dic->capacity >= 1000, 1);
+  ASSERT_EQUAL_STRING(Dictionary_getEntry(dic, "VAR20")->value.stringValue, "again");
+  Dictionary_clear(other);
+  Dictionary_clear(other);
+
+  Dictionary_destroy(other);
+  Dictionary_destroy(dic);
+}
+
+static void test_Dictionary_template(void)
+{
+  Template * template;
+  Dictionary * dic = Dictionary_create();
+  char buffer[64];
+  size_t length;
+
+  Dictionary_setNumberEntry(dic, "rate", 19.6);
+  Dictionary_setStringEntry(dic, "unity", "Kg");
+
+  /* literal text, escaped percent and modifiers in a single pass */
+  template = Template_compile("|%RATE{precision=2,min=6}%%%|%UNITY{min=4,case=U}%|%MISSING{min=3}%|%%|");
+  length = Template_render(template, dic, buffer, sizeof(buffer));
+  ASSERT_EQUAL_STRING(buffer, "| 19.60%|KG  ||%|");
+  ASSERT_EQUAL(length, stringLength(buffer));
+
+  /* the template is reused with other values */
+  Dictionary_setNumberEntry(dic, "rate", 5.5);
+  Dictionary_setStringEntry(dic, "unity", "litre");
+  Template_render(template, dic, buffer, sizeof(buffer));
+  ASSERT_EQUAL_STRING(buffer, "|  5.50%|LITRE||%|");
+
+  /* a short buffer is truncated but the whole length is returned */
+  length = Template_render(template, dic, buffer, 5);
+  ASSERT_EQUAL_STRING(buffer, "|  5");
+  ASSERT_EQUAL(length, stringLength("|  5.50%|LITRE||%|"));
+  ASSERT_EQUAL(Template_render(template, dic, NULL, 0), length);
+  Template_destroy(template);
+
+  /* a percent which does not start a placeholder is kept */
+  template = Template_compile("100% sure %UNITY{max=2}");
+  Template_render(template, dic, buffer, sizeof(buffer));
+  ASSERT_EQUAL_STRING(buffer, "100% sure %UNITY{max=2}");
+  Template_destroy(template);
+
+  template = Template_compile("");
+  ASSERT_EQUAL(Template_render(template, dic, buffer, sizeof(buffer)), 0);
+  ASSERT_EQUAL_STRING(buffer, "");
+  Template_destroy(template);
+
+  Dictionary_destroy(dic);
+}
+
+static void test_Dictionary_decimalFormat(void)
+{
+  static const double values[] = { 0, 1, -1, 0.5, 0.125, 0.375, 1.005, 2.675, 12345.6789, -0.001, 1e-7, 123456789012.25,
+      99.995, 0.1 + 0.2, 1e15, 3e20, -2.5e-3 };
+  char expected[DECIMALFORMAT_BUFFER_SIZE];
+  char buffer[DECIMALFORMAT_BUFFER_SIZE];
+  unsigned int seed = 12345;
+  size_t length;
+  double value;
+  int precision;
+  int i;
+
+  /* the fixed precision gives the same text as sprintf */
+  for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); ++i)
+    for (precision = 0; precision <= 20; precision += 1)
+    {
+      sprintf(expected, "%.*f", precision, values[i]);
+      length = DecimalFormat_write(buffer, sizeof(buffer), values[i], precision, 0);
+      ASSERT_EQUAL_STRING(buffer, expected);
+      ASSERT_EQUAL(length, stringLength(expected));
+    }
+  for (i = 0; i < 10000; ++i)
+  {
+    seed = seed * 1103515245U + 12345U;
+    value = (double)(seed % 100000000U) / 997.0 - 50000.0;
+    precision = (int)(seed % 7U);
+    sprintf(expected, "%.*f", precision, value);
+    DecimalFormat_write(buffer, sizeof(buffer), value, precision, 0);
+    ASSERT_EQUAL_STRING(buffer, expected);
+  }
+
+  /* the shortest form is read back as the same number */
+  DecimalFormat_write(buffer, sizeof(buffer), 0.1, DECIMALFORMAT_SHORTEST, 0);
+  ASSERT_EQUAL_STRING(buffer, "0.1");
+  DecimalFormat_write(buffer, sizeof(buffer), -12.5, DECIMALFORMAT_SHORTEST, 0);
+  ASSERT_EQUAL_STRING(buffer, "-12.5");
+  DecimalFormat_write(buffer, sizeof(buffer), 42, DECIMALFORMAT_SHORTEST, 0);
+  ASSERT_EQUAL_STRING(buffer, "42");
+  DecimalFormat_write(buffer, sizeof(buffer), 1.0 / 3, DECIMALFORMAT_SHORTEST, 0);
+  ASSERT_EQUAL_STRING(buffer, "0.3333333333333333");
+  DecimalFormat_write(buffer, sizeof(buffer), 2.0 / 3 * 1e-5, DECIMALFORMAT_SHORTEST, 0);
+  ASSERT(compareString(buffer, "6.6666666666666666e-06") != 0);
+  ASSERT_EQUAL(atof(buffer) - 2.0 / 3 * 1e-5 < 0 || atof(buffer) - 2.0 / 3 * 1e-5 > 0, 0);
+  DecimalFormat_write(buffer, sizeof(buffer), 0.1 + 0.2, DECIMALFORMAT_SHORTEST, 0);
+  ASSERT_EQUAL_STRING(buffer, "0.30000000000000004");
+  for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); ++i)
+  {
+    DecimalFormat_write(buffer, sizeof(buffer), values[i], DECIMALFORMAT_SHORTEST, 0);
+    ASSERT_EQUAL(atof(buffer) - values[i] < 0 || atof(buffer) - values[i] > 0, 0);
+  }
+
+  /* the padding and the truncation */
+  ASSERT_EQUAL(DecimalFormat_write(buffer, sizeof(buffer), -3.14159, 2, 8), 8);
+  ASSERT_EQUAL_STRING(buffer, "   -3.14");
+  ASSERT_EQUAL(DecimalFormat_write(buffer, 5, 1234.5678, 2, 0), 7);
+  ASSERT_EQUAL_STRING(buffer, "1234");
+  ASSERT_EQUAL(DecimalFormat_write(buffer, 3, 1.5, 1, 6), 6);
+  ASSERT_EQUAL_STRING(buffer, "  ");
+  ASSERT_EQUAL(DecimalFormat_write(NULL, 0, 1.5, 1, 0), 3);
+}
+
 void test_Dictionary(void)
 {
   BEGIN_TESTS(Dictionary)
   {
     RUN_TEST(test_Dictionary_generic);
     RUN_TEST(test_Dictionary_format);
+    RUN_TEST(test_Dictionary_hash);
+    RUN_TEST(test_Dictionary_template);
+    RUN_TEST(test_Dictionary_decimalFormat);
   }
   END_TESTS
 }
@@ -20,6 +20,16 @@
 #include <Document.h>
 #include <DocumentUtil.h>
 #include <DocumentRowList.h>
+#include <DocumentReader.h>
+#include <MyString.h>
+
+static void Document_setString(Document * document, char ** field, const char * value);
+static char * Document_moveString(StringArena * arena, char * str);
+static int Document_isHeaderRead(DocumentReader * reader);
+static const char * Document_parseFile(Document * document, const char * filename);
+static const char * Document_parseHeaderFile(Document * document, const char * filename, MoneyTotals * totals, size_t * rowCount);
+static int Document_parseHeader(Document * document, DocumentReader * reader, size_t * rowCount, MoneyTotals * totals);
+static const char * Document_parseRows(Document * document, DocumentReader * reader, int version, size_t rowCount);
 
 /** Initialize a document
  * @param document a pointer to a document
@@ -58,6 +68,7 @@ void IMPLEMENT(Document_init)(Document * document)
 
     DocumentRowList_init(&document->rows);
     document->typeDocument = QUOTATION;
+    document->arena = NULL;
 }
 
 /** Finalize a document
@@ -66,13 +77,19 @@ void IMPLEMENT(Document_init)(Document * document)
  */
 void IMPLEMENT(Document_finalize)(Document * document)
 {
-    free(document->editDate);
-    free(document->expiryDate);
-    free(document->docNumber);
-    free(document->object);
-    free(document->operator);
-
     DocumentRowList_finalize(&document->rows);
+
+    /* the strings of an arena are freed with the arena */
+    if (document->arena == NULL)
+    {
+        free(document->editDate);
+        free(document->expiryDate);
+        free(document->docNumber);
+        free(document->object);
+        free(document->operator);
+    }
+    StringArena_destroy(document->arena);
+    document->arena = NULL;
 }
 
 /** Save the content of a document to a file
@@ -82,29 +99,42 @@ void IMPLEMENT(Document_finalize)(Document * document)
  */
 void IMPLEMENT(Document_saveToFile)(Document * document, const char * filename)
 {
-    DocumentRow * rowIndexTh = document->rows;
-    int rowCount = DocumentRowList_getRowCount(document->rows), i = 0;
+    DocumentRow * row;
+    MoneyTotals totals;
+    size_t rowCount = (size_t)DocumentRowList_getRowCount(document->rows);
+    size_t headerSize;
     FILE * file = fopen(filename, "wb+");
 
     if (file == NULL)
         fatalError("Error : File opening failed");
 
-    CustomerRecord_write(&document->customer, file);
+    DocumentRowList_computeTotals(document->rows, &totals);
+    headerSize = getVarintSize(rowCount) + 3 * 8 + CUSTOMERRECORD_SIZE
+            + getCompactStringSize(document->editDate) + getCompactStringSize(document->expiryDate)
+            + getCompactStringSize(document->docNumber) + getCompactStringSize(document->object)
+            + getCompactStringSize(document->operator);
 
-    writeString(document->editDate, file);
-    writeString(document->expiryDate, file);
-    writeString(document->docNumber, file);
-    writeString(document->object, file);
-    writeString(document->operator, file);
+    if (fwrite(DOCUMENT_MAGIC, DOCUMENT_MAGIC_SIZE, 1, file) < 1
+            || fputc(DOCUMENT_FORMAT_VERSION, file) == EOF
+            || fputc((int)document->typeDocument, file) == EOF)
+        fatalError("fwrite error : return value is not valid.");
+    writeVarint(headerSize, file);
 
+    writeVarint(rowCount, file);
+    writeBinaryInteger(totals.withoutVAT, file);
+    writeBinaryInteger(totals.ofVAT, file);
+    writeBinaryInteger(totals.withVAT, file);
 
-    while (rowCount > 0)
-    {
-        rowIndexTh = DocumentRowList_get(document->rows, i);
-        DocumentRow_writeRow(rowIndexTh, file);
-        rowCount--;
-        i++;
-    }
+    CustomerRecord_write(&document->customer, file);
+
+    writeCompactString(document->editDate, file);
+    writeCompactString(document->expiryDate, file);
+    writeCompactString(document->docNumber, file);
+    writeCompactString(document->object, file);
+    writeCompactString(document->operator, file);
+
+    for (row = document->rows; row != NULL; row = row->next)
+        DocumentRow_writeCompactRow(row, file);
     fclose(file);
 }
 
@@ -115,30 +145,328 @@ void IMPLEMENT(Document_saveToFile)(Document * document, const char * filename)
  */
 void IMPLEMENT(Document_loadFromFile)(Document * document, const char * filename)
 {
-    FILE * file = fopen(filename, "rb");
+    const char * error = Document_parseFile(document, filename);
 
-    if (file == NULL)
-        fatalError("Error : File opening failed");
+    if (error != NULL)
+        fatalError(error);
+}
 
-    fseek(file, 0, SEEK_END);
-    long endOfFile = ftell(file);
-    rewind(file);
+/** Load the content of a document from a file which may be missing, truncated or corrupted
+ * @param document the document to fill
+ * @param filename the file name
+ * @return a non null value on success, 0 if the file cannot be read
+ */
+int Document_tryLoadFromFile(Document * document, const char * filename)
+{
+    return Document_parseFile(document, filename) == NULL;
+}
+
+/** Load the header of a document from a file without its rows
+ * @param document the document to fill, its list of rows being left empty
+ * @param filename the file name
+ * @param totals the totals of the rows of the document to fill
+ * @return the number of rows of the document
+ */
+int Document_loadHeaderFromFile(Document * document, const char * filename, MoneyTotals * totals)
+{
+    size_t rowCount = 0;
+    const char * error = Document_parseHeaderFile(document, filename, totals, &rowCount);
 
+    if (error != NULL)
+        fatalError(error);
+    return (int)rowCount;
+}
 
-    CustomerRecord_read(&document->customer, file);
+/** Load the header of a document from a file which may be missing, truncated or corrupted
+ * @param document the document to fill, its list of rows being left empty
+ * @param filename the file name
+ * @param totals the totals of the rows of the document to fill
+ * @return the number of rows of the document, -1 if the file cannot be read
+ */
+int Document_tryLoadHeaderFromFile(Document * document, const char * filename, MoneyTotals * totals)
+{
+    size_t rowCount = 0;
+
+    if (Document_parseHeaderFile(document, filename, totals, &rowCount) != NULL)
+        return -1;
+    return (int)rowCount;
+}
+
+/** Make the strings of a document allocated from an arena
+ * @param document the document
+ */
+void Document_enableArena(Document * document)
+{
+    DocumentRow * row;
+
+    if (document->arena != NULL)
+        return;
+
+    document->arena = StringArena_create();
+    document->editDate = Document_moveString(document->arena, document->editDate);
+    document->expiryDate = Document_moveString(document->arena, document->expiryDate);
+    document->docNumber = Document_moveString(document->arena, document->docNumber);
+    document->object = Document_moveString(document->arena, document->object);
+    document->operator = Document_moveString(document->arena, document->operator);
+    for (row = document->rows; row != NULL; row = row->next)
+        if (row->arena == NULL)
+        {
+            row->code = Document_moveString(document->arena, row->code);
+            row->designation = Document_moveString(document->arena, row->designation);
+            row->unity = Document_moveString(document->arena, row->unity);
+            row->arena = document->arena;
+        }
+}
+
+/** Set the edit date of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_editDate(Document * document, const char * value)
+{
+    Document_setString(document, &document->editDate, value);
+}
+
+/** Set the expiry date of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_expiryDate(Document * document, const char * value)
+{
+    Document_setString(document, &document->expiryDate, value);
+}
+
+/** Set the number of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_docNumber(Document * document, const char * value)
+{
+    Document_setString(document, &document->docNumber, value);
+}
+
+/** Set the object of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_object(Document * document, const char * value)
+{
+    Document_setString(document, &document->object, value);
+}
+
+/** Set the operator of a document, the copy being made in the arena of the document if it has one
+ * @param document the document
+ * @param value the value
+ */
+void Document_setValue_operator(Document * document, const char * value)
+{
+    Document_setString(document, &document->operator, value);
+}
+
+/** Replace a string of the header of a document
+ * @param document the document
+ * @param field the address of the string
+ * @param value the new value
+ */
+static void Document_setString(Document * document, char ** field, const char * value)
+{
+    if (document->arena != NULL)
+        *field = StringArena_duplicate(document->arena, value);
+    else
+    {
+        free(*field);
+        *field = duplicateString(value);
+    }
+}
+
+/** Copy a string allocated with malloc() into an arena and free it
+ * @param arena the arena
+ * @param str the string
+ * @return the copy
+ */
+static char * Document_moveString(StringArena * arena, char * str)
+{
+    char * copy = StringArena_duplicate(arena, str);
+
+    free(str);
+    return copy;
+}
+
+/** Tell if the beginning of a file loaded by DocumentReader_openPrefix() contains the whole header of a document
+ * @param reader the reader of the beginning of the file
+ * @return a non null value if the header can be parsed without the rest of the file
+ */
+static int Document_isHeaderRead(DocumentReader * reader)
+{
+    DocumentReader header = *reader;
+    size_t headerSize;
+
+    if (reader->size < DOCUMENT_HEADER_READ_SIZE)
+        return 1;
+    if (memcmp(reader->data, DOCUMENT_MAGIC, DOCUMENT_MAGIC_SIZE) != 0 || reader->data[DOCUMENT_MAGIC_SIZE] < 3)
+        return 0;
+    header.position = DOCUMENT_MAGIC_SIZE + 2;
+    headerSize = DocumentReader_readVarint(&header);
+    return headerSize <= header.size - header.position;
+}
+
+/** Load the content of a document from a file
+ * @param document the initialized document to fill, left finalizable on error
+ * @param filename the file name
+ * @return NULL on success, the message of the error otherwise
+ */
+static const char * Document_parseFile(Document * document, const char * filename)
+{
+    DocumentReader reader;
+    int useArena = document->arena != NULL;
+    MoneyTotals totals;
+    size_t rowCount = 0;
+    int version;
+    const char * error;
+
+    /* the whole file is loaded at once and the fields are parsed from the memory */
+    if (!DocumentReader_open(&reader, filename))
+        return "Error : File opening failed";
 
     Document_finalize(document);
+    if (useArena)
+        document->arena = StringArena_create();
 
-    document->editDate = readString(file);
-    document->expiryDate = readString(file);
-    document->docNumber = readString(file);
-    document->object = readString(file);
-    document->operator = readString(file);
+    version = Document_parseHeader(document, &reader, &rowCount, &totals);
+    if (version == 0)
+        error = "Error : Unknown version of the document file format";
+    else
+        error = Document_parseRows(document, &reader, version, rowCount);
+    DocumentReader_close(&reader);
+    return error;
+}
 
-    while (endOfFile != ftell(file))
+/** Read the header of a document file, the rows being read only to compute the totals of the old versions
+ * @param document the document to fill, its list of rows being left empty
+ * @param filename the file name
+ * @param totals the totals of the rows of the document to fill
+ * @param rowCount the number of rows of the document to fill
+ * @return NULL on success, the error message if the file cannot be read
+ */
+static const char * Document_parseHeaderFile(Document * document, const char * filename, MoneyTotals * totals, size_t * rowCount)
+{
+    DocumentReader reader;
+    int useArena = document->arena != NULL;
+    int version;
+    const char * error = NULL;
+
+    if (!DocumentReader_openPrefix(&reader, filename, DOCUMENT_HEADER_READ_SIZE))
+        return "Error : File opening failed";
+    /* a long header or an old file whose rows must be read needs the whole file */
+    if (!Document_isHeaderRead(&reader))
     {
-        DocumentRowList_pushBack(&document->rows, DocumentRow_readRow(file));
+        DocumentReader_close(&reader);
+        if (!DocumentReader_open(&reader, filename))
+            return "Error : File opening failed";
     }
-    fclose(file);
+
+    Document_finalize(document);
+    if (useArena)
+        document->arena = StringArena_create();
+
+    version = Document_parseHeader(document, &reader, rowCount, totals);
+    if (version == 0)
+        error = "Error : Unknown version of the document file format";
+    else if (version < 3)
+    {
+        error = Document_parseRows(document, &reader, version, *rowCount);
+        *rowCount = (size_t)DocumentRowList_getRowCount(document->rows);
+        DocumentRowList_computeTotals(document->rows, totals);
+        DocumentRowList_finalize(&document->rows);
+    }
+    else if (reader.isCorrupted)
+        error = "read error : the document file is truncated or corrupted.";
+    DocumentReader_close(&reader);
+    return error;
+}
+
+/** Parse the header of a document file of any version of the format
+ *
+ * The strings of the header are empty if the file is corrupted.
+ * @param document the finalized document to fill
+ * @param reader the reader of the file
+ * @param rowCount the number of rows to fill, not filled for the version 1
+ * @param totals the totals of the rows to fill, only filled from the version 3
+ * @return the version of the format of the file, 0 if it is unknown
+ */
+static int Document_parseHeader(Document * document, DocumentReader * reader, size_t * rowCount, MoneyTotals * totals)
+{
+    const char * bytes;
+    int version;
+
+    if (reader->size < DOCUMENT_MAGIC_SIZE || memcmp(reader->data, DOCUMENT_MAGIC, DOCUMENT_MAGIC_SIZE) != 0)
+    {
+        CustomerRecord_decode(&document->customer, DocumentReader_readBytes(reader, CUSTOMERRECORD_SIZE));
+
+        document->editDate = DocumentReader_readString(reader, document->arena);
+        document->expiryDate = DocumentReader_readString(reader, document->arena);
+        document->docNumber = DocumentReader_readString(reader, document->arena);
+        document->object = DocumentReader_readString(reader, document->arena);
+        document->operator = DocumentReader_readString(reader, document->arena);
+        return 1;
+    }
+
+    bytes = DocumentReader_readBytes(reader, DOCUMENT_MAGIC_SIZE + 2);
+    version = bytes[DOCUMENT_MAGIC_SIZE];
+    if (version != 2 && version != DOCUMENT_FORMAT_VERSION)
+    {
+        /* the strings are still read, as empty strings, so that the document stays valid */
+        DocumentReader_setCorrupted(reader);
+        version = 0;
+    }
+    document->typeDocument = (bytes[DOCUMENT_MAGIC_SIZE + 1] == BILL) ? BILL : QUOTATION;
+
+    if (version >= 3)
+    {
+        /* the size of the header is only needed to read the header alone */
+        DocumentReader_readVarint(reader);
+        *rowCount = DocumentReader_readVarint(reader);
+        totals->withoutVAT = DocumentReader_readBinaryInteger(reader);
+        totals->ofVAT = DocumentReader_readBinaryInteger(reader);
+        totals->withVAT = DocumentReader_readBinaryInteger(reader);
+    }
+
+    CustomerRecord_decode(&document->customer, DocumentReader_readBytes(reader, CUSTOMERRECORD_SIZE));
+
+    document->editDate = DocumentReader_readCompactString(reader, document->arena);
+    document->expiryDate = DocumentReader_readCompactString(reader, document->arena);
+    document->docNumber = DocumentReader_readCompactString(reader, document->arena);
+    document->object = DocumentReader_readCompactString(reader, document->arena);
+    document->operator = DocumentReader_readCompactString(reader, document->arena);
+
+    if (version == 2)
+        *rowCount = DocumentReader_readVarint(reader);
+    return version;
 }
 
+/** Parse the rows following the header of a document file
+ * @param document the document to fill
+ * @param reader the reader of the file positioned after the header
+ * @param version the version of the format of the file
+ * @param rowCount the number of rows, unused for the version 1
+ * @return NULL on success, the message of the error otherwise
+ */
+static const char * Document_parseRows(Document * document, DocumentReader * reader, int version, size_t rowCount)
+{
+    if (version == 1)
+    {
+        while (!DocumentReader_isAtEnd(reader))
+            DocumentRowList_pushBack(&document->rows, DocumentRow_parseRow(reader, document->arena));
+    }
+    else
+    {
+        /* a corrupted count of rows must not create rows until the memory is exhausted */
+        for (; rowCount > 0 && !reader->isCorrupted; --rowCount)
+            DocumentRowList_pushBack(&document->rows, DocumentRow_parseCompactRow(reader, document->arena));
+        if (!DocumentReader_isAtEnd(reader))
+            return "Error : Unexpected data at the end of the document file";
+    }
+    if (reader->isCorrupted)
+        return "read error : the document file is truncated or corrupted.";
+    return NULL;
+}
@@ -27,6 +27,7 @@
 #include <CatalogDB.h>
 #include <Print.h>
 #include <DocumentRowList.h>
+#include <DecimalFormat.h>
 
 #define EDITOR_ROWCOUNT 4
 
@@ -55,6 +56,7 @@ typedef struct _DocumentEditor {
     GtkWidget * insertAfterButton[EDITOR_ROWCOUNT];
     GtkWidget * removeButton[EDITOR_ROWCOUNT];
     GtkWidget * vscrollbar;
+    CatalogDB * catalogDB;
 
     gulong quantity_insert_text_handler[EDITOR_ROWCOUNT];
     gulong basePrice_insert_text_handler[EDITOR_ROWCOUNT];
@@ -119,28 +121,101 @@ static int DocumentEditor_getEntryOffset(DocumentEditor * documentEditor, GtkWid
     return -1;
 }
 
+/** Get the catalog of the editor, opening it the first time it is needed
+ * @param documentEditor the editor
+ * @return the catalog, NULL if it does not exist
+ */
+static CatalogDB * DocumentEditor_getCatalog(DocumentEditor * documentEditor) {
+    if (documentEditor->catalogDB == NULL)
+        documentEditor->catalogDB = CatalogDB_open(CATALOGDB_FILENAME);
+    return documentEditor->catalogDB;
+}
+
+/** Close the catalog of the editor so that it is opened again when it is next needed
+ * @param documentEditor the editor
+ */
+static void DocumentEditor_closeCatalog(DocumentEditor * documentEditor) {
+    if (documentEditor->catalogDB != NULL)
+        CatalogDB_close(documentEditor->catalogDB);
+    documentEditor->catalogDB = NULL;
+}
+
+/** Tell whether a text of a row was not typed by the operator
+ * @param value the text of the row
+ * @param previous the product of the previous code of the row, NULL if there is none
+ * @param previousValue the text given by the previous product
+ * @return true if the text is empty or is still the one given by the previous product
+ */
+static int DocumentEditor_isUntouchedText(const char * value, CatalogRecord * previous,
+        const char * previousValue) {
+    return value[0] == '\0' || (previous != NULL && strcmp(value, previousValue) == 0);
+}
+
+/** Tell whether a number of a row was not typed by the operator
+ * @param value the number of the row
+ * @param previous the product of the previous code of the row, NULL if there is none
+ * @param previousValue the number given by the previous product
+ * @return true if the number is null or is still the one given by the previous product, to the displayed precision
+ */
+static int DocumentEditor_isUntouchedNumber(double value, CatalogRecord * previous,
+        double previousValue) {
+    return fabs(value) < 0.005 || (previous != NULL && fabs(value - previousValue) < 0.005);
+}
+
+/** Fill the values of a row which were not typed by the operator with the product of the catalog which has the code of the row, if any
+ * @param documentEditor the editor
+ * @param row the row
+ * @param previousCode the code of the row before the operator changed it
+ */
+static void DocumentEditor_fillRowFromCatalog(DocumentEditor * documentEditor, DocumentRow * row,
+        const char * previousCode) {
+    CatalogDB * catalogDB = DocumentEditor_getCatalog(documentEditor);
+    CatalogRecord record;
+    CatalogRecord previousRecord;
+    CatalogRecord * previous = NULL;
+
+    if (catalogDB == NULL)
+        return;
+    CatalogRecord_init(&record);
+    CatalogRecord_init(&previousRecord);
+    /* a value still equal to the product of the previous code was filled by the editor */
+    if (previousCode[0] != '\0' && CatalogDB_findRecordByCode(catalogDB, previousCode, &previousRecord) != -1)
+        previous = &previousRecord;
+    if (CatalogDB_findRecordByCode(catalogDB, row->code, &record) != -1) {
+        if (DocumentEditor_isUntouchedText(row->designation, previous, previousRecord.designation))
+            DocumentRow_setValue_designation(row, record.designation);
+        if (DocumentEditor_isUntouchedText(row->unity, previous, previousRecord.unity))
+            DocumentRow_setValue_unity(row, record.unity);
+        if (DocumentEditor_isUntouchedNumber(row->basePrice, previous, previousRecord.basePrice))
+            row->basePrice = record.basePrice;
+        if (DocumentEditor_isUntouchedNumber(row->sellingPrice, previous, previousRecord.sellingPrice))
+            row->sellingPrice = record.sellingPrice;
+        if (DocumentEditor_isUntouchedNumber(row->rateOfVAT, previous, previousRecord.rateOfVAT))
+            row->rateOfVAT = record.rateOfVAT;
+    }
+    CatalogRecord_finalize(&previousRecord);
+    CatalogRecord_finalize(&record);
+}
+
 static void DocumentEditor_saveData(DocumentEditor * documentEditor, int first) {
     int i;
     Document * document = documentEditor->document;
     /* Phase 1 */
-    free(document->expiryDate);
-    free(document->object);
-    document->expiryDate = duplicateString(gtk_entry_get_text(
+    Document_setValue_expiryDate(document, gtk_entry_get_text(
             GTK_ENTRY(documentEditor->expiryDateEntry)));
-    document->object = duplicateString(gtk_entry_get_text(GTK_ENTRY(documentEditor->objectEntry)));
+    Document_setValue_object(document, gtk_entry_get_text(GTK_ENTRY(documentEditor->objectEntry)));
 
     /* Phase 2 : les lignes */
     for (i = 0; i < EDITOR_ROWCOUNT; ++i) {
         DocumentRow * row = DocumentRowList_get(document->rows, first + i);
         if (row != NULL) {
-            free(row->code);
-            row->code = duplicateString(
+            int isNewCode = strcmp(row->code, gtk_entry_get_text(GTK_ENTRY (documentEditor->codeEntry[i]))) != 0;
+            char * previousCode = duplicateString(row->code);
+            DocumentRow_setValue_code(row,
                     gtk_entry_get_text(GTK_ENTRY (documentEditor->codeEntry[i])));
-            free(row->designation);
-            row->designation = duplicateString(gtk_entry_get_text(
+            DocumentRow_setValue_designation(row, gtk_entry_get_text(
                     GTK_ENTRY (documentEditor->designationEntry[i])));
-            free(row->unity);
-            row->unity = duplicateString(gtk_entry_get_text(
+            DocumentRow_setValue_unity(row, gtk_entry_get_text(
                     GTK_ENTRY (documentEditor->unityEntry[i])));
             row->quantity = atof(gtk_entry_get_text(GTK_ENTRY (documentEditor->quantityEntry[i])));
             row->basePrice
@@ -150,6 +225,10 @@ static void DocumentEditor_saveData(DocumentEditor * documentEditor, int first)
             row->discount = atof(gtk_entry_get_text(GTK_ENTRY (documentEditor->discountEntry[i])));
             row->rateOfVAT
                     = atof(gtk_entry_get_text(GTK_ENTRY (documentEditor->rateOfVATEntry[i])));
+            /* a code typed by the operator brings the product from the catalog */
+            if (isNewCode && row->code[0] != '\0')
+                DocumentEditor_fillRowFromCatalog(documentEditor, row, previousCode);
+            free(previousCode);
         }
     }
 
@@ -157,14 +236,11 @@ static void DocumentEditor_saveData(DocumentEditor * documentEditor, int first)
 
 static void DocumentEditor_loadData(DocumentEditor * documentEditor, int first) {
     int i;
-    double sumWithoutVAT = 0;
-    double sumOfVAT = 0;
-    double sumWithVAT = 0;
-    double ht;
+    MoneyTotals totals;
+    GdkColor totalsColor;
     char buf[1024];
     int rowCount;
     Document * document = documentEditor->document;
-    DocumentRow * cur;
 
     /* Phase 1 : entete */
     DocumentEditor_setCustomer(&document->customer, documentEditor->customerViewer);
@@ -206,19 +282,19 @@ static void DocumentEditor_loadData(DocumentEditor * documentEditor, int first)
             gtk_entry_set_text(GTK_ENTRY (documentEditor->codeEntry[i]), row->code);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->designationEntry[i]), row->designation);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->unityEntry[i]), row->unity);
-            snprintf(buf, 1024, "%.2f", (double) (row->quantity));
+            DecimalFormat_write(buf, 1024, row->quantity, 2, 0);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->quantityEntry[i]), buf);
             gtk_entry_set_editable(GTK_ENTRY(documentEditor->basePriceEntry[i]), strcmp(row->code,
                     "") == 0);
-            snprintf(buf, 1024, "%.2f", (double) (row->basePrice));
+            DecimalFormat_write(buf, 1024, row->basePrice, 2, 0);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->basePriceEntry[i]), buf);
-            snprintf(buf, 1024, "%.2f", (double) (row->sellingPrice));
+            DecimalFormat_write(buf, 1024, row->sellingPrice, 2, 0);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->sellingPriceEntry[i]), buf);
-            snprintf(buf, 1024, "%.2f", (double) (row->discount));
+            DecimalFormat_write(buf, 1024, row->discount, 2, 0);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->discountEntry[i]), buf);
-            snprintf(buf, 1024, "%.2f", (double) (row->sellingPrice - row->discount));
+            DecimalFormat_write(buf, 1024, row->sellingPrice - row->discount, 2, 0);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->finalPriceEntry[i]), buf);
-            snprintf(buf, 1024, "%.2f", (double) (row->rateOfVAT));
+            DecimalFormat_write(buf, 1024, row->rateOfVAT, 2, 0);
             gtk_entry_set_text(GTK_ENTRY (documentEditor->rateOfVATEntry[i]), buf);
 
             if (row->sellingPrice - row->discount < 0 || row->basePrice > row->sellingPrice || row->basePrice > (row->sellingPrice - row->discount))
@@ -240,21 +316,21 @@ static void DocumentEditor_loadData(DocumentEditor * documentEditor, int first)
         gtk_widget_set_sensitive(documentEditor->vscrollbar, FALSE);
 
     /* Phase 3 : les totaux */
-    cur = document->rows;
-    while (cur != NULL) {
-        ht = (cur->sellingPrice - cur->discount) * cur->quantity;
-        sumWithoutVAT += ht;
-        sumOfVAT += ht * cur->rateOfVAT / 100.;
-        sumWithVAT += ht * (1. + cur->rateOfVAT / 100.);
-        cur = cur->next;
-    }
+    /* the totals leaving out a row whose values are too large are shown in red */
+    if (DocumentRowList_computeTotals(document->rows, &totals))
+        gdk_color_parse("black", &totalsColor);
+    else
+        gdk_color_parse("red", &totalsColor);
 
-    snprintf(buf, 1024, "%.2f", (double) sumWithoutVAT);
+    Money_write(buf, 1024, totals.withoutVAT, 2, 0);
     gtk_entry_set_text(GTK_ENTRY (documentEditor->sumWithoutVATEntry), buf);
-    snprintf(buf, 1024, "%.2f", (double) sumOfVAT);
+    Money_write(buf, 1024, totals.ofVAT, 2, 0);
     gtk_entry_set_text(GTK_ENTRY (documentEditor->sumOfVATEntry), buf);
-    snprintf(buf, 1024, "%.2f", (double) sumWithVAT);
+    Money_write(buf, 1024, totals.withVAT, 2, 0);
     gtk_entry_set_text(GTK_ENTRY (documentEditor->sumWithVATEntry), buf);
+    gtk_widget_modify_text(documentEditor->sumWithoutVATEntry, GTK_STATE_NORMAL, &totalsColor);
+    gtk_widget_modify_text(documentEditor->sumOfVATEntry, GTK_STATE_NORMAL, &totalsColor);
+    gtk_widget_modify_text(documentEditor->sumWithVATEntry, GTK_STATE_NORMAL, &totalsColor);
 }
 
 static void DocumentEditor_insert_text_handler_positiveNumeric(GtkWidget *entry, const gchar *text,
@@ -423,12 +499,9 @@ static void DocumentEditor_removeCurrent(GtkWidget * button, DocumentEditor * do
             gtk_range_set_value(GTK_RANGE(documentEditor->vscrollbar), first);
             gtk_widget_grab_focus(documentEditor->codeEntry[offset]);
         } else {
-            free(row->code);
-            row->code = duplicateString("");
-            free(row->designation);
-            row->designation = duplicateString("");
-            free(row->unity);
-            row->unity = duplicateString("");
+            DocumentRow_setValue_code(row, "");
+            DocumentRow_setValue_designation(row, "");
+            DocumentRow_setValue_unity(row, "");
             row->basePrice = 0;
             row->sellingPrice = 0;
             row->rateOfVAT = 0;
@@ -445,23 +518,23 @@ static void DocumentEditor_chooseProduct(GtkWidget * button, DocumentEditor * do
     int first = (int) gtk_range_get_value(GTK_RANGE(documentEditor->vscrollbar));
     int offset = DocumentEditor_getEntryOffset(documentEditor, button);
     DocumentRow * row = DocumentRowList_get(document->rows, first + offset);
-    int recordNum = Catalog_select(NULL);
+    int recordNum;
+
+    /* the products can be changed from the selection dialog */
+    DocumentEditor_closeCatalog(documentEditor);
+    recordNum = Catalog_select(NULL);
+    catalogDB = DocumentEditor_getCatalog(documentEditor);
 
-    if (recordNum != -1 && row != NULL) {
+    if (recordNum != -1 && row != NULL && catalogDB != NULL) {
         CatalogRecord record;
         CatalogRecord_init(&record);
-        catalogDB = CatalogDB_openOrCreate(CATALOGDB_FILENAME);
         CatalogDB_readRecord(catalogDB, recordNum, &record);
-        free(row->code);
-        row->code = duplicateString(record.code);
-        free(row->designation);
-        row->designation = duplicateString(record.designation);
-        free(row->unity);
-        row->unity = duplicateString(record.unity);
+        DocumentRow_setValue_code(row, record.code);
+        DocumentRow_setValue_designation(row, record.designation);
+        DocumentRow_setValue_unity(row, record.unity);
         row->basePrice = record.basePrice;
         row->sellingPrice = record.sellingPrice;
         row->rateOfVAT = record.rateOfVAT;
-        CatalogDB_close(catalogDB);
         CatalogRecord_finalize(&record);
         DocumentEditor_loadData(documentEditor, first);
         gtk_widget_grab_focus(documentEditor->codeEntry[offset]);
@@ -480,6 +553,7 @@ int DocumentEditor_edit(GtkWindow * parent, TypeAction typeAction, Document * do
     int first;
 
     documentEditor.document = document;
+    documentEditor.catalogDB = NULL;
 
     if (typeAction == NEW_DOCUMENT) {
         if (document->typeDocument == QUOTATION)
@@ -892,6 +966,7 @@ int DocumentEditor_edit(GtkWindow * parent, TypeAction typeAction, Document * do
         }
     } while (response == 1);
     gtk_widget_destroy(dialog);
+    DocumentEditor_closeCatalog(&documentEditor);
 
     return response == GTK_RESPONSE_OK;
 }
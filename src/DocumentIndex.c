@@ -0,0 +1,852 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <DocumentIndex.h>
+#include <DocumentReader.h>
+#include <DocumentUtil.h>
+#include <MyString.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** The state shared by the workers of a refresh */
+typedef struct
+{
+  DocumentIndex * documentIndex; /**< The refreshed index */
+  const int * pendingEntries; /**< The positions of the entries whose document must be loaded */
+  int pendingCount; /**< The number of entries whose document must be loaded */
+  int nextPending; /**< The position in pendingEntries of the next document to load */
+  DocumentIndexListener listener; /**< The function receiving the entries, NULL if none */
+  void * data; /**< The data given to the listener */
+  DocumentIndexEntry batch[DOCUMENTINDEX_BATCH_SIZE]; /**< The entries not yet given to the listener */
+  int batchCount; /**< The number of entries of batch */
+  pthread_mutex_t mutex; /**< The lock protecting the arena of the index, the batch and the counter */
+} DocumentIndexJob;
+
+/** The smallest size of an entry in an index file: seven empty strings, the type and six integers */
+#define DOCUMENTINDEX_MIN_ENTRY_SIZE (7 + 1 + 6 * 8)
+
+/** The suffix of the file locked by the processes writing an index file */
+#define DOCUMENTINDEX_LOCK_SUFFIX ".lock"
+
+/** The lock preventing two threads from writing the same temporary index file */
+static pthread_mutex_t documentIndexSaveMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static char * DocumentIndex_getPath(DocumentIndex * documentIndex, const char * filename);
+static void DocumentIndex_load(DocumentIndex * documentIndex);
+static void DocumentIndex_loadJournal(DocumentIndex * documentIndex);
+static void DocumentIndex_readEntry(DocumentIndex * documentIndex, DocumentReader * reader, DocumentIndexEntry * entry);
+static void DocumentIndex_writeEntry(const DocumentIndexEntry * entry, FILE * file);
+static int DocumentIndex_lock(const char * lockFilename);
+static void DocumentIndex_unlock(int lockFile);
+static void DocumentIndex_merge(DocumentIndex * documentIndex);
+static int DocumentIndex_isNewer(const DocumentIndexEntry * entry, const DocumentIndexEntry * otherEntry);
+static void DocumentIndex_copyEntry(DocumentIndex * documentIndex, DocumentIndexEntry * entry, const DocumentIndexEntry * source);
+static int DocumentIndex_search(DocumentIndex * documentIndex, const char * filename, int * position);
+static void DocumentIndex_reserve(DocumentIndex * documentIndex, int count);
+static void DocumentIndex_fill(DocumentIndex * documentIndex, DocumentIndexEntry * entry, Document * document, MoneyTotals * totals);
+static void DocumentIndex_loadDocuments(DocumentIndexJob * job, int threadCount);
+static void * DocumentIndex_work(void * data);
+static void DocumentIndex_notify(DocumentIndexJob * job, const DocumentIndexEntry * entry);
+static void DocumentIndex_flush(DocumentIndexJob * job);
+static TypeDocument DocumentIndex_getType(const char * filename);
+static int DocumentIndex_compareFilenames(const void * first, const void * second);
+
+/** Open the index of a directory, reading its index file if there is a valid one
+ * @param directory the directory of the documents
+ * @return the new index
+ */
+DocumentIndex * DocumentIndex_open(const char * directory)
+{
+    DocumentIndex * documentIndex = malloc(sizeof(DocumentIndex));
+
+    if (documentIndex == NULL)
+        fatalError("malloc error : Allocation of the document index failed");
+    documentIndex->directory = duplicateString(directory);
+    documentIndex->arena = StringArena_create();
+    documentIndex->entries = NULL;
+    documentIndex->count = 0;
+    documentIndex->capacity = 0;
+    documentIndex->isModified = 0;
+    DocumentIndex_load(documentIndex);
+    return documentIndex;
+}
+
+/** Save the index file if the index changed and free the memory used by an index
+ * @param documentIndex the index
+ */
+void DocumentIndex_close(DocumentIndex * documentIndex)
+{
+    if (documentIndex->isModified)
+        DocumentIndex_save(documentIndex);
+    StringArena_destroy(documentIndex->arena);
+    free(documentIndex->entries);
+    free(documentIndex->directory);
+    free(documentIndex);
+}
+
+/** Write the index file of an index
+ * @param documentIndex the index
+ * @return a non null value on success, 0 if the file cannot be written
+ */
+int DocumentIndex_save(DocumentIndex * documentIndex)
+{
+    char * filename = DocumentIndex_getPath(documentIndex, DOCUMENTINDEX_FILENAME);
+    char * temporaryFilename = concatenateString(filename, ".tmp");
+    char * lockFilename = concatenateString(filename, DOCUMENTINDEX_LOCK_SUFFIX);
+    char * journalFilename = DocumentIndex_getPath(documentIndex, DOCUMENTINDEX_JOURNAL_FILENAME);
+    FILE * file;
+    int isWritten = 0;
+    int lockFile;
+    int i;
+
+    lockFile = DocumentIndex_lock(lockFilename);
+    /* the entries written and journaled since the index was opened are kept */
+    DocumentIndex_merge(documentIndex);
+    file = fopen(temporaryFilename, "wb");
+    if (file != NULL)
+    {
+        if (fwrite(DOCUMENTINDEX_MAGIC, DOCUMENTINDEX_MAGIC_SIZE, 1, file) < 1)
+            fatalError("fwrite error : return value is not valid.");
+        fputc(DOCUMENTINDEX_FORMAT_VERSION, file);
+        writeVarint((size_t)documentIndex->count, file);
+        for (i = 0; i < documentIndex->count; ++i)
+            DocumentIndex_writeEntry(&documentIndex->entries[i], file);
+        isWritten = !ferror(file);
+        if (fclose(file) != 0)
+            isWritten = 0;
+        /* the index file is replaced at once so that a reader never sees a partial file */
+        if (isWritten && rename(temporaryFilename, filename) != 0)
+            isWritten = 0;
+        if (!isWritten)
+            remove(temporaryFilename);
+    }
+    /* the journaled entries are now in the index file */
+    if (isWritten)
+        remove(journalFilename);
+    DocumentIndex_unlock(lockFile);
+    if (isWritten)
+        documentIndex->isModified = 0;
+    free(journalFilename);
+    free(lockFilename);
+    free(temporaryFilename);
+    free(filename);
+    return isWritten;
+}
+
+/** Update the entry of a document which was just saved
+ * @param documentIndex the index
+ * @param filename the name of the document file in the directory
+ * @param document the document
+ */
+void DocumentIndex_update(DocumentIndex * documentIndex, const char * filename, Document * document)
+{
+    char * path = DocumentIndex_getPath(documentIndex, filename);
+    struct stat status;
+    MoneyTotals totals;
+    int position;
+    int entryIndex = DocumentIndex_search(documentIndex, filename, &position);
+
+    if (stat(path, &status) != 0)
+        fatalError("Error : the saved document can not be indexed");
+    free(path);
+
+    if (entryIndex == -1)
+    {
+        DocumentIndex_reserve(documentIndex, documentIndex->count + 1);
+        memmove(documentIndex->entries + position + 1, documentIndex->entries + position,
+                sizeof(DocumentIndexEntry) * (size_t)(documentIndex->count - position));
+        documentIndex->count += 1;
+        documentIndex->entries[position].filename = StringArena_duplicate(documentIndex->arena, filename);
+        documentIndex->entries[position].typeDocument = DocumentIndex_getType(filename);
+        entryIndex = position;
+    }
+    DocumentRowList_computeTotals(document->rows, &totals);
+    DocumentIndex_fill(documentIndex, &documentIndex->entries[entryIndex], document, &totals);
+    documentIndex->entries[entryIndex].modificationTime = (long)status.st_mtime;
+    documentIndex->entries[entryIndex].modificationNanoseconds = getModificationNanoseconds(&status);
+    documentIndex->entries[entryIndex].fileSize = (long)status.st_size;
+    documentIndex->isModified = 1;
+}
+
+/** Append the entry of a document which was just saved to the journal of the index of its directory
+ * @param directory the directory of the documents
+ * @param filename the name of the document file in the directory
+ * @param document the document
+ * @return a non null value on success, 0 if the journal cannot be written
+ */
+int DocumentIndex_record(const char * directory, const char * filename, Document * document)
+{
+    DocumentIndex documentIndex;
+    char * indexFilename;
+    char * lockFilename;
+    char * journalFilename;
+    FILE * file;
+    int isWritten = 0;
+    int lockFile;
+
+    /* the entry is built by an empty index which is never saved */
+    documentIndex.directory = duplicateString(directory);
+    documentIndex.arena = StringArena_create();
+    documentIndex.entries = NULL;
+    documentIndex.count = 0;
+    documentIndex.capacity = 0;
+    documentIndex.isModified = 0;
+    DocumentIndex_update(&documentIndex, filename, document);
+
+    indexFilename = DocumentIndex_getPath(&documentIndex, DOCUMENTINDEX_FILENAME);
+    lockFilename = concatenateString(indexFilename, DOCUMENTINDEX_LOCK_SUFFIX);
+    journalFilename = DocumentIndex_getPath(&documentIndex, DOCUMENTINDEX_JOURNAL_FILENAME);
+    lockFile = DocumentIndex_lock(lockFilename);
+    file = fopen(journalFilename, "ab");
+    if (file != NULL)
+    {
+        /* a new journal starts with the same magic and version as the index file */
+        if (ftell(file) == 0)
+        {
+            if (fwrite(DOCUMENTINDEX_MAGIC, DOCUMENTINDEX_MAGIC_SIZE, 1, file) < 1)
+                fatalError("fwrite error : return value is not valid.");
+            fputc(DOCUMENTINDEX_FORMAT_VERSION, file);
+        }
+        DocumentIndex_writeEntry(&documentIndex.entries[0], file);
+        isWritten = !ferror(file);
+        if (fclose(file) != 0)
+            isWritten = 0;
+    }
+    DocumentIndex_unlock(lockFile);
+
+    free(journalFilename);
+    free(lockFilename);
+    free(indexFilename);
+    StringArena_destroy(documentIndex.arena);
+    free(documentIndex.entries);
+    free(documentIndex.directory);
+    return isWritten;
+}
+
+/** Check the index against the document files of its directory
+ * @param documentIndex the index
+ * @return the number of loaded documents, -1 if the directory cannot be listed
+ */
+int DocumentIndex_refresh(DocumentIndex * documentIndex)
+{
+    return DocumentIndex_refreshWith(documentIndex, 0, NULL, NULL);
+}
+
+/** Check the index against the document files of its directory, loading the changed documents in parallel
+ * @param documentIndex the index
+ * @param threadCount the number of worker threads, 0 for one per processor
+ * @param listener the function receiving the entries, NULL if none
+ * @param data the data given to the listener
+ * @return the number of loaded documents, -1 if the directory cannot be listed
+ */
+int DocumentIndex_refreshWith(DocumentIndex * documentIndex, int threadCount, DocumentIndexListener listener, void * data)
+{
+    DIR * directory = opendir(documentIndex->directory);
+    struct dirent * directoryEntry;
+    struct stat status;
+    char ** filenames = NULL;
+    int filenameCount = 0;
+    int filenameCapacity = 0;
+    DocumentIndexEntry * entries;
+    int * pendingEntries;
+    int pendingCount = 0;
+    int count = 0;
+    int entryIndex = 0;
+    DocumentIndexJob job;
+    int i;
+
+    if (directory == NULL)
+        return -1;
+    while ((directoryEntry = readdir(directory)) != NULL)
+    {
+        if (!icaseEndWith(DOCUMENTINDEX_SUFFIX, directoryEntry->d_name)
+                || (!icaseStartWith(DOCUMENTINDEX_BILL_PREFIX, directoryEntry->d_name)
+                        && !icaseStartWith(DOCUMENTINDEX_QUOTATION_PREFIX, directoryEntry->d_name)))
+            continue;
+        if (filenameCount == filenameCapacity)
+        {
+            filenameCapacity = (filenameCapacity == 0) ? 64 : filenameCapacity * 2;
+            filenames = realloc(filenames, sizeof(char *) * (size_t)filenameCapacity);
+            if (filenames == NULL)
+                fatalError("realloc error : Allocation of the document file names failed");
+        }
+        filenames[filenameCount++] = duplicateString(directoryEntry->d_name);
+    }
+    closedir(directory);
+    if (filenameCount > 1)
+        qsort(filenames, (size_t)filenameCount, sizeof(char *), DocumentIndex_compareFilenames);
+
+    /* the sorted file names and the sorted entries are walked together */
+    entries = malloc(sizeof(DocumentIndexEntry) * (size_t)MAXVALUE(filenameCount, 1));
+    pendingEntries = malloc(sizeof(int) * (size_t)MAXVALUE(filenameCount, 1));
+    if (entries == NULL || pendingEntries == NULL)
+        fatalError("malloc error : Allocation of the document index failed");
+    for (i = 0; i < filenameCount; ++i)
+    {
+        char * path = DocumentIndex_getPath(documentIndex, filenames[i]);
+        int isStatable = stat(path, &status) == 0;
+
+        free(path);
+        while (entryIndex < documentIndex->count && strcmp(documentIndex->entries[entryIndex].filename, filenames[i]) < 0)
+            entryIndex += 1;
+        if (entryIndex < documentIndex->count && strcmp(documentIndex->entries[entryIndex].filename, filenames[i]) == 0)
+            entries[count] = documentIndex->entries[entryIndex++];
+        else
+        {
+            entries[count].filename = StringArena_duplicate(documentIndex->arena, filenames[i]);
+            entries[count].typeDocument = DocumentIndex_getType(filenames[i]);
+            entries[count].modificationTime = -1;
+        }
+        /* a file removed while listing the directory is not indexed */
+        if (!isStatable)
+            continue;
+        /* a file rewritten with the same size within the same second only differs by the nanoseconds */
+        if (entries[count].modificationTime != (long)status.st_mtime
+                || entries[count].modificationNanoseconds != getModificationNanoseconds(&status)
+                || entries[count].fileSize != (long)status.st_size)
+        {
+            entries[count].modificationTime = (long)status.st_mtime;
+            entries[count].modificationNanoseconds = getModificationNanoseconds(&status);
+            entries[count].fileSize = (long)status.st_size;
+            pendingEntries[pendingCount++] = count;
+        }
+        count += 1;
+    }
+
+    if (count != documentIndex->count || pendingCount != 0)
+        documentIndex->isModified = 1;
+    for (i = 0; i < filenameCount; ++i)
+        free(filenames[i]);
+    free(filenames);
+    free(documentIndex->entries);
+    documentIndex->entries = entries;
+    documentIndex->count = count;
+    documentIndex->capacity = MAXVALUE(filenameCount, 1);
+
+    job.documentIndex = documentIndex;
+    job.pendingEntries = pendingEntries;
+    job.pendingCount = pendingCount;
+    job.nextPending = 0;
+    job.listener = listener;
+    job.data = data;
+    job.batchCount = 0;
+
+    /* the unchanged entries are known before any document is loaded */
+    entryIndex = 0;
+    for (i = 0; i < count; ++i)
+    {
+        if (entryIndex < pendingCount && pendingEntries[entryIndex] == i)
+            entryIndex += 1;
+        else
+            DocumentIndex_notify(&job, &entries[i]);
+    }
+    DocumentIndex_flush(&job);
+
+    DocumentIndex_loadDocuments(&job, threadCount);
+    DocumentIndex_flush(&job);
+    free(pendingEntries);
+    return pendingCount;
+}
+
+/** Find the entry of a document file
+ * @param documentIndex the index
+ * @param filename the name of the document file in the directory
+ * @return the entry, NULL if the file is not indexed
+ */
+DocumentIndexEntry * DocumentIndex_find(DocumentIndex * documentIndex, const char * filename)
+{
+    int position;
+    int entryIndex = DocumentIndex_search(documentIndex, filename, &position);
+
+    return (entryIndex == -1) ? NULL : &documentIndex->entries[entryIndex];
+}
+
+/** Create a new string on the heap containing the path of a file of the directory of an index
+ * @param documentIndex the index
+ * @param filename the name of the file
+ * @return the new string
+ */
+static char * DocumentIndex_getPath(DocumentIndex * documentIndex, const char * filename)
+{
+    char * directory = concatenateString(documentIndex->directory, "/");
+    char * path = concatenateString(directory, filename);
+
+    free(directory);
+    return path;
+}
+
+/** Read the index file of an index
+ *
+ * An index file of another format, truncated or corrupted, is ignored and will be replaced.
+ * @param documentIndex the empty index
+ */
+static void DocumentIndex_load(DocumentIndex * documentIndex)
+{
+    char * filename = DocumentIndex_getPath(documentIndex, DOCUMENTINDEX_FILENAME);
+    DocumentReader reader;
+    size_t count;
+    int isOpen = DocumentReader_open(&reader, filename);
+    int i;
+
+    free(filename);
+    if (!isOpen)
+    {
+        DocumentIndex_loadJournal(documentIndex);
+        return;
+    }
+    if (reader.size < DOCUMENTINDEX_MAGIC_SIZE + 1 || memcmp(reader.data, DOCUMENTINDEX_MAGIC, DOCUMENTINDEX_MAGIC_SIZE) != 0
+            || reader.data[DOCUMENTINDEX_MAGIC_SIZE] != DOCUMENTINDEX_FORMAT_VERSION)
+    {
+        DocumentReader_close(&reader);
+        documentIndex->isModified = 1;
+        DocumentIndex_loadJournal(documentIndex);
+        return;
+    }
+
+    DocumentReader_readBytes(&reader, DOCUMENTINDEX_MAGIC_SIZE + 1);
+    count = DocumentReader_readVarint(&reader);
+    /* a corrupted count must not reserve more entries than the file can hold */
+    if (count > (reader.size - reader.position) / DOCUMENTINDEX_MIN_ENTRY_SIZE)
+        DocumentReader_setCorrupted(&reader);
+    else
+        DocumentIndex_reserve(documentIndex, (int)count);
+    for (; count > 0 && !reader.isCorrupted; --count)
+        DocumentIndex_readEntry(documentIndex, &reader, &documentIndex->entries[documentIndex->count++]);
+    if (!DocumentReader_isAtEnd(&reader))
+        DocumentReader_setCorrupted(&reader);
+    /* the searches need the entries sorted by file name */
+    for (i = 1; i < documentIndex->count && !reader.isCorrupted; ++i)
+        if (strcmp(documentIndex->entries[i - 1].filename, documentIndex->entries[i].filename) >= 0)
+            DocumentReader_setCorrupted(&reader);
+
+    if (reader.isCorrupted)
+    {
+        /* the next refresh loads all the documents again */
+        StringArena_destroy(documentIndex->arena);
+        documentIndex->arena = StringArena_create();
+        documentIndex->count = 0;
+        documentIndex->isModified = 1;
+    }
+    DocumentReader_close(&reader);
+    DocumentIndex_loadJournal(documentIndex);
+}
+
+/** Apply to an index the entries appended to its journal by DocumentIndex_record()
+ *
+ * A journaled entry replaces the entry of the same file unless the latter is newer. An
+ * entry which was not completely written is ignored.
+ * @param documentIndex the index, loaded from its index file
+ */
+static void DocumentIndex_loadJournal(DocumentIndex * documentIndex)
+{
+    char * filename = DocumentIndex_getPath(documentIndex, DOCUMENTINDEX_JOURNAL_FILENAME);
+    DocumentReader reader;
+    DocumentIndexEntry entry;
+    int isOpen = DocumentReader_open(&reader, filename);
+    int entryIndex;
+    int position;
+
+    free(filename);
+    if (!isOpen)
+        return;
+    if (reader.size < DOCUMENTINDEX_MAGIC_SIZE + 1 || memcmp(reader.data, DOCUMENTINDEX_MAGIC, DOCUMENTINDEX_MAGIC_SIZE) != 0
+            || reader.data[DOCUMENTINDEX_MAGIC_SIZE] != DOCUMENTINDEX_FORMAT_VERSION)
+        DocumentReader_setCorrupted(&reader);
+    else
+        DocumentReader_readBytes(&reader, DOCUMENTINDEX_MAGIC_SIZE + 1);
+
+    while (!reader.isCorrupted && !DocumentReader_isAtEnd(&reader))
+    {
+        DocumentIndex_readEntry(documentIndex, &reader, &entry);
+        if (reader.isCorrupted)
+            break;
+        entryIndex = DocumentIndex_search(documentIndex, entry.filename, &position);
+        if (entryIndex == -1)
+        {
+            DocumentIndex_reserve(documentIndex, documentIndex->count + 1);
+            memmove(documentIndex->entries + position + 1, documentIndex->entries + position,
+                    sizeof(DocumentIndexEntry) * (size_t)(documentIndex->count - position));
+            documentIndex->count += 1;
+            documentIndex->entries[position] = entry;
+        }
+        else if (!DocumentIndex_isNewer(&documentIndex->entries[entryIndex], &entry))
+            documentIndex->entries[entryIndex] = entry;
+        /* the journal is folded into the index file when the index is closed */
+        documentIndex->isModified = 1;
+    }
+    DocumentReader_close(&reader);
+}
+
+/** Read an entry of an index file or of a journal
+ * @param documentIndex the index receiving the strings
+ * @param reader the reader of the file
+ * @param entry the entry to fill
+ */
+static void DocumentIndex_readEntry(DocumentIndex * documentIndex, DocumentReader * reader, DocumentIndexEntry * entry)
+{
+    entry->filename = DocumentReader_readCompactString(reader, documentIndex->arena);
+    entry->typeDocument = (*DocumentReader_readBytes(reader, 1) == BILL) ? BILL : QUOTATION;
+    entry->docNumber = DocumentReader_readCompactString(reader, documentIndex->arena);
+    entry->customerName = DocumentReader_readCompactString(reader, documentIndex->arena);
+    entry->editDate = DocumentReader_readCompactString(reader, documentIndex->arena);
+    entry->expiryDate = DocumentReader_readCompactString(reader, documentIndex->arena);
+    entry->object = DocumentReader_readCompactString(reader, documentIndex->arena);
+    entry->totals.withoutVAT = DocumentReader_readBinaryInteger(reader);
+    entry->totals.ofVAT = DocumentReader_readBinaryInteger(reader);
+    entry->totals.withVAT = DocumentReader_readBinaryInteger(reader);
+    entry->modificationTime = (long)DocumentReader_readBinaryInteger(reader);
+    entry->modificationNanoseconds = (long)DocumentReader_readBinaryInteger(reader);
+    entry->fileSize = (long)DocumentReader_readBinaryInteger(reader);
+}
+
+/** Write an entry in an index file or in a journal
+ * @param entry the entry
+ * @param file the file
+ */
+static void DocumentIndex_writeEntry(const DocumentIndexEntry * entry, FILE * file)
+{
+    writeCompactString(entry->filename, file);
+    fputc((int)entry->typeDocument, file);
+    writeCompactString(entry->docNumber, file);
+    writeCompactString(entry->customerName, file);
+    writeCompactString(entry->editDate, file);
+    writeCompactString(entry->expiryDate, file);
+    writeCompactString(entry->object, file);
+    writeBinaryInteger(entry->totals.withoutVAT, file);
+    writeBinaryInteger(entry->totals.ofVAT, file);
+    writeBinaryInteger(entry->totals.withVAT, file);
+    writeBinaryInteger(entry->modificationTime, file);
+    writeBinaryInteger(entry->modificationNanoseconds, file);
+    writeBinaryInteger(entry->fileSize, file);
+}
+
+/** Serialize the threads and the processes writing the index file or the journal of a directory
+ *
+ * A selection dialog may close its index while a document is saved: the threads are
+ * serialized by a mutex and the processes by the lock of the lock file.
+ * @param lockFilename the path of the lock file
+ * @return the descriptor of the locked file, -1 if only the threads are serialized
+ */
+static int DocumentIndex_lock(const char * lockFilename)
+{
+    int lockFile;
+
+    pthread_mutex_lock(&documentIndexSaveMutex);
+    lockFile = open(lockFilename, O_RDWR | O_CREAT, 0644);
+    if (lockFile != -1 && lockf(lockFile, F_LOCK, 0) != 0)
+    {
+        close(lockFile);
+        lockFile = -1;
+    }
+    return lockFile;
+}
+
+/** Release the locks taken by DocumentIndex_lock()
+ * @param lockFile the descriptor of the locked file, -1 if none
+ */
+static void DocumentIndex_unlock(int lockFile)
+{
+    if (lockFile != -1)
+    {
+        lockf(lockFile, F_ULOCK, 0);
+        close(lockFile);
+    }
+    pthread_mutex_unlock(&documentIndexSaveMutex);
+}
+
+/** Merge into an index the entries of its index file which are newer than its own
+ *
+ * The index file may have been written by another index since this one was opened.
+ * An entry of the file replaces the entry of the index if its document was modified
+ * later, and an entry only in the file is added if its document still exists.
+ * @param documentIndex the index
+ */
+static void DocumentIndex_merge(DocumentIndex * documentIndex)
+{
+    DocumentIndex saved;
+    DocumentIndexEntry * entries;
+    int count = 0;
+    int entryIndex = 0;
+    int savedIndex = 0;
+
+    saved.directory = documentIndex->directory;
+    saved.arena = StringArena_create();
+    saved.entries = NULL;
+    saved.count = 0;
+    saved.capacity = 0;
+    saved.isModified = 0;
+    DocumentIndex_load(&saved);
+
+    /* the two sorted lists of entries are walked together */
+    entries = malloc(sizeof(DocumentIndexEntry) * (size_t)MAXVALUE(documentIndex->count + saved.count, 1));
+    if (entries == NULL)
+        fatalError("malloc error : Allocation of the document index failed");
+    while (entryIndex < documentIndex->count || savedIndex < saved.count)
+    {
+        int comparison;
+
+        if (savedIndex == saved.count)
+            comparison = -1;
+        else if (entryIndex == documentIndex->count)
+            comparison = 1;
+        else
+            comparison = strcmp(documentIndex->entries[entryIndex].filename, saved.entries[savedIndex].filename);
+
+        if (comparison < 0)
+            entries[count++] = documentIndex->entries[entryIndex++];
+        else if (comparison == 0)
+        {
+            entries[count] = documentIndex->entries[entryIndex++];
+            if (DocumentIndex_isNewer(&saved.entries[savedIndex], &entries[count]))
+                DocumentIndex_copyEntry(documentIndex, &entries[count], &saved.entries[savedIndex]);
+            savedIndex += 1;
+            count += 1;
+        }
+        else
+        {
+            char * path = DocumentIndex_getPath(documentIndex, saved.entries[savedIndex].filename);
+            struct stat status;
+
+            /* a document removed since the file was written is dropped */
+            if (stat(path, &status) == 0)
+            {
+                entries[count].filename = StringArena_duplicate(documentIndex->arena, saved.entries[savedIndex].filename);
+                DocumentIndex_copyEntry(documentIndex, &entries[count++], &saved.entries[savedIndex]);
+            }
+            free(path);
+            savedIndex += 1;
+        }
+    }
+
+    free(documentIndex->entries);
+    documentIndex->entries = entries;
+    documentIndex->count = count;
+    documentIndex->capacity = MAXVALUE(count, 1);
+    StringArena_destroy(saved.arena);
+    free(saved.entries);
+}
+
+/** Tell if the document of an entry was modified after the one of another entry of the same file
+ * @param entry the entry
+ * @param otherEntry the other entry
+ * @return a non null value if the entry is newer
+ */
+static int DocumentIndex_isNewer(const DocumentIndexEntry * entry, const DocumentIndexEntry * otherEntry)
+{
+    if (entry->modificationTime != otherEntry->modificationTime)
+        return entry->modificationTime > otherEntry->modificationTime;
+    return entry->modificationNanoseconds > otherEntry->modificationNanoseconds;
+}
+
+/** Copy the content of an entry of another index into an entry, but its file name
+ * @param documentIndex the index of the entry, receiving the strings
+ * @param entry the entry
+ * @param source the copied entry
+ */
+static void DocumentIndex_copyEntry(DocumentIndex * documentIndex, DocumentIndexEntry * entry, const DocumentIndexEntry * source)
+{
+    entry->typeDocument = source->typeDocument;
+    entry->docNumber = StringArena_duplicate(documentIndex->arena, source->docNumber);
+    entry->customerName = StringArena_duplicate(documentIndex->arena, source->customerName);
+    entry->editDate = StringArena_duplicate(documentIndex->arena, source->editDate);
+    entry->expiryDate = StringArena_duplicate(documentIndex->arena, source->expiryDate);
+    entry->object = StringArena_duplicate(documentIndex->arena, source->object);
+    entry->totals = source->totals;
+    entry->modificationTime = source->modificationTime;
+    entry->modificationNanoseconds = source->modificationNanoseconds;
+    entry->fileSize = source->fileSize;
+}
+
+/** Find the position of the entry of a document file
+ * @param documentIndex the index
+ * @param filename the name of the document file
+ * @param position the position where the entry should be inserted if there is none
+ * @return the position of the entry, -1 if the file is not indexed
+ */
+static int DocumentIndex_search(DocumentIndex * documentIndex, const char * filename, int * position)
+{
+    int first = 0;
+    int last = documentIndex->count;
+
+    while (first < last)
+    {
+        int middle = first + (last - first) / 2;
+        int comparison = strcmp(documentIndex->entries[middle].filename, filename);
+
+        if (comparison == 0)
+            return middle;
+        if (comparison < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    *position = first;
+    return -1;
+}
+
+/** Make sure that an index can hold a number of entries, its capacity doubling if needed
+ * @param documentIndex the index
+ * @param count the number of entries
+ */
+static void DocumentIndex_reserve(DocumentIndex * documentIndex, int count)
+{
+    if (count <= documentIndex->capacity)
+        return;
+    documentIndex->capacity = MAXVALUE(count, documentIndex->capacity * 2);
+    documentIndex->entries = realloc(documentIndex->entries, sizeof(DocumentIndexEntry) * (size_t)documentIndex->capacity);
+    if (documentIndex->entries == NULL)
+        fatalError("realloc error : Allocation of the document index failed");
+}
+
+/** Copy into an entry what the index keeps about a document
+ * @param documentIndex the index
+ * @param entry the entry
+ * @param document the document
+ * @param totals the totals of the rows of the document
+ */
+static void DocumentIndex_fill(DocumentIndex * documentIndex, DocumentIndexEntry * entry, Document * document, MoneyTotals * totals)
+{
+    entry->docNumber = StringArena_duplicate(documentIndex->arena, document->docNumber);
+    entry->customerName = StringArena_duplicate(documentIndex->arena, document->customer.name);
+    entry->editDate = StringArena_duplicate(documentIndex->arena, document->editDate);
+    entry->expiryDate = StringArena_duplicate(documentIndex->arena, document->expiryDate);
+    entry->object = StringArena_duplicate(documentIndex->arena, document->object);
+    entry->totals = *totals;
+}
+
+/** Load the documents of the pending entries of a refresh on a pool of worker threads
+ * @param job the job of the refresh
+ * @param threadCount the number of worker threads, 0 for one per processor
+ */
+static void DocumentIndex_loadDocuments(DocumentIndexJob * job, int threadCount)
+{
+    pthread_t threads[DOCUMENTINDEX_MAX_THREADS];
+    int i;
+
+    if (threadCount <= 0)
+        threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = MINVALUE(MAXVALUE(threadCount, 1), DOCUMENTINDEX_MAX_THREADS);
+    /* a worker without document to load would only cost its creation */
+    threadCount = MINVALUE(threadCount, job->pendingCount);
+
+    pthread_mutex_init(&job->mutex, NULL);
+    for (i = 0; i < threadCount; ++i)
+        if (pthread_create(&threads[i], NULL, DocumentIndex_work, job) != 0)
+            fatalError("pthread_create error : unable to start a worker of the document index");
+    for (i = 0; i < threadCount; ++i)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&job->mutex);
+}
+
+/** Load the headers of the documents of a refresh until none is left
+ * @param data the job of the refresh
+ * @return NULL
+ */
+static void * DocumentIndex_work(void * data)
+{
+    DocumentIndexJob * job = data;
+    DocumentIndexEntry * entry;
+    Document document;
+    MoneyTotals totals;
+    char * path;
+    int pending;
+    int isLoaded;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&job->mutex);
+        pending = job->nextPending;
+        if (pending < job->pendingCount)
+            job->nextPending += 1;
+        pthread_mutex_unlock(&job->mutex);
+        if (pending >= job->pendingCount)
+            break;
+
+        /* the entries are not moved during the loading, only the arena is shared */
+        entry = &job->documentIndex->entries[job->pendingEntries[pending]];
+        path = DocumentIndex_getPath(job->documentIndex, entry->filename);
+        Document_init(&document);
+        Document_enableArena(&document);
+        isLoaded = Document_tryLoadHeaderFromFile(&document, path, &totals) >= 0;
+        free(path);
+        /* an unreadable document is indexed empty, not listed and read again by the next refresh */
+        if (!isLoaded)
+        {
+            Document_finalize(&document);
+            Document_init(&document);
+            MoneyTotals_init(&totals);
+        }
+
+        pthread_mutex_lock(&job->mutex);
+        DocumentIndex_fill(job->documentIndex, entry, &document, &totals);
+        if (isLoaded)
+            DocumentIndex_notify(job, entry);
+        else
+            entry->modificationTime = -1;
+        pthread_mutex_unlock(&job->mutex);
+        Document_finalize(&document);
+    }
+    return NULL;
+}
+
+/** Add an entry to the batch of a refresh, giving the batch to the listener when it is full
+ * @param job the job of the refresh, locked if its workers are running
+ * @param entry the entry
+ */
+static void DocumentIndex_notify(DocumentIndexJob * job, const DocumentIndexEntry * entry)
+{
+    if (job->listener == NULL)
+        return;
+    job->batch[job->batchCount++] = *entry;
+    if (job->batchCount == DOCUMENTINDEX_BATCH_SIZE)
+        DocumentIndex_flush(job);
+}
+
+/** Give the entries of the batch of a refresh to the listener
+ * @param job the job of the refresh, locked if its workers are running
+ */
+static void DocumentIndex_flush(DocumentIndexJob * job)
+{
+    if (job->listener != NULL && job->batchCount > 0)
+        job->listener(job->batch, job->batchCount, job->data);
+    job->batchCount = 0;
+}
+
+/** Get the type of a document from the name of its file
+ * @param filename the name of the document file
+ * @return the type
+ */
+static TypeDocument DocumentIndex_getType(const char * filename)
+{
+    return icaseStartWith(DOCUMENTINDEX_BILL_PREFIX, filename) ? BILL : QUOTATION;
+}
+
+/** Compare two file names for qsort()
+ * @param first a pointer on the first file name
+ * @param second a pointer on the second file name
+ * @return the comparison of the names
+ */
+static int DocumentIndex_compareFilenames(const void * first, const void * second)
+{
+    return strcmp(*(char * const *)first, *(char * const *)second);
+}
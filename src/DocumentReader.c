@@ -0,0 +1,335 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <DocumentReader.h>
+#include <DecimalFormat.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static size_t DocumentReader_readLength(DocumentReader * reader);
+static int DocumentReader_hasBytes(DocumentReader * reader, size_t size);
+static char * DocumentReader_copyString(DocumentReader * reader, size_t length, StringArena * arena);
+
+/** The bytes returned in place of the fields of a corrupted file */
+static const char DocumentReader_zeros[DOCUMENTREADER_MAX_FIXED_SIZE];
+
+/** Load a file in memory
+ * @param reader the reader to initialize
+ * @param filename the file name
+ * @return a non null value on success, 0 if the file cannot be read
+ */
+int DocumentReader_open(DocumentReader * reader, const char * filename)
+{
+    struct stat status;
+    void * mapping;
+    char * data;
+    size_t size = 0;
+    ssize_t count;
+    int fd = open(filename, O_RDONLY);
+
+    reader->data = NULL;
+    reader->size = 0;
+    reader->position = 0;
+    reader->isMapped = 0;
+    reader->isCorrupted = 0;
+    if (fd == -1)
+        return 0;
+    if (fstat(fd, &status) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+    /* an empty file has nothing to map */
+    if (status.st_size == 0)
+    {
+        close(fd);
+        return 1;
+    }
+
+    mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED)
+    {
+        close(fd);
+        reader->data = (const char *)mapping;
+        reader->size = (size_t)status.st_size;
+        reader->isMapped = 1;
+        return 1;
+    }
+
+    /* the files which cannot be mapped are read at once */
+    data = malloc((size_t)status.st_size);
+    if (data == NULL)
+        fatalError("malloc error : Allocation of the document file failed");
+    while (size < (size_t)status.st_size && (count = read(fd, data + size, (size_t)status.st_size - size)) > 0)
+        size += (size_t)count;
+    close(fd);
+    if (size < (size_t)status.st_size)
+    {
+        free(data);
+        return 0;
+    }
+    reader->data = data;
+    reader->size = size;
+    return 1;
+}
+
+/** Load the beginning of a file in memory
+ * @param reader the reader to initialize
+ * @param filename the file name
+ * @param size the maximum number of bytes to read
+ * @return a non null value on success, 0 if the file cannot be read
+ */
+int DocumentReader_openPrefix(DocumentReader * reader, const char * filename, size_t size)
+{
+    char * data = malloc(MAXVALUE(size, 1));
+    size_t readSize = 0;
+    ssize_t count = 1;
+    int fd = open(filename, O_RDONLY);
+
+    reader->data = NULL;
+    reader->size = 0;
+    reader->position = 0;
+    reader->isMapped = 0;
+    reader->isCorrupted = 0;
+    if (data == NULL)
+        fatalError("malloc error : Allocation of the document file failed");
+    if (fd == -1)
+    {
+        free(data);
+        return 0;
+    }
+    while (readSize < size && (count = read(fd, data + readSize, size - readSize)) > 0)
+        readSize += (size_t)count;
+    close(fd);
+    if (count < 0)
+    {
+        free(data);
+        return 0;
+    }
+    reader->data = data;
+    reader->size = readSize;
+    return 1;
+}
+
+/** Release the memory holding the file
+ * @param reader the reader
+ */
+void DocumentReader_close(DocumentReader * reader)
+{
+    if (reader->isMapped)
+        munmap((void *)reader->data, reader->size);
+    else
+        free((void *)reader->data);
+    reader->data = NULL;
+    reader->size = 0;
+    reader->position = 0;
+    reader->isMapped = 0;
+    reader->isCorrupted = 0;
+}
+
+/** Tell if all the fields of the file have been read
+ * @param reader the reader
+ * @return a non null value at the end of the file
+ */
+int DocumentReader_isAtEnd(DocumentReader * reader)
+{
+    return reader->position >= reader->size;
+}
+
+/** Mark the file as corrupted, the fields read afterwards being empty
+ * @param reader the reader
+ */
+void DocumentReader_setCorrupted(DocumentReader * reader)
+{
+    reader->isCorrupted = 1;
+    /* the loops reading until the end of the file stop at once */
+    reader->position = reader->size;
+}
+
+/** Read some bytes
+ * @param reader the reader
+ * @param size the number of bytes, at most DOCUMENTREADER_MAX_FIXED_SIZE
+ * @return the bytes, valid until the reader is closed, zeros if the file is corrupted
+ */
+const char * DocumentReader_readBytes(DocumentReader * reader, size_t size)
+{
+    const char * bytes = reader->data + reader->position;
+
+    if (size > DOCUMENTREADER_MAX_FIXED_SIZE)
+        fatalError("read error : too many bytes are read at once.");
+    if (!DocumentReader_hasBytes(reader, size))
+        return DocumentReader_zeros;
+    reader->position += size;
+    return bytes;
+}
+
+/** Read a string written by writeString()
+ * @param reader the reader
+ * @param arena the arena receiving the string, NULL to create the string on the heap
+ * @return the string
+ */
+char * DocumentReader_readString(DocumentReader * reader, StringArena * arena)
+{
+    return DocumentReader_copyString(reader, DocumentReader_readLength(reader), arena);
+}
+
+/** Read a number written as a string by writeString()
+ * @param reader the reader
+ * @return the number
+ */
+double DocumentReader_readNumber(DocumentReader * reader)
+{
+    char buffer[DECIMALFORMAT_BUFFER_SIZE];
+    size_t length = DocumentReader_readLength(reader);
+    double value = 0;
+
+    if (length >= DECIMALFORMAT_BUFFER_SIZE)
+    {
+        DocumentReader_setCorrupted(reader);
+        return 0;
+    }
+    memcpy(buffer, DocumentReader_readBytes(reader, length), length);
+    buffer[length] = '\0';
+    sscanf(buffer, "%lf", &value);
+    return value;
+}
+
+/** Read an unsigned integer written by writeVarint()
+ * @param reader the reader
+ * @return the integer
+ */
+size_t DocumentReader_readVarint(DocumentReader * reader)
+{
+    size_t value = 0;
+    unsigned int shift = 0;
+    unsigned char byte;
+
+    do
+    {
+        if (shift >= sizeof(size_t) * 8)
+        {
+            DocumentReader_setCorrupted(reader);
+            return 0;
+        }
+        byte = (unsigned char)*DocumentReader_readBytes(reader, 1);
+        value |= (size_t)(byte & 0x7F) << shift;
+        shift += 7;
+    }
+    while (byte & 0x80);
+    return value;
+}
+
+/** Read a string written by writeCompactString()
+ * @param reader the reader
+ * @param arena the arena receiving the string, NULL to create the string on the heap
+ * @return the string
+ */
+char * DocumentReader_readCompactString(DocumentReader * reader, StringArena * arena)
+{
+    return DocumentReader_copyString(reader, DocumentReader_readVarint(reader), arena);
+}
+
+/** Read an integer written by writeBinaryInteger()
+ * @param reader the reader
+ * @return the integer
+ */
+long long DocumentReader_readBinaryInteger(DocumentReader * reader)
+{
+    const unsigned char * bytes = (const unsigned char *)DocumentReader_readBytes(reader, 8);
+    unsigned long long bits = 0;
+    int i;
+
+    for (i = 7; i >= 0; --i)
+        bits = (bits << 8) | bytes[i];
+    return (long long)bits;
+}
+
+/** Read a number written by writeBinaryNumber()
+ * @param reader the reader
+ * @return the number
+ */
+double DocumentReader_readBinaryNumber(DocumentReader * reader)
+{
+    long long bits = DocumentReader_readBinaryInteger(reader);
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/** Read the length of a string written by writeString()
+ * @param reader the reader
+ * @return the length
+ */
+static size_t DocumentReader_readLength(DocumentReader * reader)
+{
+    size_t length;
+
+    memcpy(&length, DocumentReader_readBytes(reader, sizeof(size_t)), sizeof(size_t));
+    return length;
+}
+
+/** Copy the next bytes of a file into a new string
+ * @param reader the reader
+ * @param length the length of the string
+ * @param arena the arena receiving the string, NULL to create the string on the heap
+ * @return the string
+ */
+static char * DocumentReader_copyString(DocumentReader * reader, size_t length, StringArena * arena)
+{
+    const char * bytes = reader->data + reader->position;
+    char * str;
+
+    /* the length of a string is not bounded: it is checked here rather than by readBytes() */
+    if (DocumentReader_hasBytes(reader, length))
+        reader->position += length;
+    else
+        length = 0;
+    if (arena != NULL)
+        str = StringArena_allocate(arena, length + 1);
+    else
+    {
+        str = malloc(length + 1);
+        if (str == NULL)
+            fatalError("malloc error : Allocation of char * str failed.");
+    }
+    memcpy(str, bytes, length);
+    str[length] = '\0';
+    return str;
+}
+
+/** Tell if the next bytes of a file can be read, the file being marked as corrupted otherwise
+ * @param reader the reader
+ * @param size the number of bytes
+ * @return a non null value if the bytes are in the file
+ */
+static int DocumentReader_hasBytes(DocumentReader * reader, size_t size)
+{
+    if (reader->isCorrupted)
+        return 0;
+    if (size > reader->size - reader->position)
+    {
+        DocumentReader_setCorrupted(reader);
+        return 0;
+    }
+    return 1;
+}
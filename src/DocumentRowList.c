@@ -19,6 +19,16 @@
 
 #include <DocumentRowList.h>
 #include <DocumentUtil.h>
+#include <DecimalFormat.h>
+
+/** The number of rows allocated by the array of the rows of a list when it is created */
+#define DOCUMENTROWLIST_INITIAL_CAPACITY 16
+
+static DocumentRowVector * DocumentRowList_getVector(DocumentRow * list);
+static void DocumentRowList_reserve(DocumentRowVector * vector, int count);
+static int DocumentRowList_find(DocumentRow * list, DocumentRow * row);
+static void DocumentRowList_insertAt(DocumentRow ** list, int rowIndex, DocumentRow * row);
+static void DocumentRow_setString(DocumentRow * row, char ** field, const char * value);
 
 /** Initialize a row
  * @param row the row
@@ -35,6 +45,8 @@ void IMPLEMENT(DocumentRow_init)(DocumentRow * row)
     row->discount = 0;
     row->rateOfVAT = 0;
     row->next = NULL;
+    row->vector = NULL;
+    row->arena = NULL;
 }
 
 /** Finalize a row
@@ -43,10 +55,21 @@ void IMPLEMENT(DocumentRow_init)(DocumentRow * row)
  */
 void IMPLEMENT(DocumentRow_finalize)(DocumentRow * row)
 {
-    free(row->code);
-    free(row->designation);
-    free(row->unity);
+    /* the strings of an arena are freed with the arena */
+    if (row->arena == NULL)
+    {
+        free(row->code);
+        free(row->designation);
+        free(row->unity);
+    }
+    if (row->vector != NULL)
+    {
+        free(row->vector->rows);
+        free(row->vector);
+    }
     row->next = NULL;
+    row->vector = NULL;
+    row->arena = NULL;
 }
 
 /** Create a new row on the heap and initialize it
@@ -86,35 +109,19 @@ void IMPLEMENT(DocumentRowList_init)(DocumentRow ** list)
  */
 void IMPLEMENT(DocumentRowList_finalize)(DocumentRow ** list)
 {
-    if (list != NULL)
-    {
-        DocumentRow * rowEnd;
-
-        while (*list != NULL)
-        {
-            DocumentRow * rowBeforeEnd;
-
-            rowEnd = *list;
-            rowBeforeEnd = *list;
-
-            while (rowEnd->next != NULL)
-            {
-                rowBeforeEnd = rowEnd;
-                rowEnd = rowEnd->next;
-            }
-
-            if (rowEnd == rowBeforeEnd)
-            {
-                DocumentRow_destroy(rowEnd);
-                *list = NULL;
-            }
-            else
-            {
-                rowBeforeEnd->next = NULL;
-                DocumentRow_destroy(rowEnd);
-            }
-        }
-    }
+    DocumentRowVector * vector;
+    int i;
+
+    if (list == NULL || *list == NULL)
+        return;
+
+    vector = DocumentRowList_getVector(*list);
+    (*list)->vector = NULL;
+    for (i = 0; i < vector->count; ++i)
+        DocumentRow_destroy(vector->rows[i]);
+    free(vector->rows);
+    free(vector);
+    *list = NULL;
 }
 
 /** Get a pointer on the rowIndex-th row of the list
@@ -124,23 +131,14 @@ void IMPLEMENT(DocumentRowList_finalize)(DocumentRow ** list)
  */
 DocumentRow * IMPLEMENT(DocumentRowList_get)(DocumentRow * list, int rowIndex)
 {
-    DocumentRow * rowIndexTh = list;
-    int countRow = 1;
+    DocumentRowVector * vector;
 
-    if (list != NULL && rowIndex >= 0)
-    {
-        while (rowIndexTh->next != NULL && countRow-1 != rowIndex)
-        {
-            rowIndexTh = rowIndexTh->next;
-            countRow++;
-        }
-        if (countRow-1 != rowIndex)
-            return NULL;
-    }
-    else
+    if (list == NULL || rowIndex < 0)
         return NULL;
-
-    return rowIndexTh;
+    vector = DocumentRowList_getVector(list);
+    if (rowIndex >= vector->count)
+        return NULL;
+    return vector->rows[rowIndex];
 }
 
 /**
@@ -149,20 +147,9 @@ DocumentRow * IMPLEMENT(DocumentRowList_get)(DocumentRow * list, int rowIndex)
  */
 int IMPLEMENT(DocumentRowList_getRowCount)(DocumentRow * list)
 {
-    DocumentRow * rowEnd = list;
-    int count = 0;
-
-    if (list != NULL)
-    {
-        count = 1;
-
-        while (rowEnd->next != NULL)
-        {
-            rowEnd = rowEnd->next;
-            count++;
-        }
-    }
-    return count;
+    if (list == NULL)
+        return 0;
+    return DocumentRowList_getVector(list)->count;
 }
 
 /** Add a row at the end of the list
@@ -171,19 +158,7 @@ int IMPLEMENT(DocumentRowList_getRowCount)(DocumentRow * list)
  */
 void IMPLEMENT(DocumentRowList_pushBack)(DocumentRow ** list, DocumentRow * row)
 {
-    DocumentRow * rowCount = *list;
-
-    if (rowCount == NULL)
-        *list = row;
-    else
-    {
-        while (rowCount->next != NULL)
-        {
-            rowCount = rowCount->next;
-        }
-        rowCount->next = row;
-    }
-    row->next = NULL;
+    DocumentRowList_insertAt(list, (*list == NULL) ? 0 : DocumentRowList_getVector(*list)->count, row);
 }
 
 /** Insert a row before a given row
@@ -193,20 +168,7 @@ void IMPLEMENT(DocumentRowList_pushBack)(DocumentRow ** list, DocumentRow * row)
  */
 void IMPLEMENT(DocumentRowList_insertBefore)(DocumentRow ** list, DocumentRow * position, DocumentRow * row)
 {
-    DocumentRow * rowTemp = *list;
-
-    if (*list == position)
-        *list = row;
-    else
-    {
-        while (rowTemp-> next != position)
-        {
-            rowTemp = rowTemp->next;
-        }
-        rowTemp->next = row;
-    }
-    row->next = position;
-
+    DocumentRowList_insertAt(list, DocumentRowList_find(*list, position), row);
 }
 
 /** Insert a row after a given row
@@ -216,22 +178,10 @@ void IMPLEMENT(DocumentRowList_insertBefore)(DocumentRow ** list, DocumentRow *
  */
 void IMPLEMENT(DocumentRowList_insertAfter)(DocumentRow ** list, DocumentRow * position, DocumentRow * row)
 {
-    DocumentRow * rowTemp = *list;
-
     if (*list == NULL)
-    {
-        *list = row;
-        row->next = NULL;
-    }
-    else if (position->next == NULL)
-        DocumentRowList_pushBack(list, row);
+        DocumentRowList_insertAt(list, 0, row);
     else
-    {
-        rowTemp = position;
-        rowTemp = rowTemp->next;
-        row->next = rowTemp;
-        position->next = row;
-    }
+        DocumentRowList_insertAt(list, DocumentRowList_find(*list, position) + 1, row);
 }
 
 /** Remove a row from the list
@@ -240,29 +190,30 @@ void IMPLEMENT(DocumentRowList_insertAfter)(DocumentRow ** list, DocumentRow * p
  */
 void IMPLEMENT(DocumentRowList_removeRow)(DocumentRow ** list, DocumentRow * position)
 {
-    DocumentRow * rowTemp = *list;
+    DocumentRowVector * vector;
+    int rowIndex;
 
     if (*list == NULL)
         fatalError("Error : List not contains rows.");
-    else if (rowTemp->next == NULL && rowTemp == position)
-        DocumentRowList_init(list);
-    else if (rowTemp == position)
-    {
-        *list = position->next;
-        DocumentRow_destroy(position);
-    }
-    else
-    {
-        while (rowTemp->next != NULL && rowTemp->next != position)
-        {
-            rowTemp = rowTemp->next;
-        }
-        if (rowTemp->next != position)
-            fatalError("Error : List not contains rows position.");
 
-        rowTemp->next = position->next;
-        DocumentRow_destroy(position);
+    rowIndex = DocumentRowList_find(*list, position);
+    vector = DocumentRowList_getVector(*list);
+    (*list)->vector = NULL;
+    memmove(vector->rows + rowIndex, vector->rows + rowIndex + 1, sizeof(DocumentRow *) * (size_t)(vector->count - rowIndex - 1));
+    vector->count -= 1;
+    DocumentRow_destroy(position);
+
+    if (vector->count == 0)
+    {
+        free(vector->rows);
+        free(vector);
+        *list = NULL;
+        return;
     }
+    if (rowIndex > 0)
+        vector->rows[rowIndex - 1]->next = (rowIndex < vector->count) ? vector->rows[rowIndex] : NULL;
+    *list = vector->rows[0];
+    (*list)->vector = vector;
 }
 
 /** Write a row in a binary file
@@ -271,30 +222,25 @@ void IMPLEMENT(DocumentRowList_removeRow)(DocumentRow ** list, DocumentRow * pos
  */
 void IMPLEMENT(DocumentRow_writeRow)(DocumentRow * row, FILE * file)
 {
-    char buffer[128UL] = "";
+    char buffer[DECIMALFORMAT_BUFFER_SIZE];
 
     writeString(row->code, file);
     writeString(row->unity, file);
     writeString(row->designation, file);
 
-    memset(buffer, '\0', 128UL);
-    sprintf (buffer, "%.2f", row->quantity);
+    DecimalFormat_write(buffer, sizeof(buffer), row->quantity, 2, 0);
     writeString(buffer, file);
 
-    memset(buffer, '\0', 128UL);
-    sprintf (buffer, "%.2f", row->basePrice);
+    DecimalFormat_write(buffer, sizeof(buffer), row->basePrice, 2, 0);
     writeString(buffer, file);
 
-    memset(buffer, '\0', 128UL);
-    sprintf (buffer, "%.2f", row->sellingPrice);
+    DecimalFormat_write(buffer, sizeof(buffer), row->sellingPrice, 2, 0);
     writeString(buffer, file);
 
-    memset(buffer, '\0', 128UL);
-    sprintf (buffer, "%.2f", row->discount);
+    DecimalFormat_write(buffer, sizeof(buffer), row->discount, 2, 0);
     writeString(buffer, file);
 
-    memset(buffer, '\0', 128UL);
-    sprintf (buffer, "%.2f", row->rateOfVAT);
+    DecimalFormat_write(buffer, sizeof(buffer), row->rateOfVAT, 2, 0);
     writeString(buffer, file);
 }
 
@@ -308,9 +254,10 @@ DocumentRow * IMPLEMENT(DocumentRow_readRow)(FILE * file)
     char * buffer = NULL;
     DocumentRow_finalize(row);
 
+    /* the strings are read in the order DocumentRow_writeRow() writes them */
     row->code = readString(file);
-    row->designation = readString(file);
     row->unity = readString(file);
+    row->designation = readString(file);
 
     buffer = readString(file);
     sscanf (buffer, "%lf", &row->quantity);
@@ -334,3 +281,235 @@ DocumentRow * IMPLEMENT(DocumentRow_readRow)(FILE * file)
 
     return row;
 }
+
+/** Read a row from a file held in memory
+ * @param reader the reader of the file
+ * @param arena the arena receiving the strings of the row, NULL to allocate them with malloc()
+ * @return a new row created on the heap filled with the data
+ */
+DocumentRow * DocumentRow_parseRow(DocumentReader * reader, StringArena * arena)
+{
+    DocumentRow * row = DocumentRow_create();
+
+    DocumentRow_finalize(row);
+    row->arena = arena;
+    /* the version 1 of the format stores the unity before the designation */
+    row->code = DocumentReader_readString(reader, arena);
+    row->unity = DocumentReader_readString(reader, arena);
+    row->designation = DocumentReader_readString(reader, arena);
+    row->quantity = DocumentReader_readNumber(reader);
+    row->basePrice = DocumentReader_readNumber(reader);
+    row->sellingPrice = DocumentReader_readNumber(reader);
+    row->discount = DocumentReader_readNumber(reader);
+    row->rateOfVAT = DocumentReader_readNumber(reader);
+    return row;
+}
+
+/** Write a row in a file in the compact format of the version 2 of the document files
+ * @param row the row
+ * @param file the opened file
+ */
+void DocumentRow_writeCompactRow(DocumentRow * row, FILE * file)
+{
+    writeCompactString(row->code, file);
+    writeCompactString(row->designation, file);
+    writeCompactString(row->unity, file);
+    writeBinaryNumber(row->quantity, file);
+    writeBinaryNumber(row->basePrice, file);
+    writeBinaryNumber(row->sellingPrice, file);
+    writeBinaryNumber(row->discount, file);
+    writeBinaryNumber(row->rateOfVAT, file);
+}
+
+/** Read a row written by DocumentRow_writeCompactRow() from a file held in memory
+ * @param reader the reader of the file
+ * @param arena the arena receiving the strings of the row, NULL to allocate them with malloc()
+ * @return a new row created on the heap filled with the data
+ */
+DocumentRow * DocumentRow_parseCompactRow(DocumentReader * reader, StringArena * arena)
+{
+    DocumentRow * row = DocumentRow_create();
+
+    DocumentRow_finalize(row);
+    row->arena = arena;
+    row->code = DocumentReader_readCompactString(reader, arena);
+    row->designation = DocumentReader_readCompactString(reader, arena);
+    row->unity = DocumentReader_readCompactString(reader, arena);
+    row->quantity = DocumentReader_readBinaryNumber(reader);
+    row->basePrice = DocumentReader_readBinaryNumber(reader);
+    row->sellingPrice = DocumentReader_readBinaryNumber(reader);
+    row->discount = DocumentReader_readBinaryNumber(reader);
+    row->rateOfVAT = DocumentReader_readBinaryNumber(reader);
+    return row;
+}
+
+/** Set the code of a row, the copy being made in the arena of the row if it has one
+ * @param row the row
+ * @param value the value
+ */
+void DocumentRow_setValue_code(DocumentRow * row, const char * value)
+{
+    DocumentRow_setString(row, &row->code, value);
+}
+
+/** Set the designation of a row, the copy being made in the arena of the row if it has one
+ * @param row the row
+ * @param value the value
+ */
+void DocumentRow_setValue_designation(DocumentRow * row, const char * value)
+{
+    DocumentRow_setString(row, &row->designation, value);
+}
+
+/** Set the unity of a row, the copy being made in the arena of the row if it has one
+ * @param row the row
+ * @param value the value
+ */
+void DocumentRow_setValue_unity(DocumentRow * row, const char * value)
+{
+    DocumentRow_setString(row, &row->unity, value);
+}
+
+/** Compute the exact totals of a list of rows
+ * @param list the pointer on the first cell of the list
+ * @param totals the totals to compute
+ * @return a non null value if all the rows are in the totals, 0 if a row was left out
+ */
+int DocumentRowList_computeTotals(DocumentRow * list, MoneyTotals * totals)
+{
+    Money sellingPrices[DOCUMENTROWLIST_TOTALS_BLOCK];
+    Money discounts[DOCUMENTROWLIST_TOTALS_BLOCK];
+    Money quantities[DOCUMENTROWLIST_TOTALS_BLOCK];
+    Money ratesOfVAT[DOCUMENTROWLIST_TOTALS_BLOCK];
+    int isComplete = 1;
+    int count;
+
+    MoneyTotals_init(totals);
+    while (list != NULL)
+    {
+        for (count = 0; list != NULL && count < DOCUMENTROWLIST_TOTALS_BLOCK; list = list->next)
+        {
+            /* a row with a value which is not a Money is left out rather than aborting */
+            if (Money_tryFromDouble(list->sellingPrice, &sellingPrices[count])
+                    && Money_tryFromDouble(list->discount, &discounts[count])
+                    && Money_tryFromDouble(list->quantity, &quantities[count])
+                    && Money_tryFromDouble(list->rateOfVAT, &ratesOfVAT[count]))
+                ++count;
+            else
+                isComplete = 0;
+        }
+        MoneyTotals_addRows(totals, sellingPrices, discounts, quantities, ratesOfVAT, count);
+    }
+    return isComplete;
+}
+
+/** Get the array of the rows of a list, building it from the links of the rows if the list has none
+ * @param list the pointer on the first cell of the list, not NULL
+ * @return the array of the rows
+ */
+static DocumentRowVector * DocumentRowList_getVector(DocumentRow * list)
+{
+    DocumentRowVector * vector = list->vector;
+    DocumentRow * row;
+
+    if (vector != NULL)
+        return vector;
+
+    vector = malloc(sizeof(DocumentRowVector));
+    if (vector == NULL)
+        fatalError("malloc error : Allocation of the rows of the list failed.");
+    vector->rows = NULL;
+    vector->count = 0;
+    vector->capacity = 0;
+    for (row = list; row != NULL; row = row->next)
+    {
+        DocumentRowList_reserve(vector, vector->count + 1);
+        vector->rows[vector->count++] = row;
+    }
+    list->vector = vector;
+    return vector;
+}
+
+/** Make sure that the array of the rows of a list can hold a number of rows, its capacity doubling if needed
+ * @param vector the array of the rows
+ * @param count the number of rows
+ */
+static void DocumentRowList_reserve(DocumentRowVector * vector, int count)
+{
+    if (count <= vector->capacity)
+        return;
+    vector->capacity = (vector->capacity == 0) ? DOCUMENTROWLIST_INITIAL_CAPACITY : vector->capacity * 2;
+    while (vector->capacity < count)
+        vector->capacity *= 2;
+    vector->rows = realloc(vector->rows, sizeof(DocumentRow *) * (size_t)vector->capacity);
+    if (vector->rows == NULL)
+        fatalError("realloc error : Allocation of the rows of the list failed.");
+}
+
+/** Get the position of a row in a list
+ * @param list the pointer on the first cell of the list
+ * @param row the row
+ * @return the position of the row
+ */
+static int DocumentRowList_find(DocumentRow * list, DocumentRow * row)
+{
+    DocumentRowVector * vector;
+    int rowIndex;
+
+    if (list == NULL)
+        fatalError("Error : List not contains rows.");
+    vector = DocumentRowList_getVector(list);
+    for (rowIndex = 0; rowIndex < vector->count; ++rowIndex)
+        if (vector->rows[rowIndex] == row)
+            return rowIndex;
+    fatalError("Error : List not contains rows position.");
+    return -1;
+}
+
+/** Insert a row at a position of a list
+ * @param list the address of the pointer on the first cell of the list
+ * @param rowIndex the position of the new row, between 0 and the number of rows
+ * @param row the row to insert
+ */
+static void DocumentRowList_insertAt(DocumentRow ** list, int rowIndex, DocumentRow * row)
+{
+    DocumentRowVector * vector;
+
+    if (*list == NULL)
+    {
+        row->next = NULL;
+        row->vector = NULL;
+        *list = row;
+        DocumentRowList_getVector(row);
+        return;
+    }
+
+    vector = DocumentRowList_getVector(*list);
+    (*list)->vector = NULL;
+    DocumentRowList_reserve(vector, vector->count + 1);
+    memmove(vector->rows + rowIndex + 1, vector->rows + rowIndex, sizeof(DocumentRow *) * (size_t)(vector->count - rowIndex));
+    vector->rows[rowIndex] = row;
+    vector->count += 1;
+
+    row->next = (rowIndex + 1 < vector->count) ? vector->rows[rowIndex + 1] : NULL;
+    if (rowIndex > 0)
+        vector->rows[rowIndex - 1]->next = row;
+    *list = vector->rows[0];
+    (*list)->vector = vector;
+}
+
+/** Replace a string of a row
+ * @param row the row
+ * @param field the address of the string
+ * @param value the new value
+ */
+static void DocumentRow_setString(DocumentRow * row, char ** field, const char * value)
+{
+    if (row->arena != NULL)
+        *field = StringArena_duplicate(row->arena, value);
+    else
+    {
+        free(*field);
+        *field = duplicateString(value);
+    }
+}
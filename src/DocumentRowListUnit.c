@@ -86,6 +86,8 @@ static void test_DocumentRowList_readAndWriteRow(void)
 
   file = fopen(BASEPATH "/unittest/documentrowlist-unittest.db", "w+b");
   row = DocumentRow_create();
+  DocumentRow_setValue_designation(row, "Designation");
+  DocumentRow_setValue_unity(row, "kg");
   row->basePrice = 1;
   DocumentRow_writeRow(row, file);
   row->basePrice = 2;
@@ -96,6 +98,8 @@ static void test_DocumentRowList_readAndWriteRow(void)
 
   fseek(file, 0, SEEK_SET);
   row = DocumentRow_readRow(file);
+  ASSERT_EQUAL_STRING(row->designation, "Designation");
+  ASSERT_EQUAL_STRING(row->unity, "kg");
   ASSERT_EQUAL_DOUBLE(row->basePrice, 1);
   DocumentRow_destroy(row);
   row = DocumentRow_readRow(file);
@@ -290,6 +294,116 @@ static void test_DocumentRowList_logic(void)
   disableHooks();
 }
 
+static void test_DocumentRowList_totals(void)
+{
+  DocumentRow * list = NULL;
+  DocumentRow * row;
+  MoneyTotals totals;
+  Money money;
+  double driftingTotal = 0;
+  char buffer[64];
+  int i;
+
+  /* the conversions and the products are rounded to the nearest ten thousandth */
+  ASSERT_EQUAL(Money_fromDouble(12.34567), 123457);
+  ASSERT_EQUAL(Money_fromDouble(-0.00005), -1);
+  ASSERT_EQUAL_DOUBLE(Money_toDouble(123457), 12.3457);
+  ASSERT_EQUAL(Money_multiply(Money_fromDouble(0.3333), Money_fromDouble(3)), 9999);
+  ASSERT_EQUAL(Money_percent(Money_fromDouble(19.99), Money_fromDouble(5.5)), 10995);
+  ASSERT_EQUAL(Money_write(buffer, sizeof(buffer), 123450, 2, 0), 5);
+  ASSERT_EQUAL_STRING(buffer, "12.35");
+  Money_write(buffer, sizeof(buffer), -123449, 2, 8);
+  ASSERT_EQUAL_STRING(buffer, "  -12.34");
+  Money_write(buffer, sizeof(buffer), 5, 4, 0);
+  ASSERT_EQUAL_STRING(buffer, "0.0005");
+
+  /* the products which do not fit on 64 bits are exact, or saturated when the result does not fit */
+  ASSERT_EQUAL(Money_multiply(Money_fromDouble(1e9), Money_fromDouble(1e5)), Money_fromDouble(1e14));
+  ASSERT_EQUAL(Money_multiply(Money_fromDouble(-1e9), Money_fromDouble(1e5)), -Money_fromDouble(1e14));
+  ASSERT_EQUAL(Money_multiply(Money_fromDouble(123456789.0123), Money_fromDouble(1000.5)), 1235185174068062LL);
+  ASSERT_EQUAL(Money_percent(Money_fromDouble(4e14), Money_fromDouble(20)), Money_fromDouble(8e13));
+  ASSERT_EQUAL(Money_multiply(Money_fromDouble(4e14), Money_fromDouble(4e14)), MONEY_MAX);
+  ASSERT_EQUAL(Money_multiply(Money_fromDouble(-4e14), Money_fromDouble(4e14)), -MONEY_MAX);
+
+  /* the values which can not be converted are rejected, not fatal */
+  ASSERT(!Money_tryFromDouble(1e15, &money));
+  ASSERT_EQUAL(money, 0);
+  ASSERT(!Money_tryFromDouble(-1e300, &money));
+  ASSERT(Money_tryFromDouble(1e14, &money));
+  ASSERT_EQUAL(money, 1000000000000000000LL);
+  ASSERT_EQUAL(Money_fromDouble(1e20), 0);
+
+  /* adding many rows does not drift */
+  for (i = 0; i < 100000; ++i)
+  {
+    row = DocumentRow_create();
+    row->quantity = 3;
+    row->sellingPrice = 0.1;
+    row->discount = 0.01;
+    row->rateOfVAT = 19.6;
+    DocumentRowList_pushBack(&list, row);
+    driftingTotal += row->quantity * (row->sellingPrice - row->discount);
+  }
+  ASSERT(DocumentRowList_computeTotals(list, &totals));
+  ASSERT_EQUAL(totals.withoutVAT, Money_fromDouble(27000));
+  /* the VAT of a row, 0.05292, is rounded to 0.0529 */
+  ASSERT_EQUAL(totals.ofVAT, Money_fromDouble(5290));
+  ASSERT_EQUAL(totals.withVAT, Money_fromDouble(32290));
+  Money_write(buffer, sizeof(buffer), totals.withVAT, 2, 0);
+  ASSERT_EQUAL_STRING(buffer, "32290.00");
+  ASSERT(driftingTotal < 27000 || driftingTotal > 27000);
+
+  /* a row whose quantity is too large is left out of the totals */
+  list->quantity = 1e16;
+  ASSERT(!DocumentRowList_computeTotals(list, &totals));
+  ASSERT_EQUAL(totals.withoutVAT, Money_fromDouble(27000) - Money_fromDouble(0.27));
+
+  DocumentRowList_finalize(&list);
+  ASSERT(DocumentRowList_computeTotals(list, &totals));
+  ASSERT_EQUAL(totals.withVAT, 0);
+}
+
+static void test_DocumentRowList_vector(void)
+{
+  DocumentRow * list;
+  DocumentRow * row;
+  int i;
+
+  DocumentRowList_init(&list);
+  for (i = 0; i < 100000; ++i)
+  {
+    row = DocumentRow_create();
+    row->quantity = i;
+    DocumentRowList_pushBack(&list, row);
+  }
+  ASSERT_EQUAL(DocumentRowList_getRowCount(list), 100000);
+  ASSERT_EQUAL_DOUBLE(DocumentRowList_get(list, 99999)->quantity, 99999);
+  ASSERT_EQUAL(DocumentRowList_get(list, 100000), NULL);
+  ASSERT_EQUAL(DocumentRowList_get(list, -1), NULL);
+
+  /* the rows stay linked in the order of their positions */
+  DocumentRowList_removeRow(&list, DocumentRowList_get(list, 0));
+  DocumentRowList_removeRow(&list, DocumentRowList_get(list, 50000));
+  row = DocumentRow_create();
+  row->quantity = -1;
+  DocumentRowList_insertBefore(&list, list, row);
+  ASSERT_EQUAL(list, row);
+  ASSERT_EQUAL(DocumentRowList_getRowCount(list), 99999);
+  for (i = 0, row = list; row != NULL; ++i, row = row->next)
+    ASSERT_EQUAL(DocumentRowList_get(list, i), row);
+  ASSERT_EQUAL(i, 99999);
+  ASSERT_EQUAL_DOUBLE(DocumentRowList_get(list, 50001)->quantity, 50002);
+
+  /* removing the last row empties the list */
+  DocumentRowList_finalize(&list);
+  row = DocumentRow_create();
+  DocumentRowList_insertAfter(&list, NULL, row);
+  ASSERT_EQUAL(DocumentRowList_getRowCount(list), 1);
+  DocumentRowList_removeRow(&list, row);
+  ASSERT_EQUAL(list, NULL);
+  ASSERT_EQUAL(DocumentRowList_getRowCount(list), 0);
+}
+
 void test_DocumentRowList(void)
 {
   BEGIN_TESTS(DocumentRowList)
@@ -299,6 +413,8 @@ void test_DocumentRowList(void)
     RUN_TEST(test_DocumentRowList_readAndWriteRow);
     RUN_TEST(test_DocumentRowList_generic);
     RUN_TEST(test_DocumentRowList_logic);
+    RUN_TEST(test_DocumentRowList_vector);
+    RUN_TEST(test_DocumentRowList_totals);
   }
   END_TESTS
 }
@@ -20,8 +20,17 @@
 #include <Document.h>
 #include <UnitTest.h>
 #include <DocumentRowList.h>
+#include <StringArena.h>
+#include <DocumentReader.h>
+#include <DocumentUtil.h>
+#include <MyString.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
+#include <utime.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <DocumentIndex.h>
 
 void test_Document_all(void)
 {
@@ -45,11 +54,607 @@ void test_Document_all(void)
   Document_finalize(&document);
 }
 
+void test_Document_arena(void)
+{
+  Document document;
+  DocumentRow * row;
+  StringArena * arena;
+  char * large;
+  int i;
+
+  /* a large string does not waste the current block */
+  arena = StringArena_create();
+  ASSERT_EQUAL_STRING(StringArena_duplicate(arena, "abc"), "abc");
+  large = StringArena_allocate(arena, STRINGARENA_BLOCK_SIZE * 2);
+  memset(large, 'x', STRINGARENA_BLOCK_SIZE * 2);
+  ASSERT_EQUAL_STRING(StringArena_duplicate(arena, "def"), "def");
+  ASSERT_EQUAL(arena->blocks->used, 8);
+  ASSERT_EQUAL(arena->blocks->next->size, STRINGARENA_BLOCK_SIZE * 2);
+  ASSERT_EQUAL(StringArena_getAllocatedSize(arena), 8 + STRINGARENA_BLOCK_SIZE * 2);
+  StringArena_destroy(arena);
+
+  Document_init(&document);
+  Document_setValue_docNumber(&document, "D42");
+  Document_setValue_object(&document, "Arena");
+  for (i = 0; i < 1000; ++i)
+  {
+    row = DocumentRow_create();
+    DocumentRow_setValue_code(row, "CODE");
+    row->quantity = i;
+    DocumentRowList_pushBack(&document.rows, row);
+  }
+  Document_saveToFile(&document, BASEPATH "/unittest/document-arena-unittest.db");
+  Document_finalize(&document);
+
+  Document_init(&document);
+  Document_enableArena(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/document-arena-unittest.db");
+  ASSERT(document.arena != NULL);
+  ASSERT_EQUAL_STRING(document.docNumber, "D42");
+  ASSERT_EQUAL_STRING(document.object, "Arena");
+  ASSERT_EQUAL(DocumentRowList_getRowCount(document.rows), 1000);
+  row = DocumentRowList_get(document.rows, 999);
+  ASSERT_EQUAL(row->arena, document.arena);
+  ASSERT_EQUAL_STRING(row->code, "CODE");
+  ASSERT_EQUAL_DOUBLE(row->quantity, 999);
+
+  /* the setters copy into the arena and the new rows keep their own strings */
+  Document_setValue_object(&document, "Changed");
+  DocumentRow_setValue_code(row, "NEWCODE");
+  ASSERT_EQUAL_STRING(document.object, "Changed");
+  ASSERT_EQUAL_STRING(row->code, "NEWCODE");
+  row = DocumentRow_create();
+  DocumentRow_setValue_unity(row, "kg");
+  DocumentRowList_pushBack(&document.rows, row);
+  ASSERT_EQUAL(row->arena, NULL);
+  DocumentRowList_removeRow(&document.rows, DocumentRowList_get(document.rows, 0));
+  Document_finalize(&document);
+  ASSERT_EQUAL(document.arena, NULL);
+}
+
+void test_Document_reader(void)
+{
+  DocumentReader reader;
+  StringArena * arena;
+  FILE * file;
+  char * str;
+
+  file = fopen(BASEPATH "/unittest/document-reader-unittest.db", "wb");
+  ASSERT(file != NULL);
+  writeString("first", file);
+  writeString("", file);
+  writeString("12.50", file);
+  fclose(file);
+
+  ASSERT(DocumentReader_open(&reader, BASEPATH "/unittest/document-reader-unittest.db"));
+  str = DocumentReader_readString(&reader, NULL);
+  ASSERT_EQUAL_STRING(str, "first");
+  free(str);
+  arena = StringArena_create();
+  ASSERT_EQUAL_STRING(DocumentReader_readString(&reader, arena), "");
+  ASSERT(!DocumentReader_isAtEnd(&reader));
+  ASSERT_EQUAL_DOUBLE(DocumentReader_readNumber(&reader), 12.5);
+  ASSERT(DocumentReader_isAtEnd(&reader));
+  StringArena_destroy(arena);
+  DocumentReader_close(&reader);
+
+  ASSERT(!DocumentReader_open(&reader, BASEPATH "/unittest/document-reader-missing.db"));
+
+  /* the fields past the end of a truncated file are empty */
+  file = fopen(BASEPATH "/unittest/document-reader-unittest.db", "wb");
+  ASSERT(file != NULL);
+  writeString("first", file);
+  ASSERT_EQUAL(fwrite("\x30\x00", 2, 1, file), 1);
+  fclose(file);
+  ASSERT(DocumentReader_open(&reader, BASEPATH "/unittest/document-reader-unittest.db"));
+  str = DocumentReader_readString(&reader, NULL);
+  ASSERT_EQUAL_STRING(str, "first");
+  free(str);
+  ASSERT(!reader.isCorrupted);
+  str = DocumentReader_readString(&reader, NULL);
+  ASSERT_EQUAL_STRING(str, "");
+  free(str);
+  ASSERT(reader.isCorrupted);
+  ASSERT(DocumentReader_isAtEnd(&reader));
+  ASSERT_EQUAL_DOUBLE(DocumentReader_readNumber(&reader), 0);
+  ASSERT_EQUAL(DocumentReader_readVarint(&reader), 0);
+  DocumentReader_close(&reader);
+}
+
+void test_Document_tryLoad(void)
+{
+  Document document;
+  FILE * file;
+  char * content;
+  long fileSize;
+
+  Document_init(&document);
+  Document_setValue_docNumber(&document, "TRUNCATED");
+  DocumentRowList_pushBack(&document.rows, DocumentRow_create());
+  Document_saveToFile(&document, BASEPATH "/unittest/document-tryload-unittest.db");
+  Document_finalize(&document);
+
+  file = fopen(BASEPATH "/unittest/document-tryload-unittest.db", "rb");
+  ASSERT(file != NULL);
+  fseek(file, 0, SEEK_END);
+  fileSize = ftell(file);
+  rewind(file);
+  content = malloc((size_t)fileSize);
+  ASSERT_EQUAL(fread(content, 1, (size_t)fileSize, file), (size_t)fileSize);
+  fclose(file);
+
+  Document_init(&document);
+  ASSERT(Document_tryLoadFromFile(&document, BASEPATH "/unittest/document-tryload-unittest.db"));
+  ASSERT_EQUAL_STRING(document.docNumber, "TRUNCATED");
+  ASSERT_EQUAL(DocumentRowList_getRowCount(document.rows), 1);
+  Document_finalize(&document);
+
+  /* a truncated file, an unknown version and a missing file are errors, not fatal errors */
+  file = fopen(BASEPATH "/unittest/document-tryload-unittest.db", "wb");
+  ASSERT_EQUAL(fwrite(content, 1, (size_t)fileSize - 5, file), (size_t)fileSize - 5);
+  fclose(file);
+  Document_init(&document);
+  ASSERT(!Document_tryLoadFromFile(&document, BASEPATH "/unittest/document-tryload-unittest.db"));
+  Document_finalize(&document);
+
+  content[DOCUMENT_MAGIC_SIZE] = 99;
+  file = fopen(BASEPATH "/unittest/document-tryload-unittest.db", "wb");
+  ASSERT_EQUAL(fwrite(content, 1, (size_t)fileSize, file), (size_t)fileSize);
+  fclose(file);
+  Document_init(&document);
+  Document_enableArena(&document);
+  ASSERT(!Document_tryLoadFromFile(&document, BASEPATH "/unittest/document-tryload-unittest.db"));
+  ASSERT_EQUAL_STRING(document.docNumber, "");
+  Document_finalize(&document);
+
+  Document_init(&document);
+  ASSERT(!Document_tryLoadFromFile(&document, BASEPATH "/unittest/document-tryload-missing.db"));
+  Document_finalize(&document);
+  free(content);
+}
+
+void test_Document_format(void)
+{
+  Document document;
+  DocumentRow * row;
+  DocumentRow * oldRow;
+  FILE * file;
+  struct stat status;
+  off_t compactSize;
+  int i;
+
+  Document_init(&document);
+  Document_setValue_docNumber(&document, "COMPACT");
+  document.typeDocument = BILL;
+  for (i = 0; i < 10000; ++i)
+  {
+    row = DocumentRow_create();
+    DocumentRow_setValue_code(row, "CODE");
+    DocumentRow_setValue_designation(row, "Designation");
+    DocumentRow_setValue_unity(row, "kg");
+    row->quantity = i;
+    row->basePrice = 12.25;
+    row->sellingPrice = 15.5;
+    row->discount = 0.75;
+    row->rateOfVAT = 19.6;
+    DocumentRowList_pushBack(&document.rows, row);
+  }
+  Document_saveToFile(&document, BASEPATH "/unittest/document-compact-unittest.db");
+
+  /* the version 1 of the format */
+  file = fopen(BASEPATH "/unittest/document-v1-unittest.db", "wb");
+  ASSERT(file != NULL);
+  CustomerRecord_write(&document.customer, file);
+  writeString(document.editDate, file);
+  writeString(document.expiryDate, file);
+  writeString(document.docNumber, file);
+  writeString(document.object, file);
+  writeString(document.operator, file);
+  for (row = document.rows; row != NULL; row = row->next)
+    DocumentRow_writeRow(row, file);
+  fclose(file);
+  Document_finalize(&document);
+
+  ASSERT(stat(BASEPATH "/unittest/document-compact-unittest.db", &status) == 0);
+  compactSize = status.st_size;
+  ASSERT(stat(BASEPATH "/unittest/document-v1-unittest.db", &status) == 0);
+  /* the compact format saves at least a third of the size of the version 1 */
+  ASSERT(compactSize * 3 < status.st_size * 2);
+
+  /* both versions give the same document, the type being only stored since the version 2 */
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/document-compact-unittest.db");
+  ASSERT_EQUAL(document.typeDocument, BILL);
+  ASSERT_EQUAL_STRING(document.docNumber, "COMPACT");
+  ASSERT_EQUAL(DocumentRowList_getRowCount(document.rows), 10000);
+  {
+    Document oldDocument;
+
+    Document_init(&oldDocument);
+    Document_loadFromFile(&oldDocument, BASEPATH "/unittest/document-v1-unittest.db");
+    ASSERT_EQUAL_STRING(oldDocument.docNumber, "COMPACT");
+    ASSERT_EQUAL(DocumentRowList_getRowCount(oldDocument.rows), 10000);
+    for (row = document.rows, oldRow = oldDocument.rows; row != NULL; row = row->next, oldRow = oldRow->next)
+    {
+      ASSERT_EQUAL_STRING(row->code, oldRow->code);
+      ASSERT_EQUAL_STRING(row->designation, "Designation");
+      ASSERT_EQUAL_STRING(oldRow->designation, "Designation");
+      ASSERT_EQUAL_STRING(row->unity, "kg");
+      ASSERT_EQUAL_STRING(oldRow->unity, "kg");
+      ASSERT_EQUAL_DOUBLE(row->quantity, oldRow->quantity);
+      ASSERT_EQUAL_DOUBLE(row->basePrice, oldRow->basePrice);
+      ASSERT_EQUAL_DOUBLE(row->sellingPrice, oldRow->sellingPrice);
+      ASSERT_EQUAL_DOUBLE(row->discount, oldRow->discount);
+      ASSERT_EQUAL_DOUBLE(row->rateOfVAT, oldRow->rateOfVAT);
+    }
+    Document_finalize(&oldDocument);
+  }
+  Document_finalize(&document);
+}
+
+void test_Document_index(void)
+{
+  Document document;
+  DocumentRow * row;
+  DocumentIndex * documentIndex;
+  DocumentIndex * otherIndex;
+  DocumentIndexEntry * entry;
+  struct utimbuf times;
+  struct timeval microTimes[2];
+  struct stat status;
+  struct stat otherStatus;
+  FILE * file;
+
+  mkdir(BASEPATH "/unittest/index", 0777);
+  remove(BASEPATH "/unittest/index/" DOCUMENTINDEX_FILENAME);
+  remove(BASEPATH "/unittest/index/" DOCUMENTINDEX_JOURNAL_FILENAME);
+  remove(BASEPATH "/unittest/index/bill-G.dat");
+  remove(BASEPATH "/unittest/index/quotation-C.dat");
+  remove(BASEPATH "/unittest/index/bill-D.dat");
+  remove(BASEPATH "/unittest/index/quotation-E.dat");
+  remove(BASEPATH "/unittest/index/bill-F.dat");
+
+  Document_init(&document);
+  Document_setValue_object(&document, "First");
+  row = DocumentRow_create();
+  row->quantity = 2;
+  row->sellingPrice = 10;
+  row->rateOfVAT = 20;
+  DocumentRowList_pushBack(&document.rows, row);
+  Document_setValue_docNumber(&document, "A");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  Document_setValue_docNumber(&document, "B");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-B.dat");
+  Document_finalize(&document);
+
+  /* the documents are loaded once */
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 0);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 2);
+  ASSERT_EQUAL(documentIndex->count, 2);
+  entry = DocumentIndex_find(documentIndex, "bill-B.dat");
+  ASSERT(entry != NULL);
+  ASSERT_EQUAL(entry->typeDocument, BILL);
+  ASSERT_EQUAL_STRING(entry->docNumber, "B");
+  ASSERT_EQUAL_STRING(entry->object, "First");
+  ASSERT_EQUAL(entry->totals.withVAT, Money_fromDouble(24));
+  DocumentIndex_close(documentIndex);
+
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 2);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 0);
+  ASSERT_EQUAL(documentIndex->isModified, 0);
+
+  /* a saved document updates its entry */
+  Document_init(&document);
+  Document_setValue_docNumber(&document, "C");
+  Document_setValue_object(&document, "Saved");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/quotation-C.dat");
+  DocumentIndex_update(documentIndex, "quotation-C.dat", &document);
+  Document_finalize(&document);
+  ASSERT_EQUAL(documentIndex->count, 3);
+  ASSERT_EQUAL_STRING(documentIndex->entries[2].filename, "quotation-C.dat");
+  ASSERT_EQUAL(documentIndex->entries[2].typeDocument, QUOTATION);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 0);
+  DocumentIndex_close(documentIndex);
+
+  /* a changed file is loaded again and a removed one is dropped */
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  Document_setValue_object(&document, "Changed");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  Document_finalize(&document);
+  times.actime = time(NULL) + 10;
+  times.modtime = times.actime;
+  utime(BASEPATH "/unittest/index/bill-A.dat", &times);
+  remove(BASEPATH "/unittest/index/bill-B.dat");
+
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 3);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 1);
+  ASSERT_EQUAL(documentIndex->count, 2);
+  ASSERT_EQUAL(DocumentIndex_find(documentIndex, "bill-B.dat"), NULL);
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-A.dat")->object, "Changed");
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "quotation-C.dat")->object, "Saved");
+  DocumentIndex_close(documentIndex);
+
+  /* a file rewritten with the same size within the same second is loaded again */
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  Document_setValue_object(&document, "Changes");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  Document_finalize(&document);
+  microTimes[0].tv_sec = times.actime;
+  microTimes[0].tv_usec = 500000;
+  microTimes[1] = microTimes[0];
+  utimes(BASEPATH "/unittest/index/bill-A.dat", microTimes);
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 1);
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-A.dat")->object, "Changes");
+  DocumentIndex_close(documentIndex);
+
+  /* a truncated index file or a corrupted count of entries is discarded and rebuilt */
+  ASSERT(stat(BASEPATH "/unittest/index/" DOCUMENTINDEX_FILENAME, &status) == 0);
+  ASSERT(truncate(BASEPATH "/unittest/index/" DOCUMENTINDEX_FILENAME, status.st_size - 3) == 0);
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 0);
+  ASSERT_EQUAL(documentIndex->isModified, 1);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 2);
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "quotation-C.dat")->object, "Saved");
+  DocumentIndex_close(documentIndex);
+
+  file = fopen(BASEPATH "/unittest/index/" DOCUMENTINDEX_FILENAME, "wb");
+  ASSERT(file != NULL);
+  ASSERT_EQUAL(fwrite(DOCUMENTINDEX_MAGIC, DOCUMENTINDEX_MAGIC_SIZE, 1, file), 1);
+  fputc(DOCUMENTINDEX_FORMAT_VERSION, file);
+  writeVarint((size_t)1 << 40, file);
+  fclose(file);
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 0);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 2);
+  DocumentIndex_close(documentIndex);
+  /* an index opened before a document is saved does not undo its update when it is closed */
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  otherIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  Document_setValue_object(&document, "Updated");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-A.dat");
+  microTimes[0].tv_sec = times.actime + 1;
+  microTimes[0].tv_usec = 0;
+  microTimes[1] = microTimes[0];
+  utimes(BASEPATH "/unittest/index/bill-A.dat", microTimes);
+  DocumentIndex_update(otherIndex, "bill-A.dat", &document);
+  Document_setValue_object(&document, "New");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-D.dat");
+  DocumentIndex_update(otherIndex, "bill-D.dat", &document);
+  DocumentIndex_close(otherIndex);
+  Document_setValue_object(&document, "Other");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/quotation-E.dat");
+  DocumentIndex_update(documentIndex, "quotation-E.dat", &document);
+  Document_finalize(&document);
+  DocumentIndex_close(documentIndex);
+
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 4);
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-A.dat")->object, "Updated");
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-D.dat")->object, "New");
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "quotation-E.dat")->object, "Other");
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 0);
+  DocumentIndex_close(documentIndex);
+
+  /* a saved document only appends its entry to the journal, which is folded into the index file by the next save */
+  ASSERT(stat(BASEPATH "/unittest/index/" DOCUMENTINDEX_FILENAME, &status) == 0);
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/index/bill-D.dat");
+  Document_setValue_object(&document, "Journaled");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-D.dat");
+  ASSERT(DocumentIndex_record(BASEPATH "/unittest/index", "bill-D.dat", &document));
+  Document_setValue_object(&document, "Recorded");
+  Document_saveToFile(&document, BASEPATH "/unittest/index/bill-G.dat");
+  ASSERT(DocumentIndex_record(BASEPATH "/unittest/index", "bill-G.dat", &document));
+  Document_finalize(&document);
+  ASSERT(stat(BASEPATH "/unittest/index/" DOCUMENTINDEX_FILENAME, &otherStatus) == 0);
+  ASSERT_EQUAL(otherStatus.st_size, status.st_size);
+  ASSERT_EQUAL(otherStatus.st_mtime, status.st_mtime);
+
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 5);
+  ASSERT_EQUAL(documentIndex->isModified, 1);
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-D.dat")->object, "Journaled");
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-G.dat")->object, "Recorded");
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 0);
+  DocumentIndex_close(documentIndex);
+  ASSERT(stat(BASEPATH "/unittest/index/" DOCUMENTINDEX_JOURNAL_FILENAME, &otherStatus) != 0);
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(documentIndex->count, 5);
+  ASSERT_EQUAL(documentIndex->isModified, 0);
+  ASSERT_EQUAL_STRING(DocumentIndex_find(documentIndex, "bill-G.dat")->object, "Recorded");
+  DocumentIndex_close(documentIndex);
+  remove(BASEPATH "/unittest/index/bill-G.dat");
+
+  /* a truncated document does not stop the refresh, it is left out and read again by the next one */
+  file = fopen(BASEPATH "/unittest/index/bill-F.dat", "wb");
+  ASSERT(file != NULL);
+  ASSERT_EQUAL(fwrite(DOCUMENT_MAGIC, DOCUMENT_MAGIC_SIZE, 1, file), 1);
+  fputc(DOCUMENT_FORMAT_VERSION, file);
+  fputc(BILL, file);
+  fputc(100, file);
+  fclose(file);
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/index");
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 1);
+  ASSERT_EQUAL(documentIndex->count, 5);
+  entry = DocumentIndex_find(documentIndex, "bill-F.dat");
+  ASSERT(entry != NULL);
+  ASSERT_EQUAL_STRING(entry->docNumber, "");
+  ASSERT_EQUAL(entry->modificationTime, -1);
+  ASSERT_EQUAL(DocumentIndex_refresh(documentIndex), 1);
+  DocumentIndex_close(documentIndex);
+
+  remove(BASEPATH "/unittest/index/bill-D.dat");
+  remove(BASEPATH "/unittest/index/quotation-E.dat");
+  remove(BASEPATH "/unittest/index/bill-F.dat");
+}
+
+void test_Document_header(void)
+{
+  Document document;
+  MoneyTotals totals;
+  MoneyTotals expectedTotals;
+  char object[DOCUMENT_HEADER_READ_SIZE * 2];
+  FILE * file;
+
+  /* the files written by test_Document_format() */
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/document-compact-unittest.db");
+  DocumentRowList_computeTotals(document.rows, &expectedTotals);
+  Document_finalize(&document);
+
+  Document_init(&document);
+  ASSERT_EQUAL(Document_loadHeaderFromFile(&document, BASEPATH "/unittest/document-compact-unittest.db", &totals), 10000);
+  ASSERT_EQUAL(document.rows, NULL);
+  ASSERT_EQUAL(document.typeDocument, BILL);
+  ASSERT_EQUAL_STRING(document.docNumber, "COMPACT");
+  ASSERT_EQUAL(totals.withVAT, expectedTotals.withVAT);
+  ASSERT_EQUAL(totals.ofVAT, expectedTotals.ofVAT);
+  ASSERT_EQUAL(Document_loadHeaderFromFile(&document, BASEPATH "/unittest/document-v1-unittest.db", &totals), 10000);
+  ASSERT_EQUAL(document.rows, NULL);
+  ASSERT_EQUAL_STRING(document.docNumber, "COMPACT");
+  ASSERT_EQUAL(totals.withVAT, expectedTotals.withVAT);
+  Document_finalize(&document);
+
+  /* the rows are never read: the first bytes of the file are enough to load the header */
+  file = fopen(BASEPATH "/unittest/document-compact-unittest.db", "rb");
+  ASSERT(file != NULL);
+  ASSERT_EQUAL(fread(object, 1, DOCUMENT_HEADER_READ_SIZE, file), DOCUMENT_HEADER_READ_SIZE);
+  fclose(file);
+  file = fopen(BASEPATH "/unittest/document-prefix-unittest.db", "wb");
+  ASSERT(file != NULL);
+  ASSERT_EQUAL(fwrite(object, 1, DOCUMENT_HEADER_READ_SIZE, file), DOCUMENT_HEADER_READ_SIZE);
+  fclose(file);
+  Document_init(&document);
+  ASSERT(!Document_tryLoadFromFile(&document, BASEPATH "/unittest/document-prefix-unittest.db"));
+  Document_finalize(&document);
+  Document_init(&document);
+  ASSERT_EQUAL(Document_loadHeaderFromFile(&document, BASEPATH "/unittest/document-prefix-unittest.db", &totals), 10000);
+  ASSERT_EQUAL(document.rows, NULL);
+  ASSERT_EQUAL_STRING(document.docNumber, "COMPACT");
+  ASSERT_EQUAL(totals.withVAT, expectedTotals.withVAT);
+  Document_finalize(&document);
+
+  /* a header longer than the first read */
+  memset(object, 'o', sizeof(object) - 1);
+  object[sizeof(object) - 1] = '\0';
+  Document_init(&document);
+  Document_setValue_object(&document, object);
+  DocumentRowList_pushBack(&document.rows, DocumentRow_create());
+  Document_saveToFile(&document, BASEPATH "/unittest/document-header-unittest.db");
+  Document_finalize(&document);
+  Document_init(&document);
+  ASSERT_EQUAL(Document_loadHeaderFromFile(&document, BASEPATH "/unittest/document-header-unittest.db", &totals), 1);
+  ASSERT_EQUAL_STRING(document.object, object);
+  Document_finalize(&document);
+}
+
+/** The number of documents of the parallel index test */
+#define DOCUMENTUNIT_PARALLEL_COUNT 200
+
+/** What the listener of the parallel index test received */
+typedef struct
+{
+  int count; /**< The number of entries received */
+  int batchCount; /**< The number of calls */
+  int seen[DOCUMENTUNIT_PARALLEL_COUNT]; /**< The number of times each document was received */
+  int lastDocument; /**< The number of the last document received */
+} DocumentUnitListener;
+
+/** Count the entries given by a refresh
+ * @param entries the entries
+ * @param count the number of entries
+ * @param data the DocumentUnitListener
+ */
+static void test_Document_listen(const DocumentIndexEntry * entries, int count, void * data)
+{
+  DocumentUnitListener * listener = data;
+  int i;
+
+  ASSERT(count > 0 && count <= DOCUMENTINDEX_BATCH_SIZE);
+  listener->batchCount += 1;
+  for (i = 0; i < count; ++i)
+  {
+    listener->lastDocument = atoi(entries[i].docNumber);
+    listener->seen[listener->lastDocument] += 1;
+    listener->count += 1;
+  }
+}
+
+void test_Document_parallelIndex(void)
+{
+  Document document;
+  DocumentIndex * documentIndex;
+  DocumentUnitListener listener;
+  struct utimbuf times;
+  char filename[256];
+  char docNumber[16];
+  int i;
+
+  mkdir(BASEPATH "/unittest/parallel", 0777);
+  remove(BASEPATH "/unittest/parallel/" DOCUMENTINDEX_FILENAME);
+
+  Document_init(&document);
+  DocumentRowList_pushBack(&document.rows, DocumentRow_create());
+  for (i = 0; i < DOCUMENTUNIT_PARALLEL_COUNT; ++i)
+  {
+    sprintf(docNumber, "%d", i);
+    sprintf(filename, BASEPATH "/unittest/parallel/%s-%d.dat", (i % 2 == 0) ? "bill" : "quotation", i);
+    Document_setValue_docNumber(&document, docNumber);
+    Document_saveToFile(&document, filename);
+  }
+  Document_finalize(&document);
+
+  /* every document is loaded by the workers and given once to the listener */
+  memset(&listener, 0, sizeof(listener));
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/parallel");
+  ASSERT_EQUAL(DocumentIndex_refreshWith(documentIndex, 4, test_Document_listen, &listener), DOCUMENTUNIT_PARALLEL_COUNT);
+  ASSERT_EQUAL(documentIndex->count, DOCUMENTUNIT_PARALLEL_COUNT);
+  ASSERT_EQUAL(listener.count, DOCUMENTUNIT_PARALLEL_COUNT);
+  ASSERT(listener.batchCount >= DOCUMENTUNIT_PARALLEL_COUNT / DOCUMENTINDEX_BATCH_SIZE);
+  for (i = 0; i < DOCUMENTUNIT_PARALLEL_COUNT; ++i)
+    ASSERT_EQUAL(listener.seen[i], 1);
+  sprintf(filename, "quotation-%d.dat", DOCUMENTUNIT_PARALLEL_COUNT - 1);
+  ASSERT_EQUAL(DocumentIndex_find(documentIndex, filename)->typeDocument, QUOTATION);
+  DocumentIndex_close(documentIndex);
+
+  /* the unchanged entries are given before the loaded ones */
+  times.actime = time(NULL) + 10;
+  times.modtime = times.actime;
+  utime(BASEPATH "/unittest/parallel/bill-0.dat", &times);
+  memset(&listener, 0, sizeof(listener));
+  documentIndex = DocumentIndex_open(BASEPATH "/unittest/parallel");
+  ASSERT_EQUAL(DocumentIndex_refreshWith(documentIndex, 0, test_Document_listen, &listener), 1);
+  ASSERT_EQUAL(listener.count, DOCUMENTUNIT_PARALLEL_COUNT);
+  ASSERT_EQUAL(listener.lastDocument, 0);
+  DocumentIndex_close(documentIndex);
+
+  for (i = 0; i < DOCUMENTUNIT_PARALLEL_COUNT; ++i)
+  {
+    sprintf(filename, BASEPATH "/unittest/parallel/%s-%d.dat", (i % 2 == 0) ? "bill" : "quotation", i);
+    remove(filename);
+  }
+}
+
 void test_Document(void)
 {
   BEGIN_TESTS(Document)
   {
     RUN_TEST(test_Document_all);
+    RUN_TEST(test_Document_arena);
+    RUN_TEST(test_Document_reader);
+    RUN_TEST(test_Document_tryLoad);
+    RUN_TEST(test_Document_format);
+    RUN_TEST(test_Document_header);
+    RUN_TEST(test_Document_index);
+    RUN_TEST(test_Document_parallelIndex);
   }
   END_TESTS
 }
@@ -153,6 +153,95 @@ char * IMPLEMENT(readString)(FILE * file)
     return newString;
 }
 
+/** Write an unsigned integer in a binary file using 7 bits per byte, the lowest bits first
+ * @param value the integer
+ * @param file the file
+ */
+void writeVarint(size_t value, FILE * file)
+{
+    unsigned char bytes[sizeof(size_t) * 8 / 7 + 1];
+    size_t count = 0;
+
+    while (value >= 0x80)
+    {
+        bytes[count++] = (unsigned char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (unsigned char)value;
+
+    if (fwrite(bytes, count, 1, file) < 1)
+        fatalError("fwrite error : return value is not valid.");
+}
+
+/** Get the number of bytes written by writeVarint() for an integer
+ * @param value the integer
+ * @return the number of bytes
+ */
+size_t getVarintSize(size_t value)
+{
+    size_t size = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size += 1;
+    }
+    return size;
+}
+
+/** Get the number of bytes written by writeCompactString() for a string
+ * @param str the string
+ * @return the number of bytes
+ */
+size_t getCompactStringSize(const char * str)
+{
+    size_t length = stringLength(str);
+
+    return getVarintSize(length) + length;
+}
+
+/** Write a string in a binary file with its length written by writeVarint()
+ * @param str the string
+ * @param file the file
+ */
+void writeCompactString(const char * str, FILE * file)
+{
+    size_t length = stringLength(str);
+
+    writeVarint(length, file);
+    if (length != 0 && fwrite(str, length, 1, file) < 1)
+        fatalError("fwrite error : return value is not valid.");
+}
+
+/** Write an integer in a binary file on 8 bytes, the lowest byte first
+ * @param value the integer
+ * @param file the file
+ */
+void writeBinaryInteger(long long value, FILE * file)
+{
+    unsigned long long bits = (unsigned long long)value;
+    unsigned char bytes[8];
+    int i;
+
+    for (i = 0; i < 8; ++i)
+        bytes[i] = (unsigned char)(bits >> (8 * i));
+
+    if (fwrite(bytes, sizeof(bytes), 1, file) < 1)
+        fatalError("fwrite error : return value is not valid.");
+}
+
+/** Write a number in a binary file as its 8 bytes IEEE 754 representation, the lowest byte first
+ * @param value the number
+ * @param file the file
+ */
+void writeBinaryNumber(double value, FILE * file)
+{
+    long long bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    writeBinaryInteger(bits, file);
+}
+
 
 /** Count the number of letter in integer
  * @param id the number to count
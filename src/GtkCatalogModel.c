@@ -33,6 +33,18 @@ static void GtkCatalogModel_init(GtkCatalogModel *pkg_tree);
 static void GtkCatalogModel_class_init(GtkCatalogModelClass *klass);
 static void GtkCatalogModel_tree_model_init(GtkTreeModelIface *iface);
 static void GtkCatalogModel_finalize(GObject *object);
+static char ** GtkCatalogModel_load_row(GtkCatalogModel *custom_list, gint recordNum);
+static void GtkCatalogModel_sortable_init(GtkTreeSortableIface *iface);
+static gboolean GtkCatalogModel_get_sort_column_id(GtkTreeSortable *sortable, gint *sort_column_id,
+        GtkSortType *order);
+static void GtkCatalogModel_set_sort_column_id(GtkTreeSortable *sortable, gint sort_column_id,
+        GtkSortType order);
+static void GtkCatalogModel_set_sort_func(GtkTreeSortable *sortable, gint sort_column_id,
+        GtkTreeIterCompareFunc sort_func, gpointer user_data, GDestroyNotify destroy);
+static void GtkCatalogModel_set_default_sort_func(GtkTreeSortable *sortable,
+        GtkTreeIterCompareFunc sort_func, gpointer user_data, GDestroyNotify destroy);
+static gboolean GtkCatalogModel_has_default_sort_func(GtkTreeSortable *sortable);
+static void GtkCatalogModel_drop_snapshot(GtkCatalogModel *custom_list);
 static GtkTreeModelFlags GtkCatalogModel_get_flags(GtkTreeModel *tree_model);
 static gint GtkCatalogModel_get_n_columns(GtkTreeModel *tree_model);
 static GType GtkCatalogModel_get_column_type(GtkTreeModel *tree_model, gint recordIndex);
@@ -71,6 +83,8 @@ GType GtkCatalogModel_get_type(void) {
         (GInstanceInitFunc) GtkCatalogModel_init, NULL };
         static const GInterfaceInfo tree_model_info = {
                 (GInterfaceInitFunc) GtkCatalogModel_tree_model_init, NULL, NULL };
+        static const GInterfaceInfo tree_sortable_info = {
+                (GInterfaceInitFunc) GtkCatalogModel_sortable_init, NULL, NULL };
 
         /* First register the new derived type with the GObject type system */
         GtkCatalogModel_type = g_type_register_static(G_TYPE_OBJECT, "GtkCatalogModel",
@@ -78,6 +92,9 @@ GType GtkCatalogModel_get_type(void) {
 
         /* Now register our GtkTreeModel interface with the type system */
         g_type_add_interface_static(GtkCatalogModel_type, GTK_TYPE_TREE_MODEL, &tree_model_info);
+
+        /* The rows are sorted by the model itself, using an in-memory snapshot of the catalog */
+        g_type_add_interface_static(GtkCatalogModel_type, GTK_TYPE_TREE_SORTABLE, &tree_sortable_info);
     }
     return GtkCatalogModel_type;
 }
@@ -135,6 +152,11 @@ static void GtkCatalogModel_init(GtkCatalogModel *custom_list) {
     custom_list->catalogDB = NULL;
     custom_list->shouldCloseDB = FALSE;
     custom_list->stamp = (gint) g_random_int(); /* Random int to check whether an iter belongs to our model */
+    RowCache_init(&custom_list->rowCache, ROWCACHE_DEFAULT_CAPACITY, CATALOGRECORD_FIELDCOUNT);
+    custom_list->snapshot = NULL;
+    custom_list->rows = NULL;
+    custom_list->sortColumn = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+    custom_list->sortOrder = GTK_SORT_ASCENDING;
 
 }
 
@@ -152,6 +174,14 @@ static void GtkCatalogModel_finalize(GObject *object) {
 
     custom_list->catalogDB = NULL;
 
+    g_debug("GtkCatalogModel: row cache hit ratio %.1f%% (%lu hits, %lu misses)",
+            100.0 * RowCache_getHitRatio(&custom_list->rowCache),
+            custom_list->rowCache.hits, custom_list->rowCache.misses);
+    RowCache_finalize(&custom_list->rowCache);
+    GtkCatalogModel_drop_snapshot(custom_list);
+    g_free(custom_list->rows);
+    custom_list->rows = NULL;
+
     /* must chain up - finalize parent */
     (*parent_class->finalize)(object);
 }
@@ -275,7 +305,7 @@ static void GtkCatalogModel_get_value(GtkTreeModel *tree_model, GtkTreeIter *ite
         GValue *value) {
     GtkCatalogModel *custom_list;
     gint recordNum;
-    char * content;
+    char ** values;
 
     g_return_if_fail (GTKCATALOGMODEL_IS_LIST (tree_model));
     custom_list = GTKCATALOGMODEL(tree_model);
@@ -290,9 +320,34 @@ static void GtkCatalogModel_get_value(GtkTreeModel *tree_model, GtkTreeIter *ite
     if (recordNum >= CatalogDB_getRecordCount(custom_list->catalogDB))
         g_return_if_reached();
 
-    content = CatalogDB_getFieldValueAsString(custom_list->catalogDB, recordNum, column);
-    g_value_set_string(value, content);
-    free(content);
+    /* the iter gives the row which displays the record */
+    recordNum = GtkCatalogModel_get_record_index(custom_list, recordNum);
+
+    /* a row is drawn one cell at a time: the record is decoded once for all its columns */
+    values = RowCache_find(&custom_list->rowCache, recordNum);
+    if (values == NULL)
+        values = GtkCatalogModel_load_row(custom_list, recordNum);
+    g_value_set_string(value, values[column]);
+}
+
+/*****************************************************************************
+ *
+ *  GtkCatalogModel_load_row: reads a record and stores the strings of all
+ *                        its columns in the row cache
+ *
+ *****************************************************************************/
+
+static char ** GtkCatalogModel_load_row(GtkCatalogModel *custom_list, gint recordNum) {
+    char ** values = RowCache_add(&custom_list->rowCache, recordNum);
+    CatalogRecord record;
+    int field;
+
+    CatalogRecord_init(&record);
+    CatalogDB_readRecord(custom_list->catalogDB, recordNum, &record);
+    for (field = 0; field < CATALOGRECORD_FIELDCOUNT; ++field)
+        values[field] = (*CatalogRecord_getFieldProperties(field).getValue)(&record);
+    CatalogRecord_finalize(&record);
+    return values;
 }
 
 /*****************************************************************************
@@ -473,19 +528,28 @@ void GtkCatalogModel_append_record(GtkCatalogModel * custom_list) {
     GtkTreeIter iter;
     GtkTreePath *path;
     CatalogRecord record;
+    gint count;
 
     g_return_if_fail (GTKCATALOGMODEL_IS_LIST(custom_list));
 
     CatalogRecord_init(&record);
     if (CatalogRecord_edit(&record)) {
         CatalogDB_appendRecord(custom_list->catalogDB, &record);
+        count = CatalogDB_getRecordCount(custom_list->catalogDB);
+
+        /* the new record is displayed at the end, even if the rows are sorted */
+        GtkCatalogModel_drop_snapshot(custom_list);
+        if (custom_list->rows != NULL) {
+            custom_list->rows = g_renew(int, custom_list->rows, count);
+            custom_list->rows[count - 1] = count - 1;
+        }
 
         /* inform the tree view and other interested objects
          * (e.g. tree row references) that we have inserted
          * a new row, and where it was inserted */
 
         path = gtk_tree_path_new();
-        gtk_tree_path_append_index(path, CatalogDB_getRecordCount(custom_list->catalogDB) - 1);
+        gtk_tree_path_append_index(path, count - 1);
 
         GtkCatalogModel_get_iter(GTK_TREE_MODEL(custom_list), &iter, path);
 
@@ -499,18 +563,36 @@ void GtkCatalogModel_append_record(GtkCatalogModel * custom_list) {
 void GtkCatalogModel_remove_record(GtkCatalogModel * custom_list, gint recordIndex) {
     if (CatalogDB_getRecordCount(custom_list->catalogDB) > 0) {
         GtkTreePath *path;
+        gint row = recordIndex;
+        gint count;
+        gint i;
 
         g_return_if_fail (GTKCATALOGMODEL_IS_LIST(custom_list));
         g_return_if_fail (recordIndex < CatalogDB_getRecordCount(custom_list->catalogDB));
 
+        CatalogDB_removeRecord(custom_list->catalogDB, recordIndex);
+        /* the following records moved */
+        RowCache_clear(&custom_list->rowCache);
+        GtkCatalogModel_drop_snapshot(custom_list);
+
+        /* forget the row of the record, the rows of the following records now display the previous positions */
+        if (custom_list->rows != NULL) {
+            count = CatalogDB_getRecordCount(custom_list->catalogDB);
+            for (i = 0; i <= count; ++i)
+                if (custom_list->rows[i] == recordIndex)
+                    row = i;
+            memmove(custom_list->rows + row, custom_list->rows + row + 1, sizeof(int) * (size_t) (count - row));
+            for (i = 0; i < count; ++i)
+                if (custom_list->rows[i] > recordIndex)
+                    custom_list->rows[i] -= 1;
+        }
+
         path = gtk_tree_path_new();
-        gtk_tree_path_append_index(path, CatalogDB_getRecordCount(custom_list->catalogDB)-1);
+        gtk_tree_path_append_index(path, row);
 
         gtk_tree_model_row_deleted(GTK_TREE_MODEL(custom_list), path);
 
         gtk_tree_path_free(path);
-
-        CatalogDB_removeRecord(custom_list->catalogDB, recordIndex);
     }
 }
 
@@ -518,6 +600,8 @@ void GtkCatalogModel_change_record(GtkCatalogModel * custom_list, gint recordInd
     GtkTreeIter iter;
     GtkTreePath *path;
     CatalogRecord record;
+    gint row = recordIndex;
+    gint i;
 
     g_return_if_fail (GTKCATALOGMODEL_IS_LIST(custom_list));
     g_return_if_fail (recordIndex < CatalogDB_getRecordCount(custom_list->catalogDB));
@@ -526,13 +610,21 @@ void GtkCatalogModel_change_record(GtkCatalogModel * custom_list, gint recordInd
     CatalogDB_readRecord(custom_list->catalogDB, recordIndex, &record);
     if (CatalogRecord_edit(&record)) {
         CatalogDB_writeRecord(custom_list->catalogDB, recordIndex, &record);
+        RowCache_invalidate(&custom_list->rowCache, recordIndex);
+        /* the row keeps its place until the rows are sorted again */
+        GtkCatalogModel_drop_snapshot(custom_list);
+
+        if (custom_list->rows != NULL)
+            for (i = 0; i < CatalogDB_getRecordCount(custom_list->catalogDB); ++i)
+                if (custom_list->rows[i] == recordIndex)
+                    row = i;
 
         /* inform the tree view and other interested objects
          * (e.g. tree row references) that we have inserted
          * a new row, and where it was inserted */
 
         path = gtk_tree_path_new();
-        gtk_tree_path_append_index(path, recordIndex);
+        gtk_tree_path_append_index(path, row);
 
         GtkCatalogModel_get_iter(GTK_TREE_MODEL(custom_list), &iter, path);
 
@@ -543,4 +635,132 @@ void GtkCatalogModel_change_record(GtkCatalogModel * custom_list, gint recordInd
     CatalogRecord_finalize(&record);
 }
 
+gint GtkCatalogModel_get_record_index(GtkCatalogModel * custom_list, gint row) {
+    if (custom_list->rows == NULL)
+        return row;
+    return custom_list->rows[row];
+}
+
+/*****************************************************************************
+ *
+ *  GtkCatalogModel_sortable_init: init callback for the GtkTreeSortable
+ *                             interface. Sorting is done by the model so
+ *                             that the records are compared in memory
+ *                             instead of through get_value.
+ *
+ *****************************************************************************/
+
+static void GtkCatalogModel_sortable_init(GtkTreeSortableIface *iface) {
+    iface->get_sort_column_id = GtkCatalogModel_get_sort_column_id;
+    iface->set_sort_column_id = GtkCatalogModel_set_sort_column_id;
+    iface->set_sort_func = GtkCatalogModel_set_sort_func;
+    iface->set_default_sort_func = GtkCatalogModel_set_default_sort_func;
+    iface->has_default_sort_func = GtkCatalogModel_has_default_sort_func;
+}
+
+static gboolean GtkCatalogModel_get_sort_column_id(GtkTreeSortable *sortable, gint *sort_column_id,
+        GtkSortType *order) {
+    GtkCatalogModel *custom_list;
+
+    g_return_val_if_fail (GTKCATALOGMODEL_IS_LIST(sortable), FALSE);
+    custom_list = GTKCATALOGMODEL(sortable);
+
+    if (sort_column_id)
+        *sort_column_id = custom_list->sortColumn;
+    if (order)
+        *order = custom_list->sortOrder;
+
+    return custom_list->sortColumn >= 0;
+}
+
+/*****************************************************************************
+ *
+ *  GtkCatalogModel_set_sort_column_id: sorts the rows using the order of the
+ *                             records given by the snapshot of the catalog
+ *                             and tells the view where each row moved.
+ *
+ *****************************************************************************/
+
+static void GtkCatalogModel_set_sort_column_id(GtkTreeSortable *sortable, gint sort_column_id,
+        GtkSortType order) {
+    GtkCatalogModel *custom_list;
+    GtkTreePath *path;
+    gint count;
+    gint row;
+    int * rows = NULL;
+    gint * oldRows;
+    gint * newOrder;
+
+    g_return_if_fail (GTKCATALOGMODEL_IS_LIST(sortable));
+    custom_list = GTKCATALOGMODEL(sortable);
+    count = CatalogDB_getRecordCount(custom_list->catalogDB);
+
+    if (sort_column_id >= CATALOGRECORD_FIELDCOUNT)
+        return;
+
+    if (sort_column_id >= 0 && count > 0) {
+        const int * sorted;
+
+        if (custom_list->snapshot == NULL)
+            custom_list->snapshot = CatalogSnapshot_create(custom_list->catalogDB);
+        sorted = CatalogSnapshot_getOrder(custom_list->snapshot, sort_column_id);
+
+        rows = g_new(int, count);
+        for (row = 0; row < count; ++row)
+            rows[row] = sorted[(order == GTK_SORT_ASCENDING) ? row : count - 1 - row];
+    }
+
+    /* newOrder[newRow] is the row where the record of newRow was displayed */
+    oldRows = g_new(gint, count + 1);
+    newOrder = g_new(gint, count + 1);
+    for (row = 0; row < count; ++row)
+        oldRows[GtkCatalogModel_get_record_index(custom_list, row)] = row;
+    for (row = 0; row < count; ++row)
+        newOrder[row] = oldRows[(rows != NULL) ? rows[row] : row];
+
+    g_free(custom_list->rows);
+    custom_list->rows = rows;
+    custom_list->sortColumn = sort_column_id;
+    custom_list->sortOrder = order;
+
+    gtk_tree_sortable_sort_column_changed(sortable);
+
+    if (count > 0) {
+        path = gtk_tree_path_new();
+        gtk_tree_model_rows_reordered(GTK_TREE_MODEL(custom_list), path, NULL, newOrder);
+        gtk_tree_path_free(path);
+    }
+
+    g_free(oldRows);
+    g_free(newOrder);
+}
+
+static void GtkCatalogModel_set_sort_func(GtkTreeSortable * UNUSED(sortable), gint UNUSED(sort_column_id),
+        GtkTreeIterCompareFunc UNUSED(sort_func), gpointer UNUSED(user_data), GDestroyNotify UNUSED(destroy)) {
+    g_warning("GtkCatalogModel: custom sort functions are not supported");
+}
+
+static void GtkCatalogModel_set_default_sort_func(GtkTreeSortable * UNUSED(sortable),
+        GtkTreeIterCompareFunc UNUSED(sort_func), gpointer UNUSED(user_data), GDestroyNotify UNUSED(destroy)) {
+    g_warning("GtkCatalogModel: custom sort functions are not supported");
+}
+
+static gboolean GtkCatalogModel_has_default_sort_func(GtkTreeSortable * UNUSED(sortable)) {
+    return FALSE;
+}
+
+/*****************************************************************************
+ *
+ *  GtkCatalogModel_drop_snapshot: the snapshot does not follow the changes
+ *                             of the database, it is created again by the
+ *                             next sort.
+ *
+ *****************************************************************************/
+
+static void GtkCatalogModel_drop_snapshot(GtkCatalogModel *custom_list) {
+    if (custom_list->snapshot != NULL)
+        CatalogSnapshot_destroy(custom_list->snapshot);
+    custom_list->snapshot = NULL;
+}
+
 /** @} */
@@ -33,6 +33,7 @@ static void GtkCustomerModel_init(GtkCustomerModel *pkg_tree);
 static void GtkCustomerModel_class_init(GtkCustomerModelClass *klass);
 static void GtkCustomerModel_tree_model_init(GtkTreeModelIface *iface);
 static void GtkCustomerModel_finalize(GObject *object);
+static char ** GtkCustomerModel_load_row(GtkCustomerModel *custom_list, gint recordNum);
 static GtkTreeModelFlags GtkCustomerModel_get_flags(GtkTreeModel *tree_model);
 static gint GtkCustomerModel_get_n_columns(GtkTreeModel *tree_model);
 static GType GtkCustomerModel_get_column_type(GtkTreeModel *tree_model,
@@ -147,6 +148,7 @@ static void GtkCustomerModel_init(GtkCustomerModel *custom_list) {
     custom_list->clientDB = NULL;
     custom_list->shouldCloseDB = FALSE;
     custom_list->stamp = (gint) g_random_int(); /* Random int to check whether an iter belongs to our model */
+    RowCache_init(&custom_list->rowCache, ROWCACHE_DEFAULT_CAPACITY, CUSTOMERRECORD_FIELDCOUNT);
 
 }
 
@@ -164,6 +166,11 @@ static void GtkCustomerModel_finalize(GObject *object) {
 
     custom_list->clientDB = NULL;
 
+    g_debug("GtkCustomerModel: row cache hit ratio %.1f%% (%lu hits, %lu misses)",
+            100.0 * RowCache_getHitRatio(&custom_list->rowCache),
+            custom_list->rowCache.hits, custom_list->rowCache.misses);
+    RowCache_finalize(&custom_list->rowCache);
+
     /* must chain up - finalize parent */
     (*parent_class->finalize)(object);
 }
@@ -288,7 +295,7 @@ static void GtkCustomerModel_get_value(GtkTreeModel *tree_model,
         GtkTreeIter *iter, gint column, GValue *value) {
     GtkCustomerModel *custom_list;
     gint recordNum;
-    char * content;
+    char ** values;
 
     g_return_if_fail (GTKCUSTOMERMODEL_IS_LIST (tree_model));
     custom_list = GTKCUSTOMERMODEL(tree_model);
@@ -303,9 +310,31 @@ static void GtkCustomerModel_get_value(GtkTreeModel *tree_model,
     if (recordNum >= CustomerDB_getRecordCount(custom_list->clientDB))
         g_return_if_reached();
 
-    content = CustomerDB_getFieldValueAsString(custom_list->clientDB, recordNum, column);
-    g_value_set_string(value, content);
-    free(content);
+    /* a row is drawn one cell at a time: the record is decoded once for all its columns */
+    values = RowCache_find(&custom_list->rowCache, recordNum);
+    if (values == NULL)
+        values = GtkCustomerModel_load_row(custom_list, recordNum);
+    g_value_set_string(value, values[column]);
+}
+
+/*****************************************************************************
+ *
+ *  GtkCustomerModel_load_row: reads a record and stores the strings of all
+ *                        its columns in the row cache
+ *
+ *****************************************************************************/
+
+static char ** GtkCustomerModel_load_row(GtkCustomerModel *custom_list, gint recordNum) {
+    char ** values = RowCache_add(&custom_list->rowCache, recordNum);
+    CustomerRecord record;
+    int field;
+
+    CustomerRecord_init(&record);
+    CustomerDB_readRecord(custom_list->clientDB, recordNum, &record);
+    for (field = 0; field < CUSTOMERRECORD_FIELDCOUNT; ++field)
+        values[field] = (*CustomerRecord_getFieldProperties(field).getValue)(&record);
+    CustomerRecord_finalize(&record);
+    return values;
 }
 
 /*****************************************************************************
@@ -528,6 +557,8 @@ void GtkCustomerModel_remove_record(GtkCustomerModel * custom_list, gint recordI
         gtk_tree_path_free(path);
 
         CustomerDB_removeRecord(custom_list->clientDB, recordIndex);
+        /* the following records moved */
+        RowCache_clear(&custom_list->rowCache);
     }
 }
 
@@ -544,6 +575,7 @@ void GtkCustomerModel_change_record(GtkCustomerModel * custom_list,
     CustomerDB_readRecord(custom_list->clientDB, recordIndex, &record);
     if (CustomerRecord_edit(&record)) {
         CustomerDB_writeRecord(custom_list->clientDB, recordIndex, &record);
+        RowCache_invalidate(&custom_list->rowCache, recordIndex);
 
         /* inform the tree view and other interested objects
          * (e.g. tree row references) that we have inserted
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id: GtkCustomerModel.c 247 2010-09-10 10:23:07Z sebtic $
+ */
+
+#include <GtkDocumentModel.h>
+#include <DocumentIndex.h>
+#include <pthread.h>
+
+/** The state of the background filling of a list of documents */
+typedef struct {
+    GtkListStore * store; /**< The filled list, referenced until the filling ends */
+    TypeDocument typeDocument; /**< The type of the listed documents */
+    const char * errorMessage; /**< The message shown if the directory cannot be listed */
+    int isListed; /**< A non null value if the directory could be listed, set when the filling ends */
+} GtkDocumentModelScan;
+
+/** The rows waiting for an idle callback to be appended to a list of documents */
+typedef struct {
+    GtkDocumentModelScan * scan; /**< The filling */
+    int count; /**< The number of rows */
+    gchar * values[DOCUMENTINDEX_BATCH_SIZE][GTKDOCUMENTMODEL_COLUMNCOUNT]; /**< The strings of the rows */
+    int isLast; /**< A non null value for the batch ending the filling */
+} GtkDocumentModelBatch;
+
+static void * GtkDocumentModel_scan(void * data);
+static void GtkDocumentModel_receive(const DocumentIndexEntry * entries, int count, void * data);
+static GtkDocumentModelBatch * GtkDocumentModel_createBatch(GtkDocumentModelScan * scan);
+static gboolean GtkDocumentModel_append(gpointer data);
+
+/** Create the list of the documents of a type, filled in the background
+ * @param typeDocument the type of the listed documents
+ * @param errorMessage the message shown if the directory of the documents cannot be listed
+ * @return the new list with GTKDOCUMENTMODEL_COLUMNCOUNT string columns
+ */
+GtkTreeModel * GtkDocumentModel_new(TypeDocument typeDocument, const char * errorMessage) {
+    GtkDocumentModelScan * scan = malloc(sizeof(GtkDocumentModelScan));
+    pthread_t thread;
+
+    if (scan == NULL)
+        fatalError("malloc error : Allocation of the document list failed");
+    scan->store = gtk_list_store_new(GTKDOCUMENTMODEL_COLUMNCOUNT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+            G_TYPE_STRING);
+    scan->typeDocument = typeDocument;
+    scan->errorMessage = errorMessage;
+    scan->isListed = 0;
+
+    /* the list outlives a dialog closed before the end of the filling */
+    g_object_ref(scan->store);
+    if (pthread_create(&thread, NULL, GtkDocumentModel_scan, scan) != 0)
+        fatalError("pthread_create error : unable to start the filling of the document list");
+    pthread_detach(thread);
+    return GTK_TREE_MODEL(scan->store);
+}
+
+/** Refresh the document index and send its entries to the main loop
+ * @param data the filling
+ * @return NULL
+ */
+static void * GtkDocumentModel_scan(void * data) {
+    GtkDocumentModelScan * scan = data;
+    DocumentIndex * documentIndex = DocumentIndex_open(BASEPATH "/data");
+    GtkDocumentModelBatch * batch;
+
+    scan->isListed = DocumentIndex_refreshWith(documentIndex, 0, GtkDocumentModel_receive, scan) != -1;
+    DocumentIndex_close(documentIndex);
+
+    /* the idle callbacks run in the order they were added so the last batch ends the filling */
+    batch = GtkDocumentModel_createBatch(scan);
+    batch->isLast = 1;
+    g_idle_add(GtkDocumentModel_append, batch);
+    return NULL;
+}
+
+/** Copy the entries of the listed type given by a refresh into a batch for the main loop
+ * @param entries the entries
+ * @param count the number of entries
+ * @param data the filling
+ */
+static void GtkDocumentModel_receive(const DocumentIndexEntry * entries, int count, void * data) {
+    GtkDocumentModelScan * scan = data;
+    GtkDocumentModelBatch * batch = GtkDocumentModel_createBatch(scan);
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        if (entries[i].typeDocument != scan->typeDocument)
+            continue;
+        /* the entries belong to the index which is closed before the rows are appended */
+        batch->values[batch->count][0] = g_strdup(entries[i].docNumber);
+        batch->values[batch->count][1] = g_strdup(entries[i].customerName);
+        batch->values[batch->count][2] = g_strdup(entries[i].editDate);
+        batch->values[batch->count][3] = g_strdup(entries[i].object);
+        batch->count += 1;
+    }
+    if (batch->count > 0)
+        g_idle_add(GtkDocumentModel_append, batch);
+    else
+        free(batch);
+}
+
+/** Create an empty batch of rows
+ * @param scan the filling
+ * @return the new batch
+ */
+static GtkDocumentModelBatch * GtkDocumentModel_createBatch(GtkDocumentModelScan * scan) {
+    GtkDocumentModelBatch * batch = malloc(sizeof(GtkDocumentModelBatch));
+
+    if (batch == NULL)
+        fatalError("malloc error : Allocation of the document list failed");
+    batch->scan = scan;
+    batch->count = 0;
+    batch->isLast = 0;
+    return batch;
+}
+
+/** Append the rows of a batch to its list, from the main loop
+ * @param data the batch
+ * @return FALSE so that the callback is removed
+ */
+static gboolean GtkDocumentModel_append(gpointer data) {
+    GtkDocumentModelBatch * batch = data;
+    GtkDocumentModelScan * scan = batch->scan;
+    GtkTreeIter iter;
+    int i;
+    int j;
+
+    for (i = 0; i < batch->count; ++i) {
+        gtk_list_store_append(scan->store, &iter);
+        gtk_list_store_set(scan->store, &iter, 0, batch->values[i][0], 1, batch->values[i][1],
+                2, batch->values[i][2], 3, batch->values[i][3], -1);
+        for (j = 0; j < GTKDOCUMENTMODEL_COLUMNCOUNT; ++j)
+            g_free(batch->values[i][j]);
+    }
+
+    if (batch->isLast) {
+        if (!scan->isListed) {
+            GtkWidget * errordialog = gtk_message_dialog_new(NULL, GTK_DIALOG_DESTROY_WITH_PARENT,
+                    GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE, "%s", scan->errorMessage);
+            g_signal_connect(errordialog, "response", G_CALLBACK(gtk_widget_destroy), NULL);
+            gtk_widget_show(errordialog);
+        }
+        g_object_unref(scan->store);
+        free(scan);
+    }
+    free(batch);
+    return FALSE;
+}
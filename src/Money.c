@@ -0,0 +1,233 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#include <Money.h>
+#include <DecimalFormat.h>
+
+/** Divide an integer rounding the quotient to the nearest integer, halves away from zero
+ * @param numerator the integer
+ * @param denominator the positive divisor
+ */
+#define MONEY_DIVIDE(numerator, denominator) \
+    (((numerator) >= 0) ? ((numerator) + (denominator) / 2) / (denominator) : -((-(numerator) + (denominator) / 2) / (denominator)))
+
+/** The largest absolute value of a double converted to a Money, half of MONEY_MAX / MONEY_SCALE */
+#define MONEY_MAX_DOUBLE 4.5e14
+
+/** The largest absolute value of the factors whose product is computed on 64 bits, the square root of MONEY_MAX */
+#define MONEY_MAX_SMALL 3037000499LL
+
+/** The mask of the 32 lowest bits of an integer */
+#define MONEY_LOW_MASK 0xFFFFFFFFULL
+
+static Money Money_multiplyDivide(Money value1, Money value2, Money divisor);
+static unsigned long long Money_getMagnitude(Money value);
+
+/** Convert a double to the nearest Money
+ * @param value the number
+ * @return the Money, 0 if the value can not be represented
+ */
+Money Money_fromDouble(double value)
+{
+    Money money;
+
+    Money_tryFromDouble(value, &money);
+    return money;
+}
+
+/** Convert a double to the nearest Money, rejecting the values out of the range of Money_fromDouble()
+ * @param value the number
+ * @param money the Money to fill, set to 0 if the value is rejected
+ * @return a non null value on success, 0 if the value can not be represented
+ */
+int Money_tryFromDouble(double value, Money * money)
+{
+    double scaled = value * MONEY_SCALE;
+
+    /* the negated comparison also rejects NaN */
+    if (!(value > -MONEY_MAX_DOUBLE && value < MONEY_MAX_DOUBLE))
+    {
+        *money = 0;
+        return 0;
+    }
+    *money = (Money)((scaled >= 0) ? floor(scaled + 0.5) : -floor(-scaled + 0.5));
+    return 1;
+}
+
+/** Convert a Money to the nearest double
+ * @param value the Money
+ * @return the number
+ */
+double Money_toDouble(Money value)
+{
+    return (double)value / MONEY_SCALE;
+}
+
+/** Multiply two Money, rounding the result
+ * @param value1 the first factor
+ * @param value2 the second factor
+ * @return the product
+ */
+Money Money_multiply(Money value1, Money value2)
+{
+    return Money_multiplyDivide(value1, value2, MONEY_SCALE);
+}
+
+/** Compute a percentage of a Money, rounding the result
+ * @param value the Money
+ * @param rate the rate in percent
+ * @return the percentage of the Money
+ */
+Money Money_percent(Money value, Money rate)
+{
+    return Money_multiplyDivide(value, rate, 100 * MONEY_SCALE);
+}
+
+/** Write a Money in decimal notation, rounded to a number of decimals
+ * @param buffer the buffer receiving the null terminated text, may be NULL if bufferSize is 0
+ * @param bufferSize the size of the buffer
+ * @param value the Money
+ * @param precision the number of decimals, at most MONEY_DECIMALS
+ * @param width the minimal length of the text, padded with spaces on the left
+ * @return the length of the whole text
+ */
+size_t Money_write(char * buffer, size_t bufferSize, Money value, int precision, int width)
+{
+    Money divisor = 1;
+    Money rounded;
+    int i;
+
+    precision = MAXVALUE(0, MINVALUE(precision, MONEY_DECIMALS));
+    for (i = precision; i < MONEY_DECIMALS; ++i)
+        divisor *= 10;
+    rounded = MONEY_DIVIDE(value, divisor);
+
+    /* the rounded integer divided by a power of ten is the double nearest to the decimal
+     * number, which is written back without any other rounding */
+    return DecimalFormat_write(buffer, bufferSize, (double)rounded / (double)(MONEY_SCALE / divisor), precision, width);
+}
+
+/** Empty the totals of a list of rows
+ * @param totals the totals
+ */
+void MoneyTotals_init(MoneyTotals * totals)
+{
+    totals->withoutVAT = 0;
+    totals->ofVAT = 0;
+    totals->withVAT = 0;
+}
+
+/** Add rows to totals
+ * @param totals the totals receiving the rows
+ * @param sellingPrices the selling price of each row
+ * @param discounts the discount of each row
+ * @param quantities the quantity of each row
+ * @param ratesOfVAT the rate of VAT of each row
+ * @param count the number of rows
+ */
+void MoneyTotals_addRows(MoneyTotals * totals, const Money * sellingPrices, const Money * discounts,
+        const Money * quantities, const Money * ratesOfVAT, int count)
+{
+    Money withoutVAT = 0;
+    Money ofVAT = 0;
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        Money rounded = Money_multiplyDivide(sellingPrices[i] - discounts[i], quantities[i], MONEY_SCALE);
+
+        withoutVAT += rounded;
+        ofVAT += Money_multiplyDivide(rounded, ratesOfVAT[i], 100 * MONEY_SCALE);
+    }
+    totals->withoutVAT += withoutVAT;
+    totals->ofVAT += ofVAT;
+    totals->withVAT += withoutVAT + ofVAT;
+}
+
+/** Multiply two Money and divide the product, rounding the quotient to the nearest integer, halves away from zero
+ *
+ * The product is computed on 64 bits when it fits and on four 32-bit limbs otherwise.
+ * @param value1 the first factor
+ * @param value2 the second factor
+ * @param divisor the positive divisor, below 2^32
+ * @return the quotient, saturated to MONEY_MAX or -MONEY_MAX
+ */
+static Money Money_multiplyDivide(Money value1, Money value2, Money divisor)
+{
+    unsigned long long magnitude1;
+    unsigned long long magnitude2;
+    unsigned long long low00, cross01, cross10, middle, low, high;
+    unsigned long long limbs[4];
+    unsigned long long remainder = 0;
+    unsigned long long quotient;
+    int isNegative = (value1 < 0) != (value2 < 0);
+    int i;
+
+    if (value1 >= -MONEY_MAX_SMALL && value1 <= MONEY_MAX_SMALL && value2 >= -MONEY_MAX_SMALL && value2 <= MONEY_MAX_SMALL)
+    {
+        Money product = value1 * value2;
+
+        return MONEY_DIVIDE(product, divisor);
+    }
+
+    /* the 128-bit product of the magnitudes from the products of their 32-bit halves */
+    magnitude1 = Money_getMagnitude(value1);
+    magnitude2 = Money_getMagnitude(value2);
+    low00 = (magnitude1 & MONEY_LOW_MASK) * (magnitude2 & MONEY_LOW_MASK);
+    cross01 = (magnitude1 & MONEY_LOW_MASK) * (magnitude2 >> 32);
+    cross10 = (magnitude1 >> 32) * (magnitude2 & MONEY_LOW_MASK);
+    middle = (low00 >> 32) + (cross01 & MONEY_LOW_MASK) + (cross10 & MONEY_LOW_MASK);
+    low = (middle << 32) | (low00 & MONEY_LOW_MASK);
+    high = (magnitude1 >> 32) * (magnitude2 >> 32) + (cross01 >> 32) + (cross10 >> 32) + (middle >> 32);
+
+    /* rounding half away from zero on the magnitude */
+    low += (unsigned long long)divisor / 2;
+    if (low < (unsigned long long)divisor / 2)
+        high += 1;
+
+    /* a long division by 32-bit limbs whose partial remainders always fit on 64 bits */
+    limbs[0] = high >> 32;
+    limbs[1] = high & MONEY_LOW_MASK;
+    limbs[2] = low >> 32;
+    limbs[3] = low & MONEY_LOW_MASK;
+    for (i = 0; i < 4; ++i)
+    {
+        unsigned long long current = (remainder << 32) | limbs[i];
+
+        limbs[i] = current / (unsigned long long)divisor;
+        remainder = current % (unsigned long long)divisor;
+    }
+    quotient = (limbs[2] << 32) | limbs[3];
+    if (limbs[0] != 0 || limbs[1] != 0 || quotient > (unsigned long long)MONEY_MAX)
+        quotient = (unsigned long long)MONEY_MAX;
+    return isNegative ? -(Money)quotient : (Money)quotient;
+}
+
+/** Get the absolute value of a Money without overflow
+ * @param value the Money
+ * @return the absolute value
+ */
+static unsigned long long Money_getMagnitude(Money value)
+{
+    if (value >= 0)
+        return (unsigned long long)value;
+    /* -value would overflow for the smallest Money */
+    return (unsigned long long)(-(value + 1)) + 1;
+}
@@ -19,6 +19,7 @@
 
 #include <MyString.h>
 #include <limits.h>
+#include <stdarg.h>
 
 /** Like the tolower() function. It converts the letter c to lower case, if possible.
  * @param c the letter to convert
@@ -393,3 +394,118 @@ char * IMPLEMENT(insertString)(const char * src, int insertPosition, const char
     copySrc[count1+insertLength] = '\0';
     return copySrc;
 }
+
+/** The capacity of a string builder at its first append */
+#define STRINGBUILDER_INITIAL_CAPACITY 64
+
+/** Initialize an empty string builder
+ * @param builder the string builder
+ */
+void StringBuilder_init(StringBuilder * builder)
+{
+    builder->data = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+}
+
+/** Free the memory used by a string builder
+ * @param builder the string builder
+ */
+void StringBuilder_finalize(StringBuilder * builder)
+{
+    free(builder->data);
+    StringBuilder_init(builder);
+}
+
+/** Empty a string builder without freeing its buffer
+ * @param builder the string builder
+ */
+void StringBuilder_clear(StringBuilder * builder)
+{
+    builder->length = 0;
+    if (builder->data != NULL)
+        builder->data[0] = '\0';
+}
+
+/** Make sure that a string builder can hold a text of a given length without growing
+ * @param builder the string builder
+ * @param length the length of the text
+ */
+void StringBuilder_reserve(StringBuilder * builder, size_t length)
+{
+    size_t capacity = (builder->capacity == 0) ? STRINGBUILDER_INITIAL_CAPACITY : builder->capacity;
+
+    if (length < builder->capacity)
+        return;
+    while (capacity <= length)
+        capacity *= 2;
+    builder->data = realloc(builder->data, capacity);
+    if (builder->data == NULL)
+        fatalError("realloc error : Allocation of the string builder failed");
+    if (builder->capacity == 0)
+        builder->data[0] = '\0';
+    builder->capacity = capacity;
+}
+
+/** Append a string to a string builder
+ * @param builder the string builder
+ * @param str the string
+ */
+void StringBuilder_append(StringBuilder * builder, const char * str)
+{
+    StringBuilder_appendN(builder, str, stringLength(str));
+}
+
+/** Append the first characters of a string to a string builder
+ * @param builder the string builder
+ * @param str the characters, which may not be null terminated
+ * @param length the number of characters to append
+ */
+void StringBuilder_appendN(StringBuilder * builder, const char * str, size_t length)
+{
+    StringBuilder_reserve(builder, builder->length + length);
+    memcpy(builder->data + builder->length, str, length);
+    builder->length += length;
+    builder->data[builder->length] = '\0';
+}
+
+/** Append a text formatted like with printf() to a string builder
+ * @param builder the string builder
+ * @param format the format
+ */
+void StringBuilder_appendFormatted(StringBuilder * builder, const char * format, ...)
+{
+    va_list arguments;
+    int length;
+
+    /* the text is first formatted in the free space and formatted again if it does not fit */
+    StringBuilder_reserve(builder, builder->length);
+    va_start(arguments, format);
+    length = vsnprintf(builder->data + builder->length, builder->capacity - builder->length, format, arguments);
+    va_end(arguments);
+    if (length < 0)
+        fatalError("vsnprintf error : unable to format the text");
+
+    if ((size_t)length >= builder->capacity - builder->length)
+    {
+        StringBuilder_reserve(builder, builder->length + (size_t)length);
+        va_start(arguments, format);
+        vsnprintf(builder->data + builder->length, builder->capacity - builder->length, format, arguments);
+        va_end(arguments);
+    }
+    builder->length += (size_t)length;
+}
+
+/** Give the text of a string builder to the caller and empty the string builder
+ * @param builder the string builder
+ * @return the text
+ */
+char * StringBuilder_detach(StringBuilder * builder)
+{
+    char * text;
+
+    StringBuilder_reserve(builder, builder->length);
+    text = builder->data;
+    StringBuilder_init(builder);
+    return text;
+}
@@ -247,6 +247,45 @@ static void test_insertString(void)
   free(temp);
 }
 
+static void test_StringBuilder(void)
+{
+  StringBuilder builder;
+  char * text;
+  size_t capacity;
+  int i;
+
+  StringBuilder_init(&builder);
+  StringBuilder_append(&builder, "abc");
+  StringBuilder_appendN(&builder, "defghi", 3);
+  StringBuilder_appendFormatted(&builder, "-%d-%s-%.2f", 42, "xyz", 1.5);
+  ASSERT_EQUAL_STRING(builder.data, "abcdef-42-xyz-1.50");
+  ASSERT_EQUAL(builder.length, stringLength("abcdef-42-xyz-1.50"));
+
+  /* the capacity doubles so that many appends stay linear */
+  for (i = 0; i < 10000; ++i)
+    StringBuilder_appendFormatted(&builder, "%04d", i);
+  ASSERT_EQUAL(builder.length, stringLength("abcdef-42-xyz-1.50") + 40000);
+  ASSERT_EQUAL_STRING(builder.data + builder.length - 8, "99989999");
+  ASSERT(builder.capacity < 2 * (builder.length + 1));
+
+  /* clearing keeps the buffer */
+  capacity = builder.capacity;
+  StringBuilder_clear(&builder);
+  ASSERT_EQUAL_STRING(builder.data, "");
+  ASSERT_EQUAL(builder.capacity, capacity);
+
+  StringBuilder_appendFormatted(&builder, "%s", "");
+  text = StringBuilder_detach(&builder);
+  ASSERT_EQUAL_STRING(text, "");
+  ASSERT_EQUAL(builder.data, NULL);
+  free(text);
+
+  text = StringBuilder_detach(&builder);
+  ASSERT_EQUAL_STRING(text, "");
+  free(text);
+  StringBuilder_finalize(&builder);
+}
+
 void test_MyString(void)
 {
   BEGIN_TESTS(MyString)
@@ -267,6 +306,7 @@ void test_MyString(void)
     RUN_TEST(test_makeUpperCaseString);
     RUN_TEST(test_makeLowerCaseString);
     RUN_TEST(test_insertString);
+    RUN_TEST(test_StringBuilder);
   }
   END_TESTS
 }
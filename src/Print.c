@@ -19,7 +19,7 @@
 
 #include <Print.h>
 #include <PrintFormat.h>
-#include <Dictionary.h>
+#include <PrintFormatCache.h>
 
 /** Create a combo box of all the models
  * @return the combo box
@@ -68,6 +68,19 @@ typedef struct
   Document * document;
 } PrintContext;
 
+/** Sink inserting the parts of a formatted document at the end of a text buffer
+ * @param text the characters of the part
+ * @param length the number of characters
+ * @param buffer the text buffer
+ */
+static void PrintPreview_insertText(const char * text, size_t length, void * buffer)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_get_end_iter(GTK_TEXT_BUFFER(buffer), &iter);
+  gtk_text_buffer_insert_with_tags_by_name(GTK_TEXT_BUFFER(buffer), &iter, text, (gint)length, "font", NULL);
+}
+
 /** Signal handler which handles the combo box changes
  * @param combo the combo box
  * @param context the context
@@ -75,27 +88,24 @@ typedef struct
 static void PrintPreview_comboChanged(GtkComboBox *combo, PrintContext * context)
 {
   GtkTextBuffer *buffer;
-  char * content;
-  PrintFormat format;
+  PrintFormatCacheEntry * format;
   char buf[1024];
-  GtkTextIter iter;
   gchar * selected = gtk_combo_box_get_active_text(combo);
   if (selected != NULL)
   {
-    PrintFormat_init(&format);
     snprintf(buf, 1024, BASEPATH "/data/printformat-%s.txt", selected);
-    PrintFormat_loadFromFile(&format, buf);
+    /* the model is only parsed again if its file changed since it was last chosen */
+    format = PrintFormatCache_acquire(buf);
+    if (format == NULL)
+      fatalError("Unable to read the print format");
 
     buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW (context->viewer));
-    content = PrintFormat_format(&format, context->document);
-
     gtk_text_buffer_set_text(buffer, "", -1);
 
-    gtk_text_buffer_get_iter_at_offset(buffer, &iter, 0);
-    gtk_text_buffer_insert_with_tags_by_name(buffer, &iter, content, -1, "font", NULL);
-    free(content);
+    /* the document is inserted part by part instead of being formatted in a single string */
+    PrintFormatCache_renderTo(format, context->document, PrintPreview_insertText, buffer);
 
-    PrintFormat_finalize(&format);
+    PrintFormatCache_release(format);
     g_free(selected);
   }
 }
@@ -142,93 +152,3 @@ void Print_preview(Document * document)
   gtk_dialog_run(GTK_DIALOG (dialog));
   gtk_widget_destroy(dialog);
 }
-
-/** Format a document according to a print format
- * @param document the document
- * @param printFormat the print format
- * @return a new string created on the heap containing the formatted document
- * @warning The user is responsible for freeing the memory
- */
-char * PrintFormat_format(PrintFormat * printFormat, Document * document)
-{
-  Dictionary * dictionary;
-  char * result;
-  char * temp, *formatted;
-  DocumentRow * row;
-  double totalHT, totalTVA, totalTTC;
-
-  /* Phase 1 : entete */
-  dictionary = Dictionary_create();
-  Dictionary_setStringEntry(dictionary, "CUSTOMER.NAME", document->customer.name);
-  Dictionary_setStringEntry(dictionary, "CUSTOMER.ADDRESS", document->customer.address);
-  Dictionary_setStringEntry(dictionary, "CUSTOMER.PORTALCODE", document->customer.postalCode);
-  Dictionary_setStringEntry(dictionary, "CUSTOMER.TOWN", document->customer.town);
-  Dictionary_setStringEntry(dictionary, "DOCNUMBER", document->docNumber);
-  Dictionary_setStringEntry(dictionary, "EDITDATE", document->editDate);
-  Dictionary_setStringEntry(dictionary, "OBJECT", document->object);
-  Dictionary_setStringEntry(dictionary, "OPERATOR", document->operator);
-  Dictionary_setStringEntry(dictionary, "EXPIRYDATE", document->expiryDate);
-  if (document->typeDocument == QUOTATION)
-    Dictionary_setStringEntry(dictionary, "TYPEDOCUMENT", "Devis");
-  else
-    Dictionary_setStringEntry(dictionary, "TYPEDOCUMENT", "Facture");
-
-  result = Dictionary_format(dictionary, printFormat->header);
-  temp = concatenateString(result, "\n");
-  free(result);
-  result = temp;
-  Dictionary_destroy(dictionary);
-
-  /* Phase 2 : les lignes */
-  row = document->rows;
-  totalTVA = 0;
-  totalHT = 0;
-  totalTTC = 0;
-  while (row != NULL)
-  {
-    dictionary = Dictionary_create();
-    Dictionary_setStringEntry(dictionary, "CODE", row->code);
-    Dictionary_setStringEntry(dictionary, "DESIGNATION", row->designation);
-    Dictionary_setStringEntry(dictionary, "UNITY", row->unity);
-    Dictionary_setNumberEntry(dictionary, "BASEPRICE", row->basePrice);
-    Dictionary_setNumberEntry(dictionary, "SELLINGPRICE", row->sellingPrice);
-    Dictionary_setNumberEntry(dictionary, "QUANTITY", row->quantity);
-    Dictionary_setNumberEntry(dictionary, "DISCOUNT", row->discount);
-    Dictionary_setNumberEntry(dictionary, "RATEOFVAT", row->rateOfVAT);
-    Dictionary_setNumberEntry(dictionary, "SOLDPRICE", row->sellingPrice - row->discount);
-    Dictionary_setNumberEntry(dictionary, "VAT", (row->sellingPrice - row->discount) * row->rateOfVAT / 100.);
-    Dictionary_setNumberEntry(dictionary, "FINALPRICE", (row->sellingPrice - row->discount) * (1. + row->rateOfVAT / 100.));
-    totalHT += row->quantity * (row->sellingPrice - row->discount);
-    totalTVA += row->quantity * (row->sellingPrice - row->discount) * row->rateOfVAT / 100.;
-    totalTTC += row->quantity * (row->sellingPrice - row->discount) * (1. + row->rateOfVAT / 100.);
-
-    formatted = Dictionary_format(dictionary, printFormat->row);
-    temp = concatenateString(result, formatted);
-    free(formatted);
-    free(result);
-    result = temp;
-    Dictionary_destroy(dictionary);
-    row = row->next;
-
-    temp = concatenateString(result, "\n");
-    free(result);
-    result = temp;
-  }
-
-  dictionary = Dictionary_create();
-  Dictionary_setNumberEntry(dictionary, "SUMWITHOUTVAT", totalHT);
-  Dictionary_setNumberEntry(dictionary, "SUMOFVAT", totalTVA);
-  Dictionary_setNumberEntry(dictionary, "SUMWITHVAT", totalTTC);
-  formatted = Dictionary_format(dictionary, printFormat->footer);
-  temp = concatenateString(result, formatted);
-  free(formatted);
-  free(result);
-  result = temp;
-
-  temp = concatenateString(result, "\n");
-  free(result);
-  result = temp;
-  Dictionary_destroy(dictionary);
-
-  return result;
-}
@@ -18,10 +18,13 @@
  */
 
 #include <PrintFormat.h>
+#include <PrintFormatCache.h>
 #include <Dictionary.h>
 
 static char * readLine(FILE * fichier);
 static char * readMarked(FILE * file, const char * mark);
+static void PrintFormat_flush(StringBuilder * output, size_t threshold, PrintFormat_Sink sink, void * data);
+static void PrintFormat_appendToBuilder(const char * text, size_t length, void * builder);
 
 /** Initialize a print format
  * @param format a print format
@@ -75,26 +78,192 @@ void IMPLEMENT(PrintFormat_loadFromFile)(PrintFormat * format, const char * file
     fclose(file);
 }
 
+/** Format a document according to a print format and give the result part by part to a sink
+ * @param printFormat the print format
+ * @param document the document
+ * @param sink the function receiving the parts of the result
+ * @param data the data given to the sink
+ */
+void PrintFormat_renderTo(PrintFormat * printFormat, Document * document, PrintFormat_Sink sink, void * data)
+{
+    Template * header = Template_compile(printFormat->header);
+    Template * row = Template_compile(printFormat->row);
+    Template * footer = Template_compile(printFormat->footer);
+    Dictionary * dictionary = Dictionary_create();
+
+    PrintFormat_renderTemplatesTo(header, row, footer, document, dictionary, sink, data);
+    Dictionary_destroy(dictionary);
+    Template_destroy(header);
+    Template_destroy(row);
+    Template_destroy(footer);
+}
+
+/** Format a document according to the compiled parts of a print format and give the result part by part to a sink
+ * @param header the compiled header format
+ * @param rowTemplate the compiled row format
+ * @param footer the compiled footer format
+ * @param document the document
+ * @param dictionary the dictionary receiving the values of each part, emptied before each part
+ * @param sink the function receiving the parts of the result
+ * @param data the data given to the sink
+ */
+void PrintFormat_renderTemplatesTo(const Template * header, const Template * rowTemplate, const Template * footer,
+        Document * document, Dictionary * dictionary, PrintFormat_Sink sink, void * data)
+{
+    StringBuilder output;
+    DocumentRow * row;
+    MoneyTotals totals;
+
+    StringBuilder_init(&output);
+    StringBuilder_reserve(&output, PRINTFORMAT_CHUNK_SIZE);
+
+    /* Phase 1 : entete */
+    Dictionary_clear(dictionary);
+    Dictionary_setStringEntry(dictionary, "CUSTOMER.NAME", document->customer.name);
+    Dictionary_setStringEntry(dictionary, "CUSTOMER.ADDRESS", document->customer.address);
+    Dictionary_setStringEntry(dictionary, "CUSTOMER.PORTALCODE", document->customer.postalCode);
+    Dictionary_setStringEntry(dictionary, "CUSTOMER.TOWN", document->customer.town);
+    Dictionary_setStringEntry(dictionary, "DOCNUMBER", document->docNumber);
+    Dictionary_setStringEntry(dictionary, "EDITDATE", document->editDate);
+    Dictionary_setStringEntry(dictionary, "OBJECT", document->object);
+    Dictionary_setStringEntry(dictionary, "OPERATOR", document->operator);
+    Dictionary_setStringEntry(dictionary, "EXPIRYDATE", document->expiryDate);
+    if (document->typeDocument == QUOTATION)
+        Dictionary_setStringEntry(dictionary, "TYPEDOCUMENT", "Devis");
+    else
+        Dictionary_setStringEntry(dictionary, "TYPEDOCUMENT", "Facture");
+
+    Template_renderTo(header, dictionary, &output);
+    StringBuilder_append(&output, "\n");
+
+    /* Phase 2 : les lignes */
+    row = document->rows;
+    /* the same entries are redefined for each row so their values are reused */
+    Dictionary_clear(dictionary);
+    while (row != NULL)
+    {
+        Money soldPrice = Money_fromDouble(row->sellingPrice) - Money_fromDouble(row->discount);
+        Money vat = Money_percent(soldPrice, Money_fromDouble(row->rateOfVAT));
+
+        Dictionary_setStringEntry(dictionary, "CODE", row->code);
+        Dictionary_setStringEntry(dictionary, "DESIGNATION", row->designation);
+        Dictionary_setStringEntry(dictionary, "UNITY", row->unity);
+        Dictionary_setNumberEntry(dictionary, "BASEPRICE", row->basePrice);
+        Dictionary_setNumberEntry(dictionary, "SELLINGPRICE", row->sellingPrice);
+        Dictionary_setNumberEntry(dictionary, "QUANTITY", row->quantity);
+        Dictionary_setNumberEntry(dictionary, "DISCOUNT", row->discount);
+        Dictionary_setNumberEntry(dictionary, "RATEOFVAT", row->rateOfVAT);
+        Dictionary_setNumberEntry(dictionary, "SOLDPRICE", Money_toDouble(soldPrice));
+        Dictionary_setNumberEntry(dictionary, "VAT", Money_toDouble(vat));
+        Dictionary_setNumberEntry(dictionary, "FINALPRICE", Money_toDouble(soldPrice + vat));
+
+        PrintFormat_flush(&output, PRINTFORMAT_CHUNK_SIZE, sink, data);
+        Template_renderTo(rowTemplate, dictionary, &output);
+        StringBuilder_append(&output, "\n");
+        row = row->next;
+    }
+
+    /* the totals are computed exactly, whatever the number of rows */
+    DocumentRowList_computeTotals(document->rows, &totals);
+    Dictionary_clear(dictionary);
+    Dictionary_setNumberEntry(dictionary, "SUMWITHOUTVAT", Money_toDouble(totals.withoutVAT));
+    Dictionary_setNumberEntry(dictionary, "SUMOFVAT", Money_toDouble(totals.ofVAT));
+    Dictionary_setNumberEntry(dictionary, "SUMWITHVAT", Money_toDouble(totals.withVAT));
+    Template_renderTo(footer, dictionary, &output);
+    StringBuilder_append(&output, "\n");
+
+    PrintFormat_flush(&output, 0, sink, data);
+    StringBuilder_finalize(&output);
+}
+
+/** A sink writing the parts of a rendered document to a file
+ * @param text the characters of the part
+ * @param length the number of characters
+ * @param file the FILE pointer of the file opened for writing
+ */
+void PrintFormat_writeToFile(const char * text, size_t length, void * file)
+{
+    if (fwrite(text, 1, length, (FILE *)file) < length)
+        fatalError("fwrite error : unable to write the formatted document");
+}
+
+/** Format a document according to a print format
+ * @param printFormat the print format
+ * @param document the document
+ * @return a new string created on the heap containing the formatted document
+ * @warning The user is responsible for freeing the memory
+ */
+char * PrintFormat_format(PrintFormat * printFormat, Document * document)
+{
+    StringBuilder result;
+
+    StringBuilder_init(&result);
+    PrintFormat_renderTo(printFormat, document, PrintFormat_appendToBuilder, &result);
+    return StringBuilder_detach(&result);
+}
+
+/** Format a document saved in a file according to a print format file and write the result in a text file
+ * @param formatFilename the file name of the print format
+ * @param documentFilename the file name of the document
+ * @param outputFilename the file name of the text file to create
+ * @return a non null value on success, 0 if a file can not be opened or written
+ */
+int PrintFormat_renderFile(const char * formatFilename, const char * documentFilename, const char * outputFilename)
+{
+    PrintFormatCacheEntry * printFormat;
+    Document document;
+    FILE * file;
+    int isWritten;
+
+    printFormat = PrintFormatCache_acquire(formatFilename);
+    if (printFormat == NULL)
+        return 0;
+    /* Document_loadFromFile() aborts on a missing file so the file is checked first */
+    file = fopen(documentFilename, "rb");
+    if (file != NULL)
+    {
+        fclose(file);
+        file = fopen(outputFilename, "w");
+    }
+    if (file == NULL)
+    {
+        PrintFormatCache_release(printFormat);
+        return 0;
+    }
+
+    Document_init(&document);
+    /* the document is only read: its strings are freed all at once */
+    Document_enableArena(&document);
+    Document_loadFromFile(&document, documentFilename);
+
+    PrintFormatCache_renderTo(printFormat, &document, PrintFormat_writeToFile, file);
+    isWritten = !ferror(file);
+    if (fclose(file) != 0)
+        isWritten = 0;
+
+    Document_finalize(&document);
+    PrintFormatCache_release(printFormat);
+    return isWritten;
+}
+
 /** Function read one line in a file
  * @param fichier a file
  * @return the new string
  */
 static char * readLine(FILE * fichier)
 {
-    char * line = duplicateString("");
+    StringBuilder line;
     char buffer[512];
-    char * tmp = NULL;
 
+    StringBuilder_init(&line);
     while (fgets(buffer, sizeof(buffer), fichier) != NULL)
     {
-        tmp = line;
-        line = concatenateString(line, buffer);
-        free(tmp);
+        StringBuilder_append(&line, buffer);
 
         if (buffer[stringLength(buffer) - 1] == '\n')
             break;
     }
-    return line;
+    return StringBuilder_detach(&line);
 }
 
 /** Function read a part of model
@@ -104,20 +273,46 @@ static char * readLine(FILE * fichier)
  */
 static char * readMarked(FILE * file, const char * mark)
 {
-    char * lineOfFile1 = readLine(file);
-    char * lineOfFile2 = readLine(file);
-    char * lineOfFile3 = NULL;
+    StringBuilder part;
+    char * line = readLine(file);
 
-    while (icaseStartWith(mark, lineOfFile2) != 1)
+    /* the lines are accumulated up to the mark or the end of the file */
+    StringBuilder_init(&part);
+    do
     {
-        lineOfFile3 = concatenateString(lineOfFile1, lineOfFile2);
-        free(lineOfFile1);
-        free(lineOfFile2);
-        lineOfFile2 = readLine(file);
-        lineOfFile1 = duplicateString(lineOfFile3);
-        free(lineOfFile3);
+        StringBuilder_append(&part, line);
+        free(line);
+        line = readLine(file);
     }
-    free(lineOfFile2);
-    copyStringWithLength(lineOfFile1, lineOfFile1, stringLength(lineOfFile1));
-    return lineOfFile1;
+    while (line[0] != '\0' && icaseStartWith(mark, line) != 1);
+    free(line);
+
+    /* the end of line preceding the mark is not part of the model */
+    if (part.length > 0 && part.data[part.length - 1] == '\n')
+        part.data[--part.length] = '\0';
+    return StringBuilder_detach(&part);
+}
+
+/** Give the content of a buffer to a sink and empty it if it holds enough characters
+ * @param output the buffer
+ * @param threshold the number of characters from which the buffer is given to the sink
+ * @param sink the sink
+ * @param data the data given to the sink
+ */
+static void PrintFormat_flush(StringBuilder * output, size_t threshold, PrintFormat_Sink sink, void * data)
+{
+    if (output->length == 0 || output->length < threshold)
+        return;
+    (*sink)(output->data, output->length, data);
+    StringBuilder_clear(output);
+}
+
+/** A sink appending the parts of a rendered document to a string builder
+ * @param text the characters of the part
+ * @param length the number of characters
+ * @param builder the string builder
+ */
+static void PrintFormat_appendToBuilder(const char * text, size_t length, void * builder)
+{
+    StringBuilder_appendN((StringBuilder *)builder, text, length);
 }
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#include <PrintFormatCache.h>
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+/** The print formats of the process */
+typedef struct
+{
+  PrintFormatCacheEntry * first; /**< The first entry, NULL if the cache is empty */
+  int loadCount; /**< The number of files parsed */
+  pthread_mutex_t mutex; /**< The lock protecting the cache from concurrent threads */
+} PrintFormatCache;
+
+/** The cache of the process */
+static PrintFormatCache printFormatCache = { NULL, 0, PTHREAD_MUTEX_INITIALIZER };
+
+static PrintFormatCacheEntry * PrintFormatCache_load(const char * filename, struct stat * status);
+static void PrintFormatCache_unuse(PrintFormatCacheEntry * entry);
+
+/** Get the print format of a file, parsing the file only if it changed since it was cached
+ * @param filename the file name of the print format
+ * @return the entry, or NULL if the file can not be read
+ * @warning the entry must be released using PrintFormatCache_release()
+ */
+PrintFormatCacheEntry * PrintFormatCache_acquire(const char * filename)
+{
+    PrintFormatCacheEntry ** link;
+    PrintFormatCacheEntry * entry;
+    struct stat status;
+
+    if (stat(filename, &status) != 0)
+        return NULL;
+
+    pthread_mutex_lock(&printFormatCache.mutex);
+    link = &printFormatCache.first;
+    while (*link != NULL && compareString((*link)->filename, filename) != 0)
+        link = &(*link)->next;
+    entry = *link;
+
+    if (entry != NULL && (entry->modificationTime != status.st_mtime
+            || entry->modificationNanoseconds != getModificationNanoseconds(&status)
+            || entry->fileSize != (long)status.st_size))
+    {
+        /* the file changed: the old version is left to its current users */
+        *link = entry->next;
+        PrintFormatCache_unuse(entry);
+        entry = NULL;
+    }
+    if (entry == NULL)
+    {
+        entry = PrintFormatCache_load(filename, &status);
+        if (entry != NULL)
+        {
+            entry->next = printFormatCache.first;
+            printFormatCache.first = entry;
+        }
+    }
+    if (entry != NULL)
+        entry->useCount += 1;
+    pthread_mutex_unlock(&printFormatCache.mutex);
+    return entry;
+}
+
+/** Release an entry given by PrintFormatCache_acquire()
+ * @param entry the entry
+ */
+void PrintFormatCache_release(PrintFormatCacheEntry * entry)
+{
+    pthread_mutex_lock(&printFormatCache.mutex);
+    PrintFormatCache_unuse(entry);
+    pthread_mutex_unlock(&printFormatCache.mutex);
+}
+
+/** Format a document according to a cached print format and give the result part by part to a sink
+ * @param entry the acquired entry
+ * @param document the document
+ * @param sink the function receiving the parts of the result
+ * @param data the data given to the sink
+ */
+void PrintFormatCache_renderTo(PrintFormatCacheEntry * entry, Document * document, PrintFormat_Sink sink, void * data)
+{
+    Dictionary * dictionary = Dictionary_create();
+
+    PrintFormat_renderTemplatesTo(entry->header, entry->row, entry->footer, document, dictionary, sink, data);
+    Dictionary_destroy(dictionary);
+}
+
+/** Drop all the entries of the cache */
+void PrintFormatCache_clear(void)
+{
+    PrintFormatCacheEntry * entry;
+
+    pthread_mutex_lock(&printFormatCache.mutex);
+    while (printFormatCache.first != NULL)
+    {
+        entry = printFormatCache.first;
+        printFormatCache.first = entry->next;
+        PrintFormatCache_unuse(entry);
+    }
+    pthread_mutex_unlock(&printFormatCache.mutex);
+}
+
+/** Get the number of files parsed by the cache since the start of the process
+ * @return the number of files parsed
+ */
+int PrintFormatCache_getLoadCount(void)
+{
+    int loadCount;
+
+    pthread_mutex_lock(&printFormatCache.mutex);
+    loadCount = printFormatCache.loadCount;
+    pthread_mutex_unlock(&printFormatCache.mutex);
+    return loadCount;
+}
+
+/** Parse and compile a print format file into a new entry which is not yet used
+ * @param filename the file name of the print format
+ * @param status the status of the file
+ * @return the new entry, or NULL if the file can not be opened
+ */
+static PrintFormatCacheEntry * PrintFormatCache_load(const char * filename, struct stat * status)
+{
+    PrintFormatCacheEntry * entry;
+    FILE * file;
+
+    /* PrintFormat_loadFromFile() aborts on a missing file so the file is checked first */
+    file = fopen(filename, "r");
+    if (file == NULL)
+        return NULL;
+    fclose(file);
+
+    entry = malloc(sizeof(PrintFormatCacheEntry));
+    if (entry == NULL)
+        fatalError("malloc error : Allocation of the print format failed");
+    entry->filename = duplicateString(filename);
+    entry->modificationTime = status->st_mtime;
+    entry->modificationNanoseconds = getModificationNanoseconds(status);
+    entry->fileSize = (long)status->st_size;
+    PrintFormat_init(&entry->format);
+    PrintFormat_loadFromFile(&entry->format, filename);
+    entry->header = Template_compile(entry->format.header);
+    entry->row = Template_compile(entry->format.row);
+    entry->footer = Template_compile(entry->format.footer);
+    entry->useCount = 1;
+    entry->next = NULL;
+    printFormatCache.loadCount += 1;
+    return entry;
+}
+
+/** Drop a use of an entry and destroy it when it is not used anymore
+ * @param entry the entry
+ * @warning the lock of the cache must be held
+ */
+static void PrintFormatCache_unuse(PrintFormatCacheEntry * entry)
+{
+    entry->useCount -= 1;
+    if (entry->useCount > 0)
+        return;
+    Template_destroy(entry->header);
+    Template_destroy(entry->row);
+    Template_destroy(entry->footer);
+    PrintFormat_finalize(&entry->format);
+    free(entry->filename);
+    free(entry);
+}
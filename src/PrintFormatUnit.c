@@ -18,8 +18,14 @@
  */
 
 #include <PrintFormat.h>
+#include <BatchRender.h>
+#include <MyString.h>
+#include <PrintFormatCache.h>
 #include <UnitTest.h>
 
+#include <sys/time.h>
+#include <utime.h>
+
 void test_PrintFormat_all(void)
 {
   const char * name = "Format de devis n°1";
@@ -38,15 +44,307 @@ void test_PrintFormat_all(void)
   ASSERT_EQUAL_STRING(header, printFormat.header);
   ASSERT_EQUAL_STRING(row, printFormat.row);
   ASSERT_EQUAL_STRING(footer, printFormat.footer);
+  PrintFormat_finalize(&printFormat);
+
+  /* a last part ending the file without end of line keeps its last character */
+  input = fopen(BASEPATH "/unittest/unittest-printformat-unittest.txt", "wt");
+  fprintf(input, ".NAME %s\n.HEADER\n%s\n.ROW\n%s\n.FOOTER\n%s", name, header, row, footer);
+  fclose(input);
+
+  PrintFormat_init(&printFormat);
+  PrintFormat_loadFromFile(&printFormat, BASEPATH "/unittest/unittest-printformat-unittest.txt");
+  ASSERT_EQUAL_STRING(row, printFormat.row);
+  ASSERT_EQUAL_STRING(footer, printFormat.footer);
+  PrintFormat_finalize(&printFormat);
+}
+
+/** The state of the sink of test_PrintFormat_renderTo() */
+typedef struct
+{
+  StringBuilder text; /**< The concatenation of the parts */
+  int callCount; /**< The number of parts */
+  size_t maxLength; /**< The length of the longest part */
+} RenderState;
+
+static void collectParts(const char * text, size_t length, void * data)
+{
+  RenderState * state = data;
+
+  StringBuilder_appendN(&state->text, text, length);
+  state->callCount += 1;
+  if (length > state->maxLength)
+    state->maxLength = length;
+}
+
+void test_PrintFormat_renderTo(void)
+{
+  PrintFormat printFormat;
+  Document document;
+  RenderState state;
+  DocumentRow * row;
+  char * formatted;
+  char * expected;
+  char * content;
+  FILE * file;
+  long fileSize;
+  int i;
+
+  PrintFormat_init(&printFormat);
+  free(printFormat.header);
+  free(printFormat.row);
+  free(printFormat.footer);
+  printFormat.header = duplicateString("%TYPEDOCUMENT% n°%DOCNUMBER%");
+  printFormat.row = duplicateString("|%DESIGNATION{min=20,max=20}%|%QUANTITY{precision=2,min=8}%|%FINALPRICE{precision=2,min=10}%|");
+  printFormat.footer = duplicateString("Total TTC |%SUMWITHVAT{precision=2,min=10}%|");
+
+  Document_init(&document);
+  free(document.docNumber);
+  document.docNumber = duplicateString("D42");
+  document.typeDocument = BILL;
+  /* about 50 characters per row so that the rendering spans a few chunks */
+  for (i = 0; i < 700; ++i)
+  {
+    row = DocumentRow_create();
+    free(row->designation);
+    row->designation = duplicateString("Designation of a product");
+    row->quantity = 2;
+    row->sellingPrice = 10;
+    row->rateOfVAT = 20;
+    DocumentRowList_pushBack(&document.rows, row);
+  }
+
+  /* the parts are bounded and their concatenation is the whole document */
+  StringBuilder_init(&state.text);
+  state.callCount = 0;
+  state.maxLength = 0;
+  PrintFormat_renderTo(&printFormat, &document, collectParts, &state);
+  ASSERT(state.callCount > 1);
+  ASSERT(state.maxLength < 2 * PRINTFORMAT_CHUNK_SIZE);
+  ASSERT(icaseStartWith("Facture n°D42\n|Designation of a pro|    2.00|     12.00|\n", state.text.data));
+  expected = duplicateString(state.text.data);
+  ASSERT(icaseEndWith("Total TTC |  16800.00|\n", expected));
+
+  /* the long texts are compared with memcmp() since compareString() is quadratic */
+  formatted = PrintFormat_format(&printFormat, &document);
+  ASSERT_EQUAL(stringLength(formatted), stringLength(expected));
+  ASSERT(memcmp(formatted, expected, stringLength(expected)) == 0);
+  free(formatted);
 
+  /* a saved document is rendered straight to a text file */
+  file = fopen(BASEPATH "/unittest/unittest-printformat-unittest.txt", "wt");
+  fprintf(file, ".NAME Test\n.HEADER\n%s\n.ROW\n%s\n.FOOTER\n%s\n.END\n", printFormat.header, printFormat.row, printFormat.footer);
+  fclose(file);
+  Document_saveToFile(&document, BASEPATH "/unittest/unittest-printformat-unittest.dat");
+  ASSERT(PrintFormat_renderFile(BASEPATH "/unittest/unittest-printformat-unittest.txt", BASEPATH "/unittest/unittest-printformat-unittest.dat", BASEPATH "/unittest/unittest-printformat-unittest.out"));
+  Document_finalize(&document);
+  Document_init(&document);
+  Document_loadFromFile(&document, BASEPATH "/unittest/unittest-printformat-unittest.dat");
+  formatted = PrintFormat_format(&printFormat, &document);
+  file = fopen(BASEPATH "/unittest/unittest-printformat-unittest.out", "rb");
+  fseek(file, 0, SEEK_END);
+  fileSize = ftell(file);
+  rewind(file);
+  content = malloc((size_t)fileSize + 1);
+  ASSERT_EQUAL(fread(content, 1, (size_t)fileSize, file), (size_t)fileSize);
+  content[fileSize] = '\0';
+  fclose(file);
+  ASSERT_EQUAL((size_t)fileSize, stringLength(formatted));
+  ASSERT(memcmp(content, formatted, (size_t)fileSize) == 0);
+  free(content);
+  free(formatted);
+  ASSERT(!PrintFormat_renderFile(BASEPATH "/unittest/missing.txt", BASEPATH "/unittest/unittest-printformat-unittest.dat", BASEPATH "/unittest/unittest-printformat-unittest.out"));
+
+  free(expected);
+  StringBuilder_finalize(&state.text);
+  Document_finalize(&document);
   PrintFormat_finalize(&printFormat);
 }
 
+void test_PrintFormatCache(void)
+{
+  const char * filename = BASEPATH "/unittest/unittest-printformatcache-unittest.txt";
+  PrintFormatCacheEntry * first;
+  PrintFormatCacheEntry * second;
+  PrintFormatCacheEntry * third;
+  struct utimbuf times;
+  struct timeval preciseTimes[2];
+  int loadCount;
+  FILE * file;
+
+  PrintFormatCache_clear();
+  file = fopen(filename, "wt");
+  fprintf(file, ".NAME Cached\n.HEADER\nfirst header\n.ROW\n%%CODE%%\n.FOOTER\nfooter\n.END\n");
+  fclose(file);
+  times.actime = 1000000000;
+  times.modtime = 1000000000;
+  utime(filename, &times);
+
+  /* the file is parsed once */
+  loadCount = PrintFormatCache_getLoadCount();
+  first = PrintFormatCache_acquire(filename);
+  second = PrintFormatCache_acquire(filename);
+  ASSERT(first != NULL);
+  ASSERT(first == second);
+  ASSERT_EQUAL(PrintFormatCache_getLoadCount(), loadCount + 1);
+  ASSERT_EQUAL_STRING(first->format.name, "Cached");
+  ASSERT_EQUAL_STRING(first->format.header, "first header");
+  ASSERT_EQUAL(first->row->count, 1);
+  PrintFormatCache_release(second);
+
+  /* a modified file is parsed again while the old version stays usable */
+  file = fopen(filename, "wt");
+  fprintf(file, ".NAME Cached\n.HEADER\nsecond header\n.ROW\n%%CODE%%\n.FOOTER\nfooter\n.END\n");
+  fclose(file);
+  times.modtime = 1000000001;
+  utime(filename, &times);
+  third = PrintFormatCache_acquire(filename);
+  ASSERT(third != first);
+  ASSERT_EQUAL(PrintFormatCache_getLoadCount(), loadCount + 2);
+  ASSERT_EQUAL_STRING(third->format.header, "second header");
+  ASSERT_EQUAL_STRING(first->format.header, "first header");
+  PrintFormatCache_release(first);
+
+  /* a change of the same size within the same second is told apart by the nanoseconds */
+  file = fopen(filename, "wt");
+  fprintf(file, ".NAME Cached\n.HEADER\nSECOND header\n.ROW\n%%CODE%%\n.FOOTER\nfooter\n.END\n");
+  fclose(file);
+  preciseTimes[0].tv_sec = 1000000001;
+  preciseTimes[0].tv_usec = 500000;
+  preciseTimes[1] = preciseTimes[0];
+  utimes(filename, preciseTimes);
+  first = PrintFormatCache_acquire(filename);
+  ASSERT(first != third);
+  ASSERT_EQUAL(PrintFormatCache_getLoadCount(), loadCount + 3);
+  ASSERT_EQUAL_STRING(first->format.header, "SECOND header");
+  PrintFormatCache_release(first);
+
+  /* a cleared entry stays usable until it is released */
+  PrintFormatCache_clear();
+  ASSERT_EQUAL_STRING(third->format.header, "second header");
+  PrintFormatCache_release(third);
+
+  ASSERT(PrintFormatCache_acquire(BASEPATH "/unittest/missing.txt") == NULL);
+  ASSERT_EQUAL(PrintFormatCache_getLoadCount(), loadCount + 3);
+}
+
+void test_BatchRender(void)
+{
+  const char * docNumbers[23];
+  char docNumberTexts[20][8];
+  char filename[256];
+  BatchRenderReport report;
+  PrintFormat printFormat;
+  Document document;
+  DocumentRow * row;
+  char * formatted;
+  char * content;
+  FILE * file;
+  long fileSize;
+  int i, j;
+
+  remove(BASEPATH "/unittest/B0.txt");
+  file = fopen(BASEPATH "/unittest/unittest-batchrender-unittest.txt", "wt");
+  fprintf(file, ".NAME Batch\n.HEADER\n%%DOCNUMBER%%\n.ROW\n%%CODE%% %%QUANTITY{precision=2}%%\n.FOOTER\n%%SUMWITHOUTVAT{precision=2}%%\n.END\n");
+  fclose(file);
+
+  for (i = 0; i < 20; ++i)
+  {
+    sprintf(docNumberTexts[i], "B%d", i);
+    docNumbers[i] = docNumberTexts[i];
+    Document_init(&document);
+    free(document.docNumber);
+    document.docNumber = duplicateString(docNumberTexts[i]);
+    for (j = 0; j <= i; ++j)
+    {
+      row = DocumentRow_create();
+      free(row->code);
+      row->code = duplicateString("C");
+      row->quantity = j;
+      row->sellingPrice = 1;
+      DocumentRowList_pushBack(&document.rows, row);
+    }
+    sprintf(filename, BASEPATH "/unittest/batch-%s.dat", docNumberTexts[i]);
+    Document_saveToFile(&document, filename);
+    Document_finalize(&document);
+  }
+
+  /* every document is rendered as if it were rendered alone */
+  ASSERT(BatchRender_run(BASEPATH "/unittest/unittest-batchrender-unittest.txt", BASEPATH "/unittest/batch-%s.dat",
+          docNumbers, 20, BASEPATH "/unittest/batch", 4, &report));
+  ASSERT_EQUAL(report.documentCount, 20);
+  ASSERT_EQUAL(report.renderedCount, 20);
+  ASSERT_EQUAL(report.failedCount, 0);
+  ASSERT_EQUAL(report.threadCount, 4);
+  ASSERT(BatchRenderReport_getThroughput(&report) >= 0);
+
+  PrintFormat_init(&printFormat);
+  PrintFormat_loadFromFile(&printFormat, BASEPATH "/unittest/unittest-batchrender-unittest.txt");
+  for (i = 0; i < 20; ++i)
+  {
+    sprintf(filename, BASEPATH "/unittest/batch-%s.dat", docNumberTexts[i]);
+    Document_init(&document);
+    Document_loadFromFile(&document, filename);
+    formatted = PrintFormat_format(&printFormat, &document);
+    Document_finalize(&document);
+
+    sprintf(filename, BASEPATH "/unittest/batch/%s.txt", docNumberTexts[i]);
+    file = fopen(filename, "rb");
+    ASSERT(file != NULL);
+    fseek(file, 0, SEEK_END);
+    fileSize = ftell(file);
+    rewind(file);
+    content = malloc((size_t)fileSize + 1);
+    ASSERT_EQUAL(fread(content, 1, (size_t)fileSize, file), (size_t)fileSize);
+    content[fileSize] = '\0';
+    fclose(file);
+    ASSERT_EQUAL_STRING(content, formatted);
+    free(content);
+    free(formatted);
+  }
+  PrintFormat_finalize(&printFormat);
+
+  /* a missing document fails without stopping the others */
+  docNumbers[20] = "missing";
+  ASSERT(!BatchRender_run(BASEPATH "/unittest/unittest-batchrender-unittest.txt", BASEPATH "/unittest/batch-%s.dat",
+          docNumbers, 21, BASEPATH "/unittest/batch", 0, &report));
+  ASSERT_EQUAL(report.renderedCount, 20);
+  ASSERT_EQUAL(report.failedCount, 1);
+  ASSERT(!BatchRender_run(BASEPATH "/unittest/missing.txt", BASEPATH "/unittest/batch-%s.dat",
+          docNumbers, 20, BASEPATH "/unittest/batch", 0, &report));
+  ASSERT_EQUAL(report.renderedCount, 0);
+
+  /* a truncated document and a number naming another directory fail without stopping the others */
+  file = fopen(BASEPATH "/unittest/batch-B19.dat", "rb");
+  fseek(file, 0, SEEK_END);
+  fileSize = ftell(file);
+  rewind(file);
+  content = malloc((size_t)fileSize);
+  ASSERT_EQUAL(fread(content, 1, (size_t)fileSize, file), (size_t)fileSize);
+  fclose(file);
+  file = fopen(BASEPATH "/unittest/batch-truncated.dat", "wb");
+  ASSERT_EQUAL(fwrite(content, 1, (size_t)fileSize - 5, file), (size_t)fileSize - 5);
+  fclose(file);
+  free(content);
+  docNumbers[21] = "truncated";
+  docNumbers[22] = "../B0";
+  ASSERT(!BatchRender_run(BASEPATH "/unittest/unittest-batchrender-unittest.txt", BASEPATH "/unittest/batch-%s.dat",
+          docNumbers, 23, BASEPATH "/unittest/batch", 0, &report));
+  ASSERT_EQUAL(report.renderedCount, 20);
+  ASSERT_EQUAL(report.failedCount, 3);
+  file = fopen(BASEPATH "/unittest/batch/truncated.txt", "rb");
+  ASSERT(file == NULL);
+  file = fopen(BASEPATH "/unittest/B0.txt", "rb");
+  ASSERT(file == NULL);
+}
+
 void test_PrintFormat(void)
 {
   BEGIN_TESTS(PrintFormat)
   {
     RUN_TEST(test_PrintFormat_all);
+    RUN_TEST(test_PrintFormat_renderTo);
+    RUN_TEST(test_PrintFormatCache);
+    RUN_TEST(test_BatchRender);
   }
   END_TESTS
 }
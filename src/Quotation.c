@@ -25,14 +25,19 @@
 #include <DocumentUtil.h>
 #include <Document.h>
 #include <DocumentRowList.h>
+#include <DocumentIndex.h>
+#include <GtkDocumentModel.h>
 
 /** Save a document as a quotation
  * @param document the document
  */
 void Quotation_save(Document * document) {
     char buf[1024];
+
     snprintf(buf, 1024, BASEPATH "/data/quotation-%s.dat", document->docNumber);
     Document_saveToFile(document, buf);
+
+    DocumentIndex_record(BASEPATH "/data", buf + sizeof(BASEPATH "/data/") - 1, document);
 }
 
 /** Load a document as a quotation
@@ -46,38 +51,8 @@ void Quotation_load(const char * docNumber, Document * document) {
 }
 
 static GtkTreeModel * Quotation_loadModel(void) {
-    GtkListStore * store;
-    GtkTreeIter iter;
-    GDir * directory;
-    Document document;
-
-    Document_init(&document);
-
-    store = gtk_list_store_new(4, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
-
-    directory = g_dir_open(BASEPATH "/data", 0, NULL);
-    if (directory == NULL) {
-        GtkWidget * errordialog = gtk_message_dialog_new(NULL, GTK_DIALOG_DESTROY_WITH_PARENT,
-                GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE, "Impossible de lister les devis");
-        g_signal_connect(errordialog, "response", G_CALLBACK(gtk_widget_destroy), NULL);
-        gtk_widget_show(errordialog);
-    } else {
-        const gchar * entry;
-        while ((entry = g_dir_read_name(directory)) != NULL) {
-            if (icaseStartWith("quotation-", entry) && icaseEndWith(".dat", entry)) {
-                char * filename = concatenateString(BASEPATH "/data/", entry);
-                Document_loadFromFile(&document, filename);
-                gtk_list_store_append(store, &iter);
-                gtk_list_store_set(store, &iter, 0, document.docNumber, 1, document.customer.name,
-                        2, document.editDate, 3, document.object, -1);
-                free(filename);
-            }
-        }
-        g_dir_close(directory);
-    }
-
-    Document_finalize(&document);
-    return GTK_TREE_MODEL(store);
+    /* the quotations are appended while the index loads the ones which changed since the last time */
+    return GtkDocumentModel_new(QUOTATION, "Impossible de lister les devis");
 }
 
 static int Quotation_select(Document * document) {
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <RowCache.h>
+
+static void RowCache_unlink(RowCache * cache, int entry);
+static void RowCache_pushFront(RowCache * cache, int entry);
+static void RowCache_release(RowCache * cache, int entry);
+static int RowCache_lookup(RowCache * cache, int recordIndex);
+
+/** Initialize an empty cache
+ * @param cache the cache
+ * @param capacity the number of rows kept by the cache
+ * @param fieldCount the number of strings of a row
+ */
+void RowCache_init(RowCache * cache, int capacity, int fieldCount)
+{
+    int bucketCount = 1;
+    int i;
+
+    if (capacity < 1 || fieldCount < 1)
+        fatalError("RowCache_init: invalid capacity or field count");
+    while (bucketCount < capacity * 2)
+        bucketCount *= 2;
+
+    cache->entries = malloc(sizeof(RowCacheEntry) * (size_t)capacity);
+    cache->buckets = malloc(sizeof(int) * (size_t)bucketCount);
+    if (cache->entries == NULL || cache->buckets == NULL)
+        fatalError("malloc error : Allocation of the row cache failed");
+    for (i = 0; i < capacity; ++i)
+    {
+        cache->entries[i].recordIndex = -1;
+        cache->entries[i].values = calloc((size_t)fieldCount, sizeof(char *));
+        if (cache->entries[i].values == NULL)
+            fatalError("calloc error : Allocation of the row cache failed");
+    }
+    cache->capacity = capacity;
+    cache->fieldCount = fieldCount;
+    cache->bucketMask = bucketCount - 1;
+    cache->hits = 0;
+    cache->misses = 0;
+    RowCache_clear(cache);
+}
+
+/** Free the memory used by a cache
+ * @param cache the cache
+ */
+void RowCache_finalize(RowCache * cache)
+{
+    int i;
+
+    RowCache_clear(cache);
+    for (i = 0; i < cache->capacity; ++i)
+        free(cache->entries[i].values);
+    free(cache->entries);
+    free(cache->buckets);
+    cache->entries = NULL;
+    cache->buckets = NULL;
+    cache->capacity = 0;
+}
+
+/** Drop all the rows of a cache
+ * @param cache the cache
+ */
+void RowCache_clear(RowCache * cache)
+{
+    int i;
+
+    for (i = 0; i <= cache->bucketMask; ++i)
+        cache->buckets[i] = -1;
+
+    /* every entry is free: chain them from the first to the last so that the first ones are used first */
+    for (i = 0; i < cache->capacity; ++i)
+    {
+        RowCache_release(cache, i);
+        cache->entries[i].previous = i - 1;
+        cache->entries[i].next = (i + 1 < cache->capacity) ? i + 1 : -1;
+    }
+    cache->first = 0;
+    cache->last = cache->capacity - 1;
+}
+
+/** Drop the row of a record
+ * @param cache the cache
+ * @param recordIndex the position of the record
+ */
+void RowCache_invalidate(RowCache * cache, int recordIndex)
+{
+    int entry = RowCache_lookup(cache, recordIndex);
+    int * link;
+
+    if (entry == -1)
+        return;
+
+    link = &cache->buckets[recordIndex & cache->bucketMask];
+    while (*link != entry)
+        link = &cache->entries[*link].hashNext;
+    *link = cache->entries[entry].hashNext;
+    RowCache_release(cache, entry);
+
+    /* a free entry is the first one to be reused */
+    RowCache_unlink(cache, entry);
+    cache->entries[entry].previous = cache->last;
+    cache->entries[entry].next = -1;
+    if (cache->last != -1)
+        cache->entries[cache->last].next = entry;
+    else
+        cache->first = entry;
+    cache->last = entry;
+}
+
+/** Get the strings of a cached row and mark it as the most recently used
+ * @param cache the cache
+ * @param recordIndex the position of the record
+ * @return the array of the strings of the row or NULL if the row is not cached
+ */
+char ** RowCache_find(RowCache * cache, int recordIndex)
+{
+    int entry = RowCache_lookup(cache, recordIndex);
+
+    if (entry == -1)
+    {
+        cache->misses += 1;
+        return NULL;
+    }
+    cache->hits += 1;
+    if (entry != cache->first)
+    {
+        RowCache_unlink(cache, entry);
+        RowCache_pushFront(cache, entry);
+    }
+    return cache->entries[entry].values;
+}
+
+/** Add the row of a record to a cache, dropping the least recently used row if needed
+ * @param cache the cache
+ * @param recordIndex the position of the record which must not be cached
+ * @return the array of fieldCount NULL pointers which must receive the strings of the row
+ */
+char ** RowCache_add(RowCache * cache, int recordIndex)
+{
+    int entry = cache->last;
+    int bucket = recordIndex & cache->bucketMask;
+
+    if (cache->entries[entry].recordIndex != -1)
+        RowCache_invalidate(cache, cache->entries[entry].recordIndex);
+
+    RowCache_unlink(cache, entry);
+    RowCache_pushFront(cache, entry);
+    cache->entries[entry].recordIndex = recordIndex;
+    cache->entries[entry].hashNext = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    return cache->entries[entry].values;
+}
+
+/** Get the ratio of the lookups which found their row
+ * @param cache the cache
+ * @return the ratio between 0 and 1, 0 if there was no lookup
+ */
+double RowCache_getHitRatio(RowCache * cache)
+{
+    if (cache->hits + cache->misses == 0)
+        return 0.0;
+    return (double)cache->hits / (double)(cache->hits + cache->misses);
+}
+
+/** Remove an entry from the list in the order of use
+ * @param cache the cache
+ * @param entry the entry
+ */
+static void RowCache_unlink(RowCache * cache, int entry)
+{
+    RowCacheEntry * current = &cache->entries[entry];
+
+    if (current->previous != -1)
+        cache->entries[current->previous].next = current->next;
+    else
+        cache->first = current->next;
+    if (current->next != -1)
+        cache->entries[current->next].previous = current->previous;
+    else
+        cache->last = current->previous;
+}
+
+/** Insert an entry at the beginning of the list in the order of use
+ * @param cache the cache
+ * @param entry the entry
+ */
+static void RowCache_pushFront(RowCache * cache, int entry)
+{
+    cache->entries[entry].previous = -1;
+    cache->entries[entry].next = cache->first;
+    if (cache->first != -1)
+        cache->entries[cache->first].previous = entry;
+    else
+        cache->last = entry;
+    cache->first = entry;
+}
+
+/** Free the strings of an entry and mark it as unused
+ * @param cache the cache
+ * @param entry the entry
+ */
+static void RowCache_release(RowCache * cache, int entry)
+{
+    int i;
+
+    for (i = 0; i < cache->fieldCount; ++i)
+    {
+        free(cache->entries[entry].values[i]);
+        cache->entries[entry].values[i] = NULL;
+    }
+    cache->entries[entry].recordIndex = -1;
+    cache->entries[entry].hashNext = -1;
+}
+
+/** Find the entry of a record
+ * @param cache the cache
+ * @param recordIndex the position of the record
+ * @return the entry or -1 if the row is not cached
+ */
+static int RowCache_lookup(RowCache * cache, int recordIndex)
+{
+    int entry;
+
+    if (recordIndex < 0)
+        return -1;
+    entry = cache->buckets[recordIndex & cache->bucketMask];
+    while (entry != -1 && cache->entries[entry].recordIndex != recordIndex)
+        entry = cache->entries[entry].hashNext;
+    return entry;
+}
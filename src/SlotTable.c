@@ -0,0 +1,469 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <SlotTable.h>
+#include <MyString.h>
+
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static int SlotTable_getSlotLimit(FILE * database, size_t recordSize);
+static int SlotTable_isValid(SlotTable * table, int slotLimit);
+static void SlotTable_rebuild(SlotTable * table, FILE * database, int slotCount, size_t recordSize);
+static void SlotTable_reserve(SlotTable * table, int capacity);
+static void SlotTable_pushFreeSlot(SlotTable * table, int slot);
+static void SlotTable_leaveIdentity(SlotTable * table);
+static void SlotTable_reserveIndexes(SlotTable * table);
+static void SlotTable_updateIndexes(SlotTable * table, int recordIndex);
+
+/** Initialize a slot table for a database of densely stored records
+ * @param table the table
+ * @param slotCount the number of records of the database
+ */
+void SlotTable_init(SlotTable * table, int slotCount)
+{
+    table->slots = NULL;
+    table->count = slotCount;
+    table->capacity = 0;
+    table->freeSlots = NULL;
+    table->freeCount = 0;
+    table->freeCapacity = 0;
+    table->indexes = NULL;
+    table->indexCapacity = 0;
+    table->slotCount = slotCount;
+    table->isIdentity = 1;
+}
+
+/** Free the memory used by a slot table
+ * @param table the table
+ */
+void SlotTable_finalize(SlotTable * table)
+{
+    free(table->slots);
+    free(table->freeSlots);
+    free(table->indexes);
+    SlotTable_init(table, 0);
+}
+
+/** Create a new string on the heap containing the file name of the slot table of a database
+ * @param filename the file name of the database
+ * @return a new string
+ */
+char * SlotTable_getFilename(const char * filename)
+{
+    return concatenateString(filename, SLOTTABLE_EXTENSION);
+}
+
+/** Initialize a slot table from the side file of a database
+ * @param table the table
+ * @param database the database file
+ * @param filename the file name of the database
+ * @param slotCount the number of slots stored in the header of the database
+ * @param recordSize the size of a slot in the database file
+ * @return a non null value if the side file is valid or missing, 0 if the table was rebuilt from the database file
+ */
+int SlotTable_load(SlotTable * table, FILE * database, const char * filename, int slotCount, size_t recordSize)
+{
+    char * tableFilename = SlotTable_getFilename(filename);
+    FILE * file = fopen(tableFilename, "rb");
+    int slotLimit = SlotTable_getSlotLimit(database, recordSize);
+    int header[3];
+
+    free(tableFilename);
+    SlotTable_init(table, slotCount);
+    if (file == NULL)
+        return 1;
+
+    if (fread(header, sizeof(int), 3, file) < 3
+            || header[0] < 0 || header[0] > slotLimit
+            || header[1] < 0 || header[2] < 0 || header[1] + header[2] > header[0])
+    {
+        fclose(file);
+        SlotTable_rebuild(table, database, MINVALUE(slotCount, slotLimit), recordSize);
+        return 0;
+    }
+
+    /* the side file is saved before the header so it wins if a checkpoint was interrupted between them */
+    table->isIdentity = 0;
+    table->slotCount = header[0];
+    table->count = header[1];
+    SlotTable_reserve(table, header[1]);
+    table->freeCapacity = MAXVALUE(header[2], 1);
+    table->freeSlots = malloc(sizeof(int) * (size_t)table->freeCapacity);
+    if (table->freeSlots == NULL)
+        fatalError("malloc error : Allocation of the free slots failed");
+    table->freeCount = header[2];
+
+    if (fread(table->slots, sizeof(int), (size_t)table->count, file) < (size_t)table->count
+            || fread(table->freeSlots, sizeof(int), (size_t)table->freeCount, file) < (size_t)table->freeCount
+            || !SlotTable_isValid(table, header[0]))
+    {
+        fclose(file);
+        SlotTable_finalize(table);
+        SlotTable_rebuild(table, database, MINVALUE(slotCount, slotLimit), recordSize);
+        return 0;
+    }
+
+    fclose(file);
+    SlotTable_reserveIndexes(table);
+    SlotTable_updateIndexes(table, 0);
+    return 1;
+}
+
+/** Save a slot table in the side file of a database or remove the side file if the table is the identity
+ * @param table the table
+ * @param filename the file name of the database
+ */
+void SlotTable_save(SlotTable * table, const char * filename)
+{
+    char * tableFilename = SlotTable_getFilename(filename);
+    char * temporaryFilename;
+    FILE * file;
+    int header[3];
+
+    if (table->isIdentity)
+    {
+        remove(tableFilename);
+        free(tableFilename);
+        return;
+    }
+
+    /* the table is written aside then renamed so that the side file is always complete */
+    temporaryFilename = concatenateString(tableFilename, ".tmp");
+    file = fopen(temporaryFilename, "wb");
+    if (file == NULL)
+        fatalError("fopen error : unable to save the slot table");
+
+    header[0] = table->slotCount;
+    header[1] = table->count;
+    header[2] = table->freeCount;
+    if (fwrite(header, sizeof(int), 3, file) < 3
+            || fwrite(table->slots, sizeof(int), (size_t)table->count, file) < (size_t)table->count
+            || fwrite(table->freeSlots, sizeof(int), (size_t)table->freeCount, file) < (size_t)table->freeCount)
+        fatalError("fwrite error : unable to save the slot table");
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+        fatalError("fsync error : unable to save the slot table");
+    fclose(file);
+    if (rename(temporaryFilename, tableFilename) != 0)
+        fatalError("rename error : unable to save the slot table");
+    free(temporaryFilename);
+    free(tableFilename);
+}
+
+/** Get the slot of a record
+ * @param table the table
+ * @param recordIndex the position of the record
+ * @return the slot
+ */
+int SlotTable_getSlot(SlotTable * table, int recordIndex)
+{
+    if (table->isIdentity)
+        return recordIndex;
+    return table->slots[recordIndex];
+}
+
+/** Get the position of the record stored in a slot
+ * @param table the table
+ * @param slot the slot
+ * @return the position of the record or -1 if the slot does not hold a record
+ */
+int SlotTable_getIndex(SlotTable * table, int slot)
+{
+    if (slot < 0 || slot >= table->slotCount)
+        return -1;
+    if (table->isIdentity)
+        return slot;
+    return table->indexes[slot];
+}
+
+/** Insert a record at a given position and choose its slot, reusing a removed slot if any
+ * @param table the table
+ * @param recordIndex the insertion position
+ * @return the slot where the record must be written
+ */
+int SlotTable_insert(SlotTable * table, int recordIndex)
+{
+    int slot;
+
+    if (recordIndex < 0 || recordIndex > table->count)
+        fatalError("Error : recordIndex is too higher or too smaller than recordCount");
+
+    if (table->freeCount == 0 && recordIndex == table->count)
+        return SlotTable_append(table);
+
+    SlotTable_leaveIdentity(table);
+    if (table->freeCount > 0)
+    {
+        table->freeCount -= 1;
+        slot = table->freeSlots[table->freeCount];
+    }
+    else
+    {
+        slot = table->slotCount;
+        table->slotCount += 1;
+    }
+
+    SlotTable_reserve(table, table->count + 1);
+    memmove(table->slots + recordIndex + 1, table->slots + recordIndex, sizeof(int) * (size_t)(table->count - recordIndex));
+    table->slots[recordIndex] = slot;
+    table->count += 1;
+    SlotTable_reserveIndexes(table);
+    SlotTable_updateIndexes(table, recordIndex);
+    return slot;
+}
+
+/** Add a record at the end using a new slot at the end of the file
+ * @param table the table
+ * @return the slot where the record must be written
+ */
+int SlotTable_append(SlotTable * table)
+{
+    int slot = table->slotCount;
+
+    table->count += 1;
+    table->slotCount += 1;
+    if (!table->isIdentity)
+    {
+        SlotTable_reserve(table, table->count);
+        table->slots[table->count - 1] = slot;
+        SlotTable_reserveIndexes(table);
+        table->indexes[slot] = table->count - 1;
+    }
+    return slot;
+}
+
+/** Remove the record at a given position
+ * @param table the table
+ * @param recordIndex the removal position
+ * @return the slot of the removed record which must be marked with a tombstone
+ */
+int SlotTable_remove(SlotTable * table, int recordIndex)
+{
+    int slot;
+
+    if (recordIndex < 0 || recordIndex >= table->count)
+        fatalError("Error : recordIndex is too higher or too smaller than recordCount");
+
+    slot = SlotTable_getSlot(table, recordIndex);
+    if (slot == table->slotCount - 1 && recordIndex == table->count - 1)
+    {
+        /* the last slot is simply forgotten, keeping a dense table dense */
+        table->count -= 1;
+        table->slotCount -= 1;
+        return slot;
+    }
+
+    SlotTable_leaveIdentity(table);
+    memmove(table->slots + recordIndex, table->slots + recordIndex + 1, sizeof(int) * (size_t)(table->count - recordIndex - 1));
+    table->count -= 1;
+    table->indexes[slot] = -1;
+    SlotTable_updateIndexes(table, recordIndex);
+    SlotTable_pushFreeSlot(table, slot);
+    return slot;
+}
+
+/** Write a tombstone in a slot of a database file
+ * @param file the database file
+ * @param offset the offset of the slot in the file
+ */
+void SlotTable_writeTombstone(FILE * file, long offset)
+{
+    if (fseek(file, offset, SEEK_SET) != 0 || fputc(SLOTTABLE_TOMBSTONE, file) == EOF)
+        fatalError("fwrite error : unable to write a tombstone");
+}
+
+/** Get the number of slots which fit in a database file
+ * @param database the database file
+ * @param recordSize the size of a slot
+ * @return the number of complete slots following the header of the file
+ */
+static int SlotTable_getSlotLimit(FILE * database, size_t recordSize)
+{
+    struct stat status;
+    size_t slotLimit;
+
+    if (fstat(fileno(database), &status) != 0)
+        fatalError("fstat error : unable to get the size of the database");
+    if (status.st_size < (off_t)sizeof(int))
+        return 0;
+    slotLimit = ((size_t)status.st_size - sizeof(int)) / recordSize;
+    return (slotLimit > INT_MAX) ? INT_MAX : (int)slotLimit;
+}
+
+/** Check that each slot read from a side file is in the database and is used only once
+ * @param table the table whose slots and free slots were just read
+ * @param slotLimit the number of slots of the table
+ * @return a non null value if the table is valid
+ */
+static int SlotTable_isValid(SlotTable * table, int slotLimit)
+{
+    char * isUsed = calloc((size_t)MAXVALUE(slotLimit, 1), 1);
+    int isValid = 1;
+    int slot;
+    int i;
+
+    if (isUsed == NULL)
+        fatalError("calloc error : Allocation of the slot marks failed");
+
+    for (i = 0; isValid && i < table->count + table->freeCount; ++i)
+    {
+        slot = (i < table->count) ? table->slots[i] : table->freeSlots[i - table->count];
+        if (slot < 0 || slot >= slotLimit || isUsed[slot])
+            isValid = 0;
+        else
+            isUsed[slot] = 1;
+    }
+
+    free(isUsed);
+    return isValid;
+}
+
+/** Initialize a slot table from the tombstones of a database file when its side file is damaged
+ *
+ * The records are kept in slot order since their logical order was only stored in the side file.
+ * @param table the table
+ * @param database the database file
+ * @param slotCount the number of slots of the database
+ * @param recordSize the size of a slot
+ */
+static void SlotTable_rebuild(SlotTable * table, FILE * database, int slotCount, size_t recordSize)
+{
+    int slot;
+    int mark;
+
+    SlotTable_init(table, 0);
+    table->isIdentity = 0;
+    for (slot = 0; slot < slotCount; ++slot)
+    {
+        if (fseek(database, (long)sizeof(int) + (long)recordSize * (long)slot, SEEK_SET) != 0
+                || (mark = fgetc(database)) == EOF)
+            fatalError("fread error : unable to rebuild the slot table");
+        table->slotCount += 1;
+        if (mark == (unsigned char)SLOTTABLE_TOMBSTONE)
+            SlotTable_pushFreeSlot(table, slot);
+        else
+        {
+            SlotTable_reserve(table, table->count + 1);
+            table->slots[table->count] = slot;
+            table->count += 1;
+        }
+    }
+
+    if (table->freeCount == 0)
+    {
+        SlotTable_finalize(table);
+        SlotTable_init(table, slotCount);
+        return;
+    }
+    SlotTable_reserveIndexes(table);
+    SlotTable_updateIndexes(table, 0);
+}
+
+/** Ensure that the slots array can store at least capacity records
+ * @param table the table
+ * @param capacity the needed capacity
+ */
+static void SlotTable_reserve(SlotTable * table, int capacity)
+{
+    int * slots;
+    int newCapacity = MAXVALUE(table->capacity, 16);
+
+    if (capacity <= table->capacity)
+        return;
+    while (newCapacity < capacity)
+        newCapacity *= 2;
+
+    slots = realloc(table->slots, sizeof(int) * (size_t)newCapacity);
+    if (slots == NULL)
+        fatalError("realloc error : Reallocation of the slot table failed");
+    table->slots = slots;
+    table->capacity = newCapacity;
+}
+
+/** Remember that a slot is free
+ * @param table the table
+ * @param slot the removed slot
+ */
+static void SlotTable_pushFreeSlot(SlotTable * table, int slot)
+{
+    if (table->freeCount == table->freeCapacity)
+    {
+        int newCapacity = MAXVALUE(table->freeCapacity * 2, 16);
+        int * freeSlots = realloc(table->freeSlots, sizeof(int) * (size_t)newCapacity);
+        if (freeSlots == NULL)
+            fatalError("realloc error : Reallocation of the free slots failed");
+        table->freeSlots = freeSlots;
+        table->freeCapacity = newCapacity;
+    }
+    table->freeSlots[table->freeCount] = slot;
+    table->freeCount += 1;
+}
+
+/** Build the explicit slots array of a table which is still the identity
+ * @param table the table
+ */
+static void SlotTable_leaveIdentity(SlotTable * table)
+{
+    int i;
+
+    if (!table->isIdentity)
+        return;
+    SlotTable_reserve(table, table->count);
+    for (i = 0; i < table->count; ++i)
+        table->slots[i] = i;
+    table->isIdentity = 0;
+    SlotTable_reserveIndexes(table);
+    SlotTable_updateIndexes(table, 0);
+}
+
+/** Ensure that the indexes array covers all the slots, the new slots holding no record
+ * @param table the table
+ */
+static void SlotTable_reserveIndexes(SlotTable * table)
+{
+    int * indexes;
+    int i;
+    int newCapacity = MAXVALUE(table->indexCapacity, 16);
+
+    if (table->slotCount <= table->indexCapacity)
+        return;
+    while (newCapacity < table->slotCount)
+        newCapacity *= 2;
+
+    indexes = realloc(table->indexes, sizeof(int) * (size_t)newCapacity);
+    if (indexes == NULL)
+        fatalError("realloc error : Reallocation of the slot table failed");
+    for (i = table->indexCapacity; i < newCapacity; ++i)
+        indexes[i] = -1;
+    table->indexes = indexes;
+    table->indexCapacity = newCapacity;
+}
+
+/** Update the position stored for the slots of the records following a given position
+ * @param table the table
+ * @param recordIndex the first position which changed
+ */
+static void SlotTable_updateIndexes(SlotTable * table, int recordIndex)
+{
+    int i;
+
+    for (i = recordIndex; i < table->count; ++i)
+        table->indexes[table->slots[i]] = i;
+}
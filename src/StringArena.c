@@ -0,0 +1,128 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <StringArena.h>
+#include <MyString.h>
+
+static StringArenaBlock * StringArena_addBlock(StringArena * arena, size_t size);
+
+/** Create a new empty arena on the heap
+ * @return the new arena
+ */
+StringArena * StringArena_create(void)
+{
+    StringArena * arena = malloc(sizeof(StringArena));
+
+    if (arena == NULL)
+        fatalError("malloc error : Allocation of the string arena failed");
+    arena->blocks = NULL;
+    arena->allocatedSize = 0;
+    return arena;
+}
+
+/** Free all the strings of an arena and the arena itself
+ * @param arena the arena
+ */
+void StringArena_destroy(StringArena * arena)
+{
+    StringArenaBlock * block;
+
+    if (arena == NULL)
+        return;
+    while (arena->blocks != NULL)
+    {
+        block = arena->blocks;
+        arena->blocks = block->next;
+        free(block);
+    }
+    free(arena);
+}
+
+/** Allocate some bytes from an arena
+ * @param arena the arena
+ * @param size the number of bytes
+ * @return the bytes, valid until the arena is destroyed
+ */
+char * StringArena_allocate(StringArena * arena, size_t size)
+{
+    StringArenaBlock * block = arena->blocks;
+    char * bytes;
+
+    if (block == NULL || block->size - block->used < size)
+    {
+        /* a large string gets its own block so that the current block keeps being filled */
+        if (size > STRINGARENA_BLOCK_SIZE / 4)
+            block = StringArena_addBlock(arena, size);
+        else
+            block = StringArena_addBlock(arena, STRINGARENA_BLOCK_SIZE);
+    }
+    bytes = (char *)(block + 1) + block->used;
+    block->used += size;
+    arena->allocatedSize += size;
+    return bytes;
+}
+
+/** Copy a string into an arena
+ * @param arena the arena
+ * @param str the string
+ * @return the copy, valid until the arena is destroyed
+ */
+char * StringArena_duplicate(StringArena * arena, const char * str)
+{
+    size_t size = stringLength(str) + 1;
+    char * copy = StringArena_allocate(arena, size);
+
+    memcpy(copy, str, size);
+    return copy;
+}
+
+/** Get the total size of the strings carved from an arena
+ * @param arena the arena
+ * @return the size in bytes
+ */
+size_t StringArena_getAllocatedSize(StringArena * arena)
+{
+    return arena->allocatedSize;
+}
+
+/** Allocate a block for an arena
+ * @param arena the arena
+ * @param size the size of the data of the block
+ * @return the block which is the one in which the strings are carved unless it is a block for a single large string
+ */
+static StringArenaBlock * StringArena_addBlock(StringArena * arena, size_t size)
+{
+    StringArenaBlock * block = malloc(sizeof(StringArenaBlock) + size);
+
+    if (block == NULL)
+        fatalError("malloc error : Allocation of a block of the string arena failed");
+    block->size = size;
+    block->used = 0;
+    if (size > STRINGARENA_BLOCK_SIZE / 4 && arena->blocks != NULL)
+    {
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+    }
+    else
+    {
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+    return block;
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+
+#include <Template.h>
+#include <MyString.h>
+#include <DecimalFormat.h>
+
+static TemplateOperation * Template_addOperation(Template * template, TemplateOperationType type, int * capacity);
+static void Template_addLiteral(Template * template, size_t start, size_t end, int * capacity);
+static size_t Template_parseField(Template * template, size_t start, int * capacity);
+static void Template_parseModifier(TemplateOperation * operation, char * modifier);
+static int Template_parseInteger(const char * text);
+static void Template_write(char * buffer, size_t bufferSize, size_t * length, const char * data, size_t size, char letterCase);
+static void Template_pad(char * buffer, size_t bufferSize, size_t * length, int count);
+
+/** Parse a template into a list of operations
+ * @param format the text of the template
+ * @return the new template
+ */
+Template * Template_compile(const char * format)
+{
+    Template * template = malloc(sizeof(Template));
+    size_t literalStart = 0;
+    size_t i = 0;
+    int capacity = 0;
+
+    if (template == NULL)
+        fatalError("malloc error : Allocation of the template failed");
+    template->text = duplicateString(format);
+    template->operations = NULL;
+    template->count = 0;
+
+    while (template->text[i] != '\0')
+    {
+        size_t fieldEnd;
+
+        if (template->text[i] != '%')
+        {
+            ++i;
+            continue;
+        }
+        if (template->text[i + 1] == '%')
+        {
+            /* the first % of the sequence is kept as literal text */
+            Template_addLiteral(template, literalStart, i + 1, &capacity);
+            i += 2;
+            literalStart = i;
+            continue;
+        }
+
+        /* a % which does not start a valid placeholder is kept as literal text */
+        Template_addLiteral(template, literalStart, i, &capacity);
+        fieldEnd = Template_parseField(template, i, &capacity);
+        if (fieldEnd == 0)
+        {
+            literalStart = i;
+            ++i;
+            continue;
+        }
+        i = fieldEnd;
+        literalStart = i;
+    }
+    Template_addLiteral(template, literalStart, i, &capacity);
+    return template;
+}
+
+/** Destroy a template
+ * @param template the template
+ */
+void Template_destroy(Template * template)
+{
+    free(template->text);
+    free(template->operations);
+    free(template);
+}
+
+/** Render a template with the values of a dictionary
+ * @param template the template
+ * @param dictionary the dictionary
+ * @param buffer the buffer receiving the null terminated output, may be NULL if bufferSize is 0
+ * @param bufferSize the size of the buffer
+ * @return the length of the whole output
+ */
+size_t Template_render(const Template * template, Dictionary * dictionary, char * buffer, size_t bufferSize)
+{
+    size_t length = 0;
+    int i;
+
+    for (i = 0; i < template->count; ++i)
+    {
+        const TemplateOperation * operation = &template->operations[i];
+        DictionaryEntry * entry;
+        size_t size;
+
+        if (operation->type == TEMPLATE_LITERAL)
+        {
+            Template_write(buffer, bufferSize, &length, template->text + operation->start, operation->length, 0);
+            continue;
+        }
+
+        entry = Dictionary_getEntryWithHash(dictionary, operation->name, operation->hash);
+        if (entry == NULL)
+            continue;
+        if (entry->type == STRING_ENTRY)
+        {
+            size = stringLength(entry->value.stringValue);
+            if (operation->maximum >= 0 && size > (size_t)operation->maximum)
+                size = (size_t)operation->maximum;
+            Template_write(buffer, bufferSize, &length, entry->value.stringValue, size, operation->letterCase);
+            Template_pad(buffer, bufferSize, &length, operation->minimum - (int)size);
+        }
+        else if (entry->type == NUMBER_ENTRY)
+        {
+            /* the number is written in place, truncated as the rest of the output */
+            if (length < bufferSize)
+                length += DecimalFormat_write(buffer + length, bufferSize - length, entry->value.numberValue,
+                        operation->precision, operation->minimum);
+            else
+                length += DecimalFormat_write(NULL, 0, entry->value.numberValue, operation->precision, operation->minimum);
+        }
+    }
+
+    if (bufferSize > 0)
+        buffer[MINVALUE(length, bufferSize - 1)] = '\0';
+    return length;
+}
+
+/** Render a template with the values of a dictionary at the end of a string builder
+ * @param template the template
+ * @param dictionary the dictionary
+ * @param builder the string builder receiving the output
+ */
+void Template_renderTo(const Template * template, Dictionary * dictionary, StringBuilder * builder)
+{
+    size_t length;
+
+    /* the output is rendered in the free space and rendered again if it does not fit */
+    StringBuilder_reserve(builder, builder->length);
+    length = Template_render(template, dictionary, builder->data + builder->length, builder->capacity - builder->length);
+    if (length >= builder->capacity - builder->length)
+    {
+        StringBuilder_reserve(builder, builder->length + length);
+        Template_render(template, dictionary, builder->data + builder->length, builder->capacity - builder->length);
+    }
+    builder->length += length;
+}
+
+/** Append an operation to a template, the array of operations growing geometrically
+ * @param template the template
+ * @param type the kind of operation
+ * @param capacity the number of allocated operations
+ * @return the new operation
+ */
+static TemplateOperation * Template_addOperation(Template * template, TemplateOperationType type, int * capacity)
+{
+    TemplateOperation * operation;
+
+    if (template->count == *capacity)
+    {
+        *capacity = (*capacity == 0) ? 8 : *capacity * 2;
+        template->operations = realloc(template->operations, sizeof(TemplateOperation) * (size_t)*capacity);
+        if (template->operations == NULL)
+            fatalError("realloc error : Allocation of the operations of the template failed");
+    }
+    operation = &template->operations[template->count];
+    template->count += 1;
+
+    operation->type = type;
+    operation->start = 0;
+    operation->length = 0;
+    operation->name = NULL;
+    operation->hash = 0;
+    operation->letterCase = 0;
+    operation->minimum = -1;
+    operation->maximum = -1;
+    operation->precision = TEMPLATE_DEFAULT_PRECISION;
+    return operation;
+}
+
+/** Append a literal span to a template, merging it with the previous one if they are contiguous
+ * @param template the template
+ * @param start the offset of the first character of the span in the text
+ * @param end the offset following the last character of the span
+ * @param capacity the number of allocated operations
+ */
+static void Template_addLiteral(Template * template, size_t start, size_t end, int * capacity)
+{
+    TemplateOperation * operation;
+
+    if (end <= start)
+        return;
+    if (template->count > 0)
+    {
+        operation = &template->operations[template->count - 1];
+        if (operation->type == TEMPLATE_LITERAL && operation->start + operation->length == start)
+        {
+            operation->length += end - start;
+            return;
+        }
+    }
+    operation = Template_addOperation(template, TEMPLATE_LITERAL, capacity);
+    operation->start = start;
+    operation->length = end - start;
+}
+
+/** Parse a placeholder and append its field to a template
+ *
+ * The characters of the text are temporarily replaced by null characters to
+ * isolate the name and the modifiers.
+ * @param template the template
+ * @param start the offset of the % starting the placeholder
+ * @param capacity the number of allocated operations
+ * @return the offset following the placeholder or 0 if it is not a valid placeholder
+ */
+static size_t Template_parseField(Template * template, size_t start, int * capacity)
+{
+    char * text = template->text;
+    size_t nameEnd = start + 1;
+    size_t end;
+    TemplateOperation * operation;
+    char separator;
+
+    /* a name is a non empty word */
+    while (text[nameEnd] != '\0' && text[nameEnd] != '%' && text[nameEnd] != '{' && text[nameEnd] != ' ' && text[nameEnd] != '\t' && text[nameEnd] != '\n')
+        ++nameEnd;
+    if (nameEnd == start + 1 || (text[nameEnd] != '%' && text[nameEnd] != '{'))
+        return 0;
+
+    end = nameEnd;
+    if (text[end] == '{')
+    {
+        while (text[end] != '\0' && text[end] != '}' && text[end] != '\n')
+            ++end;
+        if (text[end] != '}')
+            return 0;
+        ++end;
+    }
+    if (text[end] != '%')
+        return 0;
+
+    operation = Template_addOperation(template, TEMPLATE_FIELD, capacity);
+    separator = text[nameEnd];
+    text[nameEnd] = '\0';
+    operation->name = Dictionary_internName(text + start + 1);
+    operation->hash = Dictionary_hashName(operation->name);
+    text[nameEnd] = separator;
+
+    if (separator == '{')
+    {
+        size_t modifierStart = nameEnd + 1;
+        size_t i;
+
+        for (i = modifierStart; i < end; ++i)
+            if (text[i] == ',' || text[i] == '}')
+            {
+                separator = text[i];
+                text[i] = '\0';
+                Template_parseModifier(operation, text + modifierStart);
+                text[i] = separator;
+                modifierStart = i + 1;
+            }
+    }
+    return end + 1;
+}
+
+/** Apply a modifier of a placeholder to its field, the unknown modifiers being ignored
+ * @param operation the field
+ * @param modifier the null terminated modifier of the form key=value
+ */
+static void Template_parseModifier(TemplateOperation * operation, char * modifier)
+{
+    char * value = modifier;
+
+    while (*value != '\0' && *value != '=')
+        ++value;
+    if (*value != '=')
+        return;
+    *value = '\0';
+
+    if (icaseCompareString(modifier, "case") == 0)
+    {
+        if (value[1] >= 'A' && value[1] <= 'Z')
+            operation->letterCase = 'U';
+        else if (value[1] >= 'a' && value[1] <= 'z')
+            operation->letterCase = 'l';
+    }
+    else if (icaseCompareString(modifier, "min") == 0)
+        operation->minimum = Template_parseInteger(value + 1);
+    else if (icaseCompareString(modifier, "max") == 0)
+        operation->maximum = Template_parseInteger(value + 1);
+    else if (icaseCompareString(modifier, "precision") == 0)
+    {
+        operation->precision = MINVALUE(Template_parseInteger(value + 1), TEMPLATE_MAX_PRECISION);
+        if (operation->precision < 0)
+            operation->precision = TEMPLATE_DEFAULT_PRECISION;
+    }
+    *value = '=';
+}
+
+/** Read the non negative integer at the beginning of a text
+ * @param text the text
+ * @return the integer or -1 if the text does not start with a digit
+ */
+static int Template_parseInteger(const char * text)
+{
+    int value = 0;
+
+    if (*text < '0' || *text > '9')
+        return -1;
+    while (*text >= '0' && *text <= '9' && value < 100000)
+    {
+        value = value * 10 + (*text - '0');
+        ++text;
+    }
+    return value;
+}
+
+/** Append characters to the output of a rendering, the characters beyond the buffer being only counted
+ * @param buffer the buffer receiving the output
+ * @param bufferSize the size of the buffer
+ * @param length the length of the output, updated
+ * @param data the characters
+ * @param size the number of characters
+ * @param letterCase 'U' to write in upper case, 'l' in lower case, 0 to keep the case
+ */
+static void Template_write(char * buffer, size_t bufferSize, size_t * length, const char * data, size_t size, char letterCase)
+{
+    size_t count = 0;
+    size_t i;
+
+    if (*length + 1 < bufferSize)
+        count = MINVALUE(size, bufferSize - 1 - *length);
+    if (letterCase == 0 && count > 0)
+        memcpy(buffer + *length, data, count);
+    else
+        for (i = 0; i < count; ++i)
+        {
+            char c = data[i];
+            if (letterCase == 'U' && c >= 'a' && c <= 'z')
+                c = (char)(c - 'a' + 'A');
+            else if (letterCase == 'l' && c >= 'A' && c <= 'Z')
+                c = (char)(c - 'A' + 'a');
+            buffer[*length + i] = c;
+        }
+    *length += size;
+}
+
+/** Append spaces to the output of a rendering
+ * @param buffer the buffer receiving the output
+ * @param bufferSize the size of the buffer
+ * @param length the length of the output, updated
+ * @param count the number of spaces, nothing is written if it is not positive
+ */
+static void Template_pad(char * buffer, size_t bufferSize, size_t * length, int count)
+{
+    size_t i;
+
+    for (i = 0; count > 0 && i < (size_t)count; ++i)
+    {
+        if (*length + 1 < bufferSize)
+            buffer[*length] = ' ';
+        *length += 1;
+    }
+}
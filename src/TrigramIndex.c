@@ -0,0 +1,504 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <TrigramIndex.h>
+#include <CatalogIndex.h>
+#include <MyString.h>
+
+/** The maximum number of trigrams taken from a text, the score of a slot must fit in an unsigned char */
+#define TRIGRAMINDEX_MAX_TRIGRAMS 255
+
+/** The header of a trigram index file */
+typedef struct
+{
+  long databaseSize; /**< The size of the database file when the index was saved */
+  long databaseTime; /**< The modification time of the database file when the index was saved */
+  long databaseNanoseconds; /**< The nanoseconds of the modification time of the database file */
+  int trigramCount; /**< The number of posting lists, TRIGRAMINDEX_TRIGRAM_COUNT */
+  int slotTotal; /**< The total number of slots of all the posting lists */
+} TrigramIndexHeader;
+
+static int TrigramIndex_getSymbol(char c);
+static int TrigramIndex_extract(const char * text, int isQuery, int * trigrams);
+static int TrigramIndex_compareTrigrams(const void * a, const void * b);
+static void TrigramIndex_allocate(TrigramIndex * trigramIndex);
+static int TrigramIndex_findSlot(const TrigramPostingList * list, int slot, int * position);
+static int TrigramIndex_isSorted(const TrigramPostingList * list);
+
+/** Initialize an empty and invalid index
+ * @param trigramIndex the index
+ */
+void TrigramIndex_init(TrigramIndex * trigramIndex)
+{
+    trigramIndex->lists = NULL;
+    trigramIndex->isValid = 0;
+    trigramIndex->isModified = 0;
+}
+
+/** Free the memory used by an index and make it invalid
+ * @param trigramIndex the index
+ */
+void TrigramIndex_finalize(TrigramIndex * trigramIndex)
+{
+    int i;
+
+    if (trigramIndex->lists != NULL)
+        for (i = 0; i < TRIGRAMINDEX_TRIGRAM_COUNT; ++i)
+            free(trigramIndex->lists[i].slots);
+    free(trigramIndex->lists);
+    TrigramIndex_init(trigramIndex);
+}
+
+/** Remove all the entries of an index and make it valid
+ * @param trigramIndex the index
+ */
+void TrigramIndex_clear(TrigramIndex * trigramIndex)
+{
+    TrigramIndex_finalize(trigramIndex);
+    TrigramIndex_allocate(trigramIndex);
+    trigramIndex->isValid = 1;
+    trigramIndex->isModified = 1;
+}
+
+/** Create a new string on the heap containing the file name of the trigram index of a database
+ * @param filename the file name of the database
+ * @return a new string
+ */
+char * TrigramIndex_getFilename(const char * filename)
+{
+    size_t length = stringLength(filename);
+    char * base;
+    char * indexFilename;
+
+    if (length < 3 || compareString(filename + length - 3, ".db") != 0)
+        return concatenateString(filename, TRIGRAMINDEX_EXTENSION);
+
+    base = subString(filename, filename + length - 3);
+    indexFilename = concatenateString(base, TRIGRAMINDEX_EXTENSION);
+    free(base);
+    return indexFilename;
+}
+
+/** Load the trigram index of a database if it matches the database file
+ * @param trigramIndex the index
+ * @param filename the file name of the database
+ * @return a non null value if the index is valid, 0 otherwise
+ */
+int TrigramIndex_load(TrigramIndex * trigramIndex, const char * filename)
+{
+    char * indexFilename = TrigramIndex_getFilename(filename);
+    FILE * file = fopen(indexFilename, "rb");
+    TrigramIndexHeader header;
+    long databaseSize;
+    long databaseTime;
+    long databaseNanoseconds;
+    int * counts;
+    int i;
+
+    free(indexFilename);
+    TrigramIndex_finalize(trigramIndex);
+    if (file == NULL)
+        return 0;
+
+    if (fread(&header, sizeof(header), 1, file) < 1
+            || !CatalogIndex_getDatabaseStamp(filename, &databaseSize, &databaseTime, &databaseNanoseconds)
+            || header.databaseSize != databaseSize || header.databaseTime != databaseTime
+            || header.databaseNanoseconds != databaseNanoseconds
+            || header.trigramCount != TRIGRAMINDEX_TRIGRAM_COUNT || header.slotTotal < 0)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    counts = malloc(sizeof(int) * TRIGRAMINDEX_TRIGRAM_COUNT);
+    if (counts == NULL)
+        fatalError("malloc error : Allocation of the trigram index failed");
+    if (fread(counts, sizeof(int), TRIGRAMINDEX_TRIGRAM_COUNT, file) < TRIGRAMINDEX_TRIGRAM_COUNT)
+    {
+        free(counts);
+        fclose(file);
+        return 0;
+    }
+
+    TrigramIndex_allocate(trigramIndex);
+    for (i = 0; i < TRIGRAMINDEX_TRIGRAM_COUNT; ++i)
+    {
+        TrigramPostingList * list = &trigramIndex->lists[i];
+
+        if (counts[i] <= 0)
+            continue;
+        list->slots = malloc(sizeof(int) * (size_t)counts[i]);
+        if (list->slots == NULL)
+            fatalError("malloc error : Allocation of the trigram index failed");
+        list->capacity = counts[i];
+        list->count = counts[i];
+        /* the unsorted lists of an older index can not be searched */
+        if (fread(list->slots, sizeof(int), (size_t)list->count, file) < (size_t)list->count || !TrigramIndex_isSorted(list))
+        {
+            free(counts);
+            fclose(file);
+            TrigramIndex_finalize(trigramIndex);
+            return 0;
+        }
+    }
+    free(counts);
+    fclose(file);
+
+    trigramIndex->isValid = 1;
+    return 1;
+}
+
+/** Save the trigram index of a database, stamped with the current state of the database file
+ * @param trigramIndex the index
+ * @param filename the file name of the database which must be up to date on disk
+ */
+void TrigramIndex_save(TrigramIndex * trigramIndex, const char * filename)
+{
+    char * indexFilename;
+    FILE * file;
+    TrigramIndexHeader header;
+    int i;
+    int isWritten = 1;
+
+    memset(&header, 0, sizeof(header));
+    if (!trigramIndex->isValid || !CatalogIndex_getDatabaseStamp(filename, &header.databaseSize, &header.databaseTime,
+            &header.databaseNanoseconds))
+    {
+        TrigramIndex_remove(filename);
+        return;
+    }
+
+    indexFilename = TrigramIndex_getFilename(filename);
+    file = fopen(indexFilename, "wb");
+    free(indexFilename);
+    if (file == NULL)
+        return;
+
+    header.trigramCount = TRIGRAMINDEX_TRIGRAM_COUNT;
+    for (i = 0; i < TRIGRAMINDEX_TRIGRAM_COUNT; ++i)
+        header.slotTotal += trigramIndex->lists[i].count;
+
+    isWritten = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (i = 0; isWritten && i < TRIGRAMINDEX_TRIGRAM_COUNT; ++i)
+        isWritten = fwrite(&trigramIndex->lists[i].count, sizeof(int), 1, file) == 1;
+    for (i = 0; isWritten && i < TRIGRAMINDEX_TRIGRAM_COUNT; ++i)
+        isWritten = fwrite(trigramIndex->lists[i].slots, sizeof(int), (size_t)trigramIndex->lists[i].count, file)
+                == (size_t)trigramIndex->lists[i].count;
+    fclose(file);
+
+    if (!isWritten)
+    {
+        TrigramIndex_remove(filename);
+        return;
+    }
+    trigramIndex->isModified = 0;
+}
+
+/** Remove the saved trigram index of a database
+ * @param filename the file name of the database
+ */
+void TrigramIndex_remove(const char * filename)
+{
+    char * indexFilename = TrigramIndex_getFilename(filename);
+    remove(indexFilename);
+    free(indexFilename);
+}
+
+/** Record that a slot holds a product with a given designation
+ * @param trigramIndex the index
+ * @param text the designation of the product
+ * @param slot the slot of the product
+ */
+void TrigramIndex_add(TrigramIndex * trigramIndex, const char * text, int slot)
+{
+    int trigrams[TRIGRAMINDEX_MAX_TRIGRAMS];
+    int count = TrigramIndex_extract(text, 0, trigrams);
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        TrigramPostingList * list = &trigramIndex->lists[trigrams[i]];
+        int position;
+
+        if (TrigramIndex_findSlot(list, slot, &position) != -1)
+            continue;
+        if (list->count == list->capacity)
+        {
+            int newCapacity = MAXVALUE(list->capacity * 2, 4);
+            int * slots = realloc(list->slots, sizeof(int) * (size_t)newCapacity);
+            if (slots == NULL)
+                fatalError("realloc error : Reallocation of the trigram index failed");
+            list->slots = slots;
+            list->capacity = newCapacity;
+        }
+        /* the slots are mostly added in increasing order and then nothing is moved */
+        memmove(list->slots + position + 1, list->slots + position, sizeof(int) * (size_t)(list->count - position));
+        list->slots[position] = slot;
+        list->count += 1;
+    }
+    trigramIndex->isModified = 1;
+}
+
+/** Record that a slot does not hold a product with a given designation anymore
+ * @param trigramIndex the index
+ * @param text the designation of the product
+ * @param slot the slot of the product
+ */
+void TrigramIndex_delete(TrigramIndex * trigramIndex, const char * text, int slot)
+{
+    int trigrams[TRIGRAMINDEX_MAX_TRIGRAMS];
+    int count = TrigramIndex_extract(text, 0, trigrams);
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        TrigramPostingList * list = &trigramIndex->lists[trigrams[i]];
+        int position;
+        int slotIndex = TrigramIndex_findSlot(list, slot, &position);
+
+        if (slotIndex == -1)
+            continue;
+        list->count -= 1;
+        memmove(list->slots + slotIndex, list->slots + slotIndex + 1, sizeof(int) * (size_t)(list->count - slotIndex));
+    }
+    trigramIndex->isModified = 1;
+}
+
+/** Find the slots whose designation best matches a query
+ * @param trigramIndex the index
+ * @param query the query
+ * @param slotCount the number of slots of the database
+ * @param limit the maximum number of slots to return
+ * @param slots the array of at least limit elements receiving the slots, best match first
+ * @return the number of slots found
+ */
+int TrigramIndex_search(TrigramIndex * trigramIndex, const char * query, int slotCount, int limit, int * slots)
+{
+    int trigrams[TRIGRAMINDEX_MAX_TRIGRAMS];
+    int count = TrigramIndex_extract(query, 1, trigrams);
+    unsigned char * scores;
+    int * candidates;
+    int candidateCount = 0;
+    int candidateCapacity = 64;
+    int found = 0;
+    int minimumScore = (count + 1) / 2;
+    int i;
+    int j;
+
+    if (count == 0 || limit <= 0 || slotCount <= 0)
+        return 0;
+
+    scores = calloc((size_t)slotCount, sizeof(unsigned char));
+    candidates = malloc(sizeof(int) * (size_t)candidateCapacity);
+    if (scores == NULL || candidates == NULL)
+        fatalError("malloc error : Allocation of the search buffers failed");
+
+    for (i = 0; i < count; ++i)
+    {
+        TrigramPostingList * list = &trigramIndex->lists[trigrams[i]];
+
+        for (j = 0; j < list->count; ++j)
+        {
+            int slot = list->slots[j];
+
+            if (slot < 0 || slot >= slotCount)
+                continue;
+            if (scores[slot] == 0)
+            {
+                if (candidateCount == candidateCapacity)
+                {
+                    int * newCandidates = realloc(candidates, sizeof(int) * (size_t)candidateCapacity * 2);
+                    if (newCandidates == NULL)
+                        fatalError("realloc error : Reallocation of the search buffers failed");
+                    candidates = newCandidates;
+                    candidateCapacity *= 2;
+                }
+                candidates[candidateCount] = slot;
+                candidateCount += 1;
+            }
+            scores[slot] = (unsigned char)(scores[slot] + 1);
+        }
+    }
+
+    /* keep the best slots sorted by decreasing score then increasing slot */
+    for (i = 0; i < candidateCount; ++i)
+    {
+        int slot = candidates[i];
+        int position = found;
+
+        if (scores[slot] < minimumScore)
+            continue;
+        while (position > 0 && (scores[slots[position - 1]] < scores[slot]
+                || (scores[slots[position - 1]] == scores[slot] && slots[position - 1] > slot)))
+            position -= 1;
+        if (position >= limit)
+            continue;
+        if (found < limit)
+            found += 1;
+        for (j = found - 1; j > position; --j)
+            slots[j] = slots[j - 1];
+        slots[position] = slot;
+    }
+
+    free(candidates);
+    free(scores);
+    return found;
+}
+
+/** Get the symbol of a character in the alphabet of the trigrams
+ * @param c the character
+ * @return the symbol, 0 for the characters acting as a space
+ */
+static int TrigramIndex_getSymbol(char c)
+{
+    unsigned char u = (unsigned char)c;
+
+    if (u >= 128)
+        return TRIGRAMINDEX_SYMBOL_COUNT - 1;
+    c = toLowerChar(c);
+    if (c >= 'a' && c <= 'z')
+        return 1 + (c - 'a');
+    if (c >= '0' && c <= '9')
+        return 27 + (c - '0');
+    return 0;
+}
+
+/** Get the distinct trigrams of a text
+ * @param text the text
+ * @param isQuery true if the last word of the text must be left open to match the words starting with it
+ * @param trigrams the array of TRIGRAMINDEX_MAX_TRIGRAMS elements receiving the trigrams, sorted
+ * @return the number of trigrams
+ */
+static int TrigramIndex_extract(const char * text, int isQuery, int * trigrams)
+{
+    int first = 0;
+    int second = 0;
+    int length = 1;
+    int count = 0;
+    int i;
+
+    for (;; ++text)
+    {
+        int symbol;
+
+        if (*text != '\0')
+            symbol = TrigramIndex_getSymbol(*text);
+        else if (!isQuery)
+            symbol = 0;
+        else
+            break;
+
+        if (symbol == 0 && second == 0)
+        {
+            if (*text == '\0')
+                break;
+            continue;
+        }
+        if (length >= 2 && count < TRIGRAMINDEX_MAX_TRIGRAMS)
+        {
+            trigrams[count] = (first * TRIGRAMINDEX_SYMBOL_COUNT + second) * TRIGRAMINDEX_SYMBOL_COUNT + symbol;
+            count += 1;
+        }
+        first = second;
+        second = symbol;
+        length += 1;
+        if (*text == '\0')
+            break;
+    }
+
+    if (count == 0)
+        return 0;
+    qsort(trigrams, (size_t)count, sizeof(int), TrigramIndex_compareTrigrams);
+    for (i = 1, length = 1; i < count; ++i)
+        if (trigrams[i] != trigrams[length - 1])
+        {
+            trigrams[length] = trigrams[i];
+            length += 1;
+        }
+    return length;
+}
+
+/** Compare two trigrams for qsort()
+ * @param a the first trigram
+ * @param b the second trigram
+ * @return a negative, null or positive value as a is lower, equal or greater than b
+ */
+static int TrigramIndex_compareTrigrams(const void * a, const void * b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+/** Allocate the empty posting lists of an index
+ * @param trigramIndex the index
+ */
+static void TrigramIndex_allocate(TrigramIndex * trigramIndex)
+{
+    trigramIndex->lists = calloc(TRIGRAMINDEX_TRIGRAM_COUNT, sizeof(TrigramPostingList));
+    if (trigramIndex->lists == NULL)
+        fatalError("calloc error : Allocation of the trigram index failed");
+}
+
+/** Find a slot in a posting list by a binary search
+ * @param list the posting list
+ * @param slot the slot
+ * @param position the position where the slot should be inserted if it is not in the list
+ * @return the position of the slot, -1 if it is not in the list
+ */
+static int TrigramIndex_findSlot(const TrigramPostingList * list, int slot, int * position)
+{
+    int first = 0;
+    int last = list->count;
+
+    /* the appends in increasing order of a bulk build go straight to the end */
+    if (last == 0 || list->slots[last - 1] < slot)
+    {
+        *position = last;
+        return -1;
+    }
+    while (first < last)
+    {
+        int middle = first + (last - first) / 2;
+
+        if (list->slots[middle] == slot)
+            return middle;
+        if (list->slots[middle] < slot)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    *position = first;
+    return -1;
+}
+
+/** Tell if the slots of a posting list are in strictly increasing order
+ * @param list the posting list
+ * @return a non null value if the list is sorted
+ */
+static int TrigramIndex_isSorted(const TrigramPostingList * list)
+{
+    int i;
+
+    for (i = 1; i < list->count; ++i)
+        if (list->slots[i - 1] >= list->slots[i])
+            return 0;
+    return 1;
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2010 Sébastien Aupetit <sebastien.aupetit@univ-tours.fr>
+ *
+ * This source code is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This source code is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this source code. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include <WriteAheadLog.h>
+#include <MyString.h>
+
+#include <unistd.h>
+
+/** The number of integers of the stamp written at the beginning of a log */
+#define WRITEAHEADLOG_STAMP_SIZE 4
+
+static void WriteAheadLog_getStamp(SlotTable * table, unsigned int * stamp);
+static unsigned int WriteAheadLog_hash(unsigned int hash, const char * data, size_t size);
+static unsigned int WriteAheadLog_getEntryChecksum(int operation, int recordIndex, const char * record, size_t recordSize);
+
+/** Initialize the log of a database without touching the log file
+ * @param log the log
+ * @param filename the file name of the database
+ * @param recordSize the size of an encoded record
+ * @param table the slot table of the database
+ */
+void WriteAheadLog_init(WriteAheadLog * log, const char * filename, size_t recordSize, SlotTable * table)
+{
+    log->file = NULL;
+    log->filename = WriteAheadLog_getFilename(filename);
+    log->recordSize = recordSize;
+    log->table = table;
+    log->size = 0;
+    log->pendingCount = 0;
+}
+
+/** Close the log file and free the memory used by a log
+ * @param log the log
+ */
+void WriteAheadLog_finalize(WriteAheadLog * log)
+{
+    if (log->file != NULL)
+        fclose(log->file);
+    free(log->filename);
+    log->file = NULL;
+    log->filename = NULL;
+}
+
+/** Create a new string on the heap containing the file name of the log of a database
+ * @param filename the file name of the database
+ * @return a new string
+ */
+char * WriteAheadLog_getFilename(const char * filename)
+{
+    return concatenateString(filename, WRITEAHEADLOG_EXTENSION);
+}
+
+/** Apply to a database the entries of the log left by a previous session
+ * @param log the log
+ * @param database the database file whose slot table was just loaded
+ * @return the number of entries replayed
+ */
+int WriteAheadLog_replay(WriteAheadLog * log, FILE * database)
+{
+    FILE * file = fopen(log->filename, "rb");
+    unsigned int stamp[WRITEAHEADLOG_STAMP_SIZE];
+    unsigned int expectedStamp[WRITEAHEADLOG_STAMP_SIZE];
+    char * record;
+    int entry[3];
+    int count = 0;
+    int i;
+
+    if (file == NULL)
+        return 0;
+
+    /* a log which does not start from the saved slot table was already checkpointed */
+    WriteAheadLog_getStamp(log->table, expectedStamp);
+    if (fread(stamp, sizeof(unsigned int), WRITEAHEADLOG_STAMP_SIZE, file) < WRITEAHEADLOG_STAMP_SIZE)
+    {
+        fclose(file);
+        return 0;
+    }
+    for (i = 0; i < WRITEAHEADLOG_STAMP_SIZE; ++i)
+        if (stamp[i] != expectedStamp[i])
+        {
+            fclose(file);
+            return 0;
+        }
+
+    record = malloc(log->recordSize);
+    if (record == NULL)
+        fatalError("malloc error : Allocation of the log entry failed");
+
+    /* the replay stops at the first entry which was not completely written */
+    while (fread(entry, sizeof(int), 3, file) == 3)
+    {
+        int operation = entry[0];
+        int recordIndex = entry[1];
+        int slot;
+
+        if (operation != WRITEAHEADLOG_REMOVE && fread(record, log->recordSize, 1, file) < 1)
+            break;
+        if ((unsigned int)entry[2] != WriteAheadLog_getEntryChecksum(operation, recordIndex, (operation != WRITEAHEADLOG_REMOVE) ? record : NULL, log->recordSize))
+            break;
+        if (recordIndex < 0 || recordIndex > log->table->count
+                || (operation != WRITEAHEADLOG_INSERT && recordIndex == log->table->count))
+            break;
+
+        if (operation == WRITEAHEADLOG_INSERT)
+            slot = SlotTable_insert(log->table, recordIndex);
+        else if (operation == WRITEAHEADLOG_REMOVE)
+            slot = SlotTable_remove(log->table, recordIndex);
+        else if (operation == WRITEAHEADLOG_WRITE)
+            slot = SlotTable_getSlot(log->table, recordIndex);
+        else
+            break;
+
+        if (operation == WRITEAHEADLOG_REMOVE)
+            SlotTable_writeTombstone(database, (long)sizeof(int) + (long)log->recordSize * (long)slot);
+        else if (fseek(database, (long)sizeof(int) + (long)log->recordSize * (long)slot, SEEK_SET) != 0
+                || fwrite(record, log->recordSize, 1, database) < 1)
+            fatalError("fwrite error : unable to replay the log");
+        count += 1;
+    }
+
+    free(record);
+    fclose(file);
+    return count;
+}
+
+/** Append an entry to the log before the change is applied to the database
+ * @param log the log
+ * @param operation the kind of change
+ * @param recordIndex the position of the record
+ * @param record the encoded record for the insertions and the modifications, NULL otherwise
+ */
+void WriteAheadLog_append(WriteAheadLog * log, WriteAheadLogOperation operation, int recordIndex, const char * record)
+{
+    int entry[3];
+
+    if (log->file == NULL)
+    {
+        unsigned int stamp[WRITEAHEADLOG_STAMP_SIZE];
+
+        /* the first entry after a checkpoint starts a new log from the current slot table */
+        log->file = fopen(log->filename, "wb");
+        if (log->file == NULL)
+            fatalError("fopen error : unable to create the log of the database");
+        WriteAheadLog_getStamp(log->table, stamp);
+        if (fwrite(stamp, sizeof(unsigned int), WRITEAHEADLOG_STAMP_SIZE, log->file) < WRITEAHEADLOG_STAMP_SIZE)
+            fatalError("fwrite error : unable to write the log of the database");
+        log->size = (long)sizeof(stamp);
+    }
+
+    entry[0] = (int)operation;
+    entry[1] = recordIndex;
+    entry[2] = (int)WriteAheadLog_getEntryChecksum(entry[0], recordIndex, record, log->recordSize);
+    if (fwrite(entry, sizeof(int), 3, log->file) < 3
+            || (record != NULL && fwrite(record, log->recordSize, 1, log->file) < 1))
+        fatalError("fwrite error : unable to write the log of the database");
+    log->size += (long)sizeof(entry) + ((record != NULL) ? (long)log->recordSize : 0);
+
+    /* the entry must reach the system before the database file is changed */
+    if (fflush(log->file) != 0)
+        fatalError("fflush error : unable to write the log of the database");
+    log->pendingCount += 1;
+    if (log->pendingCount >= WRITEAHEADLOG_GROUP_SIZE)
+        WriteAheadLog_sync(log);
+}
+
+/** Force the pending entries to the disk
+ * @param log the log
+ */
+void WriteAheadLog_sync(WriteAheadLog * log)
+{
+    if (log->file == NULL || log->pendingCount == 0)
+        return;
+    if (fsync(fileno(log->file)) != 0)
+        fatalError("fsync error : unable to force the log of the database to the disk");
+    log->pendingCount = 0;
+}
+
+/** Tell if the log is large enough for the database to do a checkpoint
+ * @param log the log
+ * @return a non null value if a checkpoint should be done
+ */
+int WriteAheadLog_needsCheckpoint(WriteAheadLog * log)
+{
+    return log->size > WRITEAHEADLOG_CHECKPOINT_SIZE;
+}
+
+/** Empty the log once the database saved its slot table and its header
+ * @param log the log
+ */
+void WriteAheadLog_reset(WriteAheadLog * log)
+{
+    if (log->file != NULL)
+        fclose(log->file);
+    log->file = NULL;
+    log->size = 0;
+    log->pendingCount = 0;
+    remove(log->filename);
+}
+
+/** Compute the stamp identifying the content of a slot table
+ * @param table the table
+ * @param stamp the array of WRITEAHEADLOG_STAMP_SIZE integers receiving the stamp
+ */
+static void WriteAheadLog_getStamp(SlotTable * table, unsigned int * stamp)
+{
+    unsigned int hash = 2166136261U;
+    int slot;
+    int i;
+
+    for (i = 0; i < table->count; ++i)
+    {
+        slot = SlotTable_getSlot(table, i);
+        hash = WriteAheadLog_hash(hash, (const char *)&slot, sizeof(int));
+    }
+    hash = WriteAheadLog_hash(hash, (const char *)table->freeSlots, sizeof(int) * (size_t)table->freeCount);
+
+    stamp[0] = (unsigned int)table->slotCount;
+    stamp[1] = (unsigned int)table->count;
+    stamp[2] = (unsigned int)table->freeCount;
+    stamp[3] = hash;
+}
+
+/** Continue a FNV-1a hash with some bytes
+ * @param hash the hash of the previous bytes
+ * @param data the bytes
+ * @param size the number of bytes
+ * @return the new hash
+ */
+static unsigned int WriteAheadLog_hash(unsigned int hash, const char * data, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned int)(unsigned char)data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/** Compute the checksum protecting an entry of a log
+ * @param operation the kind of change
+ * @param recordIndex the position of the record
+ * @param record the encoded record, NULL if none
+ * @param recordSize the size of an encoded record
+ * @return the checksum
+ */
+static unsigned int WriteAheadLog_getEntryChecksum(int operation, int recordIndex, const char * record, size_t recordSize)
+{
+    unsigned int hash = 2166136261U;
+
+    hash = WriteAheadLog_hash(hash, (const char *)&operation, sizeof(int));
+    hash = WriteAheadLog_hash(hash, (const char *)&recordIndex, sizeof(int));
+    if (record != NULL)
+        hash = WriteAheadLog_hash(hash, record, recordSize);
+    return hash;
+}